@@ -0,0 +1,74 @@
+/**
+ * common/log.h: Logging macros with a compile-time level
+ *
+ * Shared by every native phase. Define LOG_TAG, then include this:
+ *
+ *     #define LOG_TAG "Phase3Native"
+ *     #include "common/log.h"
+ *     LOGD("Buffer %dx%d", width, height);
+ *
+ * WHY A COMPILE-TIME LEVEL? __android_log_print() formats the string and
+ * writes it to logd (a socket write) even if nobody is reading logcat.
+ * Inside a 60 fps loop that is real work on the render thread. Every
+ * macro below expands to "if (<constant>) print(...)", so a level below
+ * NATIVE_LOG_LEVEL is constant-folded away: no call, no argument
+ * evaluation, and the format string doesn't even end up in the .so.
+ *
+ * DEFAULT LEVEL: DEBUG in debug builds, INFO when NDEBUG is defined (CMake
+ * Release / Gradle release). Override with -DNATIVE_LOG_LEVEL=...
+ *
+ * Per-frame events don't belong in the log at any level; record them in
+ * a trace ring instead (see common/trace.h).
+ *
+ * On the Linux host (benchmarks) the same macros print to stderr.
+ *
+ * Lookup: "__android_log_print", "android_LogPriority", "NDEBUG"
+ */
+
+#ifndef NATIVE_COMMON_LOG_H
+#define NATIVE_COMMON_LOG_H
+
+// Same values as android_LogPriority
+#define NATIVE_LOG_VERBOSE 2
+#define NATIVE_LOG_DEBUG 3
+#define NATIVE_LOG_INFO 4
+#define NATIVE_LOG_WARN 5
+#define NATIVE_LOG_ERROR 6
+
+#ifndef NATIVE_LOG_LEVEL
+#ifdef NDEBUG
+#define NATIVE_LOG_LEVEL NATIVE_LOG_INFO
+#else
+#define NATIVE_LOG_LEVEL NATIVE_LOG_DEBUG
+#endif
+#endif
+
+#ifndef LOG_TAG
+#error "Define LOG_TAG before including common/log.h"
+#endif
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define NATIVE_LOG_PRINT(priority, ...) __android_log_print(priority, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define NATIVE_LOG_PRINT(priority, ...) \
+    (fprintf(stderr, "%c/%s: ", "??VDIWE"[priority], LOG_TAG), \
+     fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+// do/while(0) so "if (x) LOGD(...); else ..." parses as expected
+#define NATIVE_LOG_AT(priority, ...)                 \
+    do {                                             \
+        if ((priority) >= NATIVE_LOG_LEVEL) {        \
+            NATIVE_LOG_PRINT(priority, __VA_ARGS__); \
+        }                                            \
+    } while (0)
+
+#define LOGV(...) NATIVE_LOG_AT(NATIVE_LOG_VERBOSE, __VA_ARGS__)
+#define LOGD(...) NATIVE_LOG_AT(NATIVE_LOG_DEBUG, __VA_ARGS__)
+#define LOGI(...) NATIVE_LOG_AT(NATIVE_LOG_INFO, __VA_ARGS__)
+#define LOGW(...) NATIVE_LOG_AT(NATIVE_LOG_WARN, __VA_ARGS__)
+#define LOGE(...) NATIVE_LOG_AT(NATIVE_LOG_ERROR, __VA_ARGS__)
+
+#endif // NATIVE_COMMON_LOG_H
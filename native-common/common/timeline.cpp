@@ -0,0 +1,55 @@
+/**
+ * common/timeline.cpp: Fixed-timestep animation clock
+ */
+
+#include "timeline.h"
+
+#include <algorithm>
+#include <climits>
+#include <time.h>
+
+namespace timeline {
+
+Timeline::Timeline(int64_t stepNanos, int64_t maxFrameNanos)
+    : m_stepNanos(std::max<int64_t>(stepNanos, 1)),
+      m_maxFrameNanos(std::max(maxFrameNanos, m_stepNanos)) {}
+
+void Timeline::reset() {
+    m_started = false;
+    m_accumulator = 0;
+}
+
+int Timeline::advance(int64_t nowNanos) {
+    m_stats.frames++;
+    if (!m_started) {
+        m_started = true;
+        m_lastNanos = nowNanos;
+        return 0;
+    }
+
+    // Monotonic timestamps never go backwards, but a caller mixing
+    // sources (vsync time vs "now") could hand in a slightly older one
+    int64_t elapsed = std::max<int64_t>(nowNanos - m_lastNanos, 0);
+    m_lastNanos = std::max(m_lastNanos, nowNanos);
+    if (elapsed > m_maxFrameNanos) {
+        m_stats.droppedNanos += elapsed - m_maxFrameNanos;
+        elapsed = m_maxFrameNanos;
+    }
+
+    m_accumulator += elapsed;
+    int64_t steps = m_accumulator / m_stepNanos;
+    m_accumulator -= steps * m_stepNanos;
+
+    int count = static_cast<int>(std::min<int64_t>(steps, INT_MAX));
+    m_stats.steps += count;
+    m_stats.maxSteps = std::max(m_stats.maxSteps, count);
+    return count;
+}
+
+int64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+} // namespace timeline
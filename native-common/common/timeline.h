@@ -0,0 +1,110 @@
+/**
+ * common/timeline.h: Fixed-timestep animation clock
+ *
+ * Moving something "a bit per frame" ties its speed to the frame rate:
+ * the same code runs 1.5x faster on a 90 Hz panel, 2x on 120 Hz, and
+ * every dropped frame is a step that never happens, so the animation
+ * falls further behind the wall clock with each hitch.
+ *
+ * FIXED TIMESTEP: the simulation only ever advances in steps of exactly
+ * stepNanos (say 1/120 s). Each frame adds the real time since the last
+ * frame (from CLOCK_MONOTONIC) to an ACCUMULATOR, and runs as many whole
+ * steps as fit into it; the remainder waits for the next frame.
+ *
+ *     int steps = timeline.advance(timeline::monotonicNanos());
+ *     for (int i = 0; i < steps; i++) {
+ *         previous = current;
+ *         step(current, timeline.stepSeconds());
+ *     }
+ *     draw(interpolate(previous, current, timeline.alpha()));
+ *
+ * - The same number of steps happen per second at any refresh rate, with
+ *   the same dt, so the motion is identical (bit for bit, at the same
+ *   simulated time) at 60, 90 or 120 Hz.
+ * - A frame that comes late runs more steps and is back on schedule:
+ *   a dropped frame is a visible jump, not a permanent lag.
+ *
+ * INTERPOLATION: a frame usually lands between two steps. Drawing the
+ * newest state as is would stutter (some frames show 1 step of motion,
+ * some 0 or 2). Instead draw previous + (current - previous) x alpha,
+ * where alpha is the leftover fraction of a step. That shows the state
+ * up to one step in the past, in exchange for smooth motion.
+ *
+ * SPIRAL OF DEATH: if a step ever costs more than it simulates, catching
+ * up makes the next frame later still. After a long stall (debugger,
+ * screen off, a huge hitch) the elapsed time is therefore capped at
+ * maxFrameNanos; the rest is dropped and counted. Pausing is different:
+ * reset() so the time away isn't simulated at all.
+ *
+ * Pure arithmetic on timestamps handed in, no Android and no threads:
+ * one Timeline per thread that drives an animation.
+ *
+ * Lookup: "fix your timestep", "fixed timestep accumulator interpolation",
+ *         "spiral of death game loop"
+ */
+
+#ifndef NATIVE_COMMON_TIMELINE_H
+#define NATIVE_COMMON_TIMELINE_H
+
+#include <cstdint>
+
+namespace timeline {
+
+static const int64_t kDefaultStepNanos = 1000000000LL / 120;   // 120 Hz simulation
+static const int64_t kDefaultMaxFrameNanos = 250000000LL;      // Catch up at most 250 ms
+
+struct TimelineStats {
+    int64_t frames = 0;        // advance() calls
+    int64_t steps = 0;         // Fixed steps handed out
+    int maxSteps = 0;          // Most steps in one advance()
+    int64_t droppedNanos = 0;  // Elapsed time thrown away by the maxFrameNanos cap
+};
+
+class Timeline {
+public:
+    explicit Timeline(int64_t stepNanos = kDefaultStepNanos,
+                      int64_t maxFrameNanos = kDefaultMaxFrameNanos);
+
+    // Forget the last timestamp (and any leftover fraction of a step):
+    // the next advance() starts counting from its own timestamp
+    void reset();
+
+    // A frame at `nowNanos` (CLOCK_MONOTONIC). Returns how many fixed
+    // steps to run before drawing it. The first call after construction
+    // or reset() only sets the starting point and returns 0.
+    int advance(int64_t nowNanos);
+
+    // How far this frame is from the previous state towards the current
+    // one, in [0, 1): the accumulator's leftover over one step
+    float alpha() const {
+        return static_cast<float>(static_cast<double>(m_accumulator) / m_stepNanos);
+    }
+
+    int64_t stepNanos() const { return m_stepNanos; }
+    float stepSeconds() const { return static_cast<float>(m_stepNanos / 1e9); }
+
+    // Simulated time so far: steps x stepNanos (survives reset())
+    int64_t simulatedNanos() const { return m_stats.steps * m_stepNanos; }
+
+    TimelineStats stats() const { return m_stats; }
+
+private:
+    int64_t m_stepNanos;
+    int64_t m_maxFrameNanos;
+    int64_t m_lastNanos = 0;
+    bool m_started = false;
+    int64_t m_accumulator = 0;   // Elapsed time not yet simulated, < one step after advance()
+    TimelineStats m_stats;
+};
+
+// CLOCK_MONOTONIC in nanoseconds (what frame timestamps are measured in)
+int64_t monotonicNanos();
+
+// a + (b - a) x t
+inline float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+} // namespace timeline
+
+#endif // NATIVE_COMMON_TIMELINE_H
@@ -0,0 +1,124 @@
+/**
+ * common/trace.cpp: Binary event trace, formatted later
+ */
+
+#include "trace.h"
+
+#include <cstdio>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace trace {
+
+static_assert((kTraceCapacity & (kTraceCapacity - 1)) == 0,
+              "ring index is masked, capacity must be a power of two");
+
+// Sequence number of a slot once event `index` is complete
+static uint64_t completeSequence(uint64_t index) {
+    return 2 * index + 2;
+}
+
+static int64_t monotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+// Kernel thread id (what systrace/logcat show), looked up once per thread
+static uint32_t currentThread() {
+    static thread_local uint32_t tid = 0;
+    if (tid == 0) {
+        tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    }
+    return tid;
+}
+
+TraceRing::TraceRing(const EventInfo* events, uint32_t eventCount)
+    : m_events(events), m_eventCount(eventCount) {}
+
+void TraceRing::record(uint32_t id, int32_t a0, int32_t a1, int32_t a2, int32_t a3) {
+    int64_t nanos = monotonicNanos();
+    uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_slots[index & (kTraceCapacity - 1)];
+
+    // Take the slot over from whichever older event finished in it. If a
+    // writer is still busy with it (odd), or a newer lap already claimed
+    // it, give up on this event instead of waiting. drain() will find the
+    // slot doesn't hold this index and count the event as lost.
+    uint64_t current = slot.sequence.load(std::memory_order_relaxed);
+    if ((current & 1) || current > 2 * index ||
+        !slot.sequence.compare_exchange_strong(current, 2 * index + 1,
+                                               std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.nanos.store(nanos, std::memory_order_relaxed);
+    slot.id.store(id, std::memory_order_relaxed);
+    slot.thread.store(currentThread(), std::memory_order_relaxed);
+    slot.args[0].store(a0, std::memory_order_relaxed);
+    slot.args[1].store(a1, std::memory_order_relaxed);
+    slot.args[2].store(a2, std::memory_order_relaxed);
+    slot.args[3].store(a3, std::memory_order_relaxed);
+
+    slot.sequence.store(completeSequence(index), std::memory_order_release);
+}
+
+size_t TraceRing::drain(LineSink sink, void* user) {
+    std::lock_guard<std::mutex> guard(m_drainLock);
+
+    uint64_t end = m_head.load(std::memory_order_acquire);
+    if (end - m_drained > kTraceCapacity) {
+        // Overwritten before anyone looked at them
+        m_lost.fetch_add(end - kTraceCapacity - m_drained, std::memory_order_relaxed);
+        m_drained = end - kTraceCapacity;
+    }
+
+    size_t lines = 0;
+    char message[160];
+    char line[256];
+    for (; m_drained < end; m_drained++) {
+        const Slot& slot = m_slots[m_drained & (kTraceCapacity - 1)];
+        const uint64_t complete = completeSequence(m_drained);
+
+        // Still being written (or dropped, or already lapped): skip it.
+        // An in-progress event is not waited for; it's counted as lost.
+        if (slot.sequence.load(std::memory_order_acquire) != complete) {
+            m_lost.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        int64_t nanos = slot.nanos.load(std::memory_order_relaxed);
+        uint32_t id = slot.id.load(std::memory_order_relaxed);
+        uint32_t thread = slot.thread.load(std::memory_order_relaxed);
+        int32_t args[4];
+        for (int i = 0; i < 4; i++) {
+            args[i] = slot.args[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != complete) {
+            m_lost.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Formatting happens here, far from the thread that recorded it
+        if (id < m_eventCount) {
+            snprintf(message, sizeof(message), m_events[id].format,
+                     args[0], args[1], args[2], args[3]);
+            snprintf(line, sizeof(line), "%lld.%06lld tid %u %s: %s",
+                     static_cast<long long>(nanos / 1000000000LL),
+                     static_cast<long long>(nanos % 1000000000LL / 1000), thread,
+                     m_events[id].name, message);
+        } else {
+            snprintf(line, sizeof(line), "%lld.%06lld tid %u event %u: %d %d %d %d",
+                     static_cast<long long>(nanos / 1000000000LL),
+                     static_cast<long long>(nanos % 1000000000LL / 1000), thread, id,
+                     args[0], args[1], args[2], args[3]);
+        }
+        sink(line, user);
+        lines++;
+    }
+    return lines;
+}
+
+} // namespace trace
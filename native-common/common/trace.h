@@ -0,0 +1,101 @@
+/**
+ * common/trace.h: Binary event trace, formatted later
+ *
+ * Logging a per-frame event means formatting a string and writing it to
+ * logd, every frame, on the render thread. A trace record is the same
+ * information as numbers: {timestamp, thread, event id, 4 int args},
+ * 32 bytes copied into a fixed ring. Turning it into text happens later,
+ * on whichever thread calls drain() (on demand, or a background thread),
+ * using a printf format looked up by event id.
+ *
+ *     enum { kTraceFrame };
+ *     static const trace::EventInfo kEvents[] = {
+ *         {"frame", "%dx%d stride %d format %d"},
+ *     };
+ *     static trace::TraceRing g_trace(kEvents, 1);
+ *
+ *     g_trace.record(kTraceFrame, width, height, stride, format);  // hot path
+ *     g_trace.drain(printLine, nullptr);                           // later
+ *
+ * RECORDING is wait-free and never allocates, from any number of threads:
+ * a writer claims the next index with one fetch_add, then owns the slot
+ * through a per-slot sequence number (the same seqlock idea as
+ * phase3's frame/frame_timing.h, extended to several writers). If the
+ * slot's previous writer is somehow still busy with it (preempted for a
+ * whole lap of the ring), the new event is dropped rather than waited on.
+ *
+ * DRAINING formats every event recorded since the previous drain, oldest
+ * first. The ring keeps the last kTraceCapacity events; anything older
+ * that was never drained is counted in lost().
+ *
+ * Lookup: "ftrace ring buffer", "Perfetto track event", "seqlock"
+ */
+
+#ifndef NATIVE_COMMON_TRACE_H
+#define NATIVE_COMMON_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace trace {
+
+// One row of an event table. format receives the record's 4 int args
+// (printf ignores the ones it doesn't use).
+struct EventInfo {
+    const char* name;
+    const char* format;
+};
+
+// What drain() hands out: one formatted line (no trailing newline)
+using LineSink = void (*)(const char* line, void* user);
+
+static const size_t kTraceCapacity = 1024;  // Power of two
+
+class TraceRing {
+public:
+    // events[id] describes event id; the table must outlive the ring
+    TraceRing(const EventInfo* events, uint32_t eventCount);
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    // HOT PATH: store one event (any thread, wait-free, no allocation)
+    void record(uint32_t id, int32_t a0 = 0, int32_t a1 = 0, int32_t a2 = 0, int32_t a3 = 0);
+
+    // Format and hand out every event since the last drain, oldest first.
+    // Drains are serialized with a mutex that writers never touch.
+    // Returns the number of lines produced.
+    size_t drain(LineSink sink, void* user);
+
+    uint64_t recorded() const { return m_head.load(std::memory_order_acquire); }
+
+    // Events drain() couldn't deliver: dropped, overwritten before a
+    // drain, or still being written when the drain reached them
+    uint64_t lost() const { return m_lost.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        // 2 * index + 1 while event `index` is being written, 2 * index + 2
+        // once complete
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<int64_t> nanos{0};
+        std::atomic<uint32_t> id{0};
+        std::atomic<uint32_t> thread{0};
+        std::atomic<int32_t> args[4] = {};
+    };
+
+    const EventInfo* m_events;
+    uint32_t m_eventCount;
+
+    Slot m_slots[kTraceCapacity];
+    std::atomic<uint64_t> m_head{0};     // Next index to claim
+    std::atomic<uint64_t> m_lost{0};     // Counted by drain()
+
+    std::mutex m_drainLock;              // Readers only
+    uint64_t m_drained = 0;              // First index not yet drained
+};
+
+} // namespace trace
+
+#endif // NATIVE_COMMON_TRACE_H
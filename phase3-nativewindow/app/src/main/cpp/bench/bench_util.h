@@ -0,0 +1,77 @@
+/**
+ * bench/bench_util.h: Shared helpers for the host benchmarks
+ *
+ * The host benchmarks are plain executables (no framework) so they build
+ * anywhere CMake and a C++17 compiler do. Each one prints a small table
+ * that can be pasted into DISCUSSION.md.
+ */
+
+#ifndef PHASE3_BENCH_UTIL_H
+#define PHASE3_BENCH_UTIL_H
+
+#include "../raster/surface.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace bench {
+
+// The display sizes we care about (landscape; portrait costs the same)
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+static const Resolution kResolutions[] = {
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4K", 3840, 2160},
+};
+
+// Monotonic wall clock in seconds
+inline double nowSeconds() {
+    using Clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
+
+// A heap-backed stand-in for a locked ANativeWindow_Buffer
+//
+// stride can be larger than width to mimic gralloc row padding. The
+// storage is uint32_t words whatever the format (a 565 buffer just packs
+// two pixels per word).
+struct PixelBuffer {
+    std::vector<uint32_t> pixels;
+    raster::Surface surface;
+
+    PixelBuffer(int width, int height, int stride = 0,
+                raster::PixelFormat format = raster::PixelFormat::RGBA_8888) {
+        if (stride < width) {
+            stride = width;
+        }
+        size_t bytes = static_cast<size_t>(stride) * height * raster::bytesPerPixel(format);
+        pixels.assign((bytes + 3) / 4, 0);
+        surface.bits = pixels.data();
+        surface.width = width;
+        surface.height = height;
+        surface.stride = stride;
+        surface.format = format;
+    }
+};
+
+// Read "argv[index]" as a positive int, or fall back to a default
+inline int intArg(int argc, char** argv, int index, int fallback) {
+    if (index < argc) {
+        int value = std::atoi(argv[index]);
+        if (value > 0) {
+            return value;
+        }
+    }
+    return fallback;
+}
+
+} // namespace bench
+
+#endif // PHASE3_BENCH_UTIL_H
@@ -0,0 +1,218 @@
+/**
+ * bench/binning_bench.cpp: Per-tile command binning vs walking the whole list
+ *
+ * Renders N random shapes on a 1080p buffer three ways, single-threaded so
+ * only memory behavior differs:
+ * - full:     one executeDisplayList() over the whole screen. Each shape
+ *             touches its own scattered rows of the 8 MB buffer.
+ * - walk-all: one executeDisplayList() per 64x64 tile (the pre-binning
+ *             TileRenderer). Pixels stay in L1, but every tile tests every
+ *             command's bounds.
+ * - binned:   TileRenderer with its TileBinner. Pixels stay in L1 AND each
+ *             tile only sees the commands that overlap it.
+ *
+ * Each mode's speed is printed against both others' baselines: "vs full"
+ * is whether tiling pays at all, "vs walk" is what binning saves over
+ * the old TileRenderer. Binning splits each shape into ~2.2 clipped
+ * per-tile calls (the "tiles per shape" line), and on a machine whose
+ * last-level cache holds the whole 8 MB frame that overhead can cost
+ * more than L1-resident tiles save: there, binned is slower than full.
+ *
+ * Cache misses come from perf_event_open (PERF_COUNT_HW_CACHE_MISSES, i.e.
+ * last-level misses). Containers and locked-down kernels often forbid it;
+ * the column then shows "n/a" and the cache side isn't measured at all.
+ *
+ * The binned output must match the full-screen replay exactly.
+ *
+ * Usage: binning_bench [frames]
+ *
+ * Lookup: "perf_event_open", "tile binning"
+ */
+
+#include "bench_util.h"
+#include "../raster/display_list.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ========== CACHE MISS COUNTER ==========
+
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~CacheMissCounter() {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    bool available() const { return m_fd >= 0; }
+
+    void start() {
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // Misses since start(), or -1 if the counter is unavailable
+    long long stop() {
+        long long count = -1;
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+                count = -1;
+            }
+        }
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+// ========== SCENE ==========
+
+static void recordShapes(raster::DisplayList& list, int count, int width, int height,
+                         uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(0.0f, static_cast<float>(width));
+    std::uniform_real_distribution<float> y(0.0f, static_cast<float>(height));
+    std::uniform_real_distribution<float> size(2.0f, 40.0f);
+
+    list.clear(0xFF14141E);
+    for (int i = 0; i < count; i++) {
+        uint32_t argb = 0xFF000000u | (rng() & 0xFFFFFF);
+        if (i % 2 == 0) {
+            list.fillCircle(x(rng), y(rng), size(rng), argb);
+        } else {
+            int left = static_cast<int>(x(rng));
+            int top = static_cast<int>(y(rng));
+            list.fillRect(raster::makeRect(left, top, left + static_cast<int>(size(rng)),
+                                           top + static_cast<int>(size(rng))), argb);
+        }
+    }
+}
+
+// Per-tile replay of the whole list (how TileRenderer worked before binning)
+static void renderWalkAll(const raster::Surface& surface, const raster::DisplayList& list,
+                          int tileSize) {
+    for (int ty = 0; ty < surface.height; ty += tileSize) {
+        for (int tx = 0; tx < surface.width; tx += tileSize) {
+            raster::executeDisplayList(surface, list,
+                                       raster::makeRect(tx, ty, tx + tileSize, ty + tileSize));
+        }
+    }
+}
+
+struct Result {
+    double ms;
+    long long misses;
+};
+
+static Result measure(int frames, CacheMissCounter& counter,
+                      const std::function<void()>& renderFrame) {
+    renderFrame();  // Warm up
+
+    counter.start();
+    double start = bench::nowSeconds();
+    for (int frame = 0; frame < frames; frame++) {
+        renderFrame();
+    }
+    double elapsed = bench::nowSeconds() - start;
+    long long misses = counter.stop();
+
+    return {elapsed * 1000.0 / frames, misses < 0 ? -1 : misses / frames};
+}
+
+static void printResult(int count, const char* mode, const Result& result, double fullMs,
+                        double walkMs) {
+    char misses[32];
+    if (result.misses < 0) {
+        snprintf(misses, sizeof(misses), "n/a");
+    } else {
+        snprintf(misses, sizeof(misses), "%lld", result.misses);
+    }
+    printf("%8d %-9s %10.3f %12.2f %8.2fx %8.2fx %14s\n", count, mode, result.ms,
+           count / (result.ms * 1000.0), fullMs / result.ms, walkMs / result.ms, misses);
+}
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 10);
+    const int width = 1920;
+    const int height = 1080;
+    const int tileSize = raster::TileRenderer::kDefaultTileSize;
+
+    raster::FrameArena arena(1 << 20);
+    raster::DisplayList list(arena);
+    raster::ThreadPool pool(1);
+    raster::TileRenderer tiles(pool, tileSize);
+    CacheMissCounter counter;
+
+    bench::PixelBuffer full(width, height);
+    bench::PixelBuffer binned(width, height);
+
+    printf("binning_bench: %dx%d, %dx%d tiles, 1 thread, %d frames per row\n",
+           width, height, tileSize, tileSize, frames);
+    if (!counter.available()) {
+        printf("(perf_event_open unavailable: cache misses not measured)\n");
+    }
+    printf("\n%8s %-9s %10s %12s %9s %9s %14s\n", "shapes", "mode", "ms/frame",
+           "Mshapes/s", "vs full", "vs walk", "misses/frame");
+
+    const int counts[] = {1000, 10000, 100000};
+    for (int count : counts) {
+        arena.reset();
+        list.reset();
+        recordShapes(list, count, width, height, 1234 + count);
+
+        // VERIFY: binned == full-screen replay
+        raster::executeDisplayList(full.surface, list, raster::makeRect(0, 0, width, height));
+        tiles.render(binned.surface, list);
+        if (full.pixels != binned.pixels) {
+            fprintf(stderr, "MISMATCH: binned render differs from full replay (%d shapes)\n",
+                    count);
+            return 1;
+        }
+
+        Result fullResult = measure(frames, counter, [&] {
+            raster::executeDisplayList(full.surface, list, raster::makeRect(0, 0, width, height));
+        });
+        Result walkResult = measure(frames, counter, [&] {
+            renderWalkAll(full.surface, list, tileSize);
+        });
+        Result binnedResult = measure(frames, counter, [&] {
+            tiles.render(binned.surface, list);
+        });
+
+        printResult(count, "full", fullResult, fullResult.ms, walkResult.ms);
+        printResult(count, "walk-all", walkResult, fullResult.ms, walkResult.ms);
+        printResult(count, "binned", binnedResult, fullResult.ms, walkResult.ms);
+        printf("%8s binned %zu entries (%.2f tiles per shape)\n\n", "",
+               tiles.binner().binnedCount(),
+               static_cast<double>(tiles.binner().binnedCount()) / (count + 1));
+    }
+
+    printf("verify: binned output matches full replay at every size\n");
+    return 0;
+}
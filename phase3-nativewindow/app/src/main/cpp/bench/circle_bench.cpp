@@ -0,0 +1,103 @@
+/**
+ * bench/circle_bench.cpp: Scanline fillCircle() vs the per-pixel loop
+ *
+ * 1. VERIFY: draws thousands of circles (fractional centers, clipped at
+ *    every edge, padded stride) with both fillCircle() and the original
+ *    drawCircleReference() and requires identical pixels.
+ * 2. BENCHMARK: time per circle for radii 8..2000 px on a 4K buffer.
+ *
+ * Exits non-zero if any pixel differs.
+ *
+ * Usage: circle_bench [iterations]
+ */
+
+#include "bench_util.h"
+#include "../raster/raster.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+static bool verify() {
+    // Odd size and padded stride so row math and clipping both get exercised
+    bench::PixelBuffer expected(333, 217, 349);
+    bench::PixelBuffer actual(333, 217, 349);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-120.0f, 460.0f);
+    std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+    const float radii[] = {0.0f, 0.5f, 1.0f, 1.5f, 2.0f, 3.3f, 8.0f, 31.7f,
+                           80.0f, 150.25f, 400.0f, 2000.0f};
+
+    int checked = 0;
+    for (float radius : radii) {
+        for (int i = 0; i < 400; i++) {
+            float cx = position(rng);
+            float cy = position(rng);
+            // Also hit exact integer and half-pixel centers
+            if (i % 4 == 0) {
+                cx = static_cast<float>(static_cast<int>(cx));
+            } else if (i % 4 == 1) {
+                cy = static_cast<int>(cy) + 0.5f;
+            }
+            float r = radius + (i % 3 == 0 ? fraction(rng) : 0.0f);
+
+            raster::clearSurface(expected.surface, 0);
+            raster::clearSurface(actual.surface, 0);
+            raster::drawCircleReference(expected.surface, cx, cy, r, 0xFFFFFFFF);
+            raster::fillCircle(actual.surface, cx, cy, r, 0xFFFFFFFF);
+
+            if (expected.pixels != actual.pixels) {
+                fprintf(stderr, "MISMATCH: cx=%.9g cy=%.9g r=%.9g\n", cx, cy, r);
+                return false;
+            }
+            checked++;
+        }
+    }
+
+    printf("verify: %d circles pixel-identical to the per-pixel loop\n\n", checked);
+    return true;
+}
+
+template <typename DrawFn>
+static double microsPerCircle(const raster::Surface& surface, float radius,
+                              int iterations, DrawFn draw) {
+    const float cx = surface.width / 2.0f + 0.3f;
+    const float cy = surface.height / 2.0f + 0.7f;
+
+    draw(surface, cx, cy, radius, 0xFF00FF00u);  // Warm up
+
+    double start = bench::nowSeconds();
+    for (int i = 0; i < iterations; i++) {
+        draw(surface, cx, cy, radius, 0xFF000000u | static_cast<uint32_t>(i));
+    }
+    return (bench::nowSeconds() - start) * 1e6 / iterations;
+}
+
+int main(int argc, char** argv) {
+    if (!verify()) {
+        return 1;
+    }
+
+    const int baseIterations = bench::intArg(argc, argv, 1, 2000);
+    bench::PixelBuffer buffer(3840, 2160);
+    const float radii[] = {8, 16, 32, 80, 128, 256, 512, 1000, 2000};
+
+    printf("%8s %14s %14s %9s\n", "radius", "per-pixel us", "scanline us", "speedup");
+    for (float radius : radii) {
+        // Keep total work roughly constant across radii
+        int iterations = std::max(3, static_cast<int>(baseIterations * 64 / radius));
+
+        double reference = microsPerCircle(buffer.surface, radius, iterations,
+                                           raster::drawCircleReference);
+        double scanline = microsPerCircle(
+                buffer.surface, radius, iterations,
+                [](const raster::Surface& surface, float cx, float cy, float r, uint32_t color) {
+                    raster::fillCircle(surface, cx, cy, r, color);
+                });
+        printf("%8.0f %14.2f %14.2f %8.1fx\n",
+               radius, reference, scanline, reference / scanline);
+    }
+
+    return 0;
+}
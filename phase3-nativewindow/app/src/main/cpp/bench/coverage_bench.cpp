@@ -0,0 +1,304 @@
+/**
+ * bench/coverage_bench.cpp: Anti-aliased circle vs the aliased scanline fill
+ *
+ * Checked (exit code 1 on failure):
+ * - kernels: every coverage kernel this CPU runs (raster/coverage.h)
+ *            produces the scalar kernel's coverage bytes and blended
+ *            pixels exactly, on random rows of every length and offset,
+ *            and the same whole circles in RGBA_8888 and RGB_565, clipped
+ *            anywhere.
+ * - accuracy: white circles on black, the coverage fillCircleAA() gives
+ *            each pixel against its true area (16 x 16 samples per pixel).
+ * - seams:   a circle drawn 64 x 64 tile by tile equals the same circle
+ *            drawn in one call, for RGBA_8888 and RGB_565.
+ * - cost:    a circle the scene's size takes at most 10% longer with
+ *            fillCircleAA() than with fillCircle(). Damage tracking
+ *            repaints little more than the circle, so this is the frame's
+ *            cost too. Other sizes are printed, not checked.
+ *
+ * Usage: coverage_bench [iterations]
+ */
+
+#include "bench_util.h"
+#include "../raster/coverage.h"
+#include "../raster/fill.h"
+#include "../raster/raster.h"
+#include "../raster/scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Both pixel sizes of a buffer, random contents
+struct CircleBuffers {
+    static const int kWidth = 96;
+    static const int kHeight = 72;
+    static const int kStride = 101;
+    uint32_t pixels[kStride * kHeight];
+    uint16_t pixels565[kStride * kHeight];
+};
+
+// `rows` of a circle drawn by `kernel` into both of `buffers`
+static void drawCircle(const raster::CoverageKernel& kernel, CircleBuffers& buffers,
+                       const raster::CircleRows& rows, uint32_t color) {
+    kernel.circleRows(buffers.pixels, CircleBuffers::kStride, rows, color);
+    kernel.circleRows565(buffers.pixels565, CircleBuffers::kStride, rows,
+                         static_cast<uint16_t>(color));
+}
+
+static bool checkKernels() {
+    size_t count = 0;
+    const raster::CoverageKernel* kernels = raster::supportedCoverageKernels(&count);
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> center(-50.0f, 250.0f);
+    std::uniform_real_distribution<float> radius(0.0f, 120.0f);
+    std::uniform_int_distribution<uint32_t> bits;
+
+    std::uniform_real_distribution<float> circleCenter(-30.0f, 126.0f);
+    std::uniform_real_distribution<float> circleRadius(0.0f, 70.0f);
+
+    bool ok = true;
+    for (size_t k = 1; k < count; k++) {
+        int checked = 0;
+        int circles = 0;
+        for (int trial = 0; trial < 4000; trial++) {
+            int length = trial % 37;
+            int x0 = static_cast<int>(center(rng));
+            float cx = center(rng);
+            float dy = center(rng) * 0.5f;
+            float outer = radius(rng) + 0.5f;
+
+            uint8_t expected[64];
+            uint8_t actual[64];
+            raster::circleCoverageScalar(expected, x0, length, cx, dy * dy, outer);
+            kernels[k].circleCoverage(actual, x0, length, cx, dy * dy, outer);
+
+            // Random coverage too, so 0 / 255 / partial mixes all show up
+            if (trial % 2) {
+                for (int i = 0; i < length; i++) {
+                    uint32_t value = bits(rng) % 3 == 0 ? 255 : bits(rng);
+                    expected[i] = actual[i] = static_cast<uint8_t>(value);
+                }
+            }
+            uint32_t color = bits(rng);
+            uint32_t want[64];
+            uint32_t got[64];
+            for (int i = 0; i < length; i++) {
+                want[i] = got[i] = bits(rng);
+            }
+            raster::blendCoverageScalar(want, expected, length, color);
+            kernels[k].blendCoverage(got, actual, length, color);
+
+            if (memcmp(expected, actual, length) != 0 ||
+                memcmp(want, got, length * sizeof(uint32_t)) != 0) {
+                fprintf(stderr, "MISMATCH: %s, length %d, x0 %d\n", kernels[k].name, length, x0);
+                ok = false;
+                break;
+            }
+            checked++;
+        }
+
+        static CircleBuffers want;
+        static CircleBuffers got;
+        for (int trial = 0; ok && trial < 2000; trial++) {
+            for (size_t i = 0; i < sizeof(want.pixels) / sizeof(want.pixels[0]); i++) {
+                want.pixels[i] = got.pixels[i] = bits(rng);
+                want.pixels565[i] = got.pixels565[i] = static_cast<uint16_t>(bits(rng));
+            }
+            raster::CircleRows rows;
+            rows.cx = circleCenter(rng);
+            rows.cy = circleCenter(rng) * 0.75f;
+            rows.outerRadius = circleRadius(rng) + 0.5f;
+            const int width = CircleBuffers::kWidth;
+            const int height = CircleBuffers::kHeight;
+            rows.minX = static_cast<int>(bits(rng) % width);
+            rows.maxX = rows.minX + static_cast<int>(bits(rng) % (width - rows.minX));
+            rows.minY = static_cast<int>(bits(rng) % height);
+            rows.maxY = rows.minY + static_cast<int>(bits(rng) % (height - rows.minY));
+            uint32_t color = bits(rng);
+            drawCircle(kernels[0], want, rows, color);
+            drawCircle(kernels[k], got, rows, color);
+            if (memcmp(want.pixels, got.pixels, sizeof(want.pixels)) != 0 ||
+                memcmp(want.pixels565, got.pixels565, sizeof(want.pixels565)) != 0) {
+                fprintf(stderr, "MISMATCH: %s, circle cx=%.9g cy=%.9g outer=%.9g\n",
+                        kernels[k].name, rows.cx, rows.cy, rows.outerRadius);
+                ok = false;
+            }
+            circles++;
+        }
+        printf("  %-6s %d rows and %d clipped circles identical to scalar\n", kernels[k].name,
+               checked, circles);
+    }
+    return ok;
+}
+
+// True fraction of pixel (x, y) inside the circle: 16 x 16 samples over
+// [x - 0.5, x + 0.5) x [y - 0.5, y + 0.5) (pixels sample at their integer
+// coordinates, like fillCircle())
+static float pixelArea(int x, int y, float cx, float cy, float radius) {
+    int inside = 0;
+    for (int sy = 0; sy < 16; sy++) {
+        for (int sx = 0; sx < 16; sx++) {
+            float dx = x - 0.5f + (sx + 0.5f) / 16.0f - cx;
+            float dy = y - 0.5f + (sy + 0.5f) / 16.0f - cy;
+            inside += dx * dx + dy * dy <= radius * radius;
+        }
+    }
+    return inside / 256.0f;
+}
+
+static bool checkAccuracy() {
+    const float radii[] = {2.5f, 8.0f, 31.7f, 80.0f, 150.25f};
+    bench::PixelBuffer buffer(360, 360);
+    double sum = 0.0;
+    int edgePixels = 0;
+    int worst = 0;
+    for (float radius : radii) {
+        for (int i = 0; i < 8; i++) {
+            float cx = 180.0f + i * 0.13f;
+            float cy = 180.0f + i * 0.29f;
+            raster::clearSurface(buffer.surface, 0xFF000000);
+            raster::fillCircleAA(buffer.surface, cx, cy, radius, 0xFFFFFFFF,
+                                 raster::makeRect(0, 0, 360, 360));
+            for (int y = 0; y < 360; y++) {
+                for (int x = 0; x < 360; x++) {
+                    float area = pixelArea(x, y, cx, cy, radius);
+                    int drawn = raster::rowPointer(buffer.surface, y)[x] & 0xFF;
+                    int error = std::abs(drawn - static_cast<int>(area * 255.0f + 0.5f));
+                    if (area > 0.0f && area < 1.0f) {
+                        sum += error;
+                        edgePixels++;
+                    }
+                    worst = std::max(worst, error);
+                }
+            }
+        }
+    }
+    double mean = sum / edgePixels;
+    printf("  %d edge pixels: coverage off by %.1f on average, %d at worst (of 255)\n",
+           edgePixels, mean, worst);
+    // The distance ramp is exact for straight edges at any angle through
+    // the pixel center, and a little off at corners of the pixel square;
+    // tiny circles (r 2.5) are where the curve makes that largest
+    return mean <= 8.0 && worst <= 64;
+}
+
+static bool checkSeams(raster::PixelFormat format) {
+    bench::PixelBuffer whole(301, 203, 320, format);
+    bench::PixelBuffer tiled(301, 203, 320, format);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-40.0f, 340.0f);
+    std::uniform_real_distribution<float> radius(0.0f, 160.0f);
+    for (int i = 0; i < 300; i++) {
+        float cx = position(rng);
+        float cy = position(rng);
+        float r = radius(rng);
+        uint32_t background = raster::packColor(format, 20, 20, 30);
+        uint32_t color = raster::packColor(format, 100, 150, 255);
+        raster::clearSurface(whole.surface, background);
+        raster::clearSurface(tiled.surface, background);
+        raster::fillCircleAA(whole.surface, cx, cy, r, color, raster::makeRect(0, 0, 301, 203));
+        for (int ty = 0; ty < 203; ty += 64) {
+            for (int tx = 0; tx < 301; tx += 64) {
+                raster::fillCircleAA(tiled.surface, cx, cy, r, color,
+                                     raster::makeRect(tx, ty, tx + 64, ty + 64));
+            }
+        }
+        if (whole.pixels != tiled.pixels) {
+            fprintf(stderr, "SEAM: cx=%.9g cy=%.9g r=%.9g\n", cx, cy, r);
+            return false;
+        }
+    }
+    printf("  %-9s 300 circles: tiled == whole\n",
+           format == raster::PixelFormat::RGB_565 ? "RGB_565" : "RGBA_8888");
+    return true;
+}
+
+// Microseconds per circle for `iterations` circles drawn with `draw`
+template <typename DrawFn>
+static double microsPerCircle(const raster::Surface& surface, float radius, int iterations,
+                              DrawFn draw) {
+    const raster::Rect clip = raster::makeRect(0, 0, surface.width, surface.height);
+    double start = bench::nowSeconds();
+    for (int i = 0; i < iterations; i++) {
+        float cx = surface.width / 2.0f + (i % 16) * 0.0625f;
+        float cy = surface.height / 2.0f + (i % 8) * 0.125f;
+        draw(surface, cx, cy, radius, 0xFF000000u | static_cast<uint32_t>(i), clip);
+    }
+    return (bench::nowSeconds() - start) * 1e6 / iterations;
+}
+
+// Best of 9 alternating runs of each: a noisy moment on the machine hits
+// both or neither. Returns the AA cost (aa / aliased - 1).
+template <typename AliasedFn, typename SmoothFn>
+static double compare(const raster::Surface& surface, float radius, int iterations,
+                      AliasedFn aliased, SmoothFn smooth, double* plainMicros,
+                      double* aaMicros) {
+    *plainMicros = 1e30;
+    *aaMicros = 1e30;
+    for (int run = 0; run < 9; run++) {
+        *plainMicros = std::min(*plainMicros,
+                                microsPerCircle(surface, radius, iterations, aliased));
+        *aaMicros = std::min(*aaMicros, microsPerCircle(surface, radius, iterations, smooth));
+    }
+    return *aaMicros / *plainMicros - 1.0;
+}
+
+static bool measureCost(int iterations) {
+    bench::PixelBuffer buffer(1920, 1080);
+    const float sceneRadius =
+            raster::sceneCircle(buffer.surface.width, buffer.surface.height, {}).radius;
+    const float radii[] = {8.0f, 32.0f, sceneRadius, 200.0f, 500.0f};
+    auto aliased = [](const raster::Surface& s, float cx, float cy, float r, uint32_t c,
+                      const raster::Rect& clip) {
+        raster::fillCircle(s, cx, cy, r, c, clip);
+    };
+    auto smooth = [](const raster::Surface& s, float cx, float cy, float r, uint32_t c,
+                     const raster::Rect& clip) {
+        raster::fillCircleAA(s, cx, cy, r, c, clip);
+    };
+
+    double sceneCost = 0.0;
+    printf("%-8s %12s %12s %8s\n", "radius", "aliased us", "AA us", "AA cost");
+    for (float radius : radii) {
+        int n = std::max(1, static_cast<int>(iterations * 80.0f / radius));
+        double plain = 0.0;
+        double aa = 0.0;
+        double cost = compare(buffer.surface, radius, n, aliased, smooth, &plain, &aa);
+        bool scene = radius == sceneRadius;
+        printf("%-8.0f %12.2f %12.2f %+7.1f%%%s\n", radius, plain, aa, 100.0 * cost,
+               scene ? "  (the scene's circle: checked)" : "");
+        if (scene) {
+            sceneCost = cost;
+        }
+    }
+    return sceneCost <= 0.10;
+}
+
+int main(int argc, char** argv) {
+    const int iterations = bench::intArg(argc, argv, 1, 2000);
+    printf("Coverage kernels (active: %s):\n", raster::activeCoverageKernel().name);
+    bool kernelsOk = checkKernels();
+
+    printf("\nCoverage vs true pixel area:\n");
+    bool accuracyOk = checkAccuracy();
+
+    printf("\nTiled vs whole:\n");
+    bool seamsOk = checkSeams(raster::PixelFormat::RGBA_8888) &&
+                   checkSeams(raster::PixelFormat::RGB_565);
+
+    printf("\nfillCircle() vs fillCircleAA() on 1080p RGBA_8888, circle only, best of 9:\n");
+    bool costOk = measureCost(iterations);
+
+    if (!kernelsOk || !accuracyOk || !seamsOk || !costOk) {
+        printf("\nverify: FAILED (kernels %s, accuracy %s, seams %s, cost %s)\n",
+               kernelsOk ? "ok" : "wrong", accuracyOk ? "ok" : "wrong",
+               seamsOk ? "ok" : "wrong", costOk ? "ok" : "over 10%");
+        return 1;
+    }
+    printf("\nverify: kernels agree, coverage tracks area, no seams, AA within 10%%\n");
+    return 0;
+}
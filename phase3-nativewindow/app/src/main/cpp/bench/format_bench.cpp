@@ -0,0 +1,219 @@
+/**
+ * bench/format_bench.cpp: Every pixel format, with and without row padding
+ *
+ * The raster kernels are compiled once per format (RGBA_8888, RGBX_8888,
+ * RGB_565; see raster/pixel_format.h). This renders the same random
+ * display list into each format, at stride == width and at two padded
+ * strides (an odd one, so 565 rows start misaligned), and checks that:
+ * - every visible pixel equals the RGBA_8888 render converted with that
+ *   format's pack(), for the full replay and for the binned tile renderer
+ * - nothing is written to the padding between width and stride
+ *
+ * Then it times a 1080p replay per format.
+ *
+ * Usage: format_bench [frames]
+ */
+
+#include "bench_util.h"
+#include "../raster/display_list.h"
+#include "../raster/pixel_kernels.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const int kSpriteSize = 24;
+static const uint8_t kPaddingByte = 0xA5;
+
+// Sprite colors as Android color ints; each format gets its own packed copy
+static uint32_t g_spriteArgb[kSpriteSize * kSpriteSize];
+
+static void recordScene(raster::DisplayList& list, const void* sprite, int count,
+                        int width, int height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(-40.0f, width + 40.0f);
+    std::uniform_real_distribution<float> y(-40.0f, height + 40.0f);
+    std::uniform_real_distribution<float> size(1.0f, 50.0f);
+
+    list.clear(0xFF14141E);
+    for (int i = 0; i < count; i++) {
+        uint32_t argb = 0xFF000000u | (rng() & 0xFFFFFF);
+        switch (i % 4) {
+            case 0:
+                list.fillCircle(x(rng), y(rng), size(rng), argb);
+                break;
+            case 1: {
+                int left = static_cast<int>(x(rng));
+                int top = static_cast<int>(y(rng));
+                list.fillRect(raster::makeRect(left, top, left + static_cast<int>(size(rng)),
+                                               top + static_cast<int>(size(rng))), argb);
+                break;
+            }
+            case 2: {
+                float x0 = x(rng);
+                float y0 = y(rng);
+                list.line(x0, y0, x0 + 2.0f * size(rng) - 50.0f, y0 + 2.0f * size(rng) - 50.0f,
+                          argb);
+                break;
+            }
+            case 3:
+                list.blit(sprite, kSpriteSize, kSpriteSize, kSpriteSize,
+                          static_cast<int>(x(rng)), static_cast<int>(y(rng)));
+                break;
+        }
+    }
+}
+
+// A buffer whose padding bytes start out as kPaddingByte
+struct PaddedBuffer {
+    std::vector<uint8_t> bytes;
+    raster::Surface surface;
+
+    PaddedBuffer(int width, int height, int stride, raster::PixelFormat format) {
+        bytes.assign(static_cast<size_t>(stride) * height * raster::bytesPerPixel(format),
+                     kPaddingByte);
+        surface.bits = bytes.data();
+        surface.width = width;
+        surface.height = height;
+        surface.stride = stride;
+        surface.format = format;
+    }
+};
+
+// Compare `target` to `reference` (RGBA_8888, stride == width) converted
+// to Format, and check the padding is untouched
+template <class Format>
+static bool matchesReference(const raster::Surface& target, const raster::Surface& reference,
+                             const char* what) {
+    using Pixel = typename Format::Pixel;
+    for (int y = 0; y < target.height; y++) {
+        const uint8_t* ref = static_cast<const uint8_t*>(reference.bits) +
+                             static_cast<size_t>(y) * reference.stride * 4;
+        const Pixel* row = raster::rowPointer<Format>(target, y);
+
+        for (int x = 0; x < target.width; x++) {
+            Pixel expected = Format::pack(ref[x * 4 + 0], ref[x * 4 + 1],
+                                          ref[x * 4 + 2], ref[x * 4 + 3]);
+            if (row[x] != expected) {
+                fprintf(stderr, "MISMATCH (%s): pixel (%d, %d) is 0x%X, expected 0x%X\n",
+                        what, x, y, static_cast<unsigned>(row[x]),
+                        static_cast<unsigned>(expected));
+                return false;
+            }
+        }
+
+        const uint8_t* padding = reinterpret_cast<const uint8_t*>(row + target.width);
+        size_t paddingBytes = static_cast<size_t>(target.stride - target.width) * sizeof(Pixel);
+        for (size_t i = 0; i < paddingBytes; i++) {
+            if (padding[i] != kPaddingByte) {
+                fprintf(stderr, "MISMATCH (%s): row %d padding byte %zu was written\n",
+                        what, y, i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <class Format>
+static bool verifyFormat(const char* name, raster::TileRenderer& tiles) {
+    const int width = 301;  // Odd, so rows and spans end misaligned
+    const int height = 157;
+    const int strides[] = {width, width + 13, width + 64};
+
+    if (!raster::pixelKernels(Format::kFormat)) {
+        fprintf(stderr, "MISSING: no kernels for %s\n", name);
+        return false;
+    }
+
+    // Sprite packed for this format (and for the RGBA reference)
+    std::vector<typename Format::Pixel> sprite(kSpriteSize * kSpriteSize);
+    std::vector<uint32_t> referenceSprite(kSpriteSize * kSpriteSize);
+    for (int i = 0; i < kSpriteSize * kSpriteSize; i++) {
+        sprite[i] = raster::packArgb<Format>(g_spriteArgb[i]);
+        referenceSprite[i] = raster::packArgb<raster::Rgba8888>(g_spriteArgb[i]);
+    }
+
+    raster::FrameArena arena;
+    raster::DisplayList list(arena);
+    raster::DisplayList referenceList(arena);
+    recordScene(list, sprite.data(), 400, width, height, 99);
+    recordScene(referenceList, referenceSprite.data(), 400, width, height, 99);
+
+    bench::PixelBuffer reference(width, height);
+    raster::executeDisplayList(reference.surface, referenceList,
+                               raster::makeRect(0, 0, width, height));
+
+    for (int stride : strides) {
+        PaddedBuffer full(width, height, stride, Format::kFormat);
+        PaddedBuffer tiled(width, height, stride, Format::kFormat);
+        raster::executeDisplayList(full.surface, list, raster::makeRect(0, 0, width, height));
+        tiles.render(tiled.surface, list);
+
+        if (!matchesReference<Format>(full.surface, reference.surface, "full replay") ||
+            !matchesReference<Format>(tiled.surface, reference.surface, "tiled")) {
+            fprintf(stderr, "  in %s, %dx%d, stride %d\n", name, width, height, stride);
+            return false;
+        }
+    }
+
+    printf("verify: %-9s matches the RGBA_8888 render at strides %d/%d/%d\n", name,
+           strides[0], strides[1], strides[2]);
+    return true;
+}
+
+template <class Format>
+static void timeFormat(const char* name, raster::TileRenderer& tiles, int frames) {
+    const int width = 1920;
+    const int height = 1080;
+    const int stride = 1984;  // Typical gralloc padding to a 64-pixel multiple
+
+    std::vector<typename Format::Pixel> sprite(kSpriteSize * kSpriteSize);
+    for (int i = 0; i < kSpriteSize * kSpriteSize; i++) {
+        sprite[i] = raster::packArgb<Format>(g_spriteArgb[i]);
+    }
+
+    raster::FrameArena arena;
+    raster::DisplayList list(arena);
+    recordScene(list, sprite.data(), 2000, width, height, 7);
+
+    PaddedBuffer buffer(width, height, stride, Format::kFormat);
+    tiles.render(buffer.surface, list);  // Warm up
+
+    double start = bench::nowSeconds();
+    for (int frame = 0; frame < frames; frame++) {
+        tiles.render(buffer.surface, list);
+    }
+    double ms = (bench::nowSeconds() - start) * 1000.0 / frames;
+
+    double frameMB = static_cast<double>(width) * height * sizeof(typename Format::Pixel) /
+                     (1024.0 * 1024.0);
+    printf("%-10s %6zu %10.2f %12.3f\n", name, sizeof(typename Format::Pixel), frameMB, ms);
+}
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 30);
+
+    for (int i = 0; i < kSpriteSize * kSpriteSize; i++) {
+        g_spriteArgb[i] = 0xFF000000u | ((i * 7) & 0xFF) << 16 | 0x8000 | (255 - (i & 0xFF));
+    }
+
+    raster::ThreadPool pool(1);
+    raster::TileRenderer tiles(pool);
+
+    if (!verifyFormat<raster::Rgba8888>("RGBA_8888", tiles) ||
+        !verifyFormat<raster::Rgbx8888>("RGBX_8888", tiles) ||
+        !verifyFormat<raster::Rgb565>("RGB_565", tiles)) {
+        return 1;
+    }
+
+    printf("\n1080p, stride 1984, 2000 shapes, 1 thread, %d frames\n", frames);
+    printf("%-10s %6s %10s %12s\n", "format", "bytes", "MB/frame", "ms/frame");
+    timeFormat<raster::Rgba8888>("RGBA_8888", tiles, frames);
+    timeFormat<raster::Rgbx8888>("RGBX_8888", tiles, frames);
+    timeFormat<raster::Rgb565>("RGB_565", tiles, frames);
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * bench/governor_bench.cpp: Dynamic resolution governor, traces and real frames
+ *
+ * frame::ResolutionGovernor (frame/resolution_governor.h) only sees a work
+ * time per frame, so it can be driven with synthetic loads whose cost is
+ * base x scale^2 (the pixel count) plus noise, on a 60 Hz budget.
+ *
+ * Checked (exit code 1 on failure):
+ * - heavy:     base 24 ms. Settles below the high-water mark within a
+ *              second, in at most 2 changes.
+ * - too heavy: base 80 ms. Goes to minScale and never below it.
+ * - recovery:  base 24 ms, then 8 ms. Back to 1.0x once the load drops.
+ * - borderline: base right at the high-water mark, +-15% noise. Hysteresis
+ *              keeps the number of changes small; a naive governor (one
+ *              threshold, frame by frame) is run on the same trace to show
+ *              the flapping it avoids.
+ * - scene:     the scene laid out at a scale puts the circle where the
+ *              full-size one is, times the scale (within half a pixel).
+ *
+ * Then the assumption behind it all, measured: raster time of the real
+ * scene at each rung of the ladder, against scale^2.
+ *
+ * Usage: governor_bench [frames per rung]
+ */
+
+#include "bench_util.h"
+#include "../frame/clock.h"
+#include "../frame/resolution_governor.h"
+#include "../raster/scene.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <cmath>
+#include <cstdio>
+
+static const int64_t kBudget = frame::periodForHz(60.0);
+
+// Deterministic noise, so every run sees the same trace
+struct Noise {
+    uint32_t state = 12345;
+
+    // Uniform in [-1, 1]
+    double next() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / static_cast<double>(1 << 23) - 1.0;
+    }
+};
+
+// One frame of synthetic work at `scale`: base x scale^2, +-noise
+static int64_t frameCost(double baseMs, double noise, float scale, Noise& rng) {
+    double ms = baseMs * scale * scale * (1.0 + noise * rng.next());
+    return static_cast<int64_t>(ms * 1e6);
+}
+
+struct TraceResult {
+    float finalScale = 1.0f;
+    float minSeen = 1.0f;
+    int changes = 0;
+    int settledAt = -1;       // Frame of the last change
+    double finalMeanMs = 0.0; // Over the last 60 frames
+};
+
+struct Phase {
+    double baseMs;
+    double noise;
+    int frames;
+};
+
+static TraceResult runTrace(const Phase* phases, int phaseCount,
+                            const frame::GovernorConfig& config = frame::GovernorConfig()) {
+    frame::ResolutionGovernor governor(kBudget, config);
+    Noise rng;
+    TraceResult result;
+    int frameNumber = 0;
+    double lastSum = 0.0;
+    int lastCount = 0;
+    for (int p = 0; p < phaseCount; p++) {
+        for (int i = 0; i < phases[p].frames; i++, frameNumber++) {
+            int64_t work = frameCost(phases[p].baseMs, phases[p].noise, governor.scale(), rng);
+            if (p == phaseCount - 1 && i >= phases[p].frames - 60) {
+                lastSum += work / 1e6;
+                lastCount++;
+            }
+            if (governor.onFrame(work)) {
+                result.changes++;
+                result.settledAt = frameNumber;
+            }
+            result.minSeen = std::fmin(result.minSeen, governor.scale());
+        }
+    }
+    result.finalScale = governor.scale();
+    result.finalMeanMs = lastCount > 0 ? lastSum / lastCount : 0.0;
+    return result;
+}
+
+static void printTrace(const char* name, const TraceResult& result) {
+    printf("  %-11s final %.2fx (lowest %.2fx), %d changes, last at frame %d, "
+           "work %.2f ms of %.2f\n", name, result.finalScale, result.minSeen, result.changes,
+           result.settledAt, result.finalMeanMs, kBudget / 1e6);
+}
+
+// The obvious governor: one threshold, decided every frame, one step
+static int naiveChanges(double baseMs, double noise, int frames) {
+    const float step = 0.1f;
+    const double threshold = 0.85 * kBudget;
+    Noise rng;
+    float scale = 1.0f;
+    int changes = 0;
+    for (int i = 0; i < frames; i++) {
+        int64_t work = frameCost(baseMs, noise, scale, rng);
+        if (work > threshold && scale > 0.5f + 1e-3f) {
+            scale -= step;
+            changes++;
+        } else if (work <= threshold && scale < 1.0f - 1e-3f) {
+            scale += step;
+            changes++;
+        }
+    }
+    return changes;
+}
+
+static bool checkTraces() {
+    bool ok = true;
+    const double high = 0.85 * kBudget / 1e6;
+    frame::GovernorConfig config;
+
+    const Phase heavy[] = {{24.0, 0.05, 600}};
+    TraceResult result = runTrace(heavy, 1);
+    printTrace("heavy", result);
+    ok = ok && result.finalMeanMs <= high && result.changes <= 2 && result.settledAt < 60;
+
+    const Phase tooHeavy[] = {{80.0, 0.05, 600}};
+    result = runTrace(tooHeavy, 1);
+    printTrace("too heavy", result);
+    ok = ok && std::fabs(result.finalScale - config.minScale) < 1e-6 &&
+         result.minSeen >= config.minScale - 1e-6;
+
+    const Phase recovery[] = {{24.0, 0.05, 300}, {8.0, 0.05, 900}};
+    result = runTrace(recovery, 2);
+    printTrace("recovery", result);
+    ok = ok && result.finalScale == 1.0f;
+
+    const double borderline = high;
+    const Phase noisy[] = {{borderline, 0.15, 3000}};
+    result = runTrace(noisy, 1);
+    printTrace("borderline", result);
+    int naive = naiveChanges(borderline, 0.15, 3000);
+    printf("  %-11s %d changes on the same load without hysteresis\n", "", naive);
+    ok = ok && result.changes <= 2 && naive > 10 * (result.changes + 1);
+
+    // A different minimum is respected too
+    config.minScale = 0.7;
+    result = runTrace(tooHeavy, 1, config);
+    printTrace("min 0.7", result);
+    ok = ok && std::fabs(result.finalScale - 0.7f) < 1e-6 && result.minSeen >= 0.7f - 1e-6f;
+    return ok;
+}
+
+static bool checkScene() {
+    const float scales[] = {0.9f, 0.75f, 0.5f};
+    raster::SceneState state;
+    float worst = 0.0f;
+    for (int step = 0; step < 240; step++) {
+        raster::SceneCircle full = raster::sceneCircle(1920, 1080, state);
+        for (float scale : scales) {
+            int width = 0;
+            int height = 0;
+            frame::scaledSize(1920, 1080, scale, &width, &height);
+            raster::SceneCircle scaled = raster::sceneCircle(width, height, state, scale);
+            worst = std::fmax(worst, std::fabs(scaled.cx - full.cx * scale));
+            worst = std::fmax(worst, std::fabs(scaled.cy - full.cy * scale));
+            worst = std::fmax(worst, std::fabs(scaled.radius - full.radius * scale));
+        }
+        raster::advanceScene(state);
+    }
+    printf("  circle position/radius vs full size x scale: worst %.3f px\n", worst);
+    return worst <= 0.5f;
+}
+
+// The default ladder: 1.0, 0.9, ... 0.5
+static const float kLadder[] = {1.0f, 0.9f, 0.8f, 0.7f, 0.6f, 0.5f};
+
+// Raster time per rung of the ladder, for one resolution
+static void measureLadder(raster::TileRenderer& tiles, const bench::Resolution& res,
+                          int frames) {
+    bench::PixelBuffer buffer(res.width, res.height, res.width + 16);
+    raster::SceneSnapshot snapshot;
+    double fullMs = 0.0;
+
+    printf("%-6s", res.name);
+    for (float scale : kLadder) {
+        raster::Surface surface = buffer.surface;
+        frame::scaledSize(res.width, res.height, scale, &surface.width, &surface.height);
+
+        raster::SceneState state;
+        double start = bench::nowSeconds();
+        for (int i = 0; i < frames; i++) {
+            raster::recordSnapshot(snapshot, surface.width, surface.height, state, 0, i, scale);
+            tiles.render(surface, snapshot.list);
+            raster::advanceScene(state);
+        }
+        double ms = (bench::nowSeconds() - start) * 1e3 / frames;
+        if (scale == 1.0f) {
+            fullMs = ms;
+        }
+        printf(" %5.2f (%3.0f%%)", ms, 100.0 * ms / fullMs);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 60);
+
+    printf("Synthetic loads, cost = base x scale^2, %.2f ms budget:\n", kBudget / 1e6);
+    bool tracesOk = checkTraces();
+
+    printf("\nScene layout at reduced scale:\n");
+    bool sceneOk = checkScene();
+
+    raster::ThreadPool pool(raster::ThreadPool::hardwareThreads());
+    raster::TileRenderer tiles(pool);
+    printf("\nRecord + raster ms/frame per rung (%% of full), %d frames each:\n", frames);
+    printf("%-6s", "res");
+    for (float scale : kLadder) {
+        printf(" %4.1fx (%3.0f%%)", scale, 100.0 * scale * scale);
+    }
+    printf("\n");
+    for (const bench::Resolution& res : bench::kResolutions) {
+        measureLadder(tiles, res, frames);
+    }
+
+    if (!tracesOk || !sceneOk) {
+        printf("\nverify: FAILED (traces %s, scene %s)\n", tracesOk ? "ok" : "wrong",
+               sceneOk ? "ok" : "wrong");
+        return 1;
+    }
+    printf("\nverify: converges under budget, respects minScale, recovers, no flapping\n");
+    return 0;
+}
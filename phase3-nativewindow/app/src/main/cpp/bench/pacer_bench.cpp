@@ -0,0 +1,234 @@
+/**
+ * bench/pacer_bench.cpp: Frame pacing against a simulated 60/90/120 Hz display
+ *
+ * Everything except the last table runs on a SimulatedClock, so the
+ * results are exact and a simulated second takes microseconds. The
+ * display refreshes at k * period; a frame shows at the first refresh
+ * after its work is done.
+ *
+ * Checked (exit code 1 on failure):
+ * - steady:   work fits in the period. The pacer must hit every deadline
+ *             with zero jitter, and every refresh gets a new frame.
+ * - overrun:  every 10th frame takes 1.6 periods. Each one must count as
+ *             exactly one missed deadline and one skipped refresh, and
+ *             every frame must still start exactly on the grid.
+ * - vsync:    the same overruns, driven through onVsync() the way
+ *             AChoreographer callbacks would.
+ *
+ * For comparison, "usleep" is the old loop: work, then usleep(16666).
+ *
+ * The last table uses the real clock (clock_nanosleep), so its jitter is
+ * whatever this machine's scheduler delivers.
+ *
+ * Usage: pacer_bench [realFrames]
+ */
+
+#include "bench_util.h"
+#include "../frame/frame_pacer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const double kSimulatedSeconds = 2.0;
+
+struct Run {
+    frame::PacerStats stats;
+    int64_t refreshes = 0;         // Display refreshes in the run
+    int64_t stale = 0;             // Refreshes that showed no new frame
+    bool onGrid = true;            // Every frame started exactly on a deadline
+};
+
+// Which refresh shows a frame finished at `time`
+static int64_t refreshIndex(int64_t time, int64_t period) {
+    return (time + period - 1) / period;
+}
+
+// Count refreshes in (first, last] that got no new frame
+static void countStale(const std::vector<int64_t>& shownAt, Run* run) {
+    if (shownAt.empty()) {
+        return;
+    }
+    run->refreshes = shownAt.back() - shownAt.front();
+    int64_t fresh = 0;
+    for (size_t i = 1; i < shownAt.size(); i++) {
+        if (shownAt[i] != shownAt[i - 1]) {
+            fresh++;
+        }
+    }
+    run->stale = run->refreshes - fresh;
+}
+
+// Frame `index` takes this long (overrun: every 10th frame is 1.6 periods)
+static int64_t workFor(int index, int64_t period, bool overrun, std::mt19937& rng) {
+    if (overrun && index % 10 == 9) {
+        return period * 16 / 10;
+    }
+    std::uniform_int_distribution<int64_t> spread(period * 30 / 100, period * 50 / 100);
+    return spread(rng);
+}
+
+static Run runTimerMode(int64_t period, bool overrun) {
+    frame::SimulatedClock clock;
+    frame::FramePacer pacer(clock, period);
+    std::mt19937 rng(3);
+    Run run;
+    std::vector<int64_t> shownAt;
+
+    int frames = static_cast<int>(kSimulatedSeconds * frame::kNanosPerSecond / period);
+    for (int i = 0; i < frames; i++) {
+        // The simulated clock starts at 0, so the grid is k * period
+        int64_t start = pacer.waitForNextFrame();
+        run.onGrid = run.onGrid && start == clock.now() && start % period == 0;
+        clock.advance(workFor(i, period, overrun, rng));
+        shownAt.push_back(refreshIndex(clock.now(), period));
+    }
+    run.stats = pacer.stats();
+    countStale(shownAt, &run);
+    return run;
+}
+
+static Run runVsyncMode(int64_t period, bool overrun) {
+    frame::SimulatedClock clock;
+    frame::FramePacer pacer(clock, period);
+    std::mt19937 rng(3);
+    Run run;
+    std::vector<int64_t> shownAt;
+
+    int frames = static_cast<int>(kSimulatedSeconds * frame::kNanosPerSecond / period);
+    int64_t vsync = period;
+    for (int i = 0; i < frames; i++) {
+        // The callback for `vsync` runs, draws, and re-posts itself; the
+        // next callback is the first refresh after the work finished
+        clock.sleepUntil(vsync);
+        pacer.onVsync(vsync);
+        clock.advance(workFor(i, period, overrun, rng));
+        shownAt.push_back(refreshIndex(clock.now(), period));
+        vsync = (clock.now() / period + 1) * period;
+    }
+    run.stats = pacer.stats();
+    countStale(shownAt, &run);
+    return run;
+}
+
+// The old loop: draw, then usleep(16666) whatever the refresh rate
+static Run runUsleepLoop(int64_t period, bool overrun) {
+    frame::SimulatedClock clock;
+    std::mt19937 rng(3);
+    Run run;
+    std::vector<int64_t> shownAt;
+    int64_t previous = 0;
+
+    int frames = static_cast<int>(kSimulatedSeconds * frame::kNanosPerSecond / period);
+    std::vector<double> intervals;
+    for (int i = 0; i < frames; i++) {
+        int64_t start = clock.now();
+        if (i > 0) {
+            intervals.push_back((start - previous) / 1e6);
+        }
+        previous = start;
+        clock.advance(workFor(i, period, overrun, rng));
+        shownAt.push_back(refreshIndex(clock.now(), period));
+        clock.advance(16666 * 1000LL);
+    }
+
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (double interval : intervals) {
+        sum += interval;
+        sumSq += interval * interval;
+        run.stats.maxIntervalMs = std::max(run.stats.maxIntervalMs, interval);
+    }
+    run.stats.frames = frames;
+    run.stats.meanIntervalMs = sum / intervals.size();
+    run.stats.jitterMs = std::sqrt(std::max(0.0, sumSq / intervals.size() -
+                                                     run.stats.meanIntervalMs * run.stats.meanIntervalMs));
+    countStale(shownAt, &run);
+    return run;
+}
+
+static void printRun(int hz, const char* mode, const Run& run, bool paced = true) {
+    char missed[24] = "-";
+    char skipped[24] = "-";
+    if (paced) {
+        snprintf(missed, sizeof(missed), "%lld", static_cast<long long>(run.stats.missedDeadlines));
+        snprintf(skipped, sizeof(skipped), "%lld", static_cast<long long>(run.stats.skippedVsyncs));
+    }
+    printf("%4d %-14s %7lld %7s %8s %9.3f %9.3f %9.3f %8lld/%lld\n", hz, mode,
+           static_cast<long long>(run.stats.frames), missed, skipped, run.stats.meanIntervalMs,
+           run.stats.jitterMs, run.stats.maxIntervalMs, static_cast<long long>(run.stale),
+           static_cast<long long>(run.refreshes));
+}
+
+static bool check(bool condition, int hz, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "FAILED at %d Hz: %s\n", hz, what);
+    }
+    return condition;
+}
+
+int main(int argc, char** argv) {
+    const int realFrames = bench::intArg(argc, argv, 1, 120);
+    bool ok = true;
+
+    printf("simulated display, %.0f s per row (stale = refreshes with no new frame)\n\n",
+           kSimulatedSeconds);
+    printf("%4s %-14s %7s %7s %8s %9s %9s %9s %12s\n", "Hz", "mode", "frames", "missed",
+           "skipped", "mean ms", "jitter ms", "max ms", "stale");
+
+    const int rates[] = {60, 90, 120};
+    for (int hz : rates) {
+        int64_t period = frame::periodForHz(hz);
+        double periodMs = period / 1e6;
+
+        Run legacy = runUsleepLoop(period, false);
+        Run steady = runTimerMode(period, false);
+        Run overrun = runTimerMode(period, true);
+        Run vsync = runVsyncMode(period, true);
+
+        printRun(hz, "usleep", legacy, false);
+        printRun(hz, "timer steady", steady);
+        printRun(hz, "timer overrun", overrun);
+        printRun(hz, "vsync overrun", vsync);
+        printf("\n");
+
+        // A miss is seen when the NEXT frame starts, so an overrun in the
+        // very last frame isn't counted
+        int64_t overruns = (overrun.stats.frames - 1) / 10;
+        ok &= check(steady.stats.missedDeadlines == 0 && steady.stats.skippedVsyncs == 0,
+                    hz, "steady run missed deadlines");
+        ok &= check(std::fabs(steady.stats.meanIntervalMs - periodMs) < 1e-6 &&
+                    steady.stats.jitterMs < 1e-6, hz, "steady run is not exactly periodic");
+        ok &= check(steady.stale == 0, hz, "steady run left refreshes without a frame");
+        ok &= check(overrun.stats.missedDeadlines == overruns &&
+                    overrun.stats.skippedVsyncs == overruns, hz,
+                    "timer overruns not counted once each");
+        ok &= check(overrun.onGrid, hz, "timer frames left the grid after an overrun");
+        ok &= check(vsync.stats.missedDeadlines == overruns &&
+                    vsync.stats.skippedVsyncs == overruns, hz,
+                    "vsync overruns not counted once each");
+    }
+
+    // Real clock: 60 Hz, 4 ms of busy work per frame
+    frame::MonotonicClock clock;
+    frame::FramePacer pacer(clock, frame::periodForHz(60));
+    pacer.waitForNextFrame();
+    pacer.resetStats();
+    for (int i = 0; i < realFrames; i++) {
+        int64_t end = clock.now() + 4 * 1000000LL;
+        while (clock.now() < end) {
+        }
+        pacer.waitForNextFrame();
+    }
+    frame::PacerStats real = pacer.stats();
+    printf("real clock, 60 Hz, %d frames: mean %.3f ms, jitter %.3f ms, max %.3f ms, "
+           "%lld missed\n", realFrames, real.meanIntervalMs, real.jitterMs, real.maxIntervalMs,
+           static_cast<long long>(real.missedDeadlines));
+
+    if (!ok) {
+        return 1;
+    }
+    printf("verify: pacing checks passed at 60/90/120 Hz\n");
+    return 0;
+}
@@ -0,0 +1,333 @@
+/**
+ * bench/present_bench.cpp: Presenting from the render thread vs a present thread
+ *
+ * A FakeWindow stands in for ANativeWindow + BufferQueue + SurfaceFlinger:
+ * 3 buffers (garbage until first drawn); lock() blocks while none is free
+ * and copies the last posted frame into the buffer outside the dirty rect
+ * (copy-back), leaving the buffer's own old contents inside it; a
+ * compositor thread latches one queued buffer per period and now and
+ * then stalls for 3 periods, holding every buffer.
+ *
+ * The renderer is paced to the same period and draws the bouncing circle
+ * with damage tracking, either
+ *   direct:   lock / draw / post on the render thread (drawFrame())
+ *   present:  draw into PresentQueue back buffers; a present thread does
+ *             lock / copy / post (Renderer present thread mode)
+ *
+ * Checked (exit code 1 on failure): every frame the compositor latches
+ * must equal renderScene() for the animation state it was drawn from, in
+ * both modes. That covers the back buffer damage/age handling, the merged
+ * damage of skipped frames and the copy into the window.
+ *
+ * Reported: how long the render thread was blocked (inside lock/post, or
+ * waiting for a back buffer), its missed deadlines, and the present
+ * queue's wait metrics for both sides.
+ *
+ * Usage: present_bench [frames] [period ms]
+ */
+
+#include "bench_util.h"
+#include "../frame/clock.h"
+#include "../frame/frame_pacer.h"
+#include "../raster/damage.h"
+#include "../raster/display_list.h"
+#include "../raster/present_queue.h"
+#include "../raster/scene.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const int kWidth = 640;
+static const int kHeight = 360;
+static const int kStallEvery = 20;    // Compositor stalls every Nth latch...
+static const int kStallPeriods = 3;   // ...for this many extra periods
+
+// Animation state of every recent frame, by frame tag
+static const int kStateHistory = 64;
+
+// Visible pixels only (row padding is never drawn)
+static bool samePixels(const raster::Surface& a, const raster::Surface& b) {
+    for (int y = 0; y < kHeight; y++) {
+        if (memcmp(raster::rowPointer(a, y), raster::rowPointer(b, y),
+                   kWidth * sizeof(uint32_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int64_t nowNanos() {
+    return static_cast<int64_t>(bench::nowSeconds() * 1e9);
+}
+
+class FakeWindow {
+public:
+    FakeWindow() {
+        for (int i = 0; i < 3; i++) {
+            m_buffers.emplace_back(new bench::PixelBuffer(kWidth, kHeight, kWidth + 16));
+            m_buffers.back()->pixels.assign(m_buffers.back()->pixels.size(), 0xDEADBEEF);
+        }
+    }
+
+    // Like ANativeWindow_lock(): returns the buffer index; `dirty` is in/out
+    int lock(raster::Rect* dirty, raster::Surface* surface, int64_t* blockedNanos) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        int64_t start = nowNanos();
+        int index = -1;
+        m_changed.wait(lock, [&] {
+            for (int i = 0; i < 3; i++) {
+                if (m_states[i] == State::Free) {
+                    index = i;
+                    return true;
+                }
+            }
+            return false;
+        });
+        *blockedNanos += nowNanos() - start;
+        m_states[index] = State::Dequeued;
+
+        bench::PixelBuffer& buffer = *m_buffers[index];
+        if (m_lastPosted < 0) {
+            *dirty = raster::makeRect(0, 0, kWidth, kHeight);  // No copy-back possible
+        } else if (m_lastPosted != index) {
+            // Copy-back: the last posted frame everywhere outside `dirty`
+            const bench::PixelBuffer& last = *m_buffers[m_lastPosted];
+            for (int y = 0; y < kHeight; y++) {
+                const uint32_t* from = raster::rowPointer(last.surface, y);
+                uint32_t* to = raster::rowPointer(buffer.surface, y);
+                if (y < dirty->top || y >= dirty->bottom) {
+                    memcpy(to, from, kWidth * sizeof(uint32_t));
+                } else {
+                    memcpy(to, from, dirty->left * sizeof(uint32_t));
+                    memcpy(to + dirty->right, from + dirty->right,
+                           (kWidth - dirty->right) * sizeof(uint32_t));
+                }
+            }
+        }
+        *surface = buffer.surface;
+        return index;
+    }
+
+    // Like ANativeWindow_unlockAndPost(); `tag` identifies the frame
+    void post(int index, uint64_t tag) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_states[index] = State::Queued;
+        m_tags[index] = tag;
+        m_queue.push_back(index);
+        m_lastPosted = index;
+    }
+
+    // SurfaceFlinger: latch one queued buffer per period, check it
+    void compose(int64_t period, const raster::SceneState* states, std::atomic<bool>& done) {
+        bench::PixelBuffer expected(kWidth, kHeight, kWidth + 16);
+        int64_t next = nowNanos() + period;
+        int onScreen = -1;
+        for (int latch = 1; !done.load(); latch++) {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(next)));
+            next += period * (latch % kStallEvery == 0 ? 1 + kStallPeriods : 1);
+
+            int index = -1;
+            uint64_t tag = 0;
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                if (m_queue.empty()) {
+                    m_repeats++;
+                    continue;
+                }
+                index = m_queue.front();
+                m_queue.pop_front();
+                m_states[index] = State::OnScreen;
+                tag = m_tags[index];
+                if (onScreen >= 0) {
+                    m_states[onScreen] = State::Free;
+                }
+                onScreen = index;
+            }
+            m_changed.notify_all();
+
+            // Nobody writes an on-screen buffer
+            raster::renderScene(expected.surface, states[tag % kStateHistory]);
+            if (!samePixels(m_buffers[index]->surface, expected.surface)) {
+                m_mismatches++;
+            }
+            m_latched++;
+        }
+        // Let a producer blocked in lock() finish
+        std::lock_guard<std::mutex> guard(m_lock);
+        for (int i = 0; i < 3; i++) {
+            if (m_states[i] != State::Dequeued) {
+                m_states[i] = State::Free;
+            }
+        }
+        m_queue.clear();
+        m_changed.notify_all();
+    }
+
+    int latched() const { return m_latched; }
+    int mismatches() const { return m_mismatches; }
+    int repeats() const { return m_repeats; }
+
+private:
+    enum class State { Free, Dequeued, Queued, OnScreen };
+
+    std::vector<std::unique_ptr<bench::PixelBuffer>> m_buffers;
+    State m_states[3] = {State::Free, State::Free, State::Free};
+    uint64_t m_tags[3] = {};
+    std::deque<int> m_queue;
+    int m_lastPosted = -1;
+    std::mutex m_lock;
+    std::condition_variable m_changed;
+
+    int m_latched = 0;
+    int m_mismatches = 0;
+    int m_repeats = 0;
+};
+
+struct RunResult {
+    int latched = 0;
+    int mismatches = 0;
+    int repeats = 0;
+    int64_t blockedNanos = 0;     // Render thread, waiting on the window or the queue
+    int64_t missedDeadlines = 0;  // Render thread pacer
+    raster::PresentStats queue;
+};
+
+// The present thread: Renderer::presentLoop() against the fake window
+static void presentLoop(raster::PresentQueue& queue, FakeWindow& window) {
+    raster::Rect damage;
+    int64_t blocked = 0;
+    while (raster::BackBuffer* back = queue.acquireForPresent(&damage)) {
+        if (damage.isEmpty()) {
+            queue.releasePresented(back);
+            continue;
+        }
+        raster::Rect dirty = damage;
+        raster::Surface target;
+        int index = window.lock(&dirty, &target, &blocked);
+        raster::copyPixels(target, back->surface, dirty);
+        uint64_t tag = back->frame;
+        queue.releasePresented(back);
+        window.post(index, tag);
+    }
+}
+
+static RunResult run(bool presentThread, int frames, int64_t period) {
+    raster::ThreadPool pool(raster::ThreadPool::hardwareThreads());
+    raster::TileRenderer tiles(pool);
+    raster::FrameArena arena;
+    raster::DisplayList list(arena);
+    raster::DamageTracker damage;
+    raster::SceneState scene;
+    raster::SceneState states[kStateHistory];
+
+    FakeWindow window;
+    std::atomic<bool> done{false};
+    std::thread compositor([&] { window.compose(period, states, done); });
+
+    raster::PresentQueue queue(3);
+    std::thread presenter;
+    if (presentThread) {
+        presenter = std::thread(presentLoop, std::ref(queue), std::ref(window));
+    }
+
+    frame::MonotonicClock clock;
+    frame::FramePacer pacer(clock, period);
+    RunResult result;
+    for (int i = 0; i < frames; i++) {
+        pacer.waitForNextFrame();
+
+        arena.reset();
+        list.reset();
+        raster::buildScene(list, kWidth, kHeight, scene);
+        damage.beginFrame(kWidth, kHeight);
+        raster::addDisplayListDamage(damage, list);
+        raster::Rect lockRect = damage.finishScene();
+
+        if (presentThread) {
+            raster::BackBuffer* back = queue.acquireForRaster(kWidth, kHeight,
+                                                              raster::PixelFormat::RGBA_8888);
+            bool known = back->age > 0 && back->age <= raster::DamageTracker::kMaxBufferAge;
+            raster::Rect returned = known ? lockRect : raster::makeRect(0, 0, kWidth, kHeight);
+            tiles.render(back->surface, list, damage.resolve(back->surface, returned));
+            states[back->frame % kStateHistory] = scene;
+            queue.submit(back, lockRect);
+        } else {
+            raster::Rect dirty = lockRect;
+            raster::Surface surface;
+            int index = window.lock(&dirty, &surface, &result.blockedNanos);
+            tiles.render(surface, list, damage.resolve(surface, dirty));
+            states[(i + 1) % kStateHistory] = scene;
+            window.post(index, i + 1);
+        }
+        raster::advanceScene(scene);
+    }
+
+    // Let the last frames reach the screen before stopping
+    std::this_thread::sleep_for(std::chrono::nanoseconds(period * (2 + kStallPeriods)));
+    if (presentThread) {
+        queue.stop();
+        presenter.join();
+        result.queue = queue.stats();
+        result.blockedNanos = result.queue.rasterWaitNanos;
+    }
+    done = true;
+    compositor.join();
+
+    result.latched = window.latched();
+    result.mismatches = window.mismatches();
+    result.repeats = window.repeats();
+    result.missedDeadlines = pacer.stats().missedDeadlines;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 240);
+    const int periodMs = bench::intArg(argc, argv, 2, 8);
+    const int64_t period = periodMs * 1000000LL;
+
+    printf("%dx%d, %d frames paced every %d ms; the compositor latches every %d ms and\n"
+           "stalls for %d extra periods every %d latches\n\n",
+           kWidth, kHeight, frames, periodMs, periodMs, kStallPeriods, kStallEvery);
+    printf("%-8s %8s %8s %10s %14s %8s\n", "mode", "latched", "repeats", "mismatch",
+           "render blocked", "missed");
+
+    bool ok = true;
+    RunResult results[2];
+    for (int mode = 0; mode < 2; mode++) {
+        RunResult& r = results[mode];
+        r = run(mode == 1, frames, period);
+        printf("%-8s %8d %8d %10d %11.1f ms %8lld\n", mode == 1 ? "present" : "direct",
+               r.latched, r.repeats, r.mismatches, r.blockedNanos / 1e6,
+               static_cast<long long>(r.missedDeadlines));
+        ok = ok && r.mismatches == 0 && r.latched > 0;
+    }
+
+    const raster::PresentStats& q = results[1].queue;
+    printf("\npresent queue: %lld submitted, %lld presented, %lld skipped\n",
+           static_cast<long long>(q.submitted), static_cast<long long>(q.presented),
+           static_cast<long long>(q.skipped));
+    printf("  raster thread waited %lld times for a back buffer (%.1f ms, max %.2f ms)\n",
+           static_cast<long long>(q.rasterWaits), q.rasterWaitNanos / 1e6,
+           q.rasterWaitMaxNanos / 1e6);
+    printf("  present thread waited %lld times for a frame (%.1f ms, max %.2f ms)\n",
+           static_cast<long long>(q.presentWaits), q.presentWaitNanos / 1e6,
+           q.presentWaitMaxNanos / 1e6);
+
+    if (!ok) {
+        printf("\nverify: FAILED (a latched frame differs from renderScene())\n");
+        return 1;
+    }
+    printf("\nverify: every latched frame matches renderScene(), in both modes\n");
+    return 0;
+}
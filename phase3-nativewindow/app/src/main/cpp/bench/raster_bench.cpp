@@ -0,0 +1,47 @@
+/**
+ * bench/raster_bench.cpp: Full-frame CPU render cost on the host
+ *
+ * Renders the Phase 3 scene (background clear + animated circle) into a
+ * heap buffer at 1080p/1440p/4K and reports time per frame. This is the
+ * same code path drawFrame() runs between lock and unlockAndPost.
+ *
+ * Usage: raster_bench [frames]
+ */
+
+#include "bench_util.h"
+#include "../raster/scene.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 300);
+
+    printf("%-6s %12s %10s %10s %10s\n",
+           "res", "pixels", "ms/frame", "fps", "MPix/s");
+
+    for (const bench::Resolution& res : bench::kResolutions) {
+        bench::PixelBuffer buffer(res.width, res.height);
+        raster::SceneState state;
+
+        // Warm up caches and page in the buffer
+        for (int i = 0; i < 10; i++) {
+            raster::renderScene(buffer.surface, state);
+            raster::advanceScene(state);
+        }
+
+        double start = bench::nowSeconds();
+        for (int i = 0; i < frames; i++) {
+            raster::renderScene(buffer.surface, state);
+            raster::advanceScene(state);
+        }
+        double elapsed = bench::nowSeconds() - start;
+
+        double pixels = static_cast<double>(res.width) * res.height;
+        double msPerFrame = elapsed * 1000.0 / frames;
+        printf("%-6s %12.0f %10.3f %10.1f %10.1f\n",
+               res.name, pixels, msPerFrame, 1000.0 / msPerFrame,
+               pixels * frames / elapsed / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+/**
+ * bench/rgb565_bench.cpp: RGB_565 output vs RGBA_8888, with and without dither
+ *
+ * 1. Pack kernels: every SIMD kernel must match the scalar one exactly
+ *    (plain and dithered, odd lengths and offsets), then Mpix/s each.
+ * 2. The dithered tile path (8888 scratch tile -> pack565Dither) must
+ *    equal a full RGBA_8888 render packed row by row.
+ * 3. Side by side at 1080p: framebuffer bytes written per frame and
+ *    ms/frame for RGBA_8888, RGB_565 and RGB_565 + dither.
+ * 4. Banding: how far a 4x4 block average of a packed gradient is from
+ *    the original 8-bit gradient (what the eye sees from a distance).
+ *
+ * Usage: rgb565_bench [frames]
+ */
+
+#include "bench_util.h"
+#include "../raster/display_list.h"
+#include "../raster/pack565.h"
+#include "../raster/scene.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// ========== 1. PACK KERNELS ==========
+
+static bool verifyPackKernels() {
+    std::mt19937 rng(5);
+    std::vector<uint32_t> src(1000);
+    for (uint32_t& pixel : src) {
+        pixel = rng();
+    }
+    // Saturation corner cases: channels at 250-255 overflow with the offset
+    src[3] = 0xFFFFFFFF;
+    src[4] = 0x00FBFDFA;
+
+    size_t kernelCount = 0;
+    const raster::Pack565Kernel* kernels = raster::supportedPack565Kernels(&kernelCount);
+    std::vector<uint16_t> expected(src.size());
+    std::vector<uint16_t> actual(src.size());
+
+    const size_t lengths[] = {0, 1, 7, 8, 15, 16, 17, 63, 1000};
+    for (size_t k = 1; k < kernelCount; k++) {
+        for (size_t length : lengths) {
+            for (int offset = 0; offset < 5; offset++) {
+                int x = offset * 3;
+                int y = offset;
+                const uint32_t* in = src.data() + (length < src.size() ? offset : 0);
+
+                raster::pack565Scalar(expected.data(), in, length, x, y);
+                kernels[k].pack(actual.data(), in, length, x, y);
+                bool ok = std::equal(expected.begin(), expected.begin() + length, actual.begin());
+
+                raster::pack565DitherScalar(expected.data(), in, length, x, y);
+                kernels[k].packDither(actual.data(), in, length, x, y);
+                ok = ok && std::equal(expected.begin(), expected.begin() + length,
+                                      actual.begin());
+                if (!ok) {
+                    fprintf(stderr, "MISMATCH: pack565 kernel %s, length %zu, x %d, y %d\n",
+                            kernels[k].name, length, x, y);
+                    return false;
+                }
+            }
+        }
+    }
+    printf("verify: %zu pack kernels match scalar (plain + dither)\n", kernelCount);
+    return true;
+}
+
+static void timePackKernels() {
+    const int width = 1920;
+    const int height = 1080;
+    std::vector<uint32_t> src(static_cast<size_t>(width) * height, 0xFF6496FF);
+    std::vector<uint16_t> dst(src.size());
+
+    size_t kernelCount = 0;
+    const raster::Pack565Kernel* kernels = raster::supportedPack565Kernels(&kernelCount);
+    printf("\n%-8s %14s %14s\n", "kernel", "pack Mpix/s", "dither Mpix/s");
+    for (size_t k = 0; k < kernelCount; k++) {
+        double rates[2];
+        for (int dither = 0; dither < 2; dither++) {
+            raster::Pack565Fn fn = dither ? kernels[k].packDither : kernels[k].pack;
+            const int frames = 20;
+            double start = bench::nowSeconds();
+            for (int frame = 0; frame < frames; frame++) {
+                for (int y = 0; y < height; y++) {
+                    fn(dst.data() + static_cast<size_t>(y) * width,
+                       src.data() + static_cast<size_t>(y) * width, width, 0, y);
+                }
+            }
+            double seconds = bench::nowSeconds() - start;
+            rates[dither] = static_cast<double>(width) * height * frames / seconds / 1e6;
+        }
+        printf("%-8s %14.0f %14.0f\n", kernels[k].name, rates[0], rates[1]);
+    }
+}
+
+// ========== 2. DITHERED TILE PATH ==========
+
+static void recordShapes(raster::DisplayList& list, int width, int height, int count) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> x(0.0f, static_cast<float>(width));
+    std::uniform_real_distribution<float> y(0.0f, static_cast<float>(height));
+    std::uniform_real_distribution<float> size(4.0f, 80.0f);
+
+    raster::buildScene(list, width, height, raster::SceneState());
+    for (int i = 0; i < count; i++) {
+        // Colors that don't sit on 565 steps, so dithering has work to do
+        uint32_t argb = 0xFF000000u | (rng() & 0xFFFFFF);
+        if (i % 2 == 0) {
+            list.fillCircle(x(rng), y(rng), size(rng), argb);
+        } else {
+            int left = static_cast<int>(x(rng));
+            int top = static_cast<int>(y(rng));
+            list.fillRect(raster::makeRect(left, top, left + static_cast<int>(size(rng)),
+                                           top + static_cast<int>(size(rng))), argb);
+        }
+    }
+}
+
+static bool verifyDitheredTiles(raster::TileRenderer& tiles) {
+    const int width = 333;
+    const int height = 201;
+    const int stride = 352;
+
+    raster::FrameArena arena;
+    raster::DisplayList list(arena);
+    recordShapes(list, width, height, 300);
+
+    bench::PixelBuffer reference(width, height);
+    raster::executeDisplayList(reference.surface, list, raster::makeRect(0, 0, width, height));
+    std::vector<uint16_t> expected(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        raster::pack565DitherScalar(expected.data() + static_cast<size_t>(y) * width,
+                                    raster::rowPointer(reference.surface, y), width, 0, y);
+    }
+
+    bench::PixelBuffer target(width, height, stride, raster::PixelFormat::RGB_565);
+    tiles.setDither(true);
+    tiles.render(target.surface, list);
+    tiles.setDither(false);
+
+    for (int y = 0; y < height; y++) {
+        const uint16_t* row = raster::rowPointer<raster::Rgb565>(target.surface, y);
+        for (int x = 0; x < width; x++) {
+            if (row[x] != expected[static_cast<size_t>(y) * width + x]) {
+                fprintf(stderr, "MISMATCH: dithered tile pixel (%d, %d)\n", x, y);
+                return false;
+            }
+        }
+    }
+    printf("verify: dithered tiles match a full 8888 render + dither pack\n");
+    return true;
+}
+
+// ========== 3. SIDE BY SIDE ==========
+
+static void compareModes(raster::TileRenderer& tiles, int frames) {
+    const int width = 1920;
+    const int height = 1080;
+
+    raster::FrameArena arena;
+    raster::DisplayList list(arena);
+    recordShapes(list, width, height, 500);
+
+    struct Mode {
+        const char* name;
+        raster::PixelFormat format;
+        bool dither;
+    };
+    const Mode modes[] = {
+        {"RGBA_8888", raster::PixelFormat::RGBA_8888, false},
+        {"RGB_565", raster::PixelFormat::RGB_565, false},
+        {"RGB_565+dither", raster::PixelFormat::RGB_565, true},
+    };
+
+    printf("\n1080p full repaint, 500 shapes, 1 thread, %d frames\n", frames);
+    printf("%-15s %14s %10s\n", "mode", "KB written", "ms/frame");
+    for (const Mode& mode : modes) {
+        bench::PixelBuffer buffer(width, height, 0, mode.format);
+        tiles.setDither(mode.dither);
+        tiles.render(buffer.surface, list);  // Warm up
+
+        double start = bench::nowSeconds();
+        for (int frame = 0; frame < frames; frame++) {
+            tiles.render(buffer.surface, list);
+        }
+        double ms = (bench::nowSeconds() - start) * 1000.0 / frames;
+
+        double kb = static_cast<double>(width) * height * raster::bytesPerPixel(mode.format) /
+                    1024.0;
+        printf("%-15s %14.0f %10.3f\n", mode.name, kb, ms);
+    }
+    tiles.setDither(false);
+}
+
+// ========== 4. BANDING ==========
+
+struct Banding {
+    int levels;       // Distinct 4x4 block averages along the gradient
+    double maxStep;   // Largest jump between neighbouring blocks (8-bit levels)
+};
+
+// A slow horizontal gray gradient (64 levels over 512 px), packed, then
+// looked at through 4x4 block averages of the green channel
+static Banding measureBanding(raster::Pack565Fn pack) {
+    const int width = 512;
+    const int height = 4;
+    std::vector<uint32_t> source(width);
+    std::vector<uint16_t> packed(static_cast<size_t>(width) * height);
+
+    for (int x = 0; x < width; x++) {
+        uint32_t level = static_cast<uint32_t>(x * 64 / width) + 96;
+        source[x] = 0xFF000000u | level << 16 | level << 8 | level;
+    }
+    for (int y = 0; y < height; y++) {
+        pack(packed.data() + static_cast<size_t>(y) * width, source.data(), width, 0, y);
+    }
+
+    Banding result = {0, 0.0};
+    double previous = -1.0;
+    for (int bx = 0; bx < width; bx += 4) {
+        double sum = 0.0;
+        for (int y = 0; y < height; y++) {
+            for (int x = bx; x < bx + 4; x++) {
+                uint16_t p = packed[static_cast<size_t>(y) * width + x];
+                sum += ((p >> 5) & 0x3F) * 255.0 / 63.0;
+            }
+        }
+        double average = sum / 16.0;
+        if (previous < 0.0 || std::fabs(average - previous) > 1e-9) {
+            result.levels++;
+        }
+        if (previous >= 0.0) {
+            result.maxStep = std::max(result.maxStep, std::fabs(average - previous));
+        }
+        previous = average;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 30);
+
+    raster::ThreadPool pool(1);
+    raster::TileRenderer tiles(pool);
+
+    if (!verifyPackKernels() || !verifyDitheredTiles(tiles)) {
+        return 1;
+    }
+
+    timePackKernels();
+    compareModes(tiles, frames);
+
+    Banding truncated = measureBanding(raster::pack565Scalar);
+    Banding dithered = measureBanding(raster::pack565DitherScalar);
+    printf("\nbanding on a 64-level gray gradient (4x4 block averages)\n");
+    printf("%-10s %8s %10s\n", "pack", "levels", "max step");
+    printf("%-10s %8d %10.2f\n", "truncate", truncated.levels, truncated.maxStep);
+    printf("%-10s %8d %10.2f\n", "dither", dithered.levels, dithered.maxStep);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * bench/tile_bench.cpp: Tile-parallel scaling from 1 to N threads
+ *
+ * Records full frames (clear + circle) as display lists and renders them
+ * through TileRenderer with a pool of 1..N threads, reporting ms/frame
+ * and speedup over 1 thread.
+ * Every configuration is first checked against the single-threaded
+ * renderScene() output.
+ *
+ * Usage: tile_bench [frames] [maxThreads]
+ *   maxThreads defaults to the number of online CPUs
+ */
+
+#include "bench_util.h"
+#include "../raster/display_list.h"
+#include "../raster/scene.h"
+#include "../raster/thread_pool.h"
+#include "../raster/tile_renderer.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    const int frames = bench::intArg(argc, argv, 1, 200);
+    const int maxThreads = bench::intArg(argc, argv, 2, raster::ThreadPool::hardwareThreads());
+
+    printf("online CPUs: %d, tile size: %d\n\n",
+           raster::ThreadPool::hardwareThreads(), raster::TileRenderer::kDefaultTileSize);
+    printf("%-6s %8s %10s %8s %8s\n", "res", "threads", "ms/frame", "speedup", "steals");
+
+    for (const bench::Resolution& res : bench::kResolutions) {
+        double baseline = 0.0;
+
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            raster::ThreadPool pool(threads);
+            raster::TileRenderer tiles(pool);
+            bench::PixelBuffer buffer(res.width, res.height, res.width + 16);
+            raster::SceneState state;
+            raster::FrameArena arena;
+            raster::DisplayList list(arena);
+
+            // VERIFY against the single-threaded path
+            bench::PixelBuffer expected(res.width, res.height, res.width + 16);
+            for (int i = 0; i < 3; i++) {
+                arena.reset();
+                list.reset();
+                raster::buildScene(list, res.width, res.height, state);
+                tiles.render(buffer.surface, list);
+                raster::renderScene(expected.surface, state);
+                if (buffer.pixels != expected.pixels) {
+                    fprintf(stderr, "MISMATCH: %s with %d threads\n", res.name, threads);
+                    return 1;
+                }
+                raster::advanceScene(state);
+            }
+
+            int64_t stealsBefore = pool.stealCount();
+            double start = bench::nowSeconds();
+            for (int i = 0; i < frames; i++) {
+                arena.reset();
+                list.reset();
+                raster::buildScene(list, res.width, res.height, state);
+                tiles.render(buffer.surface, list);
+                raster::advanceScene(state);
+            }
+            double ms = (bench::nowSeconds() - start) * 1000.0 / frames;
+            if (threads == 1) {
+                baseline = ms;
+            }
+
+            printf("%-6s %8d %10.3f %7.2fx %8lld\n", res.name, threads, ms, baseline / ms,
+                   static_cast<long long>(pool.stealCount() - stealsBefore));
+        }
+    }
+
+    return 0;
+}
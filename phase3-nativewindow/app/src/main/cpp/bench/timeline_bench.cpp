@@ -0,0 +1,282 @@
+/**
+ * bench/timeline_bench.cpp: Fixed-timestep animation at any refresh rate
+ *
+ * Replays frame timestamps (no sleeping) through timeline::Timeline
+ * (common/timeline.h) and the phase 3 scene, the way
+ * Renderer::stepAnimation() does, and compares where the circle is drawn
+ * on a 1920-wide buffer against the old "advanceScene() once per frame".
+ *
+ * Checked (exit code 1 on failure):
+ * - rates:   60, 90, 120 and 144 Hz for 10 s. At every instant that is a
+ *            frame for 60, 90 and 120 Hz alike (every 1/30 s) the circle
+ *            is in the same place, and every frame is within a pixel of
+ *            the exact position one step earlier (what interpolation shows).
+ * - smooth:  at 90 and 144 Hz (not multiples of the 120 Hz step) the
+ *            circle moves the same distance every frame; drawing the
+ *            newest step without interpolation is measured alongside.
+ * - drops:   60 Hz with 6 frames missing, and 3 frames replaced by one
+ *            that arrives 40 ms after the last. Once the
+ *            next frame arrives, the circle is exactly where the run
+ *            without drops has it.
+ * - stall:   a 2 s gap only catches up the 250 ms cap (the rest is
+ *            counted as dropped), and reset() simulates none of it.
+ *
+ * Then the cost of advance() + interpolation per frame.
+ *
+ * Usage: timeline_bench [seconds per run]
+ */
+
+#include "bench_util.h"
+#include "common/timeline.h"
+#include "../raster/scene.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int64_t kStart = 1000000000LL;   // Any CLOCK_MONOTONIC value
+static const int kWidth = 1920;
+static const int kHeight = 1080;
+
+static float circleX(const raster::SceneState& state) {
+    return raster::sceneCircle(kWidth, kHeight, state).cx;
+}
+
+// Frame timestamps every 1/hz seconds, minus the ones in [dropFrom, dropTo)
+static std::vector<int64_t> frameTimes(double hz, double seconds, double dropFrom = 0.0,
+                                       double dropTo = 0.0) {
+    std::vector<int64_t> times;
+    int count = static_cast<int>(seconds * hz);
+    for (int i = 0; i <= count; i++) {
+        double t = i / hz;
+        if (t >= dropFrom && t < dropTo) {
+            continue;
+        }
+        times.push_back(kStart + static_cast<int64_t>(std::llround(t * 1e9)));
+    }
+    return times;
+}
+
+struct Run {
+    std::vector<float> x;          // Drawn circle x per frame
+    std::vector<float> time;       // Drawn animation time per frame
+    timeline::TimelineStats stats;
+};
+
+// What the renderer does each frame. interpolate = false draws the
+// newest step as is.
+static Run replay(const std::vector<int64_t>& times, bool interpolate = true) {
+    timeline::Timeline clock;
+    raster::SceneState current;
+    raster::SceneState previous;
+    Run run;
+    for (int64_t now : times) {
+        int steps = clock.advance(now);
+        for (int i = 0; i < steps; i++) {
+            previous = current;
+            raster::advanceScene(current, clock.stepSeconds());
+        }
+        raster::SceneState shown =
+                interpolate ? raster::interpolateScene(previous, current, clock.alpha()) : current;
+        run.x.push_back(circleX(shown));
+        run.time.push_back(shown.time);
+    }
+    run.stats = clock.stats();
+    return run;
+}
+
+// The old way: one 60 Hz frame's worth of animation per frame
+static std::vector<float> replayPerFrame(size_t frames) {
+    raster::SceneState state;
+    std::vector<float> x;
+    for (size_t i = 0; i < frames; i++) {
+        x.push_back(circleX(state));
+        raster::advanceScene(state);
+    }
+    return x;
+}
+
+// Where interpolation should draw the circle at `now`: the exact
+// animation one step before it
+static float expectedX(int64_t now) {
+    double seconds = (now - kStart - timeline::kDefaultStepNanos) / 1e9;
+    raster::SceneState state;
+    state.time = static_cast<float>(std::fmod(std::fmax(seconds, 0.0) * raster::kSceneSpeed, 100.0));
+    return circleX(state);
+}
+
+static bool checkRates(double seconds) {
+    const double rates[] = {60.0, 90.0, 120.0, 144.0};
+    std::vector<int64_t> times[4];
+    Run runs[4];
+    bool ok = true;
+    printf("%-7s %8s %8s %14s %22s\n", "rate", "frames", "steps", "worst vs exact",
+           "old way at the end");
+    for (int r = 0; r < 4; r++) {
+        times[r] = frameTimes(rates[r], seconds);
+        runs[r] = replay(times[r]);
+        float worst = 0.0f;
+        for (size_t i = 0; i < times[r].size(); i++) {
+            if (times[r][i] - kStart >= timeline::kDefaultStepNanos) {
+                worst = std::fmax(worst, std::fabs(runs[r].x[i] - expectedX(times[r][i])));
+            }
+        }
+        std::vector<float> old = replayPerFrame(times[r].size());
+        printf("%-4.0f Hz %8zu %8lld %11.3f px %11.0f px off (%.1fx speed)\n", rates[r],
+               times[r].size(), static_cast<long long>(runs[r].stats.steps), worst,
+               std::fabs(old.back() - runs[r].x.back()), rates[r] / 60.0);
+        ok = ok && worst <= 1.0f;
+    }
+
+    // Every 1/30 s is frame 2k at 60 Hz, 3k at 90 Hz and 4k at 120 Hz
+    float worst = 0.0f;
+    for (size_t k = 0; 4 * k < times[2].size(); k++) {
+        worst = std::fmax(worst, std::fabs(runs[0].x[2 * k] - runs[1].x[3 * k]));
+        worst = std::fmax(worst, std::fabs(runs[0].x[2 * k] - runs[2].x[4 * k]));
+    }
+    printf("  same instant at 60/90/120 Hz: worst difference %.4f px\n", worst);
+    return ok && worst <= 0.01f;
+}
+
+// Spread of the per-frame movement (animation time units) relative to its
+// mean. Skips the first frames: until the first step there is nothing to
+// interpolate towards.
+static double stepSpread(const std::vector<float>& time) {
+    double mean = 0.0;
+    double worst = 0.0;
+    int count = 0;
+    for (size_t i = 4; i < time.size(); i++) {
+        float delta = time[i] - time[i - 1];
+        if (delta >= 0.0f) {   // Skip the wrap at 100
+            mean += delta;
+            count++;
+        }
+    }
+    mean /= count;
+    for (size_t i = 4; i < time.size(); i++) {
+        float delta = time[i] - time[i - 1];
+        if (delta >= 0.0f) {
+            worst = std::fmax(worst, std::fabs(delta - mean) / mean);
+        }
+    }
+    return worst;
+}
+
+static bool checkSmooth(double seconds) {
+    bool ok = true;
+    for (double hz : {90.0, 144.0}) {
+        std::vector<int64_t> times = frameTimes(hz, seconds);
+        double smooth = stepSpread(replay(times).time);
+        double newest = stepSpread(replay(times, false).time);
+        printf("  %3.0f Hz: per-frame movement varies %5.2f%% interpolated, "
+               "%5.1f%% drawing the newest step\n", hz, 100.0 * smooth, 100.0 * newest);
+        ok = ok && smooth <= 0.01;
+    }
+    return ok;
+}
+
+static bool checkDrops(double seconds) {
+    std::vector<int64_t> all = frameTimes(60.0, seconds);
+
+    // 6 frames missing at 2 s, and at 5 s one frame that shows up 40 ms
+    // late instead of the 3 on-time frames it overlaps
+    std::vector<int64_t> sorted;
+    for (int64_t t : frameTimes(60.0, seconds, 2.0, 2.1)) {
+        int64_t at = t - kStart;
+        if (at >= 5000000000LL && at < 5040000000LL) {
+            continue;
+        }
+        if (at > 5040000000LL && sorted.back() < kStart + 5040000000LL) {
+            sorted.push_back(kStart + 5040000000LL);
+        }
+        sorted.push_back(t);
+    }
+
+    Run reference = replay(all);
+    Run hitched = replay(sorted);
+    size_t j = 0;
+    int compared = 0;
+    float worst = 0.0f;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        while (j + 1 < all.size() && all[j] < sorted[i]) {
+            j++;
+        }
+        if (all[j] == sorted[i]) {
+            worst = std::fmax(worst, std::fabs(hitched.x[i] - reference.x[j]));
+            compared++;
+        }
+    }
+    size_t missing = all.size() - sorted.size();
+    std::vector<float> old = replayPerFrame(sorted.size());
+    printf("  %zu fewer frames (most steps in one frame: %d): worst %.4f px from the "
+           "run without drops over %d frames\n", missing, hitched.stats.maxSteps, worst,
+           compared);
+    printf("  the old way ends %.0f px behind (%zu frames of motion lost for good)\n",
+           std::fabs(old.back() - reference.x.back()), missing);
+    return worst == 0.0f && hitched.stats.steps == reference.stats.steps;
+}
+
+static bool checkStall() {
+    timeline::Timeline clock;
+    clock.advance(kStart);
+    int steps = clock.advance(kStart + 2000000000LL);
+    timeline::TimelineStats stats = clock.stats();
+    int expected = static_cast<int>(timeline::kDefaultMaxFrameNanos / timeline::kDefaultStepNanos);
+    printf("  2 s stall: %d steps caught up (%.0f ms), %.0f ms dropped\n", steps,
+           steps * clock.stepNanos() / 1e6, stats.droppedNanos / 1e6);
+    bool ok = steps == expected &&
+              stats.droppedNanos == 2000000000LL - timeline::kDefaultMaxFrameNanos;
+
+    clock.reset();
+    int afterReset = clock.advance(kStart + 10000000000LL);
+    int next = clock.advance(kStart + 10000000000LL + timeline::kDefaultStepNanos);
+    printf("  reset, then 8 s later: %d steps, then %d for one step of time\n", afterReset, next);
+    return ok && afterReset == 0 && next == 1;
+}
+
+static void measureCost(int frames) {
+    timeline::Timeline clock;
+    raster::SceneState current;
+    raster::SceneState previous;
+    float sink = 0.0f;
+    double start = bench::nowSeconds();
+    for (int i = 0; i < frames; i++) {
+        int steps = clock.advance(kStart + static_cast<int64_t>(i) * 11111111LL);
+        for (int s = 0; s < steps; s++) {
+            previous = current;
+            raster::advanceScene(current, clock.stepSeconds());
+        }
+        sink += raster::interpolateScene(previous, current, clock.alpha()).time;
+    }
+    double ns = (bench::nowSeconds() - start) * 1e9 / frames;
+    printf("  advance + steps + interpolate at 90 Hz: %.1f ns/frame (checksum %.0f)\n", ns, sink);
+}
+
+int main(int argc, char** argv) {
+    const double seconds = bench::intArg(argc, argv, 1, 10);
+
+    printf("Circle x on a %d-wide buffer, %.0f s per rate, %.3f ms steps:\n", kWidth, seconds,
+           timeline::kDefaultStepNanos / 1e6);
+    bool ratesOk = checkRates(seconds);
+
+    printf("\nSmoothness:\n");
+    bool smoothOk = checkSmooth(seconds);
+
+    printf("\nDropped frames at 60 Hz:\n");
+    bool dropsOk = checkDrops(seconds);
+
+    printf("\nStalls:\n");
+    bool stallOk = checkStall();
+
+    printf("\nCost:\n");
+    measureCost(10000000);
+
+    if (!ratesOk || !smoothOk || !dropsOk || !stallOk) {
+        printf("\nverify: FAILED (rates %s, smooth %s, drops %s, stall %s)\n",
+               ratesOk ? "ok" : "wrong", smoothOk ? "ok" : "wrong", dropsOk ? "ok" : "wrong",
+               stallOk ? "ok" : "wrong");
+        return 1;
+    }
+    printf("\nverify: same motion at every rate, drops catch up, stalls capped\n");
+    return 0;
+}
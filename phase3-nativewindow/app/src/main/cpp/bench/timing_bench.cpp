@@ -0,0 +1,240 @@
+/**
+ * bench/timing_bench.cpp: Cost and correctness of the frame timing ring
+ *
+ * Checked (exit code 1 on failure):
+ * - percentiles: 300 frames with known stage times on a SimulatedClock.
+ *   The ring must keep exactly the last 256 and p50/p95/p99/max/mean
+ *   must match the nearest-rank values computed by hand.
+ * - no allocation: the render-thread side (FrameTimer + publish) must not
+ *   call operator new, counted with a replacement operator new.
+ * - no torn reads: a writer thread publishes frames whose fields all
+ *   derive from the frame number while a reader snapshots continuously.
+ *   Every sample the reader keeps must be self-consistent and in order.
+ *
+ * Then it prints what instrumenting a frame costs with the real clock.
+ *
+ * Usage: timing_bench [seconds for the torn-read test]
+ */
+
+#include "bench_util.h"
+#include "../frame/frame_timing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Count every heap allocation in the process
+static std::atomic<int64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static const int64_t kMicro = 1000;
+
+// Frame i: stage s takes (i + 1) * (s + 1) microseconds
+static void recordKnownFrames(frame::FrameTimingRing& ring, int frames) {
+    frame::SimulatedClock clock;
+    frame::FrameTimer timer(clock, ring);
+    for (int i = 0; i < frames; i++) {
+        timer.beginFrame();
+        for (int stage = 0; stage < frame::kStageTotal; stage++) {
+            clock.advance((i + 1) * (stage + 1) * kMicro);
+            timer.endStage(static_cast<frame::FrameStage>(stage));
+        }
+        timer.endFrame();
+    }
+}
+
+static bool checkPercentiles() {
+    const int frames = 300;
+    frame::FrameTimingRing ring;
+    recordKnownFrames(ring, frames);
+    frame::TimingSummary summary = frame::summarizeTimings(ring);
+
+    bool ok = summary.frames == static_cast<int64_t>(frame::kFrameTimingCapacity) &&
+              summary.framesPublished == frames;
+
+    // The ring holds frames first..frames-1; sample k (sorted) is frame first+k
+    const int kept = static_cast<int>(frame::kFrameTimingCapacity);
+    const int first = frames - kept;
+    auto rankValue = [&](int percent, int64_t scale) {
+        int rank = (kept * percent + 99) / 100;
+        return (first + rank) * scale * kMicro;
+    };
+
+    for (int stage = 0; stage < frame::kStageCount; stage++) {
+        // Stage s scales with (s + 1); Total is the sum 1 + 2 + 3 + 4
+        int64_t scale = stage == frame::kStageTotal ? 10 : stage + 1;
+        const frame::StageSummary& s = summary.stages[stage];
+        int64_t mean = (first + 1 + frames) * kept / 2 * scale * kMicro / kept;
+        bool stageOk = s.p50 == rankValue(50, scale) && s.p95 == rankValue(95, scale) &&
+                       s.p99 == rankValue(99, scale) && s.max == frames * scale * kMicro &&
+                       s.mean == mean;
+        printf("  %-7s p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f  mean %7.3f ms%s\n",
+               frame::stageName(stage), s.p50 / 1e6, s.p95 / 1e6, s.p99 / 1e6,
+               s.max / 1e6, s.mean / 1e6, stageOk ? "" : "  <-- WRONG");
+        ok = ok && stageOk;
+    }
+
+    // The JNI layout puts stage s field f at 2 + s * 5 + f
+    int64_t packed[frame::kTimingSnapshotLongs];
+    frame::packTimingSummary(summary, packed);
+    ok = ok && packed[0] == summary.frames && packed[1] == frames &&
+         packed[2 + frame::kStageRaster * frame::kTimingFieldsPerStage + 2] ==
+                 summary.stages[frame::kStageRaster].p99;
+    return ok;
+}
+
+static bool checkNoAllocation() {
+    frame::FrameTimingRing ring;
+    frame::MonotonicClock clock;
+    frame::FrameTimer timer(clock, ring);
+
+    int64_t before = g_allocations.load();
+    for (int i = 0; i < 10000; i++) {
+        timer.beginFrame();
+        timer.endStage(frame::kStageRecord);
+        timer.endStage(frame::kStageLock);
+        timer.endStage(frame::kStageRaster);
+        timer.endStage(frame::kStagePost);
+        timer.endFrame();
+    }
+    int64_t allocations = g_allocations.load() - before;
+    printf("  render-thread allocations over 10000 frames: %lld\n",
+           static_cast<long long>(allocations));
+    return allocations == 0;
+}
+
+// Writer: frame k has every stage = k and Total = 4k. The reader rejects
+// any sample that doesn't have that shape (a torn copy) or goes backwards.
+static bool checkTornReads(double seconds) {
+    frame::FrameTimingRing ring;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        frame::FrameTiming timing;
+        int64_t k = 1;
+        while (!done.load(std::memory_order_relaxed)) {
+            for (int stage = 0; stage < frame::kStageTotal; stage++) {
+                timing.nanos[stage] = k;
+            }
+            timing.nanos[frame::kStageTotal] = 4 * k;
+            ring.publish(timing);
+            k++;
+        }
+    });
+
+    std::vector<frame::FrameTiming> copy;
+    int64_t snapshots = 0;
+    int64_t samples = 0;
+    int64_t dropped = 0;
+    int64_t bad = 0;
+    double end = bench::nowSeconds() + seconds;
+    while (bench::nowSeconds() < end) {
+        uint64_t published = ring.framesPublished();
+        ring.copyRecent(copy);
+        snapshots++;
+        samples += static_cast<int64_t>(copy.size());
+        int64_t expected = static_cast<int64_t>(
+                std::min<uint64_t>(published, frame::kFrameTimingCapacity));
+        dropped += std::max<int64_t>(expected - static_cast<int64_t>(copy.size()), 0);
+
+        int64_t last = 0;
+        for (const frame::FrameTiming& timing : copy) {
+            int64_t k = timing.nanos[0];
+            bool consistent = k > last && timing.nanos[frame::kStageTotal] == 4 * k;
+            for (int stage = 1; stage < frame::kStageTotal; stage++) {
+                consistent = consistent && timing.nanos[stage] == k;
+            }
+            if (!consistent) {
+                bad++;
+            }
+            last = k;
+        }
+    }
+    done = true;
+    writer.join();
+
+    printf("  %lld snapshots, %lld samples kept, %lld skipped as overwritten, %lld torn\n",
+           static_cast<long long>(snapshots), static_cast<long long>(samples),
+           static_cast<long long>(dropped),
+           static_cast<long long>(bad));
+    return bad == 0 && samples > 0;
+}
+
+static void measureCost() {
+    frame::FrameTimingRing ring;
+    frame::MonotonicClock clock;
+    frame::FrameTimer timer(clock, ring);
+    const int frames = 200000;
+
+    double start = bench::nowSeconds();
+    for (int i = 0; i < frames; i++) {
+        timer.beginFrame();
+        timer.endStage(frame::kStageRecord);
+        timer.endStage(frame::kStageLock);
+        timer.endStage(frame::kStageRaster);
+        timer.endStage(frame::kStagePost);
+        timer.endFrame();
+    }
+    double perFrame = (bench::nowSeconds() - start) / frames;
+
+    frame::FrameTiming timing;
+    start = bench::nowSeconds();
+    for (int i = 0; i < frames; i++) {
+        timing.nanos[0] = i;
+        ring.publish(timing);
+    }
+    double perPublish = (bench::nowSeconds() - start) / frames;
+
+    start = bench::nowSeconds();
+    const int summaries = 2000;
+    volatile int64_t sink = 0;  // Keep the summaries from being optimized out
+    for (int i = 0; i < summaries; i++) {
+        sink = sink + frame::summarizeTimings(ring).stages[0].p50;
+    }
+    double perSummary = (bench::nowSeconds() - start) / summaries;
+
+    printf("  instrumented frame (6 clock reads + publish): %.0f ns\n", perFrame * 1e9);
+    printf("  publish alone:                                %.0f ns\n", perPublish * 1e9);
+    printf("  summarize %zu frames (reader side):           %.1f us\n",
+           frame::kFrameTimingCapacity, perSummary * 1e6);
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+
+    printf("Known stage times, 300 frames into a %zu-frame ring:\n",
+           frame::kFrameTimingCapacity);
+    bool percentilesOk = checkPercentiles();
+
+    printf("\nWriter side:\n");
+    bool noAllocation = checkNoAllocation();
+
+    printf("\nConcurrent writer + reader for %.1f s:\n", seconds);
+    bool noTears = checkTornReads(seconds);
+
+    printf("\nCost:\n");
+    measureCost();
+
+    if (!percentilesOk || !noAllocation || !noTears) {
+        printf("\nverify: FAILED (percentiles %s, allocation %s, torn reads %s)\n",
+               percentilesOk ? "ok" : "wrong", noAllocation ? "none" : "FOUND",
+               noTears ? "none" : "FOUND");
+        return 1;
+    }
+    printf("\nverify: percentiles exact, no render-thread allocation, no torn reads\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * bench/trace_bench.cpp: Per-frame logging vs the binary trace ring
+ *
+ * Compares what the render thread pays per event:
+ * - "log":    what LOGD("Drawing frame: ...") did every frame: format the
+ *             string, then one write() syscall (to /dev/null here; on a
+ *             device it's a socket write to logd, which costs more)
+ * - "trace":  trace::TraceRing::record(), 4 ints into a ring slot
+ *
+ * Checked (exit code 1 on failure):
+ * - compile-time levels: LOGD/LOGV must not even evaluate their arguments
+ *   when NATIVE_LOG_LEVEL is above them (Release builds: NDEBUG -> INFO).
+ * - 4 writer threads record while another thread drains. Every drained
+ *   line must parse back into a self-consistent event, each writer's
+ *   events must arrive in order, and delivered + lost == recorded.
+ *
+ * Usage: trace_bench [seconds for the concurrent test]
+ */
+
+#define LOG_TAG "TraceBench"
+
+#include "bench_util.h"
+#include "common/log.h"
+#include "common/trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+enum { kEventFrame, kEventCheck, kEventCount };
+
+static const trace::EventInfo kEvents[kEventCount] = {
+    {"frame", "%dx%d, stride=%d, format=%d"},
+    {"check", "%d %d %d %d"},
+};
+
+static int g_evaluations = 0;
+
+static int countEvaluation() {
+    return ++g_evaluations;
+}
+
+static bool checkCompileTimeLevels() {
+    g_evaluations = 0;
+    LOGV("verbose %d", countEvaluation());
+    LOGD("debug %d", countEvaluation());
+    int expected = (NATIVE_LOG_LEVEL <= NATIVE_LOG_VERBOSE) + (NATIVE_LOG_LEVEL <= NATIVE_LOG_DEBUG);
+    printf("  NATIVE_LOG_LEVEL %d: LOGV + LOGD evaluated their arguments %d times (expected %d)\n",
+           NATIVE_LOG_LEVEL, g_evaluations, expected);
+    return g_evaluations == expected;
+}
+
+static void measureCost() {
+    const int events = 200000;
+    int devNull = open("/dev/null", O_WRONLY);
+
+    double start = bench::nowSeconds();
+    char line[256];
+    for (int i = 0; i < events; i++) {
+        int length = snprintf(line, sizeof(line), "Drawing frame: %dx%d, stride=%d, format=%d",
+                              1080, 2400 + (i & 1), 1088, 1);
+        if (write(devNull, line, length) < 0) {
+            break;
+        }
+    }
+    double logSeconds = (bench::nowSeconds() - start) / events;
+    close(devNull);
+
+    trace::TraceRing ring(kEvents, kEventCount);
+    start = bench::nowSeconds();
+    for (int i = 0; i < events; i++) {
+        ring.record(kEventFrame, 1080, 2400 + (i & 1), 1088, 1);
+    }
+    double traceSeconds = (bench::nowSeconds() - start) / events;
+
+    // Formatting cost moves to whoever drains
+    start = bench::nowSeconds();
+    size_t lines = ring.drain([](const char*, void*) {}, nullptr);
+    double drainSeconds = lines > 0 ? (bench::nowSeconds() - start) / lines : 0.0;
+
+    printf("  log (snprintf + write):  %6.0f ns/event\n", logSeconds * 1e9);
+    printf("  trace record():          %6.0f ns/event  (%.1fx cheaper)\n", traceSeconds * 1e9,
+           logSeconds / traceSeconds);
+    printf("  drain (format later):    %6.0f ns/event, off the render thread\n",
+           drainSeconds * 1e9);
+}
+
+struct DrainCheck {
+    int64_t lines = 0;
+    int64_t bad = 0;
+    int lastSequence[4] = {-1, -1, -1, -1};
+};
+
+static void checkLine(const char* line, void* user) {
+    auto* check = static_cast<DrainCheck*>(user);
+    check->lines++;
+
+    // "<seconds> tid <tid> check: writer sequence 3*sequence ~sequence"
+    double seconds;
+    unsigned tid;
+    int writer, sequence, triple, inverted;
+    if (sscanf(line, "%lf tid %u check: %d %d %d %d", &seconds, &tid, &writer, &sequence,
+               &triple, &inverted) != 6 ||
+        writer < 0 || writer >= 4 || triple != sequence * 3 || inverted != ~sequence ||
+        sequence <= check->lastSequence[writer]) {
+        check->bad++;
+        return;
+    }
+    check->lastSequence[writer] = sequence;
+}
+
+static bool checkConcurrent(double seconds) {
+    trace::TraceRing ring(kEvents, kEventCount);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; w++) {
+        writers.emplace_back([&ring, &done, w] {
+            for (int sequence = 0; !done.load(std::memory_order_relaxed); sequence++) {
+                ring.record(kEventCheck, w, sequence, sequence * 3, ~sequence);
+                if ((sequence & 255) == 255) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    DrainCheck check;
+    double end = bench::nowSeconds() + seconds;
+    while (bench::nowSeconds() < end) {
+        ring.drain(checkLine, &check);
+    }
+    done = true;
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    ring.drain(checkLine, &check);  // Everything left
+
+    uint64_t recorded = ring.recorded();
+    uint64_t lost = ring.lost();
+    printf("  %llu recorded, %lld drained, %llu lost (overwritten before a drain), %lld bad\n",
+           static_cast<unsigned long long>(recorded), static_cast<long long>(check.lines),
+           static_cast<unsigned long long>(lost), static_cast<long long>(check.bad));
+    return check.bad == 0 && check.lines > 0 &&
+           static_cast<uint64_t>(check.lines) + lost == recorded;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+
+    printf("Compile-time log levels:\n");
+    bool levelsOk = checkCompileTimeLevels();
+
+    printf("\nCost per event on the recording thread:\n");
+    measureCost();
+
+    printf("\nSample drain:\n");
+    trace::TraceRing sample(kEvents, kEventCount);
+    sample.record(kEventFrame, 1080, 2400, 1088, 1);
+    sample.record(kEventFrame, 1080, 2400, 1088, 4);
+    sample.drain([](const char* line, void*) { printf("  %s\n", line); }, nullptr);
+
+    printf("\n4 writers + 1 drainer for %.1f s:\n", seconds);
+    bool concurrentOk = checkConcurrent(seconds);
+
+    if (!levelsOk || !concurrentOk) {
+        printf("\nverify: FAILED (log levels %s, concurrent trace %s)\n",
+               levelsOk ? "ok" : "wrong", concurrentOk ? "ok" : "wrong");
+        return 1;
+    }
+    printf("\nverify: debug logs compiled out as configured, every drained event intact\n");
+    return 0;
+}
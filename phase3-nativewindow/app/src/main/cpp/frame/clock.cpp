@@ -0,0 +1,28 @@
+/**
+ * frame/clock.cpp: A clock the frame loop can be tested against
+ */
+
+#include "clock.h"
+
+#include <cerrno>
+#include <time.h>
+
+namespace frame {
+
+int64_t MonotonicClock::now() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * kNanosPerSecond + now.tv_nsec;
+}
+
+void MonotonicClock::sleepUntil(int64_t deadline) {
+    timespec target;
+    target.tv_sec = static_cast<time_t>(deadline / kNanosPerSecond);
+    target.tv_nsec = static_cast<long>(deadline % kNanosPerSecond);
+
+    // A signal can wake us early; the deadline is absolute, so just retry
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {
+    }
+}
+
+} // namespace frame
@@ -0,0 +1,72 @@
+/**
+ * frame/clock.h: A clock the frame loop can be tested against
+ *
+ * The frame pacer only needs two things from time: "what time is it" and
+ * "sleep until then". Putting those behind an interface lets the same
+ * pacing code run against the real monotonic clock on a device and
+ * against a simulated clock in the host benchmarks, where a 60/90/120 Hz
+ * display can be replayed exactly and instantly.
+ *
+ * All times are nanoseconds on CLOCK_MONOTONIC, the same clock
+ * AChoreographer's frameTimeNanos and System.nanoTime() use.
+ *
+ * Lookup: "clock_nanosleep TIMER_ABSTIME", "CLOCK_MONOTONIC"
+ */
+
+#ifndef PHASE3_FRAME_CLOCK_H
+#define PHASE3_FRAME_CLOCK_H
+
+#include <cstdint>
+
+namespace frame {
+
+static const int64_t kNanosPerSecond = 1000000000LL;
+
+// Period of a display refresh rate, in nanoseconds
+inline int64_t periodForHz(double hz) {
+    return static_cast<int64_t>(kNanosPerSecond / hz + 0.5);
+}
+
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    virtual int64_t now() = 0;
+
+    // Return at (or as soon as possible after) the absolute time `deadline`
+    virtual void sleepUntil(int64_t deadline) = 0;
+};
+
+// The real thing: clock_gettime + clock_nanosleep(TIMER_ABSTIME)
+//
+// Sleeping until an absolute time instead of for a duration means the time
+// spent computing the wakeup doesn't add up frame after frame.
+class MonotonicClock : public Clock {
+public:
+    int64_t now() override;
+    void sleepUntil(int64_t deadline) override;
+};
+
+// Time only moves when told to: sleepUntil() jumps straight to the deadline,
+// advance() stands in for time spent working
+class SimulatedClock : public Clock {
+public:
+    explicit SimulatedClock(int64_t start = 0) : m_now(start) {}
+
+    int64_t now() override { return m_now; }
+
+    void sleepUntil(int64_t deadline) override {
+        if (deadline > m_now) {
+            m_now = deadline;
+        }
+    }
+
+    void advance(int64_t nanos) { m_now += nanos; }
+
+private:
+    int64_t m_now;
+};
+
+} // namespace frame
+
+#endif // PHASE3_FRAME_CLOCK_H
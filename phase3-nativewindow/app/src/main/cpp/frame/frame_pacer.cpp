@@ -0,0 +1,99 @@
+/**
+ * frame/frame_pacer.cpp: Start frames on a fixed vsync-rate grid
+ */
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace frame {
+
+FramePacer::FramePacer(Clock& clock, int64_t periodNanos)
+    : m_clock(clock), m_period(periodNanos) {}
+
+void FramePacer::setPeriod(int64_t periodNanos) {
+    m_period = periodNanos;
+    m_hasGrid = false;
+}
+
+int64_t FramePacer::waitForNextFrame() {
+    int64_t now = m_clock.now();
+
+    if (!m_hasGrid) {
+        // First frame: the grid starts one period from now
+        m_nextDeadline = now + m_period;
+        m_hasGrid = true;
+    } else if (now > m_nextDeadline) {
+        // The last frame overran its slot. Starting right away would eat
+        // into the next slot too, so wait for the first deadline still
+        // ahead of us, like a vsync callback would. Every deadline jumped
+        // over is a refresh that showed an old frame.
+        int64_t late = now - m_nextDeadline;
+        int64_t skipped = late / m_period + 1;
+        m_nextDeadline += skipped * m_period;
+        m_missed++;
+        m_skipped += skipped;
+    }
+
+    m_clock.sleepUntil(m_nextDeadline);
+    int64_t scheduled = m_nextDeadline;
+    m_nextDeadline += m_period;
+    recordFrameStart(m_clock.now());
+    return scheduled;
+}
+
+void FramePacer::onVsync(int64_t vsyncNanos) {
+    if (m_hasLastStart) {
+        // Choreographer timestamps sit on the refresh grid, so the gap is
+        // a whole number of periods (give or take timestamp noise)
+        int64_t periods = static_cast<int64_t>(
+                std::llround(static_cast<double>(vsyncNanos - m_lastStart) / m_period));
+        if (periods > 1) {
+            m_missed++;
+            m_skipped += periods - 1;
+        }
+    }
+    recordFrameStart(vsyncNanos);
+}
+
+void FramePacer::recordFrameStart(int64_t when) {
+    if (m_hasLastStart) {
+        double intervalMs = (when - m_lastStart) / 1e6;
+        m_intervals++;
+        m_intervalSum += intervalMs;
+        m_intervalSumSq += intervalMs * intervalMs;
+        m_intervalMax = std::max(m_intervalMax, intervalMs);
+    }
+    m_lastStart = when;
+    m_hasLastStart = true;
+    m_frames++;
+}
+
+PacerStats FramePacer::stats() const {
+    PacerStats stats;
+    stats.frames = m_frames;
+    stats.missedDeadlines = m_missed;
+    stats.skippedVsyncs = m_skipped;
+    if (m_intervals > 0) {
+        double mean = m_intervalSum / m_intervals;
+        double variance = m_intervalSumSq / m_intervals - mean * mean;
+        stats.meanIntervalMs = mean;
+        stats.jitterMs = std::sqrt(std::max(0.0, variance));
+        stats.maxIntervalMs = m_intervalMax;
+    }
+    return stats;
+}
+
+void FramePacer::resetStats() {
+    // Keep m_lastStart so the first interval after a reset still counts
+    m_frames = 0;
+    m_missed = 0;
+    m_skipped = 0;
+    m_intervals = 0;
+    m_intervalSum = 0.0;
+    m_intervalSumSq = 0.0;
+    m_intervalMax = 0.0;
+}
+
+} // namespace frame
@@ -0,0 +1,88 @@
+/**
+ * frame/frame_pacer.h: Start frames on a fixed vsync-rate grid
+ *
+ * The old render loop did "draw; usleep(16666)". Its real period was
+ * draw time + 16.6 ms (about 48 fps for a 4 ms frame), so frames slid
+ * in and out of phase with the display and some refreshes showed no new
+ * frame at all.
+ *
+ * The pacer keeps a grid of absolute deadlines, one period apart, and
+ * sleeps until the next one. How long the frame took doesn't matter
+ * anymore, as long as it fits in a period. Two ways to drive it:
+ *
+ * TIMER MODE: waitForNextFrame() after each frame. When a frame overran,
+ * the pacer skips to the first deadline still in the future instead of
+ * starting immediately: a late start would only push the next frame over
+ * its deadline too. Frames always start on the grid, and one slow frame
+ * costs exactly the refreshes it overran.
+ *
+ * VSYNC MODE: a real vsync source (AChoreographer) calls onVsync() with
+ * each frame's vsync timestamp. The pacer just keeps the statistics;
+ * a gap of N periods between callbacks means N-1 refreshes were missed.
+ *
+ * STATISTICS (since the last resetStats()): missed deadlines, refreshes
+ * that got no new frame, and the mean / standard deviation (jitter) /
+ * max of the interval between frame starts.
+ *
+ * Lookup: "frame pacing", "Swappy", "AChoreographer_postFrameCallback64"
+ */
+
+#ifndef PHASE3_FRAME_FRAME_PACER_H
+#define PHASE3_FRAME_FRAME_PACER_H
+
+#include "clock.h"
+
+namespace frame {
+
+struct PacerStats {
+    int64_t frames = 0;            // Frame starts recorded
+    int64_t missedDeadlines = 0;   // Frames that started after their deadline
+    int64_t skippedVsyncs = 0;     // Refresh periods with no new frame
+    double meanIntervalMs = 0.0;   // Average time between frame starts
+    double jitterMs = 0.0;         // Standard deviation of that interval
+    double maxIntervalMs = 0.0;    // Longest time between frame starts
+};
+
+class FramePacer {
+public:
+    FramePacer(Clock& clock, int64_t periodNanos);
+
+    // Change the refresh period (restarts the deadline grid)
+    void setPeriod(int64_t periodNanos);
+    int64_t period() const { return m_period; }
+
+    // TIMER MODE: sleep until the next deadline. Returns the deadline the
+    // frame is scheduled for (its intended start, on the grid).
+    int64_t waitForNextFrame();
+
+    // VSYNC MODE: record a vsync callback's frame time
+    void onVsync(int64_t vsyncNanos);
+
+    PacerStats stats() const;
+    void resetStats();
+
+    Clock& clock() { return m_clock; }
+
+private:
+    void recordFrameStart(int64_t when);
+
+    Clock& m_clock;
+    int64_t m_period;
+    bool m_hasGrid = false;       // First waitForNextFrame() starts the grid
+    int64_t m_nextDeadline = 0;
+    bool m_hasLastStart = false;
+    int64_t m_lastStart = 0;
+
+    // Running sums for the statistics
+    int64_t m_frames = 0;
+    int64_t m_missed = 0;
+    int64_t m_skipped = 0;
+    int64_t m_intervals = 0;
+    double m_intervalSum = 0.0;     // Milliseconds
+    double m_intervalSumSq = 0.0;
+    double m_intervalMax = 0.0;
+};
+
+} // namespace frame
+
+#endif // PHASE3_FRAME_FRAME_PACER_H
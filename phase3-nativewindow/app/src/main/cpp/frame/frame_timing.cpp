@@ -0,0 +1,143 @@
+/**
+ * frame/frame_timing.cpp: Per-stage frame times, kept for the last N frames
+ */
+
+#include "frame_timing.h"
+
+#include <algorithm>
+
+namespace frame {
+
+static_assert((kFrameTimingCapacity & (kFrameTimingCapacity - 1)) == 0,
+              "ring index is masked, capacity must be a power of two");
+
+const char* stageName(int stage) {
+    switch (stage) {
+        case kStageRecord: return "record";
+        case kStageLock: return "lock";
+        case kStageRaster: return "raster";
+        case kStagePost: return "post";
+        case kStageTotal: return "total";
+    }
+    return "?";
+}
+
+void FrameTimingRing::publish(const FrameTiming& timing) {
+    // Only this thread writes m_published, so a relaxed load is exact
+    uint64_t index = m_published.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[index & (kFrameTimingCapacity - 1)];
+
+    // Odd sequence: "being written". The fence keeps the field stores
+    // below from becoming visible before it.
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int i = 0; i < kStageCount; i++) {
+        slot.nanos[i].store(timing.nanos[i], std::memory_order_relaxed);
+    }
+
+    // Even again, and it names the frame: the fields are complete
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    m_published.store(index + 1, std::memory_order_release);
+}
+
+void FrameTimingRing::copyRecent(std::vector<FrameTiming>& out) const {
+    out.clear();
+    uint64_t end = m_published.load(std::memory_order_acquire);
+    uint64_t count = std::min<uint64_t>(end, kFrameTimingCapacity);
+    out.reserve(count);
+
+    for (uint64_t index = end - count; index < end; index++) {
+        const Slot& slot = m_slots[index & (kFrameTimingCapacity - 1)];
+
+        // The slot must hold exactly frame `index`, complete. Anything
+        // else is a write in progress or a newer frame that lapped it.
+        const uint64_t complete = 2 * index + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != complete) {
+            continue;
+        }
+
+        FrameTiming timing;
+        for (int i = 0; i < kStageCount; i++) {
+            timing.nanos[i] = slot.nanos[i].load(std::memory_order_relaxed);
+        }
+
+        // Re-check after the copy: if the sequence moved, the writer
+        // wrapped around onto this slot while we read it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != complete) {
+            continue;
+        }
+        out.push_back(timing);
+    }
+}
+
+void FrameTimer::beginFrame() {
+    m_frameStart = m_clock.now();
+    m_stageStart = m_frameStart;
+    m_current = FrameTiming();
+}
+
+void FrameTimer::endStage(FrameStage stage) {
+    int64_t now = m_clock.now();
+    m_current.nanos[stage] += now - m_stageStart;
+    m_stageStart = now;
+}
+
+void FrameTimer::endFrame() {
+    m_current.nanos[kStageTotal] = m_clock.now() - m_frameStart;
+    m_ring.publish(m_current);
+}
+
+// Nearest-rank percentile of sorted samples: the smallest value with at
+// least `percent` % of the samples at or below it
+static int64_t percentile(const std::vector<int64_t>& sorted, int percent) {
+    size_t rank = (sorted.size() * percent + 99) / 100;  // ceil(n * p / 100)
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+TimingSummary summarizeTimings(const FrameTimingRing& ring) {
+    std::vector<FrameTiming> frames;
+    ring.copyRecent(frames);
+
+    TimingSummary summary;
+    summary.frames = static_cast<int64_t>(frames.size());
+    summary.framesPublished = static_cast<int64_t>(ring.framesPublished());
+    if (frames.empty()) {
+        return summary;
+    }
+
+    std::vector<int64_t> samples(frames.size());
+    for (int stage = 0; stage < kStageCount; stage++) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            samples[i] = frames[i].nanos[stage];
+            sum += samples[i];
+        }
+        std::sort(samples.begin(), samples.end());
+
+        StageSummary& out = summary.stages[stage];
+        out.p50 = percentile(samples, 50);
+        out.p95 = percentile(samples, 95);
+        out.p99 = percentile(samples, 99);
+        out.max = samples.back();
+        out.mean = sum / static_cast<int64_t>(samples.size());
+    }
+    return summary;
+}
+
+void packTimingSummary(const TimingSummary& summary, int64_t out[kTimingSnapshotLongs]) {
+    out[0] = summary.frames;
+    out[1] = summary.framesPublished;
+    for (int stage = 0; stage < kStageCount; stage++) {
+        int64_t* fields = out + 2 + stage * kTimingFieldsPerStage;
+        const StageSummary& s = summary.stages[stage];
+        fields[0] = s.p50;
+        fields[1] = s.p95;
+        fields[2] = s.p99;
+        fields[3] = s.max;
+        fields[4] = s.mean;
+    }
+}
+
+} // namespace frame
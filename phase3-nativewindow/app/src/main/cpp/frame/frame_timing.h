@@ -0,0 +1,144 @@
+/**
+ * frame/frame_timing.h: Per-stage frame times, kept for the last N frames
+ *
+ * "The frame takes 9 ms" doesn't say where to look. The render thread
+ * stamps the clock between the stages of each frame (record the display
+ * list, ANativeWindow_lock, rasterize the tiles, ANativeWindow_unlockAndPost)
+ * and publishes one FrameTiming per frame into a ring of the last
+ * kFrameTimingCapacity frames. Any other thread (JNI, a benchmark) can
+ * summarize the ring into p50/p95/p99/max per stage at any time.
+ *
+ * RULES FOR THE RENDER THREAD: publishing never allocates, never takes a
+ * lock and never waits for a reader. The ring is fixed-size and each slot
+ * is a SEQLOCK: the writer sets the slot's sequence number to odd, writes
+ * the fields, then sets it to even. The sequence also encodes the frame
+ * number, so a reader knows which frame it expects in each slot. It keeps
+ * a copy only if it saw that frame's even sequence before and after;
+ * otherwise the writer lapped it mid-copy and that sample is dropped.
+ * Readers pay for dropped samples and sorting, the writer pays a few stores.
+ *
+ * ONE WRITER: publish() must only ever be called from one thread at a
+ * time (the render thread). Any number of readers may call copyRecent().
+ *
+ * Lookup: "seqlock", "lock-free ring buffer", "percentile nearest rank"
+ */
+
+#ifndef PHASE3_FRAME_FRAME_TIMING_H
+#define PHASE3_FRAME_FRAME_TIMING_H
+
+#include "clock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace frame {
+
+// Stages of one phase 3 frame, in the order they run.
+// Total is the whole frame (first stage start to last stage end).
+// Values are also the stage indices of the JNI snapshot (see
+// NativeRenderer.TIMING_STAGE_* on the Java side), so only append.
+enum FrameStage {
+    kStageRecord = 0,   // Build, cull and sort the display list
+    kStageLock = 1,     // ANativeWindow_lock (may wait for a free buffer)
+    kStageRaster = 2,   // Clear + draw the dirty tiles (all threads)
+    kStagePost = 3,     // ANativeWindow_unlockAndPost
+    kStageTotal = 4,
+    kStageCount = 5,
+};
+
+const char* stageName(int stage);
+
+struct FrameTiming {
+    int64_t nanos[kStageCount] = {};
+};
+
+static const size_t kFrameTimingCapacity = 256;  // Power of two
+
+class FrameTimingRing {
+public:
+    FrameTimingRing() = default;
+    FrameTimingRing(const FrameTimingRing&) = delete;
+    FrameTimingRing& operator=(const FrameTimingRing&) = delete;
+
+    // WRITER: store one frame, overwriting the oldest once full.
+    // Wait-free: a handful of relaxed stores and two release stores.
+    void publish(const FrameTiming& timing);
+
+    // READER: copy out the most recent frames (up to kFrameTimingCapacity),
+    // oldest first. Samples the writer overwrote during the copy are
+    // skipped, so this can return fewer than framesPublished() frames.
+    void copyRecent(std::vector<FrameTiming>& out) const;
+
+    // Frames published since construction (not capped at the capacity)
+    uint64_t framesPublished() const { return m_published.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        // 2 * frame + 1 while frame is being written, 2 * frame + 2 once done
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<int64_t> nanos[kStageCount] = {};
+    };
+
+    Slot m_slots[kFrameTimingCapacity];
+    std::atomic<uint64_t> m_published{0};
+};
+
+// Stamps the clock between stages and publishes the frame at the end.
+// Lives on the render thread; only the ring is shared.
+class FrameTimer {
+public:
+    FrameTimer(Clock& clock, FrameTimingRing& ring) : m_clock(clock), m_ring(ring) {}
+
+    // Start a frame: the first stage starts now
+    void beginFrame();
+
+    // The current stage ended now; the next one starts now
+    void endStage(FrameStage stage);
+
+    // Compute Total and publish. A frame that bails out early (lock
+    // failed) simply never calls this and isn't recorded.
+    void endFrame();
+
+    // The frame being timed (after endFrame(): the one just published)
+    const FrameTiming& current() const { return m_current; }
+
+private:
+    Clock& m_clock;
+    FrameTimingRing& m_ring;
+    FrameTiming m_current;
+    int64_t m_frameStart = 0;
+    int64_t m_stageStart = 0;
+};
+
+// Percentiles of one stage, nanoseconds
+struct StageSummary {
+    int64_t p50 = 0;
+    int64_t p95 = 0;
+    int64_t p99 = 0;
+    int64_t max = 0;
+    int64_t mean = 0;
+};
+
+struct TimingSummary {
+    int64_t frames = 0;           // Samples summarized (at most the capacity)
+    int64_t framesPublished = 0;  // All frames ever published
+    StageSummary stages[kStageCount];
+};
+
+// READER: snapshot the ring and compute per-stage percentiles
+// (nearest rank over the samples, so p99 of 256 frames is the 3rd worst)
+TimingSummary summarizeTimings(const FrameTimingRing& ring);
+
+// Flat int64 layout for the JNI ByteBuffer (native byte order):
+//   [0] frames  [1] framesPublished
+//   then for each stage: p50, p95, p99, max, mean
+static const int kTimingFieldsPerStage = 5;
+static const int kTimingSnapshotLongs = 2 + kStageCount * kTimingFieldsPerStage;
+
+void packTimingSummary(const TimingSummary& summary, int64_t out[kTimingSnapshotLongs]);
+
+} // namespace frame
+
+#endif // PHASE3_FRAME_FRAME_TIMING_H
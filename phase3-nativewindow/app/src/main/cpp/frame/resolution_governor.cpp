@@ -0,0 +1,117 @@
+/**
+ * frame/resolution_governor.cpp: Dynamic resolution scaling
+ */
+
+#include "resolution_governor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace frame {
+
+ResolutionGovernor::ResolutionGovernor(int64_t budgetNanos, const GovernorConfig& config)
+    : m_config(config), m_budget(budgetNanos) {
+    m_config.minScale = std::min(std::max(m_config.minScale, 0.1), 1.0);
+    m_config.scaleStep = std::max(m_config.scaleStep, 0.01);
+    m_config.downFrames = std::min(std::max(m_config.downFrames, 1), kMaxWindow);
+    m_config.upFrames = std::min(std::max(m_config.upFrames, 1), kMaxWindow);
+    m_config.settleFrames = std::max(m_config.settleFrames, 0);
+
+    // 1.0, 1.0 - step, ... and minScale itself as the last rung
+    for (double scale = 1.0; m_levelCount < kMaxLevels - 1; scale -= m_config.scaleStep) {
+        if (scale <= m_config.minScale + 1e-9) {
+            break;
+        }
+        m_levels[m_levelCount++] = scale;
+    }
+    m_levels[m_levelCount++] = m_config.minScale;
+}
+
+void ResolutionGovernor::reset() {
+    m_level = 0;
+    m_next = 0;
+    m_count = 0;
+    m_settle = 0;
+}
+
+double ResolutionGovernor::meanOfLast(int frames) const {
+    int64_t sum = 0;
+    for (int i = 1; i <= frames; i++) {
+        sum += m_samples[(m_next - i + kMaxWindow) % kMaxWindow];
+    }
+    return static_cast<double>(sum) / frames;
+}
+
+void ResolutionGovernor::changeLevel(int level) {
+    if (level > m_level) {
+        m_downscales++;
+    } else {
+        m_upscales++;
+    }
+    m_level = level;
+    m_count = 0;
+    m_settle = m_config.settleFrames;
+}
+
+bool ResolutionGovernor::onFrame(int64_t workNanos) {
+    m_frames++;
+    if (m_settle > 0) {
+        m_settle--;
+        return false;
+    }
+    m_samples[m_next] = workNanos;
+    m_next = (m_next + 1) % kMaxWindow;
+    m_count = std::min(m_count + 1, kMaxWindow);
+
+    const double high = m_config.highWater * m_budget;
+    const double low = m_config.lowWater * m_budget;
+    const double target = 0.5 * (high + low);
+    const double current = m_levels[m_level];
+
+    // Work scales with pixels: at scale s it would be mean * (s / current)^2
+    auto predicted = [&](double mean, int level) {
+        double ratio = m_levels[level] / current;
+        return mean * ratio * ratio;
+    };
+
+    // DOWN: the recent frames are over budget. Jump straight to the
+    // biggest scale predicted to land at the middle of the band.
+    if (m_count >= m_config.downFrames && m_level + 1 < m_levelCount) {
+        double mean = meanOfLast(m_config.downFrames);
+        if (mean > high) {
+            int level = m_level + 1;
+            while (level + 1 < m_levelCount && predicted(mean, level) > target) {
+                level++;
+            }
+            changeLevel(level);
+            return true;
+        }
+    }
+
+    // UP: a long stretch with headroom, and one step up still fits
+    if (m_count >= m_config.upFrames && m_level > 0) {
+        double mean = meanOfLast(m_config.upFrames);
+        if (mean < low && predicted(mean, m_level - 1) <= target) {
+            changeLevel(m_level - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+GovernorStats ResolutionGovernor::stats() const {
+    GovernorStats stats;
+    stats.frames = m_frames;
+    stats.downscales = m_downscales;
+    stats.upscales = m_upscales;
+    int window = std::min(m_count, m_config.downFrames);
+    stats.meanWorkMs = window > 0 ? meanOfLast(window) / 1e6 : 0.0;
+    return stats;
+}
+
+void scaledSize(int width, int height, float scale, int* scaledWidth, int* scaledHeight) {
+    *scaledWidth = std::max(1, static_cast<int>(std::lround(width * static_cast<double>(scale))));
+    *scaledHeight = std::max(1, static_cast<int>(std::lround(height * static_cast<double>(scale))));
+}
+
+} // namespace frame
@@ -0,0 +1,108 @@
+/**
+ * frame/resolution_governor.h: Dynamic resolution scaling
+ *
+ * A software renderer's cost grows with the number of pixels, and the
+ * full window is a lot of pixels on a 1440p phone. When the frame doesn't
+ * fit in the refresh period, rendering fewer pixels is the cheapest fix:
+ * ANativeWindow_setBuffersGeometry(window, w, h, format) with a smaller
+ * w x h makes the window hand out smaller buffers, and the compositor
+ * scales them up to the view for free (in its display hardware).
+ *
+ * The governor watches measured frame WORK time (record + raster, not
+ * time spent blocked in lock/post, which more pixels wouldn't fix) and
+ * picks a scale per axis from a ladder: 1.0, 0.9, ... down to minScale.
+ *
+ * HYSTERESIS: a governor that reacts to every slow frame would flip the
+ * resolution back and forth, and every change costs a full repaint.
+ * - Two thresholds: above highWater x budget it goes down, below
+ *   lowWater x budget it may go up, in between nothing happens.
+ * - Down is quick (mean of the last downFrames), up is cautious (mean of
+ *   the last upFrames, one step at a time).
+ * - It predicts before moving: cost scales with pixel count, i.e.
+ *   scale^2. Going down picks the biggest scale predicted to land
+ *   between the thresholds; going up only happens if the next step is
+ *   predicted to land there too, so it never raises into an immediate
+ *   drop.
+ * - After every change it ignores settleFrames frames (the first ones
+ *   at a new size are full repaints) and starts measuring afresh.
+ *
+ * Lookup: "dynamic resolution scaling", "ANativeWindow_setBuffersGeometry",
+ *         "hysteresis control loop"
+ */
+
+#ifndef PHASE3_FRAME_RESOLUTION_GOVERNOR_H
+#define PHASE3_FRAME_RESOLUTION_GOVERNOR_H
+
+#include <cstdint>
+
+namespace frame {
+
+struct GovernorConfig {
+    double minScale = 0.5;     // Smallest scale per axis (0.5 = a quarter of the pixels)
+    double scaleStep = 0.1;    // Ladder step per axis
+    double highWater = 0.85;   // Mean work above this fraction of the budget: go down
+    double lowWater = 0.60;    // Below this fraction: consider going up
+    int downFrames = 10;       // Frames averaged for going down
+    int upFrames = 60;         // Frames averaged for going up
+    int settleFrames = 10;     // Frames ignored after a change
+};
+
+struct GovernorStats {
+    int64_t frames = 0;        // onFrame() calls
+    int64_t downscales = 0;
+    int64_t upscales = 0;
+    double meanWorkMs = 0.0;   // Over the last downFrames frames
+};
+
+class ResolutionGovernor {
+public:
+    static const int kMaxLevels = 32;
+    static const int kMaxWindow = 256;   // upFrames/downFrames are clamped to this
+
+    ResolutionGovernor(int64_t budgetNanos, const GovernorConfig& config = GovernorConfig());
+
+    // The refresh period the work has to fit in
+    void setBudget(int64_t budgetNanos) { m_budget = budgetNanos; }
+    int64_t budget() const { return m_budget; }
+
+    // Record one frame's work time. Returns true if the scale changed
+    // (apply it before the next frame).
+    bool onFrame(int64_t workNanos);
+
+    // Back to full resolution, history forgotten
+    void reset();
+
+    float scale() const { return static_cast<float>(m_levels[m_level]); }
+    int level() const { return m_level; }
+    int levelCount() const { return m_levelCount; }
+    const GovernorConfig& config() const { return m_config; }
+    GovernorStats stats() const;
+
+private:
+    double meanOfLast(int frames) const;
+    void changeLevel(int level);
+
+    GovernorConfig m_config;
+    int64_t m_budget;
+
+    double m_levels[kMaxLevels];   // Scale per level, level 0 = 1.0
+    int m_levelCount = 0;
+    int m_level = 0;
+
+    // Recent work times (ring); m_count valid samples since the last change
+    int64_t m_samples[kMaxWindow] = {};
+    int m_next = 0;
+    int m_count = 0;
+    int m_settle = 0;
+
+    int64_t m_frames = 0;
+    int64_t m_downscales = 0;
+    int64_t m_upscales = 0;
+};
+
+// Buffer size for `scale`: rounded, at least 1x1
+void scaledSize(int width, int height, float scale, int* scaledWidth, int* scaledHeight);
+
+} // namespace frame
+
+#endif // PHASE3_FRAME_RESOLUTION_GOVERNOR_H
@@ -0,0 +1,184 @@
+/**
+ * frame/spsc_ring.h: Bounded single-producer / single-consumer snapshot ring
+ *
+ * Hands whole frames from one thread to another without locks, copies or
+ * allocation. The ring owns N slots (T is constructed once, in place, and
+ * reused forever, so a slot can keep its own arena and display list warm):
+ *
+ *     PRODUCER                          CONSUMER
+ *     T* slot = ring.beginWrite();      const T* frame = ring.acquireNewest();
+ *     if (slot) {                       if (frame) {
+ *         ...fill *slot...                  ...read *frame...
+ *         ring.commitWrite();               ring.release();
+ *     }                                 }
+ *
+ * LATEST WINS: a renderer never wants an old frame when a newer one is
+ * ready. acquireNewest() takes the most recent committed slot and frees
+ * every older one in the same step (counted as skipped). The consumer
+ * holds its slot until release(), so the producer can never overwrite
+ * the frame being read; it can only fill the other N-1 slots.
+ *
+ * FULL RING: beginWrite() returns nullptr instead of waiting. The
+ * producer decides what a dropped frame means (the simulation just
+ * carries on with the next step). Counted as rejected.
+ *
+ * HOW: two counters. m_head is the number of slots ever committed (only
+ * the producer writes it), m_tail the oldest slot still in use (only the
+ * consumer writes it). Slot i lives at i % N. Each side publishes its
+ * counter with a release store and reads the other's with an acquire
+ * load, which orders the slot contents with the counter that hands the
+ * slot over. head - tail is the queue depth.
+ *
+ * STATISTICS (cumulative): committed, consumed, skipped as stale,
+ * rejected as full, polls that found nothing, and the depth the consumer
+ * saw on each acquire. Each counter has exactly one writer; stats() may
+ * be called from any thread.
+ *
+ * Lookup: "lock-free SPSC queue", "triple buffering", "Lamport queue"
+ */
+
+#ifndef PHASE3_FRAME_SPSC_RING_H
+#define PHASE3_FRAME_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace frame {
+
+struct QueueStats {
+    int64_t committed = 0;   // Frames the producer handed over
+    int64_t consumed = 0;    // Frames the consumer acquired
+    int64_t skipped = 0;     // Committed, but a newer frame was acquired first
+    int64_t rejected = 0;    // beginWrite() found every slot in use
+    int64_t empty = 0;       // acquireNewest() found nothing new
+    int64_t maxDepth = 0;    // Most frames waiting at one acquire
+    double meanDepth = 0.0;  // Frames waiting per successful acquire
+};
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2, "The consumer holds one slot; the producer needs another");
+
+public:
+    static const size_t kCapacity = N;
+
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // ---- Producer thread ----
+
+    // The next free slot (with whatever the producer left in it last
+    // lap), or nullptr if the consumer still has all the others
+    T* beginWrite() {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            m_rejected.store(m_rejected.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &m_slots[head % N];
+    }
+
+    // Hand the slot from beginWrite() to the consumer
+    void commitWrite() {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // ---- Consumer thread ----
+
+    // The newest committed frame, or nullptr if nothing arrived since the
+    // last acquire. Older committed frames are freed for the producer.
+    // Every non-null result must be followed by release().
+    const T* acquireNewest() {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        if (head == tail) {
+            m_empty.store(m_empty.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        uint64_t depth = head - tail;
+        uint64_t newest = head - 1;
+        if (newest != tail) {
+            // Free the stale ones, keep `newest` (tail now points at it)
+            m_tail.store(newest, std::memory_order_release);
+        }
+
+        m_consumed.store(m_consumed.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+        m_skipped.store(m_skipped.load(std::memory_order_relaxed) +
+                                static_cast<int64_t>(depth - 1),
+                        std::memory_order_relaxed);
+        m_depthSum.store(m_depthSum.load(std::memory_order_relaxed) +
+                                 static_cast<int64_t>(depth),
+                         std::memory_order_relaxed);
+        if (static_cast<int64_t>(depth) > m_maxDepth.load(std::memory_order_relaxed)) {
+            m_maxDepth.store(static_cast<int64_t>(depth), std::memory_order_relaxed);
+        }
+        return &m_slots[newest % N];
+    }
+
+    // Done reading the frame from acquireNewest(); its slot is free again
+    void release() {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    // ---- Any thread ----
+
+    // Frames committed but not yet released (including the one held)
+    size_t depth() const {
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        return static_cast<size_t>(head - tail);
+    }
+
+    QueueStats stats() const {
+        QueueStats stats;
+        stats.committed = static_cast<int64_t>(m_head.load(std::memory_order_acquire));
+        stats.consumed = m_consumed.load(std::memory_order_relaxed);
+        stats.skipped = m_skipped.load(std::memory_order_relaxed);
+        stats.rejected = m_rejected.load(std::memory_order_relaxed);
+        stats.empty = m_empty.load(std::memory_order_relaxed);
+        stats.maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+        int64_t depthSum = m_depthSum.load(std::memory_order_relaxed);
+        stats.meanDepth = stats.consumed > 0 ? static_cast<double>(depthSum) / stats.consumed
+                                             : 0.0;
+        return stats;
+    }
+
+    // Only while neither thread is using the ring (e.g. before they start)
+    void reset() {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_consumed.store(0, std::memory_order_relaxed);
+        m_skipped.store(0, std::memory_order_relaxed);
+        m_rejected.store(0, std::memory_order_relaxed);
+        m_empty.store(0, std::memory_order_relaxed);
+        m_depthSum.store(0, std::memory_order_relaxed);
+        m_maxDepth.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    T m_slots[N];
+
+    // Separate cache lines: the producer hammers m_head, the consumer m_tail
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    std::atomic<int64_t> m_rejected{0};           // Producer's counter
+
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+    std::atomic<int64_t> m_consumed{0};           // Consumer's counters
+    std::atomic<int64_t> m_skipped{0};
+    std::atomic<int64_t> m_empty{0};
+    std::atomic<int64_t> m_depthSum{0};
+    std::atomic<int64_t> m_maxDepth{0};
+};
+
+} // namespace frame
+
+#endif // PHASE3_FRAME_SPSC_RING_H
@@ -18,354 +18,423 @@
  * It's the C++ equivalent of the Surface class in Java.
  * Provides direct access to surface buffers for pixel manipulation.
  *
+ * This file is only the JNI layer. The rendering itself (render thread,
+ * drawFrame) lives in a Renderer object per Surface (renderer.h); Java
+ * keeps a pointer to it as a jlong "handle" and passes it back on every
+ * call, so each NativeRenderer instance drives its own Renderer.
+ *
  * Lookup: "Android ANativeWindow", "JNI tutorial", "android/native_window.h"
  */
 
 #include <jni.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
-#include <android/log.h>
-#include <cstring>
-#include <cmath>
-#include <algorithm>
-#include <pthread.h>
-#include <unistd.h>
+
+#include "renderer.h"
 
 // Logging macros for native code
-// Similar to Android's Log.d(), Log.e(), etc. but from C++
+// Similar to Android's Log.d(), Log.e(), etc. but from C++.
+// LOGD/LOGV compile to nothing in release builds (see common/log.h).
 #define LOG_TAG "Phase3Native"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-
-// ========== RENDER STATE ==========
-// Global state for rendering
-// In a real app, you'd encapsulate this in a class
+#include "common/log.h"
+
+// HANDLES: a Renderer* travels to Java as a jlong (64 bits, so a pointer
+// fits on both 32- and 64-bit ABIs). 0 means "no renderer".
+static Renderer* fromHandle(jlong handle) {
+    auto* renderer = reinterpret_cast<Renderer*>(static_cast<intptr_t>(handle));
+    if (!renderer) {
+        LOGE("Native call with a null renderer handle");
+    }
+    return renderer;
+}
 
-static ANativeWindow* g_window = nullptr;  // The native window we're rendering to
-static pthread_t g_render_thread;          // Background rendering thread
-static bool g_running = false;             // Flag to control render loop
-static float g_time = 0.0f;                // Animation time counter
+// ========== JNI FUNCTIONS ==========
+// These functions are called from Java code
+// Function naming pattern: Java_<package>_<class>_<method>
+//
+// JNIEXPORT, JNICALL: Macros for proper linkage
+// JNIEnv*: Pointer to JNI environment (for calling Java from C++)
+// jobject: Java object reference (the 'this' pointer from Java)
+//
+// All of them are called from the Java UI thread.
 
 /**
- * drawFrame(): Draw a single frame to the native window
+ * Java_com_graphics_phase3_NativeRenderer_nativeCreate
  *
- * This is the C++ equivalent of Phase 1/2's Canvas drawing.
- * But instead of Canvas.drawCircle(), we manipulate pixels directly.
+ * Called from the NativeRenderer constructor
+ * Java signature: native long nativeCreate();
  *
- * ANativeWindow API pattern:
- * 1. ANativeWindow_lock() - Get buffer to draw into
- * 2. Manipulate pixels directly
- * 3. ANativeWindow_unlockAndPost() - Display the buffer
- *
- * KEY CONCEPT: ANativeWindow_Buffer
- * This struct contains:
- * - bits: Pointer to pixel data (ARGB_8888 format)
- * - width, height: Buffer dimensions
- * - stride: Bytes per row (may be > width*4 due to padding)
- * - format: Pixel format (e.g., WINDOW_FORMAT_RGBA_8888)
+ * Returns the handle every other call takes. Pair with nativeDestroy().
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeCreate(
+        JNIEnv* env,
+        jobject /* this */) {
+
+    auto* renderer = new Renderer();
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(renderer));
+}
+
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeDestroy
  *
- * PIXEL FORMAT: ARGB_8888 or RGBA_8888
- * Each pixel is 4 bytes: [A][R][G][B] or [R][G][B][A]
- * We need to check the format and write accordingly.
+ * Called from NativeRenderer.release()
+ * Java signature: native void nativeDestroy(long handle);
  *
- * Lookup: "ANativeWindow_Buffer", "Android pixel formats"
+ * Stops the render thread if it's still running and frees the Renderer.
+ * The handle is dangling afterwards; Java zeroes its copy.
  */
-static void drawFrame() {
-    if (!g_window) {
-        LOGE("No window available for drawing");
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeDestroy(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
+
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
         return;
     }
+    renderer->destroy();
+    delete renderer;
+}
+
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceCreated
+ *
+ * Called from Java when Surface is created
+ * Java signature: native void nativeOnSurfaceCreated(long handle, Surface surface);
+ *
+ * KEY FUNCTION: ANativeWindow_fromSurface()
+ * This is THE bridge from Java Surface to native ANativeWindow
+ * Takes a Java Surface object, returns native ANativeWindow pointer
+ *
+ * CRITICAL: Must call ANativeWindow_release() when done!
+ * Otherwise you'll leak memory. (The Renderer owns the reference from
+ * here on and releases it when the surface is destroyed.)
+ *
+ * Lookup: "ANativeWindow_fromSurface", "JNI jobject"
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceCreated(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jobject surface) {
 
-    // ANativeWindow_Buffer: Struct that holds buffer info
-    ANativeWindow_Buffer buffer;
-
-    // LOCK: Get exclusive access to buffer
-    // Similar to SurfaceHolder.lockCanvas() or TextureView.lockCanvas()
-    // But this is the native C API
-    //
-    // ARect* can be used to lock only part of the buffer (nullptr = entire buffer)
-    // Returns 0 on success, negative on error
-    if (ANativeWindow_lock(g_window, &buffer, nullptr) < 0) {
-        LOGE("Failed to lock window buffer");
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
         return;
     }
+    LOGI("[%d] nativeOnSurfaceCreated called", renderer->id());
 
-    // BUFFER INFO:
-    // buffer.bits: Pointer to pixel data
-    // buffer.width: Width in pixels
-    // buffer.height: Height in pixels
-    // buffer.stride: Row stride in PIXELS (not bytes!)
-    // buffer.format: Pixel format (WINDOW_FORMAT_*)
-    //
-    // IMPORTANT: stride may be > width due to alignment requirements
-    // Always use stride when calculating row offsets
-
-    int width = buffer.width;
-    int height = buffer.height;
-    int stride = buffer.stride;
-
-    // Cast bits to uint32_t* to treat as ARGB pixels
-    // Each pixel is 4 bytes (32 bits): A, R, G, B
-    auto* pixels = static_cast<uint32_t*>(buffer.bits);
-
-    LOGD("Drawing frame: %dx%d, stride=%d, format=%d", width, height, stride, buffer.format);
-
-    // ========== DRAW BACKGROUND ==========
-    // Fill entire buffer with dark blue color
-    // Same as Phase 1/2: Color.rgb(20, 20, 30)
-
-    uint32_t bgColor;
-    if (buffer.format == WINDOW_FORMAT_RGBA_8888) {
-        // RGBA format: [R][G][B][A]
-        bgColor = (20 << 0) | (20 << 8) | (30 << 16) | (255 << 24);  // RGBA
-    } else {
-        // ARGB format: [A][R][G][B]
-        bgColor = (255 << 24) | (20 << 16) | (20 << 8) | (30 << 0);  // ARGB
+    // Get native window from Java Surface
+    // THIS IS THE KEY FUNCTION!
+    // Converts Java Surface to ANativeWindow*
+    ANativeWindow* window = ANativeWindow_fromSurface(env, surface);
+    if (!window) {
+        LOGE("[%d] Failed to get ANativeWindow from Surface", renderer->id());
+        return;
     }
 
-    // Fill all pixels with background color
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            // IMPORTANT: Use stride, not width
-            // pixels[y * width + x] would be WRONG if stride != width
-            pixels[y * stride + x] = bgColor;
-        }
-    }
+    // Created/Paused -> Running: starts this renderer's thread
+    renderer->start(window);
+}
 
-    // ========== DRAW ANIMATED CIRCLE ==========
-    // Same animation as Phase 1/2: moving light blue circle
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetOutputMode
+ *
+ * Called from Java before the Surface exists
+ * Java signature: native void nativeSetOutputMode(long handle, int mode);
+ *
+ * The buffer format is requested when the Surface is created, so a new
+ * mode applies from the next surface on.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeSetOutputMode(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jint mode) {
 
-    // Calculate animation progress (0.0 to 1.0)
-    float cycle = fmodf(g_time, 4.0f);  // Repeat every 4 time units
-    float progress;
-    if (cycle < 2.0f) {
-        progress = cycle / 2.0f;  // 0 to 1 (moving right)
-    } else {
-        progress = 1.0f - ((cycle - 2.0f) / 2.0f);  // 1 to 0 (moving left)
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
     }
-
-    // Circle parameters
-    float leftEdge = 100.0f;
-    float rightEdge = width - 100.0f;
-    float cx = leftEdge + (progress * (rightEdge - leftEdge));  // X position
-    float cy = height / 2.0f;  // Center Y
-    float radius = 80.0f;      // Circle radius
-
-    // Circle color: light blue
-    uint32_t circleColor;
-    if (buffer.format == WINDOW_FORMAT_RGBA_8888) {
-        circleColor = (100 << 0) | (150 << 8) | (255 << 16) | (255 << 24);  // RGBA
-    } else {
-        circleColor = (255 << 24) | (100 << 16) | (150 << 8) | (255 << 0);  // ARGB
+    if (mode < kOutputRgba8888 || mode > kOutputRgb565Dither) {
+        LOGE("[%d] Unknown output mode %d", renderer->id(), mode);
+        return;
     }
+    LOGI("[%d] nativeSetOutputMode: %d", renderer->id(), mode);
+    renderer->setOutputMode(mode);
+}
 
-    // DRAW CIRCLE: Check each pixel if it's inside circle
-    // This is the manual way - no Canvas.drawCircle() here!
-    //
-    // Math: Point (x,y) is inside circle if:
-    // (x - cx)^2 + (y - cy)^2 <= radius^2
-    //
-    // This is slower than Canvas drawing but shows you what's happening
-
-    int minY = std::max(0, static_cast<int>(cy - radius));
-    int maxY = std::min(height - 1, static_cast<int>(cy + radius));
-    int minX = std::max(0, static_cast<int>(cx - radius));
-    int maxX = std::min(width - 1, static_cast<int>(cx + radius));
-
-    float radiusSq = radius * radius;
-
-    for (int y = minY; y <= maxY; y++) {
-        for (int x = minX; x <= maxX; x++) {
-            // Distance from circle center
-            float dx = x - cx;
-            float dy = y - cy;
-            float distSq = dx * dx + dy * dy;
-
-            // If inside circle, draw pixel
-            if (distSq <= radiusSq) {
-                pixels[y * stride + x] = circleColor;
-            }
-        }
-    }
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetRefreshRate
+ *
+ * Called from Java with Display.getRefreshRate() before the Surface is
+ * created. The frame pacer uses it as its period from the next render
+ * thread start on.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeSetRefreshRate(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jfloat hz) {
 
-    // ========== UPDATE ANIMATION ==========
-    g_time += 0.05f;
-    if (g_time > 100.0f) {
-        g_time = 0.0f;
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
     }
-
-    // UNLOCK: Post buffer to display
-    // Similar to unlockCanvasAndPost() in Phase 2
-    // This makes the frame visible on screen
-    if (ANativeWindow_unlockAndPost(g_window) < 0) {
-        LOGE("Failed to unlock and post window buffer");
+    if (hz < 1.0f) {
+        LOGE("[%d] Ignoring refresh rate %.2f Hz", renderer->id(), hz);
+        return;
     }
+    LOGI("[%d] nativeSetRefreshRate: %.2f Hz", renderer->id(), hz);
+    renderer->setRefreshRate(hz);
 }
 
 /**
- * renderLoop(): Continuous rendering thread
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetPipelined
  *
- * Same concept as Phase 2's RenderThread.run()
- * Runs in background, continuously draws frames
+ * Called from Java before the Surface is created
+ * Java signature: native void nativeSetPipelined(long handle, boolean pipelined);
  *
- * pthread: POSIX threads (standard C/C++ threading)
- * Similar to Java's Thread class
- *
- * Lookup: "pthread tutorial", "pthread_create"
+ * Pipelined mode records frames on a separate simulation thread and
+ * hands them to the render thread through a lock-free ring (renderer.h).
+ * Applies from the next render thread start on.
  */
-static void* renderLoop(void* arg) {
-    LOGI("Render loop started");
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeSetPipelined(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jboolean pipelined) {
 
-    // Target: 60 FPS = 16ms per frame
-    const long targetFrameTime = 16666;  // microseconds (16.666ms)
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
+    }
+    LOGI("[%d] nativeSetPipelined: %s", renderer->id(), pipelined ? "on" : "off");
+    renderer->setPipelined(pipelined == JNI_TRUE);
+}
 
-    while (g_running) {
-        // Draw one frame
-        drawFrame();
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetPresentBuffers
+ *
+ * Called from Java before the Surface is created
+ * Java signature: native void nativeSetPresentBuffers(long handle, int count);
+ *
+ * 0: the render thread locks and posts the window itself (default).
+ * 2 or 3: it draws into that many back buffers and a present thread
+ * copies the newest one into the window (raster/present_queue.h).
+ * Applies from the next render thread start on.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeSetPresentBuffers(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jint count) {
 
-        // Sleep to control frame rate
-        // usleep(): microseconds (1 second = 1,000,000 microseconds)
-        // Similar to Thread.sleep() in Java
-        usleep(targetFrameTime);
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
     }
-
-    LOGI("Render loop stopped");
-    return nullptr;
+    if (count != 0 && (count < 2 || count > raster::PresentQueue::kMaxBuffers)) {
+        LOGE("[%d] Ignoring %d present buffers (0, 2 or 3)", renderer->id(), count);
+        return;
+    }
+    LOGI("[%d] nativeSetPresentBuffers: %d", renderer->id(), count);
+    renderer->setPresentBuffers(count);
 }
 
-// ========== JNI FUNCTIONS ==========
-// These functions are called from Java code
-// Function naming pattern: Java_<package>_<class>_<method>
-//
-// JNIEXPORT, JNICALL: Macros for proper linkage
-// JNIEnv*: Pointer to JNI environment (for calling Java from C++)
-// jobject: Java object reference (the 'this' pointer from Java)
-
 /**
- * Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceCreated
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetResolutionScaling
  *
- * Called from Java when Surface is created
- * Java signature: native void nativeOnSurfaceCreated(Surface surface);
+ * Called from Java before the Surface is created
+ * Java signature: native void nativeSetResolutionScaling(long handle, boolean enabled,
+ *                                                        float minScale);
  *
- * KEY FUNCTION: ANativeWindow_fromSurface()
- * This is THE bridge from Java Surface to native ANativeWindow
- * Takes a Java Surface object, returns native ANativeWindow pointer
+ * Lets the renderer shrink its buffers (down to minScale per axis) while
+ * frames don't fit in the refresh period, and grow them back once they
+ * do (frame/resolution_governor.h). Applies from the next render thread
+ * start on.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeSetResolutionScaling(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jboolean enabled,
+        jfloat minScale) {
+
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
+    }
+    if (!(minScale >= 0.1f && minScale <= 1.0f)) {
+        LOGE("[%d] Ignoring minimum resolution scale %.2f (0.1 to 1)", renderer->id(), minScale);
+        return;
+    }
+    LOGI("[%d] nativeSetResolutionScaling: %s, min %.2f", renderer->id(),
+         enabled ? "on" : "off", minScale);
+    renderer->setResolutionScaling(enabled == JNI_TRUE, minScale);
+}
+
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeSetInternalScale
  *
- * CRITICAL: Must call ANativeWindow_release() when done!
- * Otherwise you'll leak memory
+ * Called from Java before the Surface is created
+ * Java signature: native void nativeSetInternalScale(long handle, float scale,
+ *                                                    boolean bilinear);
  *
- * Lookup: "ANativeWindow_fromSurface", "JNI jobject"
+ * Below 1, the scene is rasterized into a buffer `scale` times the
+ * window's size per axis and stretched (bilinear or nearest) into the
+ * full-size window buffer when presenting (raster/upscale.h). 1 turns it
+ * off. Applies from the next render thread start on.
  */
 extern "C" JNIEXPORT void JNICALL
-Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceCreated(
+Java_com_graphics_phase3_NativeRenderer_nativeSetInternalScale(
         JNIEnv* env,
         jobject /* this */,
-        jobject surface) {
+        jlong handle,
+        jfloat scale,
+        jboolean bilinear) {
 
-    LOGI("nativeOnSurfaceCreated called");
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
+    }
+    if (!(scale >= 0.25f && scale <= 1.0f)) {
+        LOGE("[%d] Ignoring internal scale %.2f (0.25 to 1)", renderer->id(), scale);
+        return;
+    }
+    LOGI("[%d] nativeSetInternalScale: %.2f, %s", renderer->id(), scale,
+         bilinear ? "bilinear" : "nearest");
+    renderer->setInternalScale(scale, bilinear == JNI_TRUE);
+}
 
-    // Get native window from Java Surface
-    // THIS IS THE KEY FUNCTION!
-    // Converts Java Surface to ANativeWindow*
-    g_window = ANativeWindow_fromSurface(env, surface);
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeGetResolutionScale
+ *
+ * Called from Java any time
+ * Java signature: native float nativeGetResolutionScale(long handle);
+ *
+ * Buffer pixels per view pixel right now, per axis: 1 at full
+ * resolution, 0.5 when the buffers are a quarter of the view's pixels.
+ */
+extern "C" JNIEXPORT jfloat JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeGetResolutionScale(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle) {
 
-    if (!g_window) {
-        LOGE("Failed to get ANativeWindow from Surface");
-        return;
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return 1.0f;
     }
+    return renderer->resolutionScale();
+}
+
+/**
+ * Java_com_graphics_phase3_NativeRenderer_nativeGetFrameTimings
+ *
+ * Called from Java any time (also without a surface)
+ * Java signature: native boolean nativeGetFrameTimings(long handle, ByteBuffer out);
+ *
+ * Summarizes the last 256 frames into p50/p95/p99/max/mean per stage and
+ * copies them into `out` as longs in native byte order (layout:
+ * frame/frame_timing.h, NativeRenderer.TIMING_* on the Java side).
+ *
+ * `out` is a direct buffer Java allocated: GetDirectBufferAddress() gives
+ * its memory, which the garbage collector won't move or free while Java
+ * holds the buffer. Nothing native outlives this call, so the buffer can
+ * be kept after the renderer is released, and every caller has its own.
+ *
+ * Lookup: "GetDirectBufferAddress", "ByteBuffer.allocateDirect"
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_graphics_phase3_NativeRenderer_nativeGetFrameTimings(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jobject out) {
 
-    // Log window dimensions
-    int width = ANativeWindow_getWidth(g_window);
-    int height = ANativeWindow_getHeight(g_window);
-    int format = ANativeWindow_getFormat(g_window);
-    LOGI("Window: %dx%d, format=%d", width, height, format);
-
-    // Set buffer format (optional, but good practice)
-    // WINDOW_FORMAT_RGBA_8888: 32-bit RGBA (8 bits per channel)
-    ANativeWindow_setBuffersGeometry(g_window, 0, 0, WINDOW_FORMAT_RGBA_8888);
-
-    // Start rendering thread
-    g_running = true;
-
-    // pthread_create(): Create a new thread
-    // Similar to new Thread().start() in Java
-    // Params: thread id, attributes, start function, argument
-    int result = pthread_create(&g_render_thread, nullptr, renderLoop, nullptr);
-    if (result != 0) {
-        LOGE("Failed to create render thread: %d", result);
-        g_running = false;
-        ANativeWindow_release(g_window);
-        g_window = nullptr;
-    } else {
-        LOGI("Render thread created successfully");
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer || !out) {
+        return JNI_FALSE;
     }
+    // nullptr / -1 for a heap (non-direct) buffer
+    void* address = env->GetDirectBufferAddress(out);
+    jlong capacity = env->GetDirectBufferCapacity(out);
+    if (!address || capacity < 0) {
+        return JNI_FALSE;
+    }
+    return renderer->copyTimingSnapshot(address, static_cast<size_t>(capacity)) ? JNI_TRUE
+                                                                                 : JNI_FALSE;
 }
 
 /**
  * Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceChanged
  *
  * Called from Java when Surface size changes
- * Java signature: native void nativeOnSurfaceChanged(int width, int height);
+ * Java signature: native void nativeOnSurfaceChanged(long handle, int width, int height);
  *
- * For our simple animation, we don't need to do anything here
- * More complex apps might update projection matrices, etc.
+ * The animation adapts by itself, reading the window's dimensions every
+ * frame. With dynamic resolution on, though, the window reports the
+ * (scaled) BUFFER size, so the renderer needs the view size from here
+ * to know what 1.0x is.
  */
 extern "C" JNIEXPORT void JNICALL
 Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceChanged(
         JNIEnv* env,
         jobject /* this */,
+        jlong handle,
         jint width,
         jint height) {
 
-    LOGI("nativeOnSurfaceChanged: %dx%d", width, height);
-
-    // Our animation adapts automatically by reading window dimensions
-    // So nothing special needed here
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
+    }
+    LOGI("[%d] nativeOnSurfaceChanged: %dx%d", renderer->id(), width, height);
+    renderer->setViewSize(width, height);
 }
 
 /**
  * Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceDestroyed
  *
  * Called from Java when Surface is destroyed
- * Java signature: native void nativeOnSurfaceDestroyed();
+ * Java signature: native void nativeOnSurfaceDestroyed(long handle);
  *
  * CRITICAL: Must stop rendering thread and release window!
  * Same cleanup pattern as Phase 2's onSurfaceTextureDestroyed()
  *
- * pthread_join(): Wait for thread to finish
- * ANativeWindow_release(): Release native window (free resources)
+ * Renderer::pause() does both: pthread_join() (wait for the render
+ * thread to finish), then ANativeWindow_release(). The Renderer itself
+ * stays around (Paused) for the next surface.
  *
  * If you forget these, you'll leak memory and threads!
  */
 extern "C" JNIEXPORT void JNICALL
 Java_com_graphics_phase3_NativeRenderer_nativeOnSurfaceDestroyed(
         JNIEnv* env,
-        jobject /* this */) {
-
-    LOGI("nativeOnSurfaceDestroyed called");
-
-    // Signal thread to stop
-    g_running = false;
+        jobject /* this */,
+        jlong handle) {
 
-    // Wait for thread to finish
-    // pthread_join(): Block until thread terminates
-    // Similar to Thread.join() in Java
-    if (g_render_thread) {
-        LOGI("Waiting for render thread to stop...");
-        pthread_join(g_render_thread, nullptr);
-        LOGI("Render thread stopped");
-        g_render_thread = 0;
+    Renderer* renderer = fromHandle(handle);
+    if (!renderer) {
+        return;
     }
+    LOGI("[%d] nativeOnSurfaceDestroyed called", renderer->id());
 
-    // Release native window
-    // IMPORTANT: This frees resources!
-    // Failure to call this will leak memory
-    if (g_window) {
-        LOGI("Releasing native window");
-        ANativeWindow_release(g_window);
-        g_window = nullptr;
-    }
+    // Running -> Paused: thread joined, window released
+    renderer->pause();
+
+    // Now that nothing records anymore, format the last frames' trace
+    // events (up to 1024) into logcat
+    renderer->dumpTrace();
 
-    LOGI("Native cleanup complete");
+    LOGI("[%d] Native cleanup complete", renderer->id());
 }
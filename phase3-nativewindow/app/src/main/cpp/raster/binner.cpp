@@ -0,0 +1,111 @@
+/**
+ * raster/binner.cpp: Sort display-list commands into screen tiles
+ */
+
+#include "binner.h"
+
+#include <algorithm>
+
+namespace raster {
+
+bool TileBinner::tileRange(const Rect& bounds, int* col0, int* row0,
+                           int* col1, int* row1) const {
+    Rect clipped = intersectRects(bounds, makeRect(0, 0, m_width, m_height));
+    if (clipped.isEmpty()) {
+        return false;
+    }
+    *col0 = clipped.left / m_tileSize;
+    *row0 = clipped.top / m_tileSize;
+    *col1 = (clipped.right - 1) / m_tileSize + 1;
+    *row1 = (clipped.bottom - 1) / m_tileSize + 1;
+    return true;
+}
+
+// Does this command paint every pixel of `tile` with an opaque color?
+static bool coversTile(const Command& command, const Rect& tile) {
+    switch (command.type) {
+        case CommandType::Clear:
+            return (command.clear.color >> 24) == 0xFF;
+        case CommandType::FillRect:
+            return (command.fillRect.color >> 24) == 0xFF &&
+                   rectContains(command.bounds, tile);
+        default:
+            return false;
+    }
+}
+
+void TileBinner::bin(const DisplayList& list, int width, int height, int tileSize) {
+    m_width = width;
+    m_height = height;
+    m_tileSize = tileSize;
+    m_columns = (width + tileSize - 1) / tileSize;
+    m_rows = (height + tileSize - 1) / tileSize;
+    const size_t tiles = static_cast<size_t>(m_columns) * m_rows;
+
+    m_firstVisible.assign(tiles, 0);
+    m_offsets.assign(tiles + 1, 0);
+
+    // PASS 1: find the last full-tile opaque command in every tile
+    for (size_t i = 0; i < list.size(); i++) {
+        const Command& command = list[i];
+        if (command.type != CommandType::Clear && command.type != CommandType::FillRect) {
+            continue;
+        }
+        int col0, row0, col1, row1;
+        if (!tileRange(command.bounds, &col0, &row0, &col1, &row1)) {
+            continue;
+        }
+        for (int row = row0; row < row1; row++) {
+            for (int col = col0; col < col1; col++) {
+                Rect tile = intersectRects(
+                        makeRect(col * tileSize, row * tileSize,
+                                 (col + 1) * tileSize, (row + 1) * tileSize),
+                        makeRect(0, 0, width, height));
+                if (coversTile(command, tile)) {
+                    m_firstVisible[row * m_columns + col] = static_cast<uint32_t>(i);
+                }
+            }
+        }
+    }
+
+    // PASS 2: count the visible commands per tile
+    for (size_t i = 0; i < list.size(); i++) {
+        int col0, row0, col1, row1;
+        if (!tileRange(list[i].bounds, &col0, &row0, &col1, &row1)) {
+            continue;
+        }
+        for (int row = row0; row < row1; row++) {
+            for (int col = col0; col < col1; col++) {
+                int tile = row * m_columns + col;
+                if (i >= m_firstVisible[tile]) {
+                    m_offsets[tile + 1]++;
+                }
+            }
+        }
+    }
+
+    // Prefix sum: counts -> start offsets
+    for (size_t tile = 0; tile < tiles; tile++) {
+        m_offsets[tile + 1] += m_offsets[tile];
+    }
+
+    // PASS 3: fill the bins (commands arrive in list order)
+    m_indices.resize(m_offsets[tiles]);
+    m_cursor.assign(m_offsets.begin(), m_offsets.end() - 1);
+    for (size_t i = 0; i < list.size(); i++) {
+        int col0, row0, col1, row1;
+        if (!tileRange(list[i].bounds, &col0, &row0, &col1, &row1)) {
+            continue;
+        }
+        for (int row = row0; row < row1; row++) {
+            for (int col = col0; col < col1; col++) {
+                int tile = row * m_columns + col;
+                if (i >= m_firstVisible[tile]) {
+                    m_indices[m_cursor[tile]++] = static_cast<uint32_t>(i);
+                }
+            }
+        }
+    }
+}
+
+} // namespace raster
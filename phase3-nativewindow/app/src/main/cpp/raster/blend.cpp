@@ -0,0 +1,149 @@
+/**
+ * raster/blend.cpp: Blend dispatch and the scalar kernels
+ */
+
+#include "blend.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace raster {
+
+namespace {
+
+// The three modes on one channel (source already scaled by the opacity);
+// every kernel's SIMD version does the same operations
+struct SourceOver {
+    static uint32_t apply(uint32_t s, uint32_t d, uint32_t sa, uint32_t /*da*/) {
+        return s + mulDiv255(d, 255 - sa);
+    }
+};
+
+struct Plus {
+    static uint32_t apply(uint32_t s, uint32_t d, uint32_t /*sa*/, uint32_t /*da*/) {
+        return s + d;
+    }
+};
+
+struct Multiply {
+    static uint32_t apply(uint32_t s, uint32_t d, uint32_t sa, uint32_t da) {
+        return mulDiv255(s, d) + mulDiv255(s, 255 - da) + mulDiv255(d, 255 - sa);
+    }
+};
+
+template <class Mode>
+void blendScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t s = src[i];
+        uint32_t d = dst[i];
+        uint32_t sa = mulDiv255(s >> 24, alpha);
+        uint32_t da = d >> 24;
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint32_t sc = mulDiv255((s >> shift) & 0xFF, alpha);
+            uint32_t dc = (d >> shift) & 0xFF;
+            result |= saturate255(Mode::apply(sc, dc, sa, da)) << shift;
+        }
+        dst[i] = result;
+    }
+}
+
+} // namespace
+
+void blendSourceOverScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendScalar<SourceOver>(dst, src, count, alpha);
+}
+
+void blendPlusScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendScalar<Plus>(dst, src, count, alpha);
+}
+
+void blendMultiplyScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendScalar<Multiply>(dst, src, count, alpha);
+}
+
+namespace {
+
+struct KernelTable {
+    BlendKernel kernels[4];
+    size_t count = 0;
+
+    KernelTable() {
+        kernels[count++] = {"scalar", blendSourceOverScalar, blendPlusScalar,
+                            blendMultiplyScalar};
+
+#if defined(__x86_64__) || defined(__i386__)
+        // Neither is in the x86_64 baseline: both need a runtime check
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1")) {
+            kernels[count++] = {"sse4", blendSourceOverSSE4, blendPlusSSE4, blendMultiplySSE4};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            kernels[count++] = {"avx2", blendSourceOverAVX2, blendPlusAVX2, blendMultiplyAVX2};
+        }
+#endif
+
+#if defined(__ARM_NEON)
+        kernels[count++] = {"neon", blendSourceOverNEON, blendPlusNEON, blendMultiplyNEON};
+#endif
+    }
+};
+
+const KernelTable& kernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+std::atomic<const BlendKernel*> g_active{nullptr};
+
+const BlendKernel* active() {
+    const BlendKernel* kernel = g_active.load(std::memory_order_acquire);
+    if (!kernel) {
+        const KernelTable& table = kernelTable();
+        kernel = &table.kernels[table.count - 1];
+        g_active.store(kernel, std::memory_order_release);
+    }
+    return kernel;
+}
+
+} // namespace
+
+const BlendKernel* supportedBlendKernels(size_t* count) {
+    const KernelTable& table = kernelTable();
+    *count = table.count;
+    return table.kernels;
+}
+
+const BlendKernel& activeBlendKernel() {
+    return *active();
+}
+
+bool selectBlendKernel(const char* name) {
+    const KernelTable& table = kernelTable();
+    for (size_t i = 0; i < table.count; i++) {
+        if (strcmp(table.kernels[i].name, name) == 0) {
+            g_active.store(&table.kernels[i], std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+BlendSpanFn blendSpanFn(const BlendKernel& kernel, BlendMode mode) {
+    switch (mode) {
+        case BlendMode::SourceOver:
+            return kernel.sourceOver;
+        case BlendMode::Plus:
+            return kernel.plus;
+        case BlendMode::Multiply:
+            return kernel.multiply;
+    }
+    return kernel.sourceOver;
+}
+
+void blendSpan(BlendMode mode, uint32_t* dst, const uint32_t* src, size_t count,
+               uint32_t alpha) {
+    blendSpanFn(*active(), mode)(dst, src, count, alpha);
+}
+
+} // namespace raster
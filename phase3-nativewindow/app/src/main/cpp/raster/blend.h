@@ -0,0 +1,115 @@
+/**
+ * raster/blend.h: Premultiplied-alpha compositing of pixel spans
+ *
+ * Everything else in the rasterizer writes opaque colors: a pixel is
+ * simply replaced. Compositing a translucent layer (a UI panel, a
+ * fading bitmap) instead combines each source pixel with the one
+ * already in the buffer.
+ *
+ * PREMULTIPLIED ALPHA: the source's color channels are stored already
+ * multiplied by its alpha (50% white is 80 80 80 80, not FF FF FF 80).
+ * Then every mode is the same formula on all 4 channels, alpha included,
+ * and no division is needed:
+ *
+ *     SourceOver   d = s + d x (1 - sa)
+ *     Plus         d = s + d                   (additive, saturating)
+ *     Multiply     d = s x d + s x (1 - da) + d x (1 - sa)
+ *
+ * (Porter-Duff / W3C compositing; "x" is a product of two 0-1 values,
+ * done on 0-255 bytes as round(a * b / 255).) Every result saturates at
+ * 255, so a source that isn't really premultiplied (a channel above its
+ * alpha) clips instead of wrapping around.
+ *
+ * LAYER OPACITY: each kernel takes a 0-255 `alpha` that scales the whole
+ * source first (all 4 channels, since they're premultiplied): fading a
+ * layer costs no extra pass.
+ *
+ * EXACTNESS: round(a * b / 255) is computed as
+ *     t = a * b + 128;  (t + (t >> 8)) >> 8
+ * which is exact for all byte inputs and fits 16-bit lanes, and every
+ * kernel does exactly these operations in this order. So all kernels
+ * produce the same bytes, and alpha 255 leaves the source unchanged.
+ *
+ * DISPATCH works like raster/fill.h: scalar, SSE4.1 (4 pixels per
+ * instruction, pshufb for the alpha spread) and AVX2 (8) on x86, NEON
+ * (8, channels deinterleaved by vld4) on ARM. The best one is picked once
+ * at startup.
+ *
+ * Lookup: "premultiplied alpha", "Porter-Duff compositing",
+ *         "SIMD alpha blending", "divide by 255"
+ */
+
+#ifndef PHASE3_RASTER_BLEND_H
+#define PHASE3_RASTER_BLEND_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace raster {
+
+enum class BlendMode : uint8_t {
+    SourceOver,  // Normal "paint on top"
+    Plus,        // Additive: glows, light
+    Multiply,    // Darken by the source: shadows, tints
+};
+
+// Composite `count` premultiplied RGBA_8888 source pixels onto dst, the
+// source first scaled by alpha / 255 (255 = as is)
+using BlendSpanFn = void (*)(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+
+struct BlendKernel {
+    const char* name;  // "scalar", "sse4", "avx2", "neon"
+    BlendSpanFn sourceOver;
+    BlendSpanFn plus;
+    BlendSpanFn multiply;
+};
+
+// All kernels this CPU can run, from slowest to fastest
+const BlendKernel* supportedBlendKernels(size_t* count);
+
+// The kernel currently used by blendSpan()
+const BlendKernel& activeBlendKernel();
+
+// Force a kernel by name. Returns false if this CPU can't run it.
+bool selectBlendKernel(const char* name);
+
+// A kernel's function for `mode`
+BlendSpanFn blendSpanFn(const BlendKernel& kernel, BlendMode mode);
+
+// Composite one span through the active kernel
+void blendSpan(BlendMode mode, uint32_t* dst, const uint32_t* src, size_t count,
+               uint32_t alpha = 255);
+
+// ---- One channel, the way every kernel computes it ----
+
+// round(a * b / 255) for a, b in 0-255
+inline uint32_t mulDiv255(uint32_t a, uint32_t b) {
+    uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline uint32_t saturate255(uint32_t value) {
+    return value > 255 ? 255 : value;
+}
+
+// ---- Kernels (defined in blend*.cpp, only call through dispatch) ----
+void blendSourceOverScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendPlusScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendMultiplyScalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+#if defined(__x86_64__) || defined(__i386__)
+void blendSourceOverSSE4(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendPlusSSE4(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendMultiplySSE4(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendSourceOverAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendPlusAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendMultiplyAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+#endif
+#if defined(__ARM_NEON)
+void blendSourceOverNEON(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendPlusNEON(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+void blendMultiplyNEON(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha);
+#endif
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_BLEND_H
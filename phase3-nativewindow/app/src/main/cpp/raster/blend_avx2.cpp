@@ -0,0 +1,99 @@
+/**
+ * raster/blend_avx2.cpp: Blend kernels for x86 with AVX2, 8 pixels per step
+ *
+ * Compiled with -mavx2 and only called when the CPU has it, like
+ * raster/fill_avx2.cpp.
+ *
+ * The SSE4.1 kernel twice over, side by side: AVX2 unpacks, shuffles and
+ * packs within each 128-bit half, so unpacklo/unpackhi split the pixels
+ * as 0 1 4 5 / 2 3 6 7 and _mm256_packus_epi16 puts them back in order.
+ */
+
+#include "blend.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+namespace raster {
+
+namespace {
+
+// round(a * b / 255) per 16-bit lane (inputs 0-255)
+inline __m256i mulDiv255(__m256i a, __m256i b) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+inline __m256i inverse(__m256i alpha) {
+    return _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+}
+
+struct SourceOver {
+    static __m256i apply(__m256i s, __m256i d, __m256i sa, __m256i /*da*/) {
+        return _mm256_add_epi16(s, mulDiv255(d, inverse(sa)));
+    }
+};
+
+struct Plus {
+    static __m256i apply(__m256i s, __m256i d, __m256i /*sa*/, __m256i /*da*/) {
+        return _mm256_add_epi16(s, d);
+    }
+};
+
+struct Multiply {
+    static __m256i apply(__m256i s, __m256i d, __m256i sa, __m256i da) {
+        return _mm256_add_epi16(
+                _mm256_add_epi16(mulDiv255(s, d), mulDiv255(s, inverse(da))),
+                mulDiv255(d, inverse(sa)));
+    }
+};
+
+template <class Mode, BlendSpanFn tail>
+void blendAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaSpread = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7,
+                                                 14, 15, 14, 15, 14, 15, 14, 15,
+                                                 6, 7, 6, 7, 6, 7, 6, 7,
+                                                 14, 15, 14, 15, 14, 15, 14, 15);
+    const __m256i opacity = _mm256_set1_epi16(static_cast<short>(alpha));
+    const bool scaled = alpha != 255;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i sLo = _mm256_unpacklo_epi8(s, zero);
+        __m256i sHi = _mm256_unpackhi_epi8(s, zero);
+        __m256i dLo = _mm256_unpacklo_epi8(d, zero);
+        __m256i dHi = _mm256_unpackhi_epi8(d, zero);
+        if (scaled) {
+            sLo = mulDiv255(sLo, opacity);
+            sHi = mulDiv255(sHi, opacity);
+        }
+        __m256i lo = Mode::apply(sLo, dLo, _mm256_shuffle_epi8(sLo, alphaSpread),
+                                 _mm256_shuffle_epi8(dLo, alphaSpread));
+        __m256i hi = Mode::apply(sHi, dHi, _mm256_shuffle_epi8(sHi, alphaSpread),
+                                 _mm256_shuffle_epi8(dHi, alphaSpread));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    tail(dst + i, src + i, count - i, alpha);
+}
+
+} // namespace
+
+void blendSourceOverAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendAVX2<SourceOver, blendSourceOverScalar>(dst, src, count, alpha);
+}
+
+void blendPlusAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendAVX2<Plus, blendPlusScalar>(dst, src, count, alpha);
+}
+
+void blendMultiplyAVX2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t alpha) {
+    blendAVX2<Multiply, blendMultiplyScalar>(dst, src, count, alpha);
+}
+
+} // namespace raster
+
+#endif
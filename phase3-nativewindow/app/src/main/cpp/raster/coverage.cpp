@@ -0,0 +1,129 @@
+/**
+ * raster/coverage.cpp: Coverage dispatch and the scalar kernels
+ */
+
+#include "coverage.h"
+#include "fill.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace raster {
+
+void circleCoverageScalar(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                          float outerRadius) {
+    for (int i = 0; i < count; i++) {
+        coverage[i] = circlePixelCoverage(x0 + i, cx, dySq, outerRadius);
+    }
+}
+
+void blendCoverageScalar(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = blendPixel(dst[i], color, coverage[i]);
+    }
+}
+
+// Blend the edges one pixel at a time, fill the solid middle
+template <class Pixel, class Blend>
+static inline void blendCircleRow(Pixel* row, const CircleRowSpan& span, float cx, float dySq,
+                                  float outerRadius, Pixel color, Blend blend) {
+    for (int x = span.left; x < span.solidLeft; x++) {
+        row[x] = blend(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+    if (span.solidLeft <= span.solidRight) {
+        fillPixels(row + span.solidLeft, static_cast<size_t>(span.solidRight - span.solidLeft + 1),
+                   color);
+    }
+    for (int x = span.solidRight + 1; x <= span.right; x++) {
+        row[x] = blend(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+}
+
+template <class Pixel, class Blend>
+static inline void drawCircleRows(Pixel* pixels, int stride, const CircleRows& rows,
+                                  Pixel color, Blend blend) {
+    for (int y = rows.minY; y <= rows.maxY; y++) {
+        float dy = y - rows.cy;
+        float dySq = dy * dy;
+        CircleRowSpan span;
+        if (circleRowSpan(rows.cx, dySq, rows.outerRadius, rows.minX, rows.maxX, &span)) {
+            blendCircleRow(pixels + static_cast<ptrdiff_t>(y) * stride, span, rows.cx, dySq,
+                           rows.outerRadius, color, blend);
+        }
+    }
+}
+
+void circleRowsScalar(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color) {
+    drawCircleRows(pixels, stride, rows, color, blendPixel);
+}
+
+void circleRows565Scalar(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color) {
+    drawCircleRows(pixels, stride, rows, color, blendPixel565);
+}
+
+namespace {
+
+struct KernelTable {
+    CoverageKernel kernels[3];
+    size_t count = 0;
+
+    KernelTable() {
+        kernels[count++] = {"scalar", circleCoverageScalar, blendCoverageScalar,
+                            circleRowsScalar, circleRows565Scalar};
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels[count++] = {"sse2", circleCoverageSSE2, blendCoverageSSE2, circleRowsSSE2,
+                                circleRows565SSE2};
+        }
+#endif
+
+#if defined(__ARM_NEON)
+        kernels[count++] = {"neon", circleCoverageNEON, blendCoverageNEON, circleRowsNEON,
+                            circleRows565NEON};
+#endif
+    }
+};
+
+const KernelTable& kernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+std::atomic<const CoverageKernel*> g_active{nullptr};
+
+const CoverageKernel* active() {
+    const CoverageKernel* kernel = g_active.load(std::memory_order_acquire);
+    if (!kernel) {
+        const KernelTable& table = kernelTable();
+        kernel = &table.kernels[table.count - 1];
+        g_active.store(kernel, std::memory_order_release);
+    }
+    return kernel;
+}
+
+} // namespace
+
+const CoverageKernel* supportedCoverageKernels(size_t* count) {
+    const KernelTable& table = kernelTable();
+    *count = table.count;
+    return table.kernels;
+}
+
+const CoverageKernel& activeCoverageKernel() {
+    return *active();
+}
+
+bool selectCoverageKernel(const char* name) {
+    const KernelTable& table = kernelTable();
+    for (size_t i = 0; i < table.count; i++) {
+        if (strcmp(table.kernels[i].name, name) == 0) {
+            g_active.store(&table.kernels[i], std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace raster
@@ -0,0 +1,274 @@
+/**
+ * raster/coverage.h: Anti-aliased edges as per-pixel coverage
+ *
+ * fillCircle() decides each pixel with one inside/outside test at its
+ * sample point, so the edge is a staircase. An ANTI-ALIASED edge instead
+ * gives every pixel a COVERAGE: how much of it the shape covers, 0-255,
+ * and blends the color over what is already there by that much.
+ *
+ * For a circle the coverage comes straight from the distance d between
+ * the pixel's sample point and the center:
+ *
+ *     coverage = clamp(radius + 0.5 - d, 0, 1)
+ *
+ * i.e. a one-pixel ramp centered on the exact edge (the signed distance
+ * to the edge, which is what a pixel-wide box filter sees across a
+ * gently curved edge). Only a ring about 1-2 px wide has anything but 0
+ * or 255.
+ *
+ * ONE ROW AT A TIME: along a row, coverage only rises towards the center
+ * and falls after it, so a row is an edge at each end and a solid middle.
+ * Each row's split is solved up front, the way fillCircle() solves its
+ * span: one square root for where coverage starts, a compare or two for
+ * where it reaches 255 (circleRowSpan()). The kernel then blends just the
+ * edges and hands the middle to one fillSpan(); nothing walks in from the
+ * ends looking for it. Most rows have at most 2 edge pixels at each end,
+ * and the SIMD kernels blend both ends of those as a single group of 4.
+ *
+ * WHOLE CIRCLES: fillCircleAA() makes one kernel call per circle, not one
+ * per row, so the per-row work is only the row's own. The SIMD kernels
+ * also solve 4 rows' square roots in one instruction.
+ *
+ * The pieces are kernels of their own as well:
+ * - circleCoverage(): the distance math for a run of pixels on one row,
+ *   4 pixels per instruction (sqrt included) with SSE2 / NEON
+ * - blendCoverage(): dst = dst + (color - dst) x coverage, per channel
+ *
+ * EXACTNESS: every kernel does the same float operations in the same
+ * order (no FMA, see CMakeLists.txt) and the same integer rounding, so
+ * they all produce the same bytes, and a pixel's coverage doesn't depend
+ * on where the run it's in starts: drawing in tiles leaves no seams.
+ * A blend with coverage 255 gives exactly `color`, so it doesn't matter
+ * which pixels end up in the solid fill.
+ *
+ * DISPATCH works like raster/pack565.h: scalar, SSE2 (x86) and NEON (ARM),
+ * the best one picked once at startup. Rows come in both pixel sizes:
+ * RGB_565 edges are unpacked to 5/6/5-bit channels and blended with the
+ * same weights and rounding as blendPixel565().
+ *
+ * Lookup: "analytic anti-aliasing coverage", "signed distance
+ *         anti-aliasing", "alpha blending SIMD"
+ */
+
+#ifndef PHASE3_RASTER_COVERAGE_H
+#define PHASE3_RASTER_COVERAGE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace raster {
+
+// coverage[i] for pixel x0 + i on a row dySq = (y - cy)^2 from the
+// center, of a circle whose coverage reaches 0 at outerRadius
+// (radius + 0.5): clamp(outerRadius - distance, 0, 1) x 255, rounded
+using CircleCoverageFn = void (*)(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                                  float outerRadius);
+
+// dst[i] blended towards color by coverage[i] / 255, per channel
+// (alpha included: an opaque color over an opaque pixel stays opaque)
+using BlendCoverageFn = void (*)(uint32_t* dst, const uint8_t* coverage, int count,
+                                 uint32_t color);
+
+// One row of the circle, split where its coverage changes: pixels
+// [left, solidLeft) and (solidRight, right] are edge, blended by coverage;
+// [solidLeft, solidRight] is solid, filled with the color. No solid pixels
+// is solidLeft = right + 1, solidRight = right (all of it one left edge).
+struct CircleRowSpan {
+    int left;
+    int solidLeft;
+    int solidRight;
+    int right;
+};
+
+// The part of a circle to draw: rows [minY, maxY], pixels [minX, maxX]
+// of each (already clipped), coverage reaching 0 at outerRadius
+struct CircleRows {
+    float cx;
+    float cy;
+    float outerRadius;
+    int minX;
+    int maxX;
+    int minY;
+    int maxY;
+};
+
+// Draw `rows` into pixels whose row y starts at pixels + y * stride: each
+// row split by circleRowSpan(), its edges blended in by coverage and its
+// solid middle filled with `color`
+using CircleRowsFn = void (*)(uint32_t* pixels, int stride, const CircleRows& rows,
+                              uint32_t color);
+using CircleRows565Fn = void (*)(uint16_t* pixels, int stride, const CircleRows& rows,
+                                 uint16_t color);
+
+struct CoverageKernel {
+    const char* name;           // "scalar", "sse2", "neon"
+    CircleCoverageFn circleCoverage;
+    BlendCoverageFn blendCoverage;
+    CircleRowsFn circleRows;
+    CircleRows565Fn circleRows565;
+};
+
+// All kernels this CPU can run, from slowest to fastest
+const CoverageKernel* supportedCoverageKernels(size_t* count);
+
+// The kernel fillCircleAA() uses
+const CoverageKernel& activeCoverageKernel();
+
+// Force a kernel by name. Returns false if this CPU can't run it.
+bool selectCoverageKernel(const char* name);
+
+// ---- One pixel, the way every kernel computes it ----
+
+// Coverage 0-255 of pixel x (see CircleCoverageFn)
+inline uint8_t circlePixelCoverage(int x, float cx, float dySq, float outerRadius) {
+    float dx = static_cast<float>(x) - cx;
+    float distance = sqrtf(dx * dx + dySq);
+    float covered = std::min(std::max(outerRadius - distance, 0.0f), 1.0f);
+    return static_cast<uint8_t>(covered * 255.0f + 0.5f);
+}
+
+// SOLID TEST: a pixel whose squared distance is at most this has coverage
+// 255 (it's a full pixel inside the edge), no square root needed; a row's
+// solid middle is where it holds. It's conservative: a pixel just outside
+// it may still round to 255, and blending that gives exactly `color` too.
+inline float circleSolidSq(float outerRadius) {
+    float inner = outerRadius - 1.0f;
+    return inner > 0.0f ? inner * inner : -1.0f;
+}
+
+inline bool circlePixelSolid(int x, float cx, float dySq, float solidSq) {
+    float dx = static_cast<float>(x) - cx;
+    return dx * dx + dySq <= solidSq;
+}
+
+// Coverage 0-255 to a blend weight 0-256, so 255 gives exactly `color`
+inline uint32_t coverageWeight(uint32_t coverage) {
+    return coverage + (coverage >> 7);
+}
+
+// (dst * (256 - w) + color * w + 128) >> 8 per channel, two channels at a
+// time (the same rounding as raster/upscale.cpp)
+inline uint32_t blendPixel(uint32_t dst, uint32_t color, uint32_t coverage) {
+    const uint32_t mask = 0x00FF00FF;
+    uint32_t weight = coverageWeight(coverage);
+    uint32_t inverse = 256 - weight;
+    uint32_t even = ((dst & mask) * inverse + (color & mask) * weight + 0x00800080) >> 8;
+    uint32_t odd = (((dst >> 8) & mask) * inverse + ((color >> 8) & mask) * weight +
+                    0x00800080) >> 8;
+    return (even & mask) | ((odd & mask) << 8);
+}
+
+// The 565 version: each channel at its own width, the same weights and
+// rounding
+inline uint16_t blendPixel565(uint16_t dst, uint16_t color, uint32_t coverage) {
+    uint32_t weight = coverageWeight(coverage);
+    uint32_t inverse = 256 - weight;
+    uint32_t r = ((dst >> 11) * inverse + (color >> 11) * weight + 128) >> 8;
+    uint32_t g = (((dst >> 5) & 0x3F) * inverse + ((color >> 5) & 0x3F) * weight + 128) >> 8;
+    uint32_t b = ((dst & 0x1F) * inverse + (color & 0x1F) * weight + 128) >> 8;
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// floorf / ceilf to int, without the library call they are on x86
+// without SSE4.1
+inline int floorToInt(float v) {
+    int t = static_cast<int>(v);
+    return t - (v < static_cast<float>(t));
+}
+
+inline int ceilToInt(float v) {
+    int t = static_cast<int>(v);
+    return t + (v > static_cast<float>(t));
+}
+
+// The rest of circleRowSpan() from the row's half-width solved for and
+// rounded in (left = ceil(cx - halfWidth), right = floor(cx + halfWidth),
+// not yet clipped): the SIMD kernels come in here with 4 rows' worth
+// solved at once, by the same float operations
+inline bool splitCircleRow(int left, int right, float cx, float dySq, float outerRadius,
+                           int minX, int maxX, CircleRowSpan* span) {
+    left = std::max(minX, left);
+    right = std::min(maxX, right);
+    if (left > right) {
+        return false;
+    }
+
+    const float solidSq = circleSolidSq(outerRadius);
+    if (right - left >= 5 && circlePixelSolid(left + 2, cx, dySq, solidSq) &&
+        circlePixelSolid(right - 2, cx, dySq, solidSq)) {
+        *span = {left, left + 2, right - 2, right};
+        return true;
+    }
+
+    *span = {left, right + 1, right, right};
+    float remaining = solidSq - dySq;
+    if (remaining < 0.0f) {
+        return true;
+    }
+    float halfWidth = sqrtf(remaining);
+    int solidLeft = std::max(left, ceilToInt(cx - halfWidth));
+    int solidRight = std::min(right, floorToInt(cx + halfWidth));
+    while (solidLeft <= solidRight && !circlePixelSolid(solidLeft, cx, dySq, solidSq)) {
+        solidLeft++;
+    }
+    while (solidRight >= solidLeft && !circlePixelSolid(solidRight, cx, dySq, solidSq)) {
+        solidRight--;
+    }
+    if (solidLeft <= solidRight) {
+        span->solidLeft = solidLeft;
+        span->solidRight = solidRight;
+    }
+    return true;
+}
+
+// The pixels in [minX, maxX] of a row dySq from the center that can have
+// any coverage, split as CircleRowSpan; false if there are none.
+//
+// The ends are solved like circleSpan() in raster.cpp, one square root
+// for the half-width, but need no fixing up: a pixel the rounding leaves
+// out is a hair from outerRadius away, coverage 0, and one it takes in
+// just blends by 0.
+//
+// The solid middle is the 2 compares circleSolidSq() makes cheap in most
+// rows: if the pixels 2 in from each end are solid, so is everything
+// between. Otherwise it's solved with a square root of its own and stepped
+// in until both ends pass circlePixelSolid(). Either way it never holds a
+// pixel that isn't solid; a solid pixel left in an edge just blends to
+// exactly the color.
+inline bool circleRowSpan(float cx, float dySq, float outerRadius, int minX, int maxX,
+                          CircleRowSpan* span) {
+    float remaining = outerRadius * outerRadius - dySq;
+    if (remaining < 0.0f) {
+        return false;
+    }
+    float halfWidth = sqrtf(remaining);
+    return splitCircleRow(ceilToInt(cx - halfWidth), floorToInt(cx + halfWidth), cx, dySq,
+                          outerRadius, minX, maxX, span);
+}
+
+// ---- Kernels (defined in coverage*.cpp, only call through dispatch) ----
+void circleCoverageScalar(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                          float outerRadius);
+void blendCoverageScalar(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color);
+void circleRowsScalar(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color);
+void circleRows565Scalar(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color);
+#if defined(__x86_64__) || defined(__i386__)
+void circleCoverageSSE2(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                        float outerRadius);
+void blendCoverageSSE2(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color);
+void circleRowsSSE2(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color);
+void circleRows565SSE2(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color);
+#endif
+#if defined(__ARM_NEON)
+void circleCoverageNEON(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                        float outerRadius);
+void blendCoverageNEON(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color);
+void circleRowsNEON(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color);
+void circleRows565NEON(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color);
+#endif
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_COVERAGE_H
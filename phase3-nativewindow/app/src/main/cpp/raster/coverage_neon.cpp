@@ -0,0 +1,320 @@
+/**
+ * raster/coverage_neon.cpp: Coverage kernels for ARM
+ *
+ * Coverage: 4 pixels per iteration in float lanes. arm64 has an IEEE
+ * vector square root (vsqrtq_f32); 32-bit NEON only has an estimate, so
+ * there the 4 square roots go through the VFP unit one lane at a time
+ * (still correctly rounded, like sqrtf). The rest is vector math in the
+ * scalar kernel's order.
+ *
+ * Blend: 4 pixels per iteration. The weights are narrowed to 16 bits and
+ * zipped so each pixel's weight covers its 4 channels; the products fit
+ * 16-bit lanes (255 * 256), and vrshrn_n_u16(sum, 8) is exactly the
+ * scalar (sum + 128) >> 8.
+ *
+ * Rows: like the SSE2 ones. 4 rows' half-widths with one square root,
+ * then a single group for both ends of most rows, 4 pixels per step
+ * otherwise. RGB_565 rows unpack the 5/6/5-bit channels into 16-bit lanes.
+ */
+
+#include "coverage.h"
+#include "fill.h"
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace raster {
+
+namespace {
+
+// 4 correctly rounded square roots, like sqrtf
+inline float32x4_t sqrt4(float32x4_t squared) {
+#if defined(__aarch64__)
+    return vsqrtq_f32(squared);
+#else
+    float32x4_t root = squared;
+    root = vsetq_lane_f32(sqrtf(vgetq_lane_f32(squared, 0)), root, 0);
+    root = vsetq_lane_f32(sqrtf(vgetq_lane_f32(squared, 1)), root, 1);
+    root = vsetq_lane_f32(sqrtf(vgetq_lane_f32(squared, 2)), root, 2);
+    root = vsetq_lane_f32(sqrtf(vgetq_lane_f32(squared, 3)), root, 3);
+    return root;
+#endif
+}
+
+struct CircleLanes {
+    int32x4_t lane;
+    float32x4_t center;
+    float32x4_t rowSq;
+    float32x4_t outer;
+
+    CircleLanes(float cx, float dySq, float outerRadius)
+        : center(vdupq_n_f32(cx)), rowSq(vdupq_n_f32(dySq)), outer(vdupq_n_f32(outerRadius)) {
+        const int32_t lanes[4] = {0, 1, 2, 3};
+        lane = vld1q_s32(lanes);
+    }
+
+    // Squared distances of the pixels at the 4 x positions
+    float32x4_t distanceSq(int32x4_t x) const {
+        float32x4_t dx = vsubq_f32(vcvtq_f32_s32(x), center);
+        return vaddq_f32(vmulq_f32(dx, dx), rowSq);
+    }
+
+    // Squared distances of pixels x .. x + 3
+    float32x4_t distanceSq(int x) const {
+        return distanceSq(vaddq_s32(vdupq_n_s32(x), lane));
+    }
+
+    // Coverage 0-255 of the 4 pixels, one per 32-bit lane
+    uint32x4_t coverage(float32x4_t squared) const {
+        float32x4_t distance = sqrt4(squared);
+        float32x4_t covered = vminq_f32(vmaxq_f32(vsubq_f32(outer, distance), vdupq_n_f32(0.0f)),
+                                        vdupq_n_f32(1.0f));
+        return vcvtq_u32_f32(vaddq_f32(vmulq_f32(covered, vdupq_n_f32(255.0f)),
+                                       vdupq_n_f32(0.5f)));
+    }
+};
+
+// 4 pixels blended towards color by 4 coverages (32-bit lanes, 0-255)
+inline uint32x4_t blend4(uint32x4_t pixels, uint32x4_t coverage, uint16x8_t colorChannels) {
+    uint16x4_t weight = vmovn_u32(vaddq_u32(coverage, vshrq_n_u32(coverage, 7)));
+    uint16x4x2_t pairs = vzip_u16(weight, weight);          // w0 w0 w1 w1 | w2 w2 w3 w3
+    uint16x4x2_t lo = vzip_u16(pairs.val[0], pairs.val[0]); // w0 x 4, w1 x 4
+    uint16x4x2_t hi = vzip_u16(pairs.val[1], pairs.val[1]); // w2 x 4, w3 x 4
+    uint16x8_t weightLo = vcombine_u16(lo.val[0], lo.val[1]);
+    uint16x8_t weightHi = vcombine_u16(hi.val[0], hi.val[1]);
+
+    const uint16x8_t full = vdupq_n_u16(256);
+    uint8x16_t bytes = vreinterpretq_u8_u32(pixels);
+    uint16x8_t sumLo = vmulq_u16(vmovl_u8(vget_low_u8(bytes)), vsubq_u16(full, weightLo));
+    uint16x8_t sumHi = vmulq_u16(vmovl_u8(vget_high_u8(bytes)), vsubq_u16(full, weightHi));
+    sumLo = vmlaq_u16(sumLo, colorChannels, weightLo);
+    sumHi = vmlaq_u16(sumHi, colorChannels, weightHi);
+    return vreinterpretq_u32_u8(vcombine_u8(vrshrn_n_u16(sumLo, 8), vrshrn_n_u16(sumHi, 8)));
+}
+
+inline void blend4(uint32_t* dst, uint32x4_t coverage, uint16x8_t colorChannels) {
+    vst1q_u32(dst, blend4(vld1q_u32(dst), coverage, colorChannels));
+}
+
+inline uint16x8_t channelsOf(uint32_t color) {
+    return vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(color)));
+}
+
+// A 565 color split into its channels, one per 16-bit lane
+struct Channels565 {
+    uint16x4_t r;
+    uint16x4_t g;
+    uint16x4_t b;
+
+    explicit Channels565(uint16_t color)
+        : r(vdup_n_u16(static_cast<uint16_t>(color >> 11))),
+          g(vdup_n_u16(static_cast<uint16_t>((color >> 5) & 0x3F))),
+          b(vdup_n_u16(static_cast<uint16_t>(color & 0x1F))) {}
+};
+
+// (d * inverse + c * weight + 128) >> 8 in 16-bit lanes
+inline uint16x4_t blendChannel(uint16x4_t d, uint16x4_t c, uint16x4_t weight,
+                               uint16x4_t inverse) {
+    return vrshr_n_u16(vmla_u16(vmul_u16(d, inverse), c, weight), 8);
+}
+
+// 4 565 pixels blended towards color by 4 coverages (32-bit lanes, 0-255)
+inline uint16x4_t blend4(uint16x4_t pixels, uint32x4_t coverage, const Channels565& color) {
+    uint16x4_t weight = vmovn_u32(vaddq_u32(coverage, vshrq_n_u32(coverage, 7)));
+    uint16x4_t inverse = vsub_u16(vdup_n_u16(256), weight);
+
+    uint16x4_t r = blendChannel(vshr_n_u16(pixels, 11), color.r, weight, inverse);
+    uint16x4_t g = blendChannel(vand_u16(vshr_n_u16(pixels, 5), vdup_n_u16(0x3F)), color.g,
+                                weight, inverse);
+    uint16x4_t b = blendChannel(vand_u16(pixels, vdup_n_u16(0x1F)), color.b, weight, inverse);
+    return vorr_u16(vorr_u16(vshl_n_u16(r, 11), vshl_n_u16(g, 5)), b);
+}
+
+// Pixels x .. x + 3 blended by their coverage
+inline void blendGroup(uint32_t* row, int x, const CircleLanes& lanes,
+                       uint16x8_t colorChannels) {
+    blend4(row + x, lanes.coverage(lanes.distanceSq(x)), colorChannels);
+}
+
+inline void blendGroup(uint16_t* row, int x, const CircleLanes& lanes,
+                       const Channels565& channels) {
+    vst1_u16(row + x, blend4(vld1_u16(row + x), lanes.coverage(lanes.distanceSq(x)), channels));
+}
+
+inline uint32x4_t endsCoverage(const CircleLanes& lanes, int left, int right) {
+    const int32_t positions[4] = {left, left + 1, right - 1, right};
+    return lanes.coverage(lanes.distanceSq(vld1q_s32(positions)));
+}
+
+// Pixels left, left + 1, right - 1 and right blended as one group
+inline void blendEnds(uint32_t* row, int left, int right, const CircleLanes& lanes,
+                      uint16x8_t colorChannels) {
+    uint32x4_t pixels = vcombine_u32(vld1_u32(row + left), vld1_u32(row + right - 1));
+    pixels = blend4(pixels, endsCoverage(lanes, left, right), colorChannels);
+    vst1_u32(row + left, vget_low_u32(pixels));
+    vst1_u32(row + right - 1, vget_high_u32(pixels));
+}
+
+inline void blendEnds(uint16_t* row, int left, int right, const CircleLanes& lanes,
+                      const Channels565& channels) {
+    uint32_t leftPair;
+    uint32_t rightPair;
+    memcpy(&leftPair, row + left, 4);
+    memcpy(&rightPair, row + right - 1, 4);
+    uint32x2_t pairs = vset_lane_u32(rightPair, vdup_n_u32(leftPair), 1);
+    uint16x4_t pixels = blend4(vreinterpret_u16_u32(pairs), endsCoverage(lanes, left, right),
+                               channels);
+    pairs = vreinterpret_u32_u16(pixels);
+    leftPair = vget_lane_u32(pairs, 0);
+    rightPair = vget_lane_u32(pairs, 1);
+    memcpy(row + left, &leftPair, 4);
+    memcpy(row + right - 1, &rightPair, 4);
+}
+
+inline uint32_t blendOne(uint32_t dst, uint32_t color, uint32_t coverage) {
+    return blendPixel(dst, color, coverage);
+}
+
+inline uint16_t blendOne(uint16_t dst, uint16_t color, uint32_t coverage) {
+    return blendPixel565(dst, color, coverage);
+}
+
+// A row in either pixel size. A group may reach into the solid middle
+// (those pixels blend to exactly the color), but never into the other
+// edge, whose pixels must be blended once.
+template <class Pixel, class Channels>
+inline void circleRowGroups(Pixel* row, const CircleRowSpan& span, float cx, float dySq,
+                            float outerRadius, Pixel color, const Channels& channels) {
+    const CircleLanes lanes(cx, dySq, outerRadius);
+    const int left = span.left;
+    const int right = span.right;
+
+    // MOST ROWS: the edge is at most 2 pixels deep at each end, so one
+    // group holds both ends, the 2 outermost pixels on each side
+    if (right - left >= 3 && span.solidLeft - left <= 2 && right - span.solidRight <= 2) {
+        blendEnds(row, left, right, lanes, channels);
+        if (right - left > 3) {
+            fillPixels(row + left + 2, static_cast<size_t>(right - left - 3), color);
+        }
+        return;
+    }
+
+    // The left edge from its outer end; with no solid middle it's the row
+    const int leftLimit = span.solidLeft <= span.solidRight ? span.solidRight : right;
+    int x = left;
+    for (; x < span.solidLeft && x + 3 <= leftLimit; x += 4) {
+        blendGroup(row, x, lanes, channels);
+    }
+    for (; x < span.solidLeft; x++) {
+        row[x] = blendOne(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+
+    // The right edge from its outer end, the same way
+    x = right;
+    for (; x > span.solidRight && x - 3 >= span.solidLeft; x -= 4) {
+        blendGroup(row, x - 3, lanes, channels);
+    }
+    for (; x > span.solidRight; x--) {
+        row[x] = blendOne(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+
+    if (span.solidLeft <= span.solidRight) {
+        fillPixels(row + span.solidLeft, static_cast<size_t>(span.solidRight - span.solidLeft + 1),
+                   color);
+    }
+}
+
+// ceilToInt() / floorToInt() of 4 lanes: truncate, then one step where
+// that went the wrong way (the compare is all ones, -1)
+inline int32x4_t ceilToInt(float32x4_t v) {
+    int32x4_t t = vcvtq_s32_f32(v);
+    return vsubq_s32(t, vreinterpretq_s32_u32(vcgtq_f32(v, vcvtq_f32_s32(t))));
+}
+
+inline int32x4_t floorToInt(float32x4_t v) {
+    int32x4_t t = vcvtq_s32_f32(v);
+    return vaddq_s32(t, vreinterpretq_s32_u32(vcltq_f32(v, vcvtq_f32_s32(t))));
+}
+
+// The whole circle, 4 rows at a time: their half-widths with one square
+// root, the rest of each row's span and the row itself one by one
+template <class Pixel, class Channels>
+inline void drawCircleRows(Pixel* pixels, int stride, const CircleRows& rows, Pixel color,
+                           const Channels& channels) {
+    const int32_t laneOffsets[4] = {0, 1, 2, 3};
+    const int32x4_t lane = vld1q_s32(laneOffsets);
+    const float32x4_t center = vdupq_n_f32(rows.cx);
+    const float32x4_t rowCenter = vdupq_n_f32(rows.cy);
+    const float32x4_t outerSq = vdupq_n_f32(rows.outerRadius * rows.outerRadius);
+
+    for (int y = rows.minY; y <= rows.maxY; y += 4) {
+        // Lanes past maxY are solved too, and not drawn
+        float32x4_t dy = vsubq_f32(vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(y), lane)), rowCenter);
+        float32x4_t dySq = vmulq_f32(dy, dy);
+        float32x4_t remaining = vsubq_f32(outerSq, dySq);
+        float32x4_t halfWidth = sqrt4(vmaxq_f32(remaining, vdupq_n_f32(0.0f)));
+
+        int32_t lefts[4];
+        int32_t rights[4];
+        uint32_t missed[4];
+        float squares[4];
+        vst1q_s32(lefts, ceilToInt(vsubq_f32(center, halfWidth)));
+        vst1q_s32(rights, floorToInt(vaddq_f32(center, halfWidth)));
+        vst1q_u32(missed, vcltq_f32(remaining, vdupq_n_f32(0.0f)));
+        vst1q_f32(squares, dySq);
+
+        int count = std::min(4, rows.maxY - y + 1);
+        for (int i = 0; i < count; i++) {
+            CircleRowSpan span;
+            if (!missed[i] &&
+                splitCircleRow(lefts[i], rights[i], rows.cx, squares[i], rows.outerRadius,
+                               rows.minX, rows.maxX, &span)) {
+                circleRowGroups(pixels + static_cast<ptrdiff_t>(y + i) * stride, span, rows.cx,
+                                squares[i], rows.outerRadius, color, channels);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void circleCoverageNEON(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                        float outerRadius) {
+    const CircleLanes lanes(cx, dySq, outerRadius);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint16x4_t narrow = vmovn_u32(lanes.coverage(lanes.distanceSq(x0 + i)));
+        uint8x8_t bytes = vmovn_u16(vcombine_u16(narrow, narrow));
+        uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+        memcpy(coverage + i, &packed, 4);
+    }
+    circleCoverageScalar(coverage + i, x0 + i, count - i, cx, dySq, outerRadius);
+}
+
+void blendCoverageNEON(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color) {
+    const uint16x8_t colorChannels = channelsOf(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t bits;
+        memcpy(&bits, coverage + i, 4);
+        uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+        blend4(dst + i, vmovl_u16(vget_low_u16(wide)), colorChannels);
+    }
+    blendCoverageScalar(dst + i, coverage + i, count - i, color);
+}
+
+void circleRowsNEON(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color) {
+    drawCircleRows(pixels, stride, rows, color, channelsOf(color));
+}
+
+void circleRows565NEON(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color) {
+    drawCircleRows(pixels, stride, rows, color, Channels565(color));
+}
+
+} // namespace raster
+
+#endif
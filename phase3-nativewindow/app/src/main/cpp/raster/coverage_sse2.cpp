@@ -0,0 +1,325 @@
+/**
+ * raster/coverage_sse2.cpp: Coverage kernels for x86
+ *
+ * Coverage: 4 pixels per iteration in float lanes. _mm_sqrt_ps is
+ * correctly rounded like sqrtf, and the x positions are converted from
+ * integers (not stepped by adding 4.0f), so each lane is the scalar
+ * result bit for bit.
+ *
+ * Blend: 4 pixels per iteration, channels widened to 16 bits. Each
+ * pixel's weight is spread over its 4 channels with two unpacks;
+ * d * (256 - w) + c * w is at most 255 * 256, so _mm_mullo_epi16 loses
+ * nothing.
+ *
+ * Row: the caller has already split it (CircleRowSpan), so there's no
+ * search here. Most rows are one group holding the 2 outermost pixels at
+ * each end; wider edges (near the top and bottom) go 4 pixels per step.
+ * RGB_565 rows are the same with 16-bit lanes: the 5/6/5-bit channels are
+ * shifted out, and d * (256 - w) + c * w is at most 63 * 256.
+ */
+
+#include "coverage.h"
+#include "fill.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace raster {
+
+namespace {
+
+struct CircleLanes {
+    __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    __m128 center;
+    __m128 rowSq;
+    __m128 outer;
+
+    CircleLanes(float cx, float dySq, float outerRadius)
+        : center(_mm_set1_ps(cx)), rowSq(_mm_set1_ps(dySq)),
+          outer(_mm_set1_ps(outerRadius)) {}
+
+    // Squared distances of the pixels at the 4 x positions
+    __m128 distanceSq(__m128i x) const {
+        __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(x), center);
+        return _mm_add_ps(_mm_mul_ps(dx, dx), rowSq);
+    }
+
+    // Squared distances of pixels x .. x + 3
+    __m128 distanceSq(int x) const {
+        return distanceSq(_mm_add_epi32(_mm_set1_epi32(x), lane));
+    }
+
+    // Coverage 0-255 of the 4 pixels, one per 32-bit lane
+    __m128i coverage(__m128 squared) const {
+        __m128 distance = _mm_sqrt_ps(squared);
+        __m128 covered = _mm_min_ps(_mm_max_ps(_mm_sub_ps(outer, distance), _mm_setzero_ps()),
+                                    _mm_set1_ps(1.0f));
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(covered, _mm_set1_ps(255.0f)),
+                                           _mm_set1_ps(0.5f)));
+    }
+};
+
+// 4 pixels blended towards color by 4 coverages (32-bit lanes, 0-255)
+inline __m128i blend4(__m128i pixels, __m128i coverage, __m128i colorChannels) {
+    const __m128i zero = _mm_setzero_si128();
+
+    // Weights 0-256: w w w w for pixel 0, pixel 1 (lo) / pixel 2, 3 (hi)
+    __m128i weight = _mm_add_epi32(coverage, _mm_srli_epi32(coverage, 7));
+    weight = _mm_packs_epi32(weight, weight);
+    weight = _mm_unpacklo_epi16(weight, weight);
+    __m128i weightLo = _mm_unpacklo_epi32(weight, weight);
+    __m128i weightHi = _mm_unpackhi_epi32(weight, weight);
+
+    const __m128i full = _mm_set1_epi16(256);
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i lo = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_sub_epi16(full, weightLo)),
+            _mm_mullo_epi16(colorChannels, weightLo));
+    __m128i hi = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_sub_epi16(full, weightHi)),
+            _mm_mullo_epi16(colorChannels, weightHi));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+inline void blend4(uint32_t* dst, __m128i coverage, __m128i colorChannels) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), blend4(pixels, coverage, colorChannels));
+}
+
+inline __m128i channelsOf(uint32_t color) {
+    return _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), _mm_setzero_si128());
+}
+
+// A 565 color split into its channels, one per 16-bit lane
+struct Channels565 {
+    __m128i r;
+    __m128i g;
+    __m128i b;
+
+    explicit Channels565(uint16_t color)
+        : r(_mm_set1_epi16(static_cast<short>(color >> 11))),
+          g(_mm_set1_epi16(static_cast<short>((color >> 5) & 0x3F))),
+          b(_mm_set1_epi16(static_cast<short>(color & 0x1F))) {}
+};
+
+// (d * inverse + c * weight + 128) >> 8 in 16-bit lanes
+inline __m128i blendChannel(__m128i d, __m128i c, __m128i weight, __m128i inverse) {
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(d, inverse), _mm_mullo_epi16(c, weight));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+// 4 565 pixels (the low 4 16-bit lanes) blended towards color by 4
+// coverages (32-bit lanes, 0-255)
+inline __m128i blend4(__m128i pixels, __m128i coverage, const Channels565& color) {
+    __m128i weight = _mm_add_epi32(coverage, _mm_srli_epi32(coverage, 7));
+    weight = _mm_packs_epi32(weight, weight);
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+
+    __m128i r = blendChannel(_mm_srli_epi16(pixels, 11), color.r, weight, inverse);
+    __m128i g = blendChannel(_mm_and_si128(_mm_srli_epi16(pixels, 5), _mm_set1_epi16(0x3F)),
+                             color.g, weight, inverse);
+    __m128i b = blendChannel(_mm_and_si128(pixels, _mm_set1_epi16(0x1F)), color.b, weight,
+                             inverse);
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+}
+
+// Pixels x .. x + 3 blended by their coverage
+inline void blendGroup(uint32_t* row, int x, const CircleLanes& lanes, __m128i colorChannels) {
+    blend4(row + x, lanes.coverage(lanes.distanceSq(x)), colorChannels);
+}
+
+inline void blendGroup(uint16_t* row, int x, const CircleLanes& lanes,
+                       const Channels565& channels) {
+    __m128i* dst = reinterpret_cast<__m128i*>(row + x);
+    _mm_storel_epi64(dst, blend4(_mm_loadl_epi64(dst), lanes.coverage(lanes.distanceSq(x)),
+                                 channels));
+}
+
+// Two adjacent 565 pixels as one 32-bit value
+inline __m128i loadPair(const uint16_t* pixels) {
+    int bits;
+    memcpy(&bits, pixels, 4);
+    return _mm_cvtsi32_si128(bits);
+}
+
+inline void storePair(uint16_t* pixels, __m128i pair) {
+    int bits = _mm_cvtsi128_si32(pair);
+    memcpy(pixels, &bits, 4);
+}
+
+// Pixels left, left + 1, right - 1 and right blended as one group
+inline void blendEnds(uint32_t* row, int left, int right, const CircleLanes& lanes,
+                      __m128i colorChannels) {
+    __m128i coverage =
+            lanes.coverage(lanes.distanceSq(_mm_setr_epi32(left, left + 1, right - 1, right)));
+    __m128i pixels = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + left)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + right - 1)));
+    pixels = blend4(pixels, coverage, colorChannels);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row + left), pixels);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row + right - 1),
+                     _mm_unpackhi_epi64(pixels, pixels));
+}
+
+inline void blendEnds(uint16_t* row, int left, int right, const CircleLanes& lanes,
+                      const Channels565& channels) {
+    __m128i coverage =
+            lanes.coverage(lanes.distanceSq(_mm_setr_epi32(left, left + 1, right - 1, right)));
+    __m128i pixels = _mm_unpacklo_epi32(loadPair(row + left), loadPair(row + right - 1));
+    pixels = blend4(pixels, coverage, channels);
+    storePair(row + left, pixels);
+    storePair(row + right - 1, _mm_srli_si128(pixels, 4));
+}
+
+inline uint32_t blendOne(uint32_t dst, uint32_t color, uint32_t coverage) {
+    return blendPixel(dst, color, coverage);
+}
+
+inline uint16_t blendOne(uint16_t dst, uint16_t color, uint32_t coverage) {
+    return blendPixel565(dst, color, coverage);
+}
+
+// A row in either pixel size. A group may reach into the solid middle
+// (those pixels blend to exactly the color), but never into the other
+// edge, whose pixels must be blended once.
+template <class Pixel, class Channels>
+inline void circleRowGroups(Pixel* row, const CircleRowSpan& span, float cx, float dySq,
+                            float outerRadius, Pixel color, const Channels& channels) {
+    const CircleLanes lanes(cx, dySq, outerRadius);
+    const int left = span.left;
+    const int right = span.right;
+
+    // MOST ROWS: the edge is at most 2 pixels deep at each end, so one
+    // group holds both ends, the 2 outermost pixels on each side
+    if (right - left >= 3 && span.solidLeft - left <= 2 && right - span.solidRight <= 2) {
+        blendEnds(row, left, right, lanes, channels);
+        if (right - left > 3) {
+            fillPixels(row + left + 2, static_cast<size_t>(right - left - 3), color);
+        }
+        return;
+    }
+
+    // The left edge from its outer end; with no solid middle it's the row
+    const int leftLimit = span.solidLeft <= span.solidRight ? span.solidRight : right;
+    int x = left;
+    for (; x < span.solidLeft && x + 3 <= leftLimit; x += 4) {
+        blendGroup(row, x, lanes, channels);
+    }
+    for (; x < span.solidLeft; x++) {
+        row[x] = blendOne(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+
+    // The right edge from its outer end, the same way
+    x = right;
+    for (; x > span.solidRight && x - 3 >= span.solidLeft; x -= 4) {
+        blendGroup(row, x - 3, lanes, channels);
+    }
+    for (; x > span.solidRight; x--) {
+        row[x] = blendOne(row[x], color, circlePixelCoverage(x, cx, dySq, outerRadius));
+    }
+
+    if (span.solidLeft <= span.solidRight) {
+        fillPixels(row + span.solidLeft, static_cast<size_t>(span.solidRight - span.solidLeft + 1),
+                   color);
+    }
+}
+
+// ceilToInt() / floorToInt() of 4 lanes: truncate, then one step where
+// that went the wrong way (the compare is all ones, -1)
+inline __m128i ceilToInt(__m128 v) {
+    __m128i t = _mm_cvttps_epi32(v);
+    return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(v, _mm_cvtepi32_ps(t))));
+}
+
+inline __m128i floorToInt(__m128 v) {
+    __m128i t = _mm_cvttps_epi32(v);
+    return _mm_add_epi32(t, _mm_castps_si128(_mm_cmplt_ps(v, _mm_cvtepi32_ps(t))));
+}
+
+// The whole circle, 4 rows at a time: their half-widths with one square
+// root, the rest of each row's span and the row itself one by one
+template <class Pixel, class Channels>
+inline void drawCircleRows(Pixel* pixels, int stride, const CircleRows& rows, Pixel color,
+                           const Channels& channels) {
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128 center = _mm_set1_ps(rows.cx);
+    const __m128 rowCenter = _mm_set1_ps(rows.cy);
+    const __m128 outerSq = _mm_set1_ps(rows.outerRadius * rows.outerRadius);
+
+    for (int y = rows.minY; y <= rows.maxY; y += 4) {
+        // Lanes past maxY are solved too, and not drawn
+        __m128 dy = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(y), lane)),
+                               rowCenter);
+        __m128 dySq = _mm_mul_ps(dy, dy);
+        __m128 remaining = _mm_sub_ps(outerSq, dySq);
+        int missed = _mm_movemask_ps(_mm_cmplt_ps(remaining, _mm_setzero_ps()));
+        __m128 halfWidth = _mm_sqrt_ps(_mm_max_ps(remaining, _mm_setzero_ps()));
+
+        alignas(16) int lefts[4];
+        alignas(16) int rights[4];
+        alignas(16) float squares[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lefts),
+                        ceilToInt(_mm_sub_ps(center, halfWidth)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(rights),
+                        floorToInt(_mm_add_ps(center, halfWidth)));
+        _mm_store_ps(squares, dySq);
+
+        int count = std::min(4, rows.maxY - y + 1);
+        for (int i = 0; i < count; i++) {
+            CircleRowSpan span;
+            if (!(missed & (1 << i)) &&
+                splitCircleRow(lefts[i], rights[i], rows.cx, squares[i], rows.outerRadius,
+                               rows.minX, rows.maxX, &span)) {
+                circleRowGroups(pixels + static_cast<ptrdiff_t>(y + i) * stride, span, rows.cx,
+                                squares[i], rows.outerRadius, color, channels);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void circleCoverageSSE2(uint8_t* coverage, int x0, int count, float cx, float dySq,
+                        float outerRadius) {
+    const CircleLanes lanes(cx, dySq, outerRadius);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = lanes.coverage(lanes.distanceSq(x0 + i));
+        __m128i words = _mm_packs_epi32(values, values);
+        int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        memcpy(coverage + i, &packed, 4);
+    }
+    circleCoverageScalar(coverage + i, x0 + i, count - i, cx, dySq, outerRadius);
+}
+
+void blendCoverageSSE2(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color) {
+    const __m128i colorChannels = channelsOf(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int bits;
+        memcpy(&bits, coverage + i, 4);
+        __m128i values = _mm_unpacklo_epi16(
+                _mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), _mm_setzero_si128()),
+                _mm_setzero_si128());
+        blend4(dst + i, values, colorChannels);
+    }
+    blendCoverageScalar(dst + i, coverage + i, count - i, color);
+}
+
+void circleRowsSSE2(uint32_t* pixels, int stride, const CircleRows& rows, uint32_t color) {
+    drawCircleRows(pixels, stride, rows, color, channelsOf(color));
+}
+
+void circleRows565SSE2(uint16_t* pixels, int stride, const CircleRows& rows, uint16_t color) {
+    drawCircleRows(pixels, stride, rows, color, Channels565(color));
+}
+
+} // namespace raster
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * raster/damage.cpp: Dirty-rectangle tracking for partial repaints
+ */
+
+#include "damage.h"
+
+namespace raster {
+
+// ========== DamageRegion ==========
+
+void DamageRegion::add(const Rect& rect) {
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    // Work on a scratch copy with room for the new rect
+    Rect rects[kMaxRects + 1];
+    int count = 0;
+    for (int i = 0; i < m_count; i++) {
+        rects[count++] = m_rects[i];
+    }
+    rects[count++] = rect;
+
+    // Keep merging until nothing overlaps and we fit in kMaxRects.
+    // Counts are tiny (<= 5), so the brute-force pair search is cheapest.
+    for (;;) {
+        int mergeA = -1;
+        int mergeB = -1;
+
+        for (int a = 0; a < count && mergeA < 0; a++) {
+            for (int b = a + 1; b < count; b++) {
+                if (rectsOverlap(rects[a], rects[b])) {
+                    mergeA = a;
+                    mergeB = b;
+                    break;
+                }
+            }
+        }
+
+        if (mergeA < 0 && count > kMaxRects) {
+            // Too many rects: merge the pair that adds the fewest pixels
+            int64_t bestWaste = INT64_MAX;
+            for (int a = 0; a < count; a++) {
+                for (int b = a + 1; b < count; b++) {
+                    int64_t waste = uniteRects(rects[a], rects[b]).area() -
+                                    rects[a].area() - rects[b].area();
+                    if (waste < bestWaste) {
+                        bestWaste = waste;
+                        mergeA = a;
+                        mergeB = b;
+                    }
+                }
+            }
+        }
+
+        if (mergeA < 0) {
+            break;
+        }
+
+        rects[mergeA] = uniteRects(rects[mergeA], rects[mergeB]);
+        rects[mergeB] = rects[--count];
+    }
+
+    for (int i = 0; i < count; i++) {
+        m_rects[i] = rects[i];
+    }
+    m_count = count;
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    for (int i = 0; i < other.m_count; i++) {
+        add(other.m_rects[i]);
+    }
+}
+
+void DamageRegion::intersect(const Rect& clip) {
+    int count = 0;
+    for (int i = 0; i < m_count; i++) {
+        Rect clipped = intersectRects(m_rects[i], clip);
+        if (!clipped.isEmpty()) {
+            m_rects[count++] = clipped;
+        }
+    }
+    m_count = count;
+}
+
+Rect DamageRegion::bounds() const {
+    Rect result;
+    for (int i = 0; i < m_count; i++) {
+        result = uniteRects(result, m_rects[i]);
+    }
+    return result;
+}
+
+int64_t DamageRegion::area() const {
+    int64_t total = 0;
+    for (int i = 0; i < m_count; i++) {
+        total += m_rects[i].area();
+    }
+    return total;
+}
+
+void DamageRegion::removeAt(int index) {
+    m_rects[index] = m_rects[--m_count];
+}
+
+// ========== DamageTracker ==========
+
+void DamageTracker::reset() {
+    m_firstFrame = m_frame + 1;
+    m_primitiveCount = 0;
+    for (TrackedBuffer& buffer : m_buffers) {
+        buffer = TrackedBuffer();
+    }
+}
+
+void DamageTracker::beginFrame(int width, int height) {
+    if (width != m_width || height != m_height) {
+        m_width = width;
+        m_height = height;
+        reset();
+    }
+
+    m_frame++;
+    m_fullThisFrame = (m_frame == m_firstFrame);
+    historyFor(m_frame).clear();
+
+    for (int i = 0; i < m_primitiveCount; i++) {
+        m_primitives[i].seen = false;
+    }
+}
+
+void DamageTracker::addPrimitive(uint32_t id, const Rect& bounds) {
+    DamageRegion& damage = historyFor(m_frame);
+
+    for (int i = 0; i < m_primitiveCount; i++) {
+        Primitive& primitive = m_primitives[i];
+        if (primitive.id == id) {
+            // Moved (or not): erase where it was, draw where it is
+            if (primitive.bounds != bounds) {
+                damage.add(primitive.bounds);
+                damage.add(bounds);
+                primitive.bounds = bounds;
+            }
+            primitive.seen = true;
+            return;
+        }
+    }
+
+    if (m_primitiveCount == kMaxPrimitives) {
+        // Too many shapes to track individually; just repaint everything
+        m_fullThisFrame = true;
+        return;
+    }
+
+    Primitive& primitive = m_primitives[m_primitiveCount++];
+    primitive.id = id;
+    primitive.bounds = bounds;
+    primitive.seen = true;
+    damage.add(bounds);
+}
+
+Rect DamageTracker::finishScene() {
+    DamageRegion& damage = historyFor(m_frame);
+
+    // Primitives not declared this frame were removed: erase them
+    for (int i = 0; i < m_primitiveCount;) {
+        if (!m_primitives[i].seen) {
+            damage.add(m_primitives[i].bounds);
+            m_primitives[i] = m_primitives[--m_primitiveCount];
+        } else {
+            i++;
+        }
+    }
+
+    if (m_fullThisFrame) {
+        damage.clear();
+        damage.add(fullRect());
+    }
+    damage.intersect(fullRect());
+
+    // Lock enough to repaint any buffer up to kMaxBufferAge frames old
+    m_lockRect = Rect();
+    for (int age = 0; age < kMaxBufferAge; age++) {
+        if (m_frame - age < m_firstFrame) {
+            break;
+        }
+        m_lockRect = uniteRects(m_lockRect, historyFor(m_frame - age).bounds());
+    }
+    return m_lockRect;
+}
+
+const DamageRegion& DamageTracker::resolve(const Surface& surface,
+                                           const Rect& returnedBounds) {
+    Rect surfaceRect = makeRect(0, 0, surface.width, surface.height);
+    Rect lockRegion = intersectRects(returnedBounds, surfaceRect);
+
+    // A different size, stride or format means the BufferQueue reallocated:
+    // nothing we remember about any buffer is valid anymore
+    bool geometryChanged = surface.width != m_width || surface.height != m_height ||
+                           surface.stride != m_stride || surface.format != m_format;
+    if (geometryChanged) {
+        m_width = surface.width;
+        m_height = surface.height;
+        m_stride = surface.stride;
+        m_format = surface.format;
+        reset();
+    }
+
+    // How many frames ago did we last draw into this exact buffer?
+    int age = 0;
+    TrackedBuffer* slot = nullptr;
+    for (TrackedBuffer& buffer : m_buffers) {
+        if (buffer.bits == surface.bits && buffer.bits != nullptr) {
+            slot = &buffer;
+            uint64_t frames = m_frame - buffer.lastFrame;
+            if (frames >= 1 && frames <= static_cast<uint64_t>(kMaxBufferAge)) {
+                age = static_cast<int>(frames);
+            }
+            break;
+        }
+    }
+
+    // Full repaint of the locked region when:
+    // - the producer grew our dirty rect (it couldn't copy back), or
+    // - this isn't a buffer we have drawn into recently
+    bool full = geometryChanged || returnedBounds != m_lockRect || age == 0;
+
+    m_repaint.clear();
+    if (full) {
+        m_repaint.add(lockRegion);
+    } else {
+        for (int i = 0; i < age; i++) {
+            m_repaint.add(historyFor(m_frame - i));
+        }
+        m_repaint.intersect(lockRegion);
+    }
+
+    // Remember this buffer (evict the least recently used one if needed)
+    if (!slot) {
+        slot = &m_buffers[0];
+        for (TrackedBuffer& buffer : m_buffers) {
+            if (buffer.lastFrame < slot->lastFrame) {
+                slot = &buffer;
+            }
+        }
+        slot->bits = surface.bits;
+    }
+    slot->lastFrame = m_frame;
+
+    m_stats.pixelsTouched = m_repaint.area();
+    m_stats.pixelsTotal = static_cast<int64_t>(surface.width) * surface.height;
+    m_stats.rectCount = m_repaint.count();
+    m_stats.bufferAge = age;
+    m_stats.fullRepaint = full;
+    return m_repaint;
+}
+
+} // namespace raster
@@ -0,0 +1,151 @@
+/**
+ * raster/damage.h: Dirty-rectangle tracking for partial repaints
+ *
+ * Our scene is one 80 px circle moving over a flat background, yet
+ * drawFrame() used to repaint every pixel of the buffer every frame.
+ * The DamageTracker works out which pixels can actually have changed so
+ * drawFrame() can lock and repaint only those.
+ *
+ * HOW ANativeWindow_lock(window, &buffer, &dirtyBounds) BEHAVES:
+ * - Outside dirtyBounds, the Surface copies the last posted frame into the
+ *   buffer for us ("copy-back"), so those pixels are already correct.
+ * - Inside dirtyBounds, the buffer still holds whatever WE drew into that
+ *   particular buffer the last time we had it. With 2-3 buffers rotating,
+ *   that is 2-3 frames old.
+ * - If copy-back is impossible (first frame, resize), dirtyBounds comes
+ *   back as the whole buffer and we must repaint all of it.
+ *
+ * So inside the lock rect we need to know how old the buffer is ("buffer
+ * age", the same idea as EGL_EXT_buffer_age). We recognize buffers by
+ * their bits pointer. A buffer we have drawn into `age` frames ago only
+ * needs the damage of the last `age` frames repainted. A buffer we don't
+ * recognize gets a full repaint of the locked region.
+ *
+ * PER-FRAME USAGE:
+ *   tracker.beginFrame(width, height);
+ *   tracker.addPrimitive(id, bounds);         // for every drawn shape
+ *   Rect lockRect = tracker.finishScene();    // pass to ANativeWindow_lock
+ *   ... lock ...
+ *   const DamageRegion& repaint = tracker.resolve(surface, returnedBounds);
+ *   for each rect in repaint: clear + draw clipped to it
+ *
+ * Lookup: "Surface::lock copyback", "EGL_EXT_buffer_age", "damage tracking"
+ */
+
+#ifndef PHASE3_RASTER_DAMAGE_H
+#define PHASE3_RASTER_DAMAGE_H
+
+#include "rect.h"
+#include "surface.h"
+
+namespace raster {
+
+// A small set of non-overlapping rects
+//
+// Adding a rect merges it with any rect it overlaps. When the set is full,
+// the pair whose union wastes the fewest pixels gets merged, so the set
+// never grows beyond kMaxRects.
+class DamageRegion {
+public:
+    static const int kMaxRects = 4;
+
+    void clear() { m_count = 0; }
+    void add(const Rect& rect);
+    void add(const DamageRegion& other);
+
+    // Clip every rect to `clip`, dropping the ones that become empty
+    void intersect(const Rect& clip);
+
+    bool isEmpty() const { return m_count == 0; }
+    int count() const { return m_count; }
+    const Rect& operator[](int index) const { return m_rects[index]; }
+
+    Rect bounds() const;
+    int64_t area() const;  // Exact, since the rects never overlap
+
+private:
+    void removeAt(int index);
+
+    Rect m_rects[kMaxRects];
+    int m_count = 0;
+};
+
+// What the last resolve() decided, for logging and benchmarks
+struct DamageStats {
+    int64_t pixelsTouched = 0;  // Pixels cleared and redrawn this frame
+    int64_t pixelsTotal = 0;    // width * height
+    int rectCount = 0;          // Rects in the repaint region
+    int bufferAge = 0;          // 0 = unknown buffer (full repaint)
+    bool fullRepaint = false;   // Whole lock region repainted
+};
+
+class DamageTracker {
+public:
+    // How many frames of damage history we keep. BufferQueues hand out at
+    // most 3 buffers to a producer, so any older buffer is a new one.
+    static const int kMaxBufferAge = 3;
+
+    // Start a frame. A size change forgets everything.
+    void beginFrame(int width, int height);
+
+    // Declare where primitive `id` is drawn this frame
+    // (a primitive that isn't declared again is treated as removed)
+    void addPrimitive(uint32_t id, const Rect& bounds);
+
+    // Close the scene: returns the rect to pass to ANativeWindow_lock
+    // (the damage of the last kMaxBufferAge frames, or the whole buffer)
+    Rect finishScene();
+
+    // After the lock: what needs repainting in the buffer we were given
+    //
+    // `returnedBounds` is the inOutDirtyBounds the lock wrote back. If the
+    // producer grew it (no copy-back possible), or handed us a buffer we
+    // don't recognize, the whole returned region is repainted.
+    const DamageRegion& resolve(const Surface& surface, const Rect& returnedBounds);
+
+    // Forget all buffers and history (next frame is a full repaint)
+    void reset();
+
+    const DamageStats& stats() const { return m_stats; }
+
+private:
+    static const int kMaxPrimitives = 64;
+    static const int kMaxTrackedBuffers = 4;
+
+    struct Primitive {
+        uint32_t id;
+        Rect bounds;
+        bool seen;
+    };
+
+    struct TrackedBuffer {
+        const void* bits = nullptr;
+        uint64_t lastFrame = 0;
+    };
+
+    DamageRegion& historyFor(uint64_t frame) { return m_history[frame % kMaxBufferAge]; }
+    Rect fullRect() const { return makeRect(0, 0, m_width, m_height); }
+
+    int m_width = 0;
+    int m_height = 0;
+    int32_t m_stride = 0;
+    PixelFormat m_format = PixelFormat::RGBA_8888;
+
+    uint64_t m_frame = 0;        // Frame counter, 1 for the first frame
+    uint64_t m_firstFrame = 1;   // First frame with usable history
+    bool m_fullThisFrame = true; // Damage for this frame is the whole buffer
+
+    Primitive m_primitives[kMaxPrimitives];
+    int m_primitiveCount = 0;
+
+    DamageRegion m_history[kMaxBufferAge];  // Per-frame damage, ring buffer
+    Rect m_lockRect;
+    DamageRegion m_repaint;
+
+    TrackedBuffer m_buffers[kMaxTrackedBuffers];
+    DamageStats m_stats;
+};
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_DAMAGE_H
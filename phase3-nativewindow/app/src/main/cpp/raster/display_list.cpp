@@ -0,0 +1,220 @@
+/**
+ * raster/display_list.cpp: Retained drawing commands for the CPU renderer
+ */
+
+#include "display_list.h"
+#include "raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace raster {
+
+// Bounds that no viewport can miss (Clear covers whatever it's given)
+static Rect everywhere() {
+    const int32_t big = std::numeric_limits<int32_t>::max() / 2;
+    return makeRect(-big, -big, big, big);
+}
+
+Command& DisplayList::append(CommandType type, const Rect& bounds) {
+    if (m_count == m_capacity) {
+        // Grow inside the arena; the old array is simply abandoned until
+        // the arena resets
+        size_t capacity = std::max<size_t>(64, m_capacity * 2);
+        Command* commands = m_arena.allocateArray<Command>(capacity);
+        if (m_count > 0) {
+            memcpy(commands, m_commands, m_count * sizeof(Command));
+        }
+        m_commands = commands;
+        m_capacity = capacity;
+    }
+
+    Command& command = m_commands[m_count];
+    command = Command();  // Value-initialized: all fields zero
+    command.type = type;
+    command.id = static_cast<uint32_t>(m_count);
+    command.bounds = bounds;
+    m_count++;
+    return command;
+}
+
+Command& DisplayList::clear(uint32_t argb) {
+    Command& command = append(CommandType::Clear, everywhere());
+    command.clear.color = argb;
+    return command;
+}
+
+Command& DisplayList::fillRect(const Rect& rect, uint32_t argb) {
+    Command& command = append(CommandType::FillRect, rect);
+    command.fillRect.color = argb;
+    return command;
+}
+
+Command& DisplayList::fillCircle(float cx, float cy, float radius, uint32_t argb) {
+    Command& command = append(CommandType::FillCircle, circleRect(cx, cy, radius));
+    command.fillCircle.cx = cx;
+    command.fillCircle.cy = cy;
+    command.fillCircle.radius = radius;
+    command.fillCircle.color = argb;
+    return command;
+}
+
+Command& DisplayList::fillCircleAA(float cx, float cy, float radius, uint32_t argb) {
+    Command& command =
+            append(CommandType::FillCircleAA, antiAliasedCircleRect(cx, cy, radius));
+    command.fillCircle.cx = cx;
+    command.fillCircle.cy = cy;
+    command.fillCircle.radius = radius;
+    command.fillCircle.color = argb;
+    return command;
+}
+
+Command& DisplayList::blit(const void* pixels, int width, int height, int stride,
+                           int x, int y) {
+    Command& command = append(CommandType::Blit, makeRect(x, y, x + width, y + height));
+    command.blit.pixels = pixels;
+    command.blit.stride = stride;
+    return command;
+}
+
+Command& DisplayList::line(float x0, float y0, float x1, float y1, uint32_t argb) {
+    // Endpoints are rounded to pixel centers when drawn
+    Rect bounds = makeRect(static_cast<int32_t>(lroundf(std::min(x0, x1))),
+                           static_cast<int32_t>(lroundf(std::min(y0, y1))),
+                           static_cast<int32_t>(lroundf(std::max(x0, x1))) + 1,
+                           static_cast<int32_t>(lroundf(std::max(y0, y1))) + 1);
+    Command& command = append(CommandType::Line, bounds);
+    command.line.x0 = x0;
+    command.line.y0 = y0;
+    command.line.x1 = x1;
+    command.line.y1 = y1;
+    command.line.color = argb;
+    return command;
+}
+
+Command& DisplayList::blendBitmap(const uint32_t* pixels, int width, int height, int stride,
+                                  int x, int y, BlendMode mode, uint8_t alpha) {
+    Command& command =
+            append(CommandType::BlendBitmap, makeRect(x, y, x + width, y + height));
+    command.blendBitmap.pixels = pixels;
+    command.blendBitmap.stride = stride;
+    command.blendBitmap.mode = mode;
+    command.blendBitmap.alpha = alpha;
+    return command;
+}
+
+void DisplayList::reset() {
+    m_commands = nullptr;
+    m_count = 0;
+    m_capacity = 0;
+}
+
+void DisplayList::cull(const Rect& viewport) {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_count; i++) {
+        if (rectsOverlap(m_commands[i].bounds, viewport)) {
+            m_commands[kept++] = m_commands[i];
+        }
+    }
+    m_count = kept;
+}
+
+void DisplayList::sortByLayer() {
+    std::stable_sort(m_commands, m_commands + m_count,
+                     [](const Command& a, const Command& b) { return a.layer < b.layer; });
+}
+
+void executeCommand(const Surface& surface, const PixelKernels& kernels,
+                    const Command& command, const Rect& clip) {
+    switch (command.type) {
+        case CommandType::Clear:
+            kernels.fillRect(surface, clip, command.clear.color);
+            break;
+
+        case CommandType::FillRect:
+            kernels.fillRect(surface, intersectRects(command.bounds, clip),
+                             command.fillRect.color);
+            break;
+
+        case CommandType::FillCircle: {
+            const FillCircleParams& circle = command.fillCircle;
+            kernels.fillCircle(surface, circle.cx, circle.cy, circle.radius, circle.color, clip);
+            break;
+        }
+
+        case CommandType::FillCircleAA: {
+            const FillCircleParams& circle = command.fillCircle;
+            kernels.fillCircleAA(surface, circle.cx, circle.cy, circle.radius, circle.color,
+                                 clip);
+            break;
+        }
+
+        case CommandType::Blit: {
+            const Rect& dst = command.bounds;
+            kernels.blit(surface, command.blit.pixels, dst.right - dst.left,
+                         dst.bottom - dst.top, command.blit.stride, dst.left, dst.top, clip);
+            break;
+        }
+
+        case CommandType::Line: {
+            const LineParams& line = command.line;
+            kernels.line(surface, line.x0, line.y0, line.x1, line.y1, line.color, clip);
+            break;
+        }
+
+        case CommandType::BlendBitmap: {
+            const Rect& dst = command.bounds;
+            const BlendBitmapParams& bitmap = command.blendBitmap;
+            kernels.blendBitmap(surface, bitmap.pixels, dst.right - dst.left,
+                                dst.bottom - dst.top, bitmap.stride, dst.left, dst.top,
+                                bitmap.mode, bitmap.alpha, clip);
+            break;
+        }
+    }
+}
+
+void executeDisplayList(const Surface& surface, const DisplayList& list, const Rect& clip) {
+    const PixelKernels* kernels = pixelKernels(surface.format);
+    Rect target = intersectRects(clip, makeRect(0, 0, surface.width, surface.height));
+    if (!kernels || target.isEmpty()) {
+        return;
+    }
+
+    // One front-to-back pass; each command is skipped unless it can touch
+    // the clip rect
+    for (const Command& command : list) {
+        if (rectsOverlap(command.bounds, target)) {
+            executeCommand(surface, *kernels, command, target);
+        }
+    }
+}
+
+void executeCommands(const Surface& surface, const PixelKernels& kernels,
+                     const DisplayList& list, const uint32_t* indices, size_t count,
+                     const Rect& clip) {
+    Rect target = intersectRects(clip, makeRect(0, 0, surface.width, surface.height));
+    if (target.isEmpty()) {
+        return;
+    }
+
+    // The binner only guarantees a command overlaps the tile, not this
+    // (possibly smaller) clip, so the overlap test stays
+    for (size_t i = 0; i < count; i++) {
+        const Command& command = list[indices[i]];
+        if (rectsOverlap(command.bounds, target)) {
+            executeCommand(surface, kernels, command, target);
+        }
+    }
+}
+
+void addDisplayListDamage(DamageTracker& tracker, const DisplayList& list) {
+    for (const Command& command : list) {
+        if (command.type != CommandType::Clear) {
+            tracker.addPrimitive(command.id, command.bounds);
+        }
+    }
+}
+
+} // namespace raster
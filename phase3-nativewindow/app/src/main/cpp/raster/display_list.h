@@ -0,0 +1,175 @@
+/**
+ * raster/display_list.h: Retained drawing commands for the CPU renderer
+ *
+ * Instead of drawing shapes the moment they are described (immediate
+ * mode), the scene is first recorded as a flat array of small POD commands
+ * and then rasterized in one pass. That separates WHAT to draw from
+ * DRAWING it:
+ * - The scene can be built on a different thread than the one rasterizing
+ * - Commands can be culled against the viewport and sorted by layer before
+ *   any pixel is touched
+ * - The rasterizer can run the same list once per tile
+ *
+ * Every command is the same size (a Command), so the list is one
+ * contiguous array that the rasterizer walks front to back. Its memory
+ * comes from a FrameArena, so recording a frame never calls malloc once
+ * the arena has warmed up.
+ *
+ * COLORS are stored as Android color ints (0xAARRGGBB, like Color.argb())
+ * and packed for the surface format when the command is rasterized (by
+ * the format's PixelKernels), so the producer doesn't need to know the
+ * buffer format.
+ *
+ * Lookup: "display list", "command buffer", "retained mode rendering"
+ */
+
+#ifndef PHASE3_RASTER_DISPLAY_LIST_H
+#define PHASE3_RASTER_DISPLAY_LIST_H
+
+#include "damage.h"
+#include "frame_arena.h"
+#include "pixel_kernels.h"
+#include "rect.h"
+#include "surface.h"
+
+#include <type_traits>
+
+namespace raster {
+
+enum class CommandType : uint8_t {
+    Clear,       // Fill the whole target
+    FillRect,    // Fill `bounds`
+    FillCircle,  // Solid circle
+    FillCircleAA,  // Solid circle with an anti-aliased edge (FillCircleParams too)
+    Blit,        // Copy opaque pixels to (bounds.left, bounds.top)
+    Line,        // 1 px line
+    BlendBitmap,  // Composite a premultiplied bitmap at (bounds.left, bounds.top)
+};
+
+struct ClearParams {
+    uint32_t color;
+};
+
+struct FillRectParams {
+    uint32_t color;  // The rect itself is Command::bounds
+};
+
+struct FillCircleParams {
+    float cx;
+    float cy;
+    float radius;
+    uint32_t color;
+};
+
+struct BlitParams {
+    // Already in the destination pixel format. Must stay valid until the
+    // list has been rasterized (copy it into the arena if in doubt).
+    const void* pixels;
+    int32_t stride;  // In pixels
+};
+
+struct BlendBitmapParams {
+    // Premultiplied RGBA_8888 whatever the target format, valid until the
+    // list has been rasterized (like BlitParams)
+    const uint32_t* pixels;
+    int32_t stride;  // In pixels
+    BlendMode mode;
+    uint8_t alpha;   // Layer opacity, 255 = as is
+};
+
+struct LineParams {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    uint32_t color;
+};
+
+struct Command {
+    CommandType type;
+    uint8_t reserved;
+    uint16_t layer;  // Sort key: lower layers are drawn first
+    uint32_t id;     // Stable identity across frames (for damage tracking)
+    Rect bounds;     // Every pixel this command may write (for culling)
+    union {
+        ClearParams clear;
+        FillRectParams fillRect;
+        FillCircleParams fillCircle;
+        BlitParams blit;
+        LineParams line;
+        BlendBitmapParams blendBitmap;
+    };
+};
+
+static_assert(std::is_trivially_copyable<Command>::value,
+              "Commands are copied and sorted with memcpy semantics");
+
+class DisplayList {
+public:
+    // Commands are allocated from `arena`; the list is invalid after the
+    // arena is reset, so call reset() on both together
+    explicit DisplayList(FrameArena& arena) : m_arena(arena) {}
+
+    DisplayList(const DisplayList&) = delete;
+    DisplayList& operator=(const DisplayList&) = delete;
+
+    // ---- Recording ----
+    // Each returns the new command so callers can adjust id/layer.
+    // Without an explicit id, a command's id is its position in the list.
+    Command& clear(uint32_t argb);
+    Command& fillRect(const Rect& rect, uint32_t argb);
+    Command& fillCircle(float cx, float cy, float radius, uint32_t argb);
+    Command& fillCircleAA(float cx, float cy, float radius, uint32_t argb);
+    Command& blit(const void* pixels, int width, int height, int stride, int x, int y);
+    Command& line(float x0, float y0, float x1, float y1, uint32_t argb);
+    Command& blendBitmap(const uint32_t* pixels, int width, int height, int stride, int x,
+                         int y, BlendMode mode, uint8_t alpha = 255);
+
+    // Drop every command (does NOT reset the arena)
+    void reset();
+
+    // ---- Preparing ----
+    // Remove commands that can't touch `viewport` (Clear always survives)
+    void cull(const Rect& viewport);
+
+    // Stable sort by layer: same-layer commands keep recording order
+    void sortByLayer();
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    const Command* begin() const { return m_commands; }
+    const Command* end() const { return m_commands + m_count; }
+    const Command& operator[](size_t index) const { return m_commands[index]; }
+
+private:
+    Command& append(CommandType type, const Rect& bounds);
+
+    FrameArena& m_arena;
+    Command* m_commands = nullptr;
+    size_t m_count = 0;
+    size_t m_capacity = 0;
+};
+
+// Rasterize one command, writing only pixels inside `clip`
+// (`clip` must lie within the surface; `kernels` must match surface.format)
+void executeCommand(const Surface& surface, const PixelKernels& kernels,
+                    const Command& command, const Rect& clip);
+
+// Rasterize a whole list in order, writing only pixels inside `clip`
+// (looks up the kernels for surface.format once; unknown formats draw nothing)
+void executeDisplayList(const Surface& surface, const DisplayList& list, const Rect& clip);
+
+// Rasterize only the commands at `indices` (in that order), clipped to
+// `clip`. Used with a TileBinner's per-tile command lists.
+void executeCommands(const Surface& surface, const PixelKernels& kernels,
+                     const DisplayList& list, const uint32_t* indices, size_t count,
+                     const Rect& clip);
+
+// Declare every command to a DamageTracker (by id and bounds)
+//
+// Clear commands are treated as a static background and not tracked.
+void addDisplayListDamage(DamageTracker& tracker, const DisplayList& list);
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_DISPLAY_LIST_H
@@ -0,0 +1,156 @@
+/**
+ * raster/fill.cpp: Span fill dispatch, scalar kernel and fillRect()
+ */
+
+#include "fill.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace raster {
+
+void fillSpanScalar(uint32_t* dst, size_t count, uint32_t color) {
+    // Reference kernel: one store per pixel
+    // (at -O2 the compiler may vectorize this itself, but without the
+    // alignment handling or streaming stores of the hand-written kernels)
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+namespace {
+
+struct KernelTable {
+    FillKernel kernels[4];
+    size_t count = 0;
+
+    KernelTable() {
+        kernels[count++] = {"scalar", fillSpanScalar};
+
+#if defined(__x86_64__) || defined(__i386__)
+        // SSE2 is part of the x86_64 baseline; AVX2 needs a runtime check
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels[count++] = {"sse2", fillSpanSSE2};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            kernels[count++] = {"avx2", fillSpanAVX2};
+        }
+#endif
+
+#if defined(__ARM_NEON)
+        // NEON is mandatory on arm64, and the NDK builds armeabi-v7a with
+        // NEON enabled (every Android 28+ ARM device has it)
+        kernels[count++] = {"neon", fillSpanNEON};
+#endif
+    }
+};
+
+const KernelTable& kernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+// The active kernel (nullptr until first use, then an entry of kernelTable())
+std::atomic<const FillKernel*> g_active{nullptr};
+
+const FillKernel* active() {
+    const FillKernel* kernel = g_active.load(std::memory_order_acquire);
+    if (!kernel) {
+        const KernelTable& table = kernelTable();
+        kernel = &table.kernels[table.count - 1];
+        g_active.store(kernel, std::memory_order_release);
+    }
+    return kernel;
+}
+
+} // namespace
+
+const FillKernel* supportedFillKernels(size_t* count) {
+    const KernelTable& table = kernelTable();
+    *count = table.count;
+    return table.kernels;
+}
+
+const FillKernel& activeFillKernel() {
+    return *active();
+}
+
+bool selectFillKernel(const char* name) {
+    const KernelTable& table = kernelTable();
+    for (size_t i = 0; i < table.count; i++) {
+        if (strcmp(table.kernels[i].name, name) == 0) {
+            g_active.store(&table.kernels[i], std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void fillSpan(uint32_t* dst, size_t count, uint32_t color) {
+    active()->fillSpan(dst, count, color);
+}
+
+void fillSpan16(uint16_t* dst, size_t count, uint16_t color) {
+    if (count == 0) {
+        return;
+    }
+    if (reinterpret_cast<uintptr_t>(dst) & 2) {
+        *dst++ = color;
+        count--;
+    }
+
+    uint32_t pair = color | (static_cast<uint32_t>(color) << 16);
+    active()->fillSpan(reinterpret_cast<uint32_t*>(dst), count / 2, pair);
+
+    if (count & 1) {
+        dst[count - 1] = color;
+    }
+}
+
+template <class Format>
+void fillRect(const Surface& surface, int x0, int y0, int x1, int y1,
+              typename Format::Pixel color) {
+    // Clip to the surface
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, surface.width);
+    y1 = std::min(y1, surface.height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    size_t spanWidth = static_cast<size_t>(x1 - x0);
+
+    // Full-width rows with no padding are one contiguous block
+    if (x0 == 0 && x1 == surface.width && surface.stride == surface.width) {
+        fillPixels(rowPointer<Format>(surface, y0), spanWidth * (y1 - y0), color);
+        return;
+    }
+
+    for (int y = y0; y < y1; y++) {
+        fillPixels(rowPointer<Format>(surface, y) + x0, spanWidth, color);
+    }
+}
+
+template void fillRect<Rgba8888>(const Surface&, int, int, int, int, uint32_t);
+template void fillRect<Rgbx8888>(const Surface&, int, int, int, int, uint32_t);
+template void fillRect<Rgb565>(const Surface&, int, int, int, int, uint16_t);
+
+void fillRect(const Surface& surface, int x0, int y0, int x1, int y1,
+              uint32_t color) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            fillRect<Rgba8888>(surface, x0, y0, x1, y1, color);
+            break;
+        case PixelFormat::RGBX_8888:
+            fillRect<Rgbx8888>(surface, x0, y0, x1, y1, color);
+            break;
+        case PixelFormat::RGB_565:
+            fillRect<Rgb565>(surface, x0, y0, x1, y1, static_cast<uint16_t>(color));
+            break;
+    }
+}
+
+} // namespace raster
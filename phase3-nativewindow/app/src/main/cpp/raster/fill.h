@@ -0,0 +1,89 @@
+/**
+ * raster/fill.h: Span fill engine
+ *
+ * Clearing a 1440p buffer is 3.7M stores. Writing them one uint32_t at a
+ * time leaves most of the memory bandwidth unused, so every solid fill in
+ * the rasterizer goes through fillSpan(), which writes 16-32 bytes per
+ * store with NEON (ARM) or SSE2/AVX2 (x86).
+ *
+ * DISPATCH:
+ * Several kernels get compiled in; the best one the CPU supports is picked
+ * once at startup (the same idea as Skia's SkOpts). Benchmarks can force a
+ * specific kernel with selectFillKernel().
+ *
+ * Lookup: "SIMD memset", "non-temporal stores", "__builtin_cpu_supports"
+ */
+
+#ifndef PHASE3_RASTER_FILL_H
+#define PHASE3_RASTER_FILL_H
+
+#include "surface.h"
+
+#include <cstddef>
+
+namespace raster {
+
+// Write `count` copies of color starting at dst (no alignment required)
+using FillSpanFn = void (*)(uint32_t* dst, size_t count, uint32_t color);
+
+struct FillKernel {
+    const char* name;  // "scalar", "sse2", "avx2", "neon"
+    FillSpanFn fillSpan;
+};
+
+// All kernels this CPU can run, from slowest to fastest
+// (the last entry is what gets picked by default)
+const FillKernel* supportedFillKernels(size_t* count);
+
+// The kernel currently used by fillSpan()/fillRect()
+const FillKernel& activeFillKernel();
+
+// Force a kernel by name. Returns false if this CPU can't run it.
+bool selectFillKernel(const char* name);
+
+// Fill one span through the active kernel
+void fillSpan(uint32_t* dst, size_t count, uint32_t color);
+
+// Fill one span of 16-bit pixels (RGB_565) through the active kernel
+//
+// Two 565 pixels make one 32-bit word, so after at most one pixel to
+// reach 4-byte alignment the span is handed to the 32-bit kernel with the
+// color doubled up. No separate 16-bit SIMD code needed.
+void fillSpan16(uint16_t* dst, size_t count, uint16_t color);
+
+// Pick the span fill for a pixel size (resolved at compile time)
+inline void fillPixels(uint32_t* dst, size_t count, uint32_t color) {
+    fillSpan(dst, count, color);
+}
+inline void fillPixels(uint16_t* dst, size_t count, uint16_t color) {
+    fillSpan16(dst, count, color);
+}
+
+// Fill the rectangle [x0, x1) x [y0, y1), clipped to the surface
+//
+// Rows are filled one span at a time. When the rectangle covers whole rows
+// and stride == width, the rows are contiguous in memory and the whole
+// thing is a single span.
+//
+// The template is instantiated for Rgba8888, Rgbx8888 and Rgb565 (see
+// raster/pixel_format.h). The plain version takes a packColor() value
+// and picks the instantiation from surface.format.
+template <class Format>
+void fillRect(const Surface& surface, int x0, int y0, int x1, int y1,
+              typename Format::Pixel color);
+void fillRect(const Surface& surface, int x0, int y0, int x1, int y1,
+              uint32_t color);
+
+// ---- Kernels (defined in fill_*.cpp, only call through dispatch) ----
+void fillSpanScalar(uint32_t* dst, size_t count, uint32_t color);
+#if defined(__x86_64__) || defined(__i386__)
+void fillSpanSSE2(uint32_t* dst, size_t count, uint32_t color);
+void fillSpanAVX2(uint32_t* dst, size_t count, uint32_t color);
+#endif
+#if defined(__ARM_NEON)
+void fillSpanNEON(uint32_t* dst, size_t count, uint32_t color);
+#endif
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_FILL_H
@@ -0,0 +1,83 @@
+/**
+ * raster/fill_avx2.cpp: 32-byte span fill for x86
+ *
+ * This file alone is compiled with -mavx2 (see CMakeLists.txt), so the
+ * rest of the library still runs on CPUs without AVX2. It is only called
+ * when __builtin_cpu_supports("avx2") says so.
+ */
+
+#include "fill.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+namespace raster {
+
+static const size_t kStreamingThreshold = 256 * 1024 / sizeof(uint32_t);
+
+void fillSpanAVX2(uint32_t* dst, size_t count, uint32_t color) {
+    const __m256i value = _mm256_set1_epi32(static_cast<int>(color));
+
+    // SHORT SPANS (clipped circle rows, tile pieces): a couple of
+    // overlapping stores instead of loops whose trip counts the branch
+    // predictor can't guess
+    if (count < 8) {
+        if (count >= 4) {
+            const __m128i half = _mm256_castsi256_si128(value);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), half);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + count - 4), half);
+        } else if (count > 0) {
+            dst[0] = color;
+            dst[count / 2] = color;
+            dst[count - 1] = color;
+        }
+        return;
+    }
+
+    // Head: one unaligned store, then continue from the next 32-byte
+    // boundary (overlapping it)
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+    size_t head = 8 - ((reinterpret_cast<uintptr_t>(dst) & 31) >> 2);
+    dst += head;
+    count -= head;
+    uint32_t* end = dst + count;
+
+    const bool streaming = count >= kStreamingThreshold;
+
+    // Body: 4 x 32 bytes = 32 pixels per iteration
+    while (count >= 32) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst);
+        if (streaming) {
+            _mm256_stream_si256(p + 0, value);
+            _mm256_stream_si256(p + 1, value);
+            _mm256_stream_si256(p + 2, value);
+            _mm256_stream_si256(p + 3, value);
+        } else {
+            _mm256_store_si256(p + 0, value);
+            _mm256_store_si256(p + 1, value);
+            _mm256_store_si256(p + 2, value);
+            _mm256_store_si256(p + 3, value);
+        }
+        dst += 32;
+        count -= 32;
+    }
+    while (count >= 8) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dst), value);
+        dst += 8;
+        count -= 8;
+    }
+    if (streaming) {
+        _mm_sfence();
+    }
+
+    // Tail: one unaligned store ending at the span's end (the span is at
+    // least 8 pixels, so it stays inside)
+    if (count > 0) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(end - 8), value);
+    }
+}
+
+} // namespace raster
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * raster/frame_arena.cpp: Per-frame bump allocator
+ */
+
+#include "frame_arena.h"
+
+#include <algorithm>
+
+namespace raster {
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        if (m_current < m_blocks.size()) {
+            Block& block = m_blocks[m_current];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+            size_t start = alignUp(base + m_offset, alignment) - base;
+            if (start + bytes <= block.size) {
+                m_offset = start + bytes;
+                m_used += bytes;
+                m_highWater = std::max(m_highWater, m_used);
+                return block.memory.get() + start;
+            }
+            // Doesn't fit: move on to the next block (the tail is wasted
+            // until reset, which is fine for one frame)
+            m_current++;
+            m_offset = 0;
+            continue;
+        }
+
+        // Out of blocks: this only happens while the arena is warming up
+        size_t size = std::max(m_blockSize, bytes + alignment);
+        m_blocks.push_back(Block{std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+        m_reserved += size;
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+} // namespace raster
@@ -0,0 +1,68 @@
+/**
+ * raster/frame_arena.h: Per-frame bump allocator
+ *
+ * Display list commands live for exactly one frame. Instead of calling
+ * malloc/free for them (which can take a lock and stall the render
+ * thread), they come out of an arena: allocation is a pointer bump, and
+ * reset() at the start of the next frame "frees" everything at once while
+ * keeping the memory for reuse. After the first few frames the arena
+ * never touches the system allocator again.
+ *
+ * Not thread-safe: one arena per producer thread.
+ *
+ * Lookup: "arena allocator", "linear allocator", "frame allocator"
+ */
+
+#ifndef PHASE3_RASTER_FRAME_ARENA_H
+#define PHASE3_RASTER_FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raster {
+
+class FrameArena {
+public:
+    static const size_t kDefaultBlockSize = 64 * 1024;
+
+    explicit FrameArena(size_t blockSize = kDefaultBlockSize)
+        : m_blockSize(blockSize) {}
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // `bytes` of uninitialized memory, valid until the next reset()
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Forget every allocation; the blocks stay for the next frame
+    void reset();
+
+    size_t bytesUsed() const { return m_used; }          // Since last reset()
+    size_t bytesReserved() const { return m_reserved; }  // Owned blocks
+    size_t highWater() const { return m_highWater; }     // Most ever used in a frame
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size;
+    };
+
+    size_t m_blockSize;
+    std::vector<Block> m_blocks;
+    size_t m_current = 0;  // Block we're bumping in
+    size_t m_offset = 0;   // Bump pointer within it
+    size_t m_used = 0;
+    size_t m_reserved = 0;
+    size_t m_highWater = 0;
+};
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_FRAME_ARENA_H
@@ -0,0 +1,114 @@
+/**
+ * raster/pack565.cpp: 565 pack dispatch and the scalar kernels
+ */
+
+#include "pack565.h"
+#include "pixel_format.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace raster {
+
+const uint8_t kBayer4x4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+static inline uint8_t addSaturate(uint8_t value, uint8_t offset) {
+    unsigned sum = static_cast<unsigned>(value) + offset;
+    return static_cast<uint8_t>(sum > 255 ? 255 : sum);
+}
+
+void pack565Scalar(uint16_t* dst, const uint32_t* src, size_t count, int /*x*/, int /*y*/) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t p = src[i];
+        dst[i] = Rgb565::pack(p & 0xFF, (p >> 8) & 0xFF, (p >> 16) & 0xFF, 0xFF);
+    }
+}
+
+void pack565DitherScalar(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    const uint8_t* row = kBayer4x4[y & 3];
+    for (size_t i = 0; i < count; i++) {
+        uint32_t p = src[i];
+        uint8_t threshold = row[(x + i) & 3];
+        uint8_t r = addSaturate(p & 0xFF, threshold >> 1);
+        uint8_t g = addSaturate((p >> 8) & 0xFF, threshold >> 2);
+        uint8_t b = addSaturate((p >> 16) & 0xFF, threshold >> 1);
+        dst[i] = Rgb565::pack(r, g, b, 0xFF);
+    }
+}
+
+namespace {
+
+struct KernelTable {
+    Pack565Kernel kernels[3];
+    size_t count = 0;
+
+    KernelTable() {
+        kernels[count++] = {"scalar", pack565Scalar, pack565DitherScalar};
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels[count++] = {"sse2", pack565SSE2, pack565DitherSSE2};
+        }
+#endif
+
+#if defined(__ARM_NEON)
+        kernels[count++] = {"neon", pack565NEON, pack565DitherNEON};
+#endif
+    }
+};
+
+const KernelTable& kernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+std::atomic<const Pack565Kernel*> g_active{nullptr};
+
+const Pack565Kernel* active() {
+    const Pack565Kernel* kernel = g_active.load(std::memory_order_acquire);
+    if (!kernel) {
+        const KernelTable& table = kernelTable();
+        kernel = &table.kernels[table.count - 1];
+        g_active.store(kernel, std::memory_order_release);
+    }
+    return kernel;
+}
+
+} // namespace
+
+const Pack565Kernel* supportedPack565Kernels(size_t* count) {
+    const KernelTable& table = kernelTable();
+    *count = table.count;
+    return table.kernels;
+}
+
+const Pack565Kernel& activePack565Kernel() {
+    return *active();
+}
+
+bool selectPack565Kernel(const char* name) {
+    const KernelTable& table = kernelTable();
+    for (size_t i = 0; i < table.count; i++) {
+        if (strcmp(table.kernels[i].name, name) == 0) {
+            g_active.store(&table.kernels[i], std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void pack565(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    active()->pack(dst, src, count, x, y);
+}
+
+void pack565Dither(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    active()->packDither(dst, src, count, x, y);
+}
+
+} // namespace raster
@@ -0,0 +1,70 @@
+/**
+ * raster/pack565.h: RGBA_8888 -> RGB_565 row conversion, with ordered dither
+ *
+ * An RGB_565 buffer is half the bytes of RGBA_8888, which matters on
+ * phones where memory bandwidth, not ALU, limits the frame rate. But 5-6
+ * bits per channel turn smooth gradients into visible bands.
+ *
+ * ORDERED DITHER: before truncating, add a per-pixel offset from a 4x4
+ * Bayer matrix (scaled to the channel's step: 0-7 for the 5-bit channels,
+ * 0-3 for green). Neighbouring pixels round different ways, so a 4x4 block
+ * averages out to the original 8-bit color and the eye sees a gradient
+ * instead of bands. The pattern is anchored to screen coordinates, which
+ * is why every kernel takes the (x, y) of the row's first pixel: tiles and
+ * partial repaints line up without seams.
+ *
+ * DISPATCH works like raster/fill.h: scalar, SSE2 (x86) and NEON (ARM)
+ * kernels, the best one picked once at startup.
+ *
+ * Lookup: "ordered dithering", "Bayer matrix", "RGB565 banding"
+ */
+
+#ifndef PHASE3_RASTER_PACK565_H
+#define PHASE3_RASTER_PACK565_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace raster {
+
+// 4x4 Bayer threshold matrix, values 0-15, indexed [y & 3][x & 3]
+extern const uint8_t kBayer4x4[4][4];
+
+// Convert `count` RGBA_8888 pixels to RGB_565 (alpha is dropped).
+// (x, y) is where src[0] lands on screen (only used for the dither).
+using Pack565Fn = void (*)(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+
+struct Pack565Kernel {
+    const char* name;       // "scalar", "sse2", "neon"
+    Pack565Fn pack;         // Truncate, same as Rgb565::pack()
+    Pack565Fn packDither;   // Bayer offset first, then truncate
+};
+
+// All kernels this CPU can run, from slowest to fastest
+const Pack565Kernel* supportedPack565Kernels(size_t* count);
+
+// The kernel currently used by pack565()/pack565Dither()
+const Pack565Kernel& activePack565Kernel();
+
+// Force a kernel by name. Returns false if this CPU can't run it.
+bool selectPack565Kernel(const char* name);
+
+// Convert one row through the active kernel
+void pack565(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+void pack565Dither(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+
+// ---- Kernels (defined in pack565*.cpp, only call through dispatch) ----
+void pack565Scalar(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+void pack565DitherScalar(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+#if defined(__x86_64__) || defined(__i386__)
+void pack565SSE2(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+void pack565DitherSSE2(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+#endif
+#if defined(__ARM_NEON)
+void pack565NEON(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+void pack565DitherNEON(uint16_t* dst, const uint32_t* src, size_t count, int x, int y);
+#endif
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_PACK565_H
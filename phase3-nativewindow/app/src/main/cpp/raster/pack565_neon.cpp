@@ -0,0 +1,67 @@
+/**
+ * raster/pack565_neon.cpp: 16 pixels per iteration RGB_565 packing for ARM
+ *
+ * vld4q_u8 loads 16 RGBA pixels and splits them into one register per
+ * channel. Each channel is then widened to the top byte of a 16-bit lane
+ * and vsri ("shift right and insert") drops G and B in below R, keeping
+ * only the top 5/6/5 bits.
+ */
+
+#include "pack565.h"
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+namespace raster {
+
+static inline uint16x8_t to565(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+    uint16x8_t value = vshll_n_u8(r, 8);
+    value = vsriq_n_u16(value, vshll_n_u8(g, 8), 5);
+    value = vsriq_n_u16(value, vshll_n_u8(b, 8), 11);
+    return value;
+}
+
+// Shared body: per-lane offsets are added (saturating) before packing
+static inline void packRows(uint16_t* dst, const uint32_t* src, size_t count,
+                            uint8x16_t redBlueOffsets, uint8x16_t greenOffsets) {
+    while (count >= 16) {
+        uint8x16x4_t rgba = vld4q_u8(reinterpret_cast<const uint8_t*>(src));
+        uint8x16_t r = vqaddq_u8(rgba.val[0], redBlueOffsets);
+        uint8x16_t g = vqaddq_u8(rgba.val[1], greenOffsets);
+        uint8x16_t b = vqaddq_u8(rgba.val[2], redBlueOffsets);
+
+        vst1q_u16(dst, to565(vget_low_u8(r), vget_low_u8(g), vget_low_u8(b)));
+        vst1q_u16(dst + 8, to565(vget_high_u8(r), vget_high_u8(g), vget_high_u8(b)));
+        src += 16;
+        dst += 16;
+        count -= 16;
+    }
+}
+
+void pack565NEON(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    size_t body = count & ~static_cast<size_t>(15);
+    packRows(dst, src, body, vdupq_n_u8(0), vdupq_n_u8(0));
+    pack565Scalar(dst + body, src + body, count - body, x, y);
+}
+
+void pack565DitherNEON(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    // After vld4 each lane is one pixel, so the 4-pixel Bayer row repeats
+    // four times across a register
+    const uint8_t* row = kBayer4x4[y & 3];
+    uint8_t redBlue[16];
+    uint8_t green[16];
+    for (int i = 0; i < 16; i++) {
+        uint8_t threshold = row[(x + i) & 3];
+        redBlue[i] = threshold >> 1;
+        green[i] = threshold >> 2;
+    }
+
+    size_t body = count & ~static_cast<size_t>(15);
+    packRows(dst, src, body, vld1q_u8(redBlue), vld1q_u8(green));
+    pack565DitherScalar(dst + body, src + body, count - body, x + static_cast<int>(body), y);
+}
+
+} // namespace raster
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * raster/pack565_sse2.cpp: 8 pixels per iteration RGB_565 packing for x86
+ *
+ * SSE2 has no unsigned 32 -> 16 bit pack (packus_epi32 is SSE4.1), so the
+ * 565 value is sign-extended first and narrowed with the signed
+ * _mm_packs_epi32, which then can't saturate.
+ */
+
+#include "pack565.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+
+namespace raster {
+
+// Four RGBA pixels -> four 565 values in the low half of each 32-bit lane
+// (sign-extended, ready for _mm_packs_epi32)
+static inline __m128i to565(__m128i pixels) {
+    const __m128i redMask = _mm_set1_epi32(0x000000F8);
+    const __m128i greenMask = _mm_set1_epi32(0x0000FC00);
+    const __m128i blueMask = _mm_set1_epi32(0x00F80000);
+
+    __m128i r = _mm_slli_epi32(_mm_and_si128(pixels, redMask), 8);     // bits 15-11
+    __m128i g = _mm_srli_epi32(_mm_and_si128(pixels, greenMask), 5);   // bits 10-5
+    __m128i b = _mm_srli_epi32(_mm_and_si128(pixels, blueMask), 19);   // bits 4-0
+    __m128i value = _mm_or_si128(r, _mm_or_si128(g, b));
+    return _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+}
+
+// Shared body: `offsets` is added (saturating, per byte) before packing
+static inline void packRows(uint16_t* dst, const uint32_t* src, size_t count,
+                            __m128i offsets) {
+    while (count >= 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+        a = _mm_adds_epu8(a, offsets);
+        b = _mm_adds_epu8(b, offsets);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                         _mm_packs_epi32(to565(a), to565(b)));
+        src += 8;
+        dst += 8;
+        count -= 8;
+    }
+}
+
+void pack565SSE2(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    size_t body = count & ~static_cast<size_t>(7);
+    packRows(dst, src, body, _mm_setzero_si128());
+    pack565Scalar(dst + body, src + body, count - body, x, y);
+}
+
+void pack565DitherSSE2(uint16_t* dst, const uint32_t* src, size_t count, int x, int y) {
+    // The Bayer row repeats every 4 pixels, which is exactly one register
+    // of RGBA pixels, so one offset vector serves the whole row
+    const uint8_t* row = kBayer4x4[y & 3];
+    alignas(16) uint8_t offsets[16];
+    for (int i = 0; i < 4; i++) {
+        uint8_t threshold = row[(x + i) & 3];
+        offsets[i * 4 + 0] = threshold >> 1;  // R: 5 bits, step 8
+        offsets[i * 4 + 1] = threshold >> 2;  // G: 6 bits, step 4
+        offsets[i * 4 + 2] = threshold >> 1;  // B: 5 bits, step 8
+        offsets[i * 4 + 3] = 0;
+    }
+
+    size_t body = count & ~static_cast<size_t>(7);
+    packRows(dst, src, body, _mm_load_si128(reinterpret_cast<const __m128i*>(offsets)));
+    pack565DitherScalar(dst + body, src + body, count - body, x + static_cast<int>(body), y);
+}
+
+} // namespace raster
+
+#endif
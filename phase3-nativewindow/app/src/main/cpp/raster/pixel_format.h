@@ -0,0 +1,92 @@
+/**
+ * raster/pixel_format.h: Compile-time descriptions of the buffer formats
+ *
+ * ANativeWindow_lock can hand us RGBA_8888, RGBX_8888 or RGB_565 buffers.
+ * Checking the format inside a pixel loop costs a branch per pixel (or per
+ * span), so instead every raster kernel is a template over one of these
+ * traits types. Each instantiation knows its pixel size and color packing
+ * at compile time, and the only runtime decision left is picking the
+ * instantiation, once per locked buffer (see raster/pixel_kernels.h).
+ *
+ * A traits type provides:
+ *   Pixel               uint32_t or uint16_t, one pixel in memory
+ *   kFormat             the matching PixelFormat (WINDOW_FORMAT_*) value
+ *   pack(r, g, b, a)    constexpr, 8-bit channels to a Pixel
+ *
+ * Lookup: "traits class", "AHARDWAREBUFFER_FORMAT_R5G6B5_UNORM"
+ */
+
+#ifndef PHASE3_RASTER_PIXEL_FORMAT_H
+#define PHASE3_RASTER_PIXEL_FORMAT_H
+
+#include <cstdint>
+
+namespace raster {
+
+// Pixel formats we know how to write.
+// The values match WINDOW_FORMAT_* from android/native_window.h so the
+// JNI layer can convert with a static_cast (checked by static_assert there).
+enum class PixelFormat : int32_t {
+    RGBA_8888 = 1,
+    RGBX_8888 = 2,
+    RGB_565 = 4,
+};
+
+// [R][G][B][A] in memory: 0xAABBGGRR as a little-endian uint32_t
+struct Rgba8888 {
+    using Pixel = uint32_t;
+    static constexpr PixelFormat kFormat = PixelFormat::RGBA_8888;
+
+    static constexpr Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        return (Pixel(r) << 0) | (Pixel(g) << 8) | (Pixel(b) << 16) | (Pixel(a) << 24);
+    }
+};
+
+// Same bytes as RGBA_8888, but the compositor ignores the 4th byte.
+// We still write 0xFF there so the buffer reads back as opaque.
+struct Rgbx8888 {
+    using Pixel = uint32_t;
+    static constexpr PixelFormat kFormat = PixelFormat::RGBX_8888;
+
+    static constexpr Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t /*a*/) {
+        return Rgba8888::pack(r, g, b, 0xFF);
+    }
+};
+
+// 16 bits: RRRRRGGG GGGBBBBB (red in the high bits), no alpha.
+// Channels are truncated to their top bits (no rounding, no dithering).
+struct Rgb565 {
+    using Pixel = uint16_t;
+    static constexpr PixelFormat kFormat = PixelFormat::RGB_565;
+
+    static constexpr Pixel pack(uint8_t r, uint8_t g, uint8_t b, uint8_t /*a*/) {
+        return static_cast<Pixel>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+    }
+};
+
+// Android color int (0xAARRGGBB, like Color.argb()) to a Format's Pixel
+template <class Format>
+constexpr typename Format::Pixel packArgb(uint32_t argb) {
+    return Format::pack((argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, argb >> 24);
+}
+
+static_assert(packArgb<Rgba8888>(0xFF6496FF) == 0xFFFF9664, "RGBA byte order");
+static_assert(packArgb<Rgbx8888>(0x006496FF) == 0xFFFF9664, "RGBX writes opaque X");
+static_assert(packArgb<Rgb565>(0xFFFFFFFF) == 0xFFFF, "565 white");
+static_assert(packArgb<Rgb565>(0xFFFF0000) == 0xF800, "565 red in the high bits");
+
+// Bytes per pixel of a runtime format (0 if unknown)
+inline int bytesPerPixel(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA_8888:
+        case PixelFormat::RGBX_8888:
+            return 4;
+        case PixelFormat::RGB_565:
+            return 2;
+    }
+    return 0;
+}
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_PIXEL_FORMAT_H
@@ -0,0 +1,79 @@
+/**
+ * raster/pixel_kernels.cpp: One table of raster kernels per pixel format
+ */
+
+#include "pixel_kernels.h"
+#include "fill.h"
+#include "raster.h"
+
+#include <cstddef>
+
+namespace raster {
+
+namespace {
+
+// Adapters from the table's signatures (Android color ints) to the
+// format templates (packed pixels)
+template <class Format>
+struct KernelsFor {
+    static void fillRect(const Surface& surface, const Rect& rect, uint32_t argb) {
+        raster::fillRect<Format>(surface, rect.left, rect.top, rect.right, rect.bottom,
+                                 packArgb<Format>(argb));
+    }
+
+    static void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                           uint32_t argb, const Rect& clip) {
+        raster::fillCircle<Format>(surface, cx, cy, radius, packArgb<Format>(argb), clip);
+    }
+
+    static void fillCircleAA(const Surface& surface, float cx, float cy, float radius,
+                             uint32_t argb, const Rect& clip) {
+        raster::fillCircleAA<Format>(surface, cx, cy, radius, packArgb<Format>(argb), clip);
+    }
+
+    static void blit(const Surface& surface, const void* pixels, int width, int height,
+                     int stride, int x, int y, const Rect& clip) {
+        blitPixels<Format>(surface, pixels, width, height, stride, x, y, clip);
+    }
+
+    static void line(const Surface& surface, float x0, float y0, float x1, float y1,
+                     uint32_t argb, const Rect& clip) {
+        drawLine<Format>(surface, x0, y0, x1, y1, packArgb<Format>(argb), clip);
+    }
+
+    static void blendBitmap(const Surface& surface, const uint32_t* pixels, int width,
+                            int height, int stride, int x, int y, BlendMode mode,
+                            uint32_t alpha, const Rect& clip) {
+        raster::blendBitmap<Format>(surface, pixels, width, height, stride, x, y, mode, alpha,
+                                    clip);
+    }
+
+    static constexpr PixelKernels table(const char* name) {
+        return {Format::kFormat, name, sizeof(typename Format::Pixel),
+                fillRect, fillCircle, fillCircleAA, blit, line, blendBitmap};
+    }
+};
+
+const PixelKernels g_kernels[] = {
+    KernelsFor<Rgba8888>::table("RGBA_8888"),
+    KernelsFor<Rgbx8888>::table("RGBX_8888"),
+    KernelsFor<Rgb565>::table("RGB_565"),
+};
+
+} // namespace
+
+const PixelKernels* pixelKernels(PixelFormat format) {
+    for (const PixelKernels& kernels : g_kernels) {
+        if (kernels.format == format) {
+            return &kernels;
+        }
+    }
+    return nullptr;
+}
+
+const PixelKernels* allPixelKernels(size_t* count) {
+    *count = sizeof(g_kernels) / sizeof(g_kernels[0]);
+    return g_kernels;
+}
+
+} // namespace raster
@@ -0,0 +1,68 @@
+/**
+ * raster/pixel_kernels.h: One table of raster kernels per pixel format
+ *
+ * The display-list replay calls a handful of kernels thousands of times
+ * per frame. Rather than switching on surface.format in each of those
+ * calls, the replay looks up the format's table ONCE when it gets the
+ * locked buffer and calls straight through its function pointers. Every
+ * entry is an instantiation of the templates in raster/raster.h and
+ * raster/fill.h for one traits type, so the loops inside are already
+ * specialized and colors are packed with the constexpr Format::pack().
+ *
+ * Colors passed to these kernels are Android color ints (0xAARRGGBB),
+ * the same as in the display list.
+ *
+ * Lookup: "function pointer table", "explicit template instantiation"
+ */
+
+#ifndef PHASE3_RASTER_PIXEL_KERNELS_H
+#define PHASE3_RASTER_PIXEL_KERNELS_H
+
+#include "blend.h"
+#include "rect.h"
+#include "surface.h"
+
+#include <cstddef>
+
+namespace raster {
+
+struct PixelKernels {
+    PixelFormat format;
+    const char* name;  // "RGBA_8888", "RGBX_8888", "RGB_565"
+    int bytesPerPixel;
+
+    // [rect.left, rect.right) x [rect.top, rect.bottom), clipped to the surface
+    void (*fillRect)(const Surface& surface, const Rect& rect, uint32_t argb);
+
+    // Solid circle, only inside `clip` (see fillCircle() in raster.h)
+    void (*fillCircle)(const Surface& surface, float cx, float cy, float radius,
+                       uint32_t argb, const Rect& clip);
+
+    // Same with an anti-aliased edge (see fillCircleAA() in raster.h)
+    void (*fillCircleAA)(const Surface& surface, float cx, float cy, float radius,
+                         uint32_t argb, const Rect& clip);
+
+    // Opaque pixels already in this format (stride in pixels)
+    void (*blit)(const Surface& surface, const void* pixels, int width, int height,
+                 int stride, int x, int y, const Rect& clip);
+
+    // 1 px Bresenham line, only inside `clip`
+    void (*line)(const Surface& surface, float x0, float y0, float x1, float y1,
+                 uint32_t argb, const Rect& clip);
+
+    // Premultiplied RGBA_8888 bitmap composited with `mode` (see
+    // blendBitmap() in raster.h)
+    void (*blendBitmap)(const Surface& surface, const uint32_t* pixels, int width, int height,
+                        int stride, int x, int y, BlendMode mode, uint32_t alpha,
+                        const Rect& clip);
+};
+
+// The kernels for `format`, or nullptr if we can't draw into it
+const PixelKernels* pixelKernels(PixelFormat format);
+
+// Every supported format's table (for tests and benchmarks)
+const PixelKernels* allPixelKernels(size_t* count);
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_PIXEL_KERNELS_H
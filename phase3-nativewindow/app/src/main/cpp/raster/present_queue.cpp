@@ -0,0 +1,227 @@
+/**
+ * raster/present_queue.cpp: Back buffers between a raster thread and a present thread
+ */
+
+#include "present_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace raster {
+
+// Rows start on cache line boundaries (and SIMD loads/stores never split one)
+static const size_t kRowAlignment = 64;
+
+static int64_t steadyNanos() {
+    using Clock = std::chrono::steady_clock;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now().time_since_epoch()).count();
+}
+
+PresentQueue::PresentQueue(int bufferCount)
+    : m_count(std::min(std::max(bufferCount, 2), kMaxBuffers)) {}
+
+PresentQueue::~PresentQueue() {
+    for (BackBuffer& buffer : m_buffers) {
+        freeMemory(buffer);
+    }
+}
+
+void PresentQueue::freeMemory(BackBuffer& buffer) {
+    free(buffer.m_memory);
+    buffer.m_memory = nullptr;
+    buffer.surface = Surface();
+}
+
+BackBuffer* PresentQueue::acquireForRaster(int width, int height, PixelFormat format) {
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    auto findFree = [this]() -> BackBuffer* {
+        // Prefer the buffer drawn most recently: the smaller its age, the
+        // less a DamageTracker has to repaint in it
+        BackBuffer* best = nullptr;
+        for (int i = 0; i < m_count; i++) {
+            BackBuffer& buffer = m_buffers[i];
+            if (buffer.m_state == BackBuffer::State::Free &&
+                (!best || buffer.m_lastDrawn > best->m_lastDrawn)) {
+                best = &buffer;
+            }
+        }
+        return best;
+    };
+
+    BackBuffer* buffer = findFree();
+    if (!buffer && !m_stopped) {
+        int64_t start = steadyNanos();
+        m_freed.wait(lock, [&] { return m_stopped || (buffer = findFree()) != nullptr; });
+        int64_t waited = steadyNanos() - start;
+        m_stats.rasterWaits++;
+        m_stats.rasterWaitNanos += waited;
+        m_stats.rasterWaitMaxNanos = std::max(m_stats.rasterWaitMaxNanos, waited);
+    }
+    if (m_stopped || !buffer) {
+        return nullptr;
+    }
+    buffer->m_state = BackBuffer::State::Rasterizing;
+    m_rasterFrame++;
+    lock.unlock();
+
+    // (Re)allocate outside the lock; nobody else touches a Rasterizing buffer
+    Surface& surface = buffer->surface;
+    if (surface.width != width || surface.height != height || surface.format != format ||
+        !buffer->m_memory) {
+        freeMemory(*buffer);
+        int bytesPerPixelValue = bytesPerPixel(format);
+        size_t rowBytes = (static_cast<size_t>(width) * bytesPerPixelValue + kRowAlignment - 1) &
+                          ~(kRowAlignment - 1);
+        size_t bytes = rowBytes * static_cast<size_t>(height);
+        void* memory = nullptr;
+        if (bytes == 0 || posix_memalign(&memory, kRowAlignment, bytes) != 0) {
+            memory = nullptr;
+        }
+        buffer->m_memory = memory;
+        buffer->m_lastDrawn = 0;
+        if (memory) {
+            surface.bits = memory;
+            surface.width = width;
+            surface.height = height;
+            surface.stride = static_cast<int32_t>(rowBytes / bytesPerPixelValue);
+            surface.format = format;
+        }
+    }
+
+    uint64_t frame = m_rasterFrame;
+    buffer->age = buffer->m_lastDrawn == 0 ? 0 : static_cast<int>(std::min<uint64_t>(
+                                                      frame - buffer->m_lastDrawn, 1000));
+    buffer->frame = frame;
+    if (!buffer->m_memory) {
+        // Out of memory: hand it back and let the caller skip the frame
+        std::lock_guard<std::mutex> guard(m_lock);
+        buffer->m_state = BackBuffer::State::Free;
+        return nullptr;
+    }
+    return buffer;
+}
+
+void PresentQueue::submit(BackBuffer* buffer, const Rect& damage) {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        buffer->m_state = BackBuffer::State::Ready;
+        buffer->m_damage = damage;
+        buffer->m_lastDrawn = buffer->frame;
+        buffer->submitNanos = steadyNanos();
+        m_stats.submitted++;
+    }
+    m_ready.notify_one();
+}
+
+BackBuffer* PresentQueue::acquireForPresent(Rect* damage) {
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    auto findNewest = [this]() -> BackBuffer* {
+        BackBuffer* newest = nullptr;
+        for (int i = 0; i < m_count; i++) {
+            BackBuffer& buffer = m_buffers[i];
+            if (buffer.m_state == BackBuffer::State::Ready &&
+                (!newest || buffer.frame > newest->frame)) {
+                newest = &buffer;
+            }
+        }
+        return newest;
+    };
+
+    BackBuffer* newest = findNewest();
+    if (!newest && !m_stopped) {
+        int64_t start = steadyNanos();
+        m_ready.wait(lock, [&] { return m_stopped || (newest = findNewest()) != nullptr; });
+        int64_t waited = steadyNanos() - start;
+        m_stats.presentWaits++;
+        m_stats.presentWaitNanos += waited;
+        m_stats.presentWaitMaxNanos = std::max(m_stats.presentWaitMaxNanos, waited);
+    }
+    if (m_stopped || !newest) {
+        return nullptr;
+    }
+
+    // Older Ready frames will never be shown: free them, keep their damage
+    Rect merged = newest->m_damage;
+    bool freedAny = false;
+    for (int i = 0; i < m_count; i++) {
+        BackBuffer& buffer = m_buffers[i];
+        if (&buffer != newest && buffer.m_state == BackBuffer::State::Ready) {
+            merged = uniteRects(merged, buffer.m_damage);
+            buffer.m_state = BackBuffer::State::Free;
+            m_stats.skipped++;
+            freedAny = true;
+        }
+    }
+    newest->m_state = BackBuffer::State::Presenting;
+    m_stats.presented++;
+    *damage = merged;
+    lock.unlock();
+
+    if (freedAny) {
+        m_freed.notify_one();
+    }
+    return newest;
+}
+
+void PresentQueue::releasePresented(BackBuffer* buffer) {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        buffer->m_state = BackBuffer::State::Free;
+    }
+    m_freed.notify_one();
+}
+
+void PresentQueue::stop() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopped = true;
+    }
+    m_freed.notify_all();
+    m_ready.notify_all();
+}
+
+void PresentQueue::restart() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stopped = false;
+    for (int i = 0; i < m_count; i++) {
+        m_buffers[i].m_state = BackBuffer::State::Free;
+    }
+}
+
+PresentStats PresentQueue::stats() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_stats;
+}
+
+bool copyPixels(const Surface& dst, const Surface& src, const Rect& rect) {
+    if (dst.format != src.format) {
+        return false;
+    }
+    Rect clipped = intersectRects(rect, makeRect(0, 0, std::min(dst.width, src.width),
+                                                 std::min(dst.height, src.height)));
+    if (clipped.isEmpty()) {
+        return true;
+    }
+
+    const size_t pixelBytes = static_cast<size_t>(bytesPerPixel(src.format));
+    const size_t rowBytes = static_cast<size_t>(clipped.right - clipped.left) * pixelBytes;
+    const size_t dstStride = static_cast<size_t>(dst.stride) * pixelBytes;
+    const size_t srcStride = static_cast<size_t>(src.stride) * pixelBytes;
+    uint8_t* to = static_cast<uint8_t*>(dst.bits) + clipped.top * dstStride +
+                  clipped.left * pixelBytes;
+    const uint8_t* from = static_cast<const uint8_t*>(src.bits) + clipped.top * srcStride +
+                          clipped.left * pixelBytes;
+    for (int y = clipped.top; y < clipped.bottom; y++) {
+        memcpy(to, from, rowBytes);
+        to += dstStride;
+        from += srcStride;
+    }
+    return true;
+}
+
+} // namespace raster
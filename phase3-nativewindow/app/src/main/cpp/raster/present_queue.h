@@ -0,0 +1,148 @@
+/**
+ * raster/present_queue.h: Back buffers between a raster thread and a present thread
+ *
+ * ANativeWindow_lock() blocks when the BufferQueue has no free buffer
+ * (the compositor still holds them all), and unlockAndPost() can block
+ * too. Called from drawFrame(), either stall stops the whole renderer:
+ * no recording, no rasterizing, just waiting on SurfaceFlinger.
+ *
+ * With a PresentQueue the raster thread never touches the window. It
+ * draws into one of 2-3 back buffers of its own (64-byte aligned heap
+ * memory, in the window's pixel format) and submits it. A PRESENT thread
+ * takes the newest submitted frame, locks the window, copies the changed
+ * rows in and posts it. Lock and post can block the present thread as
+ * long as they like; the raster thread only waits when every back buffer
+ * is still waiting to be presented (or being presented).
+ *
+ *     raster:   acquireForRaster() -> draw -> submit(damage)
+ *     present:  acquireForPresent(&damage) -> lock/copy/post -> releasePresented()
+ *
+ * BUFFER STATES: Free -> Rasterizing -> Ready -> Presenting -> Free.
+ * When the present thread falls behind and several frames are Ready, it
+ * takes the newest and frees the others (counted as skipped). Their
+ * damage rects are merged into the newest one's, so the window still
+ * gets every pixel that changed since the last frame it showed.
+ *
+ * BUFFER AGE: back buffers aren't copied back like window buffers, so a
+ * buffer's contents are whatever was drawn into it last time.
+ * BackBuffer::age says how many raster frames ago that was (0 = never,
+ * or reallocated), which is exactly what a DamageTracker needs.
+ *
+ * WAIT METRICS: time the raster thread spent waiting for a free buffer
+ * and time the present thread spent waiting for a frame (count, total,
+ * max), so it's visible which side is the bottleneck.
+ *
+ * Lookup: "BufferQueue dequeueBuffer blocking", "mailbox present mode",
+ *         "triple buffering"
+ */
+
+#ifndef PHASE3_RASTER_PRESENT_QUEUE_H
+#define PHASE3_RASTER_PRESENT_QUEUE_H
+
+#include "rect.h"
+#include "surface.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace raster {
+
+struct BackBuffer {
+    Surface surface;        // Rows start on 64-byte boundaries
+    int age = 0;            // Raster frames since last drawn into (0 = unknown contents)
+    uint64_t frame = 0;     // Raster frame number of the contents
+    int64_t submitNanos = 0;  // When submit() handed it over (steady clock)
+
+private:
+    friend class PresentQueue;
+
+    enum class State { Free, Rasterizing, Ready, Presenting };
+
+    void* m_memory = nullptr;
+    State m_state = State::Free;
+    Rect m_damage;              // Changed since the previous submitted frame
+    uint64_t m_lastDrawn = 0;   // Raster frame number, 0 = never
+};
+
+struct PresentStats {
+    int64_t submitted = 0;          // Frames rasterized
+    int64_t presented = 0;          // Frames handed to the present thread
+    int64_t skipped = 0;            // Ready, but a newer one was presented instead
+    int64_t rasterWaits = 0;        // acquireForRaster() calls that had to wait
+    int64_t rasterWaitNanos = 0;
+    int64_t rasterWaitMaxNanos = 0;
+    int64_t presentWaits = 0;       // acquireForPresent() calls that had to wait
+    int64_t presentWaitNanos = 0;
+    int64_t presentWaitMaxNanos = 0;
+};
+
+class PresentQueue {
+public:
+    static const int kMaxBuffers = 3;
+
+    // bufferCount is clamped to 2..kMaxBuffers
+    explicit PresentQueue(int bufferCount = kMaxBuffers);
+    ~PresentQueue();
+
+    PresentQueue(const PresentQueue&) = delete;
+    PresentQueue& operator=(const PresentQueue&) = delete;
+
+    int bufferCount() const { return m_count; }
+
+    // ---- Raster thread ----
+
+    // A free back buffer of this size and format, waiting for one if every
+    // buffer is Ready or Presenting. (Re)allocated if the size or format
+    // changed, which resets its age. nullptr once stop() was called.
+    BackBuffer* acquireForRaster(int width, int height, PixelFormat format);
+
+    // The buffer is complete. `damage` covers every pixel that differs
+    // from the previously submitted frame.
+    void submit(BackBuffer* buffer, const Rect& damage);
+
+    // ---- Present thread ----
+
+    // The newest Ready frame, waiting for one if there is none. `damage`
+    // gets everything that changed since the last presented frame.
+    // nullptr once stop() was called.
+    BackBuffer* acquireForPresent(Rect* damage);
+
+    // Done copying out of it
+    void releasePresented(BackBuffer* buffer);
+
+    // ---- Either thread ----
+
+    // Wake both sides and make the acquires return nullptr until restart()
+    void stop();
+
+    // Accept frames again. Frames still Ready are dropped (their thread
+    // is gone); buffer contents and ages are kept.
+    void restart();
+
+    PresentStats stats() const;
+
+private:
+    static void freeMemory(BackBuffer& buffer);
+
+    BackBuffer m_buffers[kMaxBuffers];
+    int m_count;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_freed;   // A buffer became Free
+    std::condition_variable m_ready;   // A buffer became Ready
+    bool m_stopped = false;
+    uint64_t m_rasterFrame = 0;        // Frames handed out to the raster thread
+    PresentStats m_stats;
+};
+
+// Copy `rect` (clipped to both surfaces) from src to dst, row by row.
+// The formats must match: back buffers are allocated in the window's
+// format, so presenting is a plain copy, no per-pixel conversion.
+// Returns false (and copies nothing) if they don't.
+bool copyPixels(const Surface& dst, const Surface& src, const Rect& rect);
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_PRESENT_QUEUE_H
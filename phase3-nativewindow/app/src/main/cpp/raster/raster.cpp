@@ -0,0 +1,415 @@
+/**
+ * raster/raster.cpp: Software rasterizer primitives
+ *
+ * No Android headers in here! Everything goes through raster::Surface so
+ * the same code can be benchmarked on a desktop machine.
+ */
+
+#include "raster.h"
+#include "coverage.h"
+#include "fill.h"
+#include "pack565.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace raster {
+
+void clearSurface(const Surface& surface, uint32_t color) {
+    // One rectangle covering everything; fillRect() turns it into a single
+    // span when stride == width, or one wide-store span per row otherwise
+    fillRect(surface, 0, 0, surface.width, surface.height, color);
+}
+
+bool circleBounds(const Surface& surface, float cx, float cy, float radius,
+                  CircleBounds* bounds) {
+    bounds->minY = std::max(0, static_cast<int>(cy - radius));
+    bounds->maxY = std::min(surface.height - 1, static_cast<int>(cy + radius));
+    bounds->minX = std::max(0, static_cast<int>(cx - radius));
+    bounds->maxX = std::min(surface.width - 1, static_cast<int>(cx + radius));
+    return bounds->minX <= bounds->maxX && bounds->minY <= bounds->maxY;
+}
+
+// The exact per-pixel test, written the same way as the reference loop so
+// the float rounding matches bit for bit
+static inline bool insideCircle(int x, float cx, float dySq, float radiusSq) {
+    float dx = x - cx;
+    return dx * dx + dySq <= radiusSq;
+}
+
+bool circleSpan(float cx, float cy, float radius, int y, int minX, int maxX,
+                int* x0, int* x1) {
+    float dy = y - cy;
+    float dySq = dy * dy;
+    float radiusSq = radius * radius;
+
+    float remaining = radiusSq - dySq;
+    if (remaining < 0.0f) {
+        return false;
+    }
+
+    // Solve (x - cx)^2 = radius^2 - dy^2 for the two edges of this row
+    float halfWidth = sqrtf(remaining);
+    int left = std::max(minX, ceilToInt(cx - halfWidth));
+    int right = std::min(maxX, floorToInt(cx + halfWidth));
+
+    // sqrtf/ceilf can land one pixel off the per-pixel answer; fix up the
+    // ends with the exact test. The inside set of a row is contiguous and
+    // centered on cx, so this never moves more than a pixel or two.
+    while (left <= right && !insideCircle(left, cx, dySq, radiusSq)) {
+        left++;
+    }
+    while (right >= left && !insideCircle(right, cx, dySq, radiusSq)) {
+        right--;
+    }
+    if (left > right) {
+        // The estimate came out empty; the only pixel that could still be
+        // inside is the one closest to the center
+        int nearest = std::min(maxX, std::max(minX, static_cast<int>(lroundf(cx))));
+        if (!insideCircle(nearest, cx, dySq, radiusSq)) {
+            return false;
+        }
+        left = right = nearest;
+    }
+    while (left > minX && insideCircle(left - 1, cx, dySq, radiusSq)) {
+        left--;
+    }
+    while (right < maxX && insideCircle(right + 1, cx, dySq, radiusSq)) {
+        right++;
+    }
+
+    *x0 = left;
+    *x1 = right;
+    return true;
+}
+
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                uint32_t color) {
+    fillCircle(surface, cx, cy, radius, color,
+               makeRect(0, 0, surface.width, surface.height));
+}
+
+template <class Format>
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                typename Format::Pixel color, const Rect& clip) {
+    // SCANLINE CIRCLE: Instead of testing every pixel in the bounding box,
+    // solve the circle equation once per row for where the row enters and
+    // leaves the circle, then fill that span with wide stores.
+    CircleBounds bounds;
+    if (!circleBounds(surface, cx, cy, radius, &bounds)) {
+        return;
+    }
+
+    // Clipping only narrows the range the spans may cover; the span math
+    // itself is unchanged
+    bounds.minX = std::max(bounds.minX, clip.left);
+    bounds.minY = std::max(bounds.minY, clip.top);
+    bounds.maxX = std::min(bounds.maxX, clip.right - 1);
+    bounds.maxY = std::min(bounds.maxY, clip.bottom - 1);
+    if (bounds.minX > bounds.maxX || bounds.minY > bounds.maxY) {
+        return;
+    }
+
+    for (int y = bounds.minY; y <= bounds.maxY; y++) {
+        int x0, x1;
+        if (circleSpan(cx, cy, radius, y, bounds.minX, bounds.maxX, &x0, &x1)) {
+            fillPixels(rowPointer<Format>(surface, y) + x0,
+                       static_cast<size_t>(x1 - x0 + 1), color);
+        }
+    }
+}
+
+// The rows of an anti-aliased circle, in pixels of either size
+static inline void circleRowsPixels(const CoverageKernel& kernel, uint32_t* pixels, int stride,
+                                    const CircleRows& rows, uint32_t color) {
+    kernel.circleRows(pixels, stride, rows, color);
+}
+static inline void circleRowsPixels(const CoverageKernel& kernel, uint16_t* pixels, int stride,
+                                    const CircleRows& rows, uint16_t color) {
+    kernel.circleRows565(pixels, stride, rows, color);
+}
+
+template <class Format>
+void fillCircleAA(const Surface& surface, float cx, float cy, float radius,
+                  typename Format::Pixel color, const Rect& clip) {
+    // Everything within half a pixel of the edge gets some coverage
+    const float outer = radius + 0.5f;
+    CircleBounds bounds;
+    if (!circleBounds(surface, cx, cy, outer, &bounds)) {
+        return;
+    }
+    bounds.minX = std::max(bounds.minX, clip.left);
+    bounds.minY = std::max(bounds.minY, clip.top);
+    bounds.maxX = std::min(bounds.maxX, clip.right - 1);
+    bounds.maxY = std::min(bounds.maxY, clip.bottom - 1);
+    if (bounds.minX > bounds.maxX || bounds.minY > bounds.maxY) {
+        return;
+    }
+
+    // One call for the whole circle: the kernel splits each row into its
+    // edges and solid middle and only blends the edges (see raster/coverage.h)
+    const CircleRows rows = {cx, cy, outer, bounds.minX, bounds.maxX, bounds.minY, bounds.maxY};
+    circleRowsPixels(activeCoverageKernel(), rowPointer<Format>(surface, 0), surface.stride,
+                     rows, color);
+}
+
+template <class Format>
+void blitPixels(const Surface& surface, const void* pixels, int width, int height,
+                int stride, int x, int y, const Rect& clip) {
+    using Pixel = typename Format::Pixel;
+
+    Rect dst = intersectRects(makeRect(x, y, x + width, y + height), clip);
+    dst = intersectRects(dst, makeRect(0, 0, surface.width, surface.height));
+    if (dst.isEmpty()) {
+        return;
+    }
+
+    size_t rowBytes = static_cast<size_t>(dst.right - dst.left) * sizeof(Pixel);
+    for (int row = dst.top; row < dst.bottom; row++) {
+        const Pixel* src = static_cast<const Pixel*>(pixels) +
+                           static_cast<intptr_t>(row - y) * stride + (dst.left - x);
+        memcpy(rowPointer<Format>(surface, row) + dst.left, src, rowBytes);
+    }
+}
+
+// Composite one row of the bitmap in pixels of either size
+static inline void blendRow(BlendSpanFn blend, uint32_t* dst, const uint32_t* src,
+                            size_t count, uint32_t alpha) {
+    blend(dst, src, count, alpha);
+}
+static void blendRow(BlendSpanFn blend, uint16_t* dst, const uint32_t* src, size_t count,
+                     uint32_t alpha) {
+    // Widen to opaque 8888 (5/6 bits repeated into the low bits, so
+    // packing back without blending gives the same 565 pixel), blend,
+    // pack back
+    const size_t kChunk = 256;
+    uint32_t wide[kChunk];
+    while (count > 0) {
+        size_t n = std::min(count, kChunk);
+        for (size_t i = 0; i < n; i++) {
+            uint32_t r = dst[i] >> 11;
+            uint32_t g = (dst[i] >> 5) & 0x3F;
+            uint32_t b = dst[i] & 0x1F;
+            wide[i] = Rgba8888::pack(static_cast<uint8_t>((r << 3) | (r >> 2)),
+                                     static_cast<uint8_t>((g << 2) | (g >> 4)),
+                                     static_cast<uint8_t>((b << 3) | (b >> 2)), 0xFF);
+        }
+        blend(wide, src, n, alpha);
+        pack565(dst, wide, n, 0, 0);
+        dst += n;
+        src += n;
+        count -= n;
+    }
+}
+
+template <class Format>
+void blendBitmap(const Surface& surface, const uint32_t* pixels, int width, int height,
+                 int stride, int x, int y, BlendMode mode, uint32_t alpha, const Rect& clip) {
+    Rect dst = intersectRects(makeRect(x, y, x + width, y + height), clip);
+    dst = intersectRects(dst, makeRect(0, 0, surface.width, surface.height));
+    if (dst.isEmpty() || alpha == 0) {
+        return;  // A fully transparent source leaves every mode's dst as is
+    }
+
+    BlendSpanFn blend = blendSpanFn(activeBlendKernel(), mode);
+    size_t count = static_cast<size_t>(dst.right - dst.left);
+    for (int row = dst.top; row < dst.bottom; row++) {
+        const uint32_t* src = pixels + static_cast<intptr_t>(row - y) * stride + (dst.left - x);
+        blendRow(blend, rowPointer<Format>(surface, row) + dst.left, src, count, alpha);
+    }
+}
+
+template <class Format>
+void drawLine(const Surface& surface, float x0, float y0, float x1, float y1,
+              typename Format::Pixel color, const Rect& clip) {
+    Rect target = intersectRects(clip, makeRect(0, 0, surface.width, surface.height));
+    if (target.isEmpty()) {
+        return;
+    }
+
+    // BRESENHAM: step one pixel along the major axis, and one along the
+    // minor axis whenever the accumulated error crosses half a pixel
+    int x = static_cast<int>(lroundf(x0));
+    int y = static_cast<int>(lroundf(y0));
+    int endX = static_cast<int>(lroundf(x1));
+    int endY = static_cast<int>(lroundf(y1));
+
+    int dx = std::abs(endX - x);
+    int dy = -std::abs(endY - y);
+    int stepX = x < endX ? 1 : -1;
+    int stepY = y < endY ? 1 : -1;
+    int error = dx + dy;
+
+    for (;;) {
+        if (x >= target.left && x < target.right && y >= target.top && y < target.bottom) {
+            rowPointer<Format>(surface, y)[x] = color;
+        }
+        if (x == endX && y == endY) {
+            break;
+        }
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y += stepY;
+        }
+    }
+}
+
+// ========== FORMAT DISPATCH ==========
+// One instantiation per format, and the plain entry points that choose
+// between them from surface.format
+
+template void fillCircle<Rgba8888>(const Surface&, float, float, float, uint32_t, const Rect&);
+template void fillCircle<Rgbx8888>(const Surface&, float, float, float, uint32_t, const Rect&);
+template void fillCircle<Rgb565>(const Surface&, float, float, float, uint16_t, const Rect&);
+template void fillCircleAA<Rgba8888>(const Surface&, float, float, float, uint32_t,
+                                     const Rect&);
+template void fillCircleAA<Rgbx8888>(const Surface&, float, float, float, uint32_t,
+                                     const Rect&);
+template void fillCircleAA<Rgb565>(const Surface&, float, float, float, uint16_t, const Rect&);
+template void blitPixels<Rgba8888>(const Surface&, const void*, int, int, int, int, int,
+                                   const Rect&);
+template void blitPixels<Rgbx8888>(const Surface&, const void*, int, int, int, int, int,
+                                   const Rect&);
+template void blitPixels<Rgb565>(const Surface&, const void*, int, int, int, int, int,
+                                 const Rect&);
+template void blendBitmap<Rgba8888>(const Surface&, const uint32_t*, int, int, int, int, int,
+                                    BlendMode, uint32_t, const Rect&);
+template void blendBitmap<Rgbx8888>(const Surface&, const uint32_t*, int, int, int, int, int,
+                                    BlendMode, uint32_t, const Rect&);
+template void blendBitmap<Rgb565>(const Surface&, const uint32_t*, int, int, int, int, int,
+                                  BlendMode, uint32_t, const Rect&);
+template void drawLine<Rgba8888>(const Surface&, float, float, float, float, uint32_t,
+                                 const Rect&);
+template void drawLine<Rgbx8888>(const Surface&, float, float, float, float, uint32_t,
+                                 const Rect&);
+template void drawLine<Rgb565>(const Surface&, float, float, float, float, uint16_t,
+                               const Rect&);
+
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                uint32_t color, const Rect& clip) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            fillCircle<Rgba8888>(surface, cx, cy, radius, color, clip);
+            break;
+        case PixelFormat::RGBX_8888:
+            fillCircle<Rgbx8888>(surface, cx, cy, radius, color, clip);
+            break;
+        case PixelFormat::RGB_565:
+            fillCircle<Rgb565>(surface, cx, cy, radius, static_cast<uint16_t>(color), clip);
+            break;
+    }
+}
+
+void fillCircleAA(const Surface& surface, float cx, float cy, float radius,
+                  uint32_t color, const Rect& clip) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            fillCircleAA<Rgba8888>(surface, cx, cy, radius, color, clip);
+            break;
+        case PixelFormat::RGBX_8888:
+            fillCircleAA<Rgbx8888>(surface, cx, cy, radius, color, clip);
+            break;
+        case PixelFormat::RGB_565:
+            fillCircleAA<Rgb565>(surface, cx, cy, radius, static_cast<uint16_t>(color), clip);
+            break;
+    }
+}
+
+void blitPixels(const Surface& surface, const void* pixels, int width, int height,
+                int stride, int x, int y, const Rect& clip) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            blitPixels<Rgba8888>(surface, pixels, width, height, stride, x, y, clip);
+            break;
+        case PixelFormat::RGBX_8888:
+            blitPixels<Rgbx8888>(surface, pixels, width, height, stride, x, y, clip);
+            break;
+        case PixelFormat::RGB_565:
+            blitPixels<Rgb565>(surface, pixels, width, height, stride, x, y, clip);
+            break;
+    }
+}
+
+void blendBitmap(const Surface& surface, const uint32_t* pixels, int width, int height,
+                 int stride, int x, int y, BlendMode mode, uint32_t alpha, const Rect& clip) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            blendBitmap<Rgba8888>(surface, pixels, width, height, stride, x, y, mode, alpha,
+                                  clip);
+            break;
+        case PixelFormat::RGBX_8888:
+            blendBitmap<Rgbx8888>(surface, pixels, width, height, stride, x, y, mode, alpha,
+                                  clip);
+            break;
+        case PixelFormat::RGB_565:
+            blendBitmap<Rgb565>(surface, pixels, width, height, stride, x, y, mode, alpha, clip);
+            break;
+    }
+}
+
+void drawLine(const Surface& surface, float x0, float y0, float x1, float y1,
+              uint32_t color, const Rect& clip) {
+    switch (surface.format) {
+        case PixelFormat::RGBA_8888:
+            drawLine<Rgba8888>(surface, x0, y0, x1, y1, color, clip);
+            break;
+        case PixelFormat::RGBX_8888:
+            drawLine<Rgbx8888>(surface, x0, y0, x1, y1, color, clip);
+            break;
+        case PixelFormat::RGB_565:
+            drawLine<Rgb565>(surface, x0, y0, x1, y1, static_cast<uint16_t>(color), clip);
+            break;
+    }
+}
+
+Rect circleRect(float cx, float cy, float radius) {
+    // Same truncation as circleBounds(), before clipping; +1 because Rect
+    // is half-open
+    return makeRect(static_cast<int>(cx - radius), static_cast<int>(cy - radius),
+                    static_cast<int>(cx + radius) + 1, static_cast<int>(cy + radius) + 1);
+}
+
+Rect antiAliasedCircleRect(float cx, float cy, float radius) {
+    // The same truncation fillCircleAA() bounds its rows and columns with
+    return circleRect(cx, cy, radius + 0.5f);
+}
+
+void drawCircleReference(const Surface& surface, float cx, float cy,
+                         float radius, uint32_t color) {
+    // DRAW CIRCLE: Check each pixel if it's inside circle
+    // This is the manual way - no Canvas.drawCircle() here!
+    //
+    // Math: Point (x,y) is inside circle if:
+    // (x - cx)^2 + (y - cy)^2 <= radius^2
+
+    int minY = std::max(0, static_cast<int>(cy - radius));
+    int maxY = std::min(surface.height - 1, static_cast<int>(cy + radius));
+    int minX = std::max(0, static_cast<int>(cx - radius));
+    int maxX = std::min(surface.width - 1, static_cast<int>(cx + radius));
+
+    float radiusSq = radius * radius;
+
+    for (int y = minY; y <= maxY; y++) {
+        uint32_t* row = rowPointer(surface, y);
+        for (int x = minX; x <= maxX; x++) {
+            // Distance from circle center
+            float dx = x - cx;
+            float dy = y - cy;
+            float distSq = dx * dx + dy * dy;
+
+            // If inside circle, draw pixel
+            if (distSq <= radiusSq) {
+                row[x] = color;
+            }
+        }
+    }
+}
+
+} // namespace raster
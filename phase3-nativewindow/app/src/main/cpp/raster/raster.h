@@ -0,0 +1,125 @@
+/**
+ * raster/raster.h: Software rasterizer primitives
+ *
+ * These are the pixel loops that used to live inline in drawFrame().
+ * They only know about raster::Surface, so they build on Android and on a
+ * Linux host alike.
+ *
+ * Colors are already packed for the surface format (see packColor()).
+ *
+ * The pixel-writing functions come in two flavors: a template over a
+ * format traits type (raster/pixel_format.h), with no format checks in
+ * its loops, and a plain version that picks the instantiation from
+ * surface.format on every call. Per-frame code should fetch the
+ * instantiations once through pixelKernels() (raster/pixel_kernels.h).
+ */
+
+#ifndef PHASE3_RASTER_RASTER_H
+#define PHASE3_RASTER_RASTER_H
+
+#include "blend.h"
+#include "rect.h"
+#include "surface.h"
+
+namespace raster {
+
+// Fill every pixel of the surface with one color
+void clearSurface(const Surface& surface, uint32_t color);
+
+// Pixel bounds of a circle, clipped to the surface (inclusive)
+//
+// Same min/max math drawFrame() always used. Returns false when the
+// circle is entirely off-surface.
+struct CircleBounds {
+    int minX, minY, maxX, maxY;
+};
+bool circleBounds(const Surface& surface, float cx, float cy, float radius,
+                  CircleBounds* bounds);
+
+// The [x0, x1] span (inclusive) a circle covers on row y
+//
+// Computed once per row from the circle equation, then nudged by one pixel
+// where float rounding disagrees with the per-pixel test, so the result is
+// exactly the set of x in [minX, maxX] with (x - cx)^2 + (dy)^2 <= radius^2.
+// Returns false when the row is empty.
+bool circleSpan(float cx, float cy, float radius, int y, int minX, int maxX,
+                int* x0, int* x1);
+
+// Fill a solid circle centered at (cx, cy)
+//
+// A pixel (x, y) is inside when (x - cx)^2 + (y - cy)^2 <= radius^2.
+// The circle is clipped to the surface. Each row is one fillSpan() call.
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                uint32_t color);
+
+// Same, but only the pixels inside `clip` are written
+//
+// Pixels are decided exactly as in the unclipped version, so drawing a
+// circle in pieces (one clip rect at a time) leaves no seams.
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                uint32_t color, const Rect& clip);
+template <class Format>
+void fillCircle(const Surface& surface, float cx, float cy, float radius,
+                typename Format::Pixel color, const Rect& clip);
+
+// Anti-aliased circle: solid inside, blended over the destination on
+// the ~1 px ring around the exact edge (see raster/coverage.h)
+//
+// Coverage is 0 beyond radius + 0.5 and 255 inside radius - 0.5. The
+// clipped circle goes to the active coverage kernel in one call, which
+// splits each row into its edges and solid middle, blends the edges and
+// fills the middle with fillSpan() like fillCircle(). Every pixel is
+// decided on its own, so drawing in pieces (one clip rect at a time)
+// leaves no seams.
+void fillCircleAA(const Surface& surface, float cx, float cy, float radius,
+                  uint32_t color, const Rect& clip);
+template <class Format>
+void fillCircleAA(const Surface& surface, float cx, float cy, float radius,
+                  typename Format::Pixel color, const Rect& clip);
+
+// Pixel rect a circle can touch (for damage tracking)
+Rect circleRect(float cx, float cy, float radius);
+
+// Same for fillCircleAA(), whose ring reaches half a pixel further
+Rect antiAliasedCircleRect(float cx, float cy, float radius);
+
+// Copy a width x height block of opaque pixels to (x, y), inside `clip`
+//
+// The source must already be in the surface's pixel format; `stride` is
+// in pixels of that format.
+void blitPixels(const Surface& surface, const void* pixels, int width, int height,
+                int stride, int x, int y, const Rect& clip);
+template <class Format>
+void blitPixels(const Surface& surface, const void* pixels, int width, int height,
+                int stride, int x, int y, const Rect& clip);
+
+// Composite a width x height premultiplied RGBA_8888 bitmap onto the
+// surface at (x, y), inside `clip` (see raster/blend.h)
+//
+// The source is RGBA_8888 whatever the surface format; `stride` is in
+// pixels and `alpha` (0-255) fades the whole bitmap. RGB_565 rows are
+// widened to 8888, blended and packed back (truncated, like
+// Rgb565::pack()), a few hundred pixels at a time.
+void blendBitmap(const Surface& surface, const uint32_t* pixels, int width, int height,
+                 int stride, int x, int y, BlendMode mode, uint32_t alpha, const Rect& clip);
+template <class Format>
+void blendBitmap(const Surface& surface, const uint32_t* pixels, int width, int height,
+                 int stride, int x, int y, BlendMode mode, uint32_t alpha, const Rect& clip);
+
+// 1 px line between two points (rounded to pixel centers), inside `clip`
+void drawLine(const Surface& surface, float x0, float y0, float x1, float y1,
+              uint32_t color, const Rect& clip);
+template <class Format>
+void drawLine(const Surface& surface, float x0, float y0, float x1, float y1,
+              typename Format::Pixel color, const Rect& clip);
+
+// The original per-pixel circle loop from drawFrame()
+//
+// Tests every pixel of the bounding box with dx*dx + dy*dy. Kept as the
+// reference fillCircle() is checked against (see bench/circle_bench.cpp).
+void drawCircleReference(const Surface& surface, float cx, float cy,
+                         float radius, uint32_t color);
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_RASTER_H
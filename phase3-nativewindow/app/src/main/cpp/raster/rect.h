@@ -0,0 +1,73 @@
+/**
+ * raster/rect.h: Integer pixel rectangles
+ *
+ * Half-open [left, right) x [top, bottom), the same convention as ARect
+ * in android/rect.h, so converting between them is a field copy.
+ */
+
+#ifndef PHASE3_RASTER_RECT_H
+#define PHASE3_RASTER_RECT_H
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raster {
+
+struct Rect {
+    int32_t left = 0;
+    int32_t top = 0;
+    int32_t right = 0;
+    int32_t bottom = 0;
+
+    bool isEmpty() const { return left >= right || top >= bottom; }
+
+    int64_t area() const {
+        return isEmpty() ? 0 : static_cast<int64_t>(right - left) * (bottom - top);
+    }
+
+    bool operator==(const Rect& o) const {
+        return left == o.left && top == o.top && right == o.right && bottom == o.bottom;
+    }
+    bool operator!=(const Rect& o) const { return !(*this == o); }
+};
+
+inline Rect makeRect(int32_t left, int32_t top, int32_t right, int32_t bottom) {
+    Rect r;
+    r.left = left;
+    r.top = top;
+    r.right = right;
+    r.bottom = bottom;
+    return r;
+}
+
+// Overlap of two rects (may be empty)
+inline Rect intersectRects(const Rect& a, const Rect& b) {
+    return makeRect(std::max(a.left, b.left), std::max(a.top, b.top),
+                    std::min(a.right, b.right), std::min(a.bottom, b.bottom));
+}
+
+// Smallest rect containing both (an empty rect contributes nothing)
+inline Rect uniteRects(const Rect& a, const Rect& b) {
+    if (a.isEmpty()) {
+        return b;
+    }
+    if (b.isEmpty()) {
+        return a;
+    }
+    return makeRect(std::min(a.left, b.left), std::min(a.top, b.top),
+                    std::max(a.right, b.right), std::max(a.bottom, b.bottom));
+}
+
+inline bool rectsOverlap(const Rect& a, const Rect& b) {
+    return !intersectRects(a, b).isEmpty();
+}
+
+inline bool rectContains(const Rect& outer, const Rect& inner) {
+    return inner.isEmpty() ||
+           (outer.left <= inner.left && outer.top <= inner.top &&
+            outer.right >= inner.right && outer.bottom >= inner.bottom);
+}
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_RECT_H
@@ -0,0 +1,116 @@
+/**
+ * raster/scene.cpp: The Phase 1/2/3 bouncing circle animation
+ */
+
+#include "scene.h"
+#include "fill.h"
+#include "raster.h"
+
+#include <cmath>
+
+namespace raster {
+
+// The counter wraps to keep float precision; 100 is a whole number of
+// 4-unit cycles, so the wrap doesn't move the circle
+static const float kSceneWrap = 100.0f;
+
+void advanceScene(SceneState& state, float seconds) {
+    state.time += kSceneSpeed * seconds;
+    if (state.time >= kSceneWrap) {
+        state.time -= kSceneWrap;
+    }
+}
+
+void advanceScene(SceneState& state) {
+    advanceScene(state, 1.0f / 60.0f);
+}
+
+SceneState interpolateScene(const SceneState& from, const SceneState& to, float alpha) {
+    float target = to.time;
+    if (target < from.time) {
+        target += kSceneWrap;  // `to` wrapped, `from` didn't
+    }
+    SceneState state;
+    state.time = from.time + (target - from.time) * alpha;
+    if (state.time >= kSceneWrap) {
+        state.time -= kSceneWrap;
+    }
+    return state;
+}
+
+SceneCircle sceneCircle(int width, int height, const SceneState& state, float scale) {
+    // Calculate animation progress (0.0 to 1.0)
+    float cycle = fmodf(state.time, 4.0f);  // Repeat every 4 time units
+    float progress;
+    if (cycle < 2.0f) {
+        progress = cycle / 2.0f;  // 0 to 1 (moving right)
+    } else {
+        progress = 1.0f - ((cycle - 2.0f) / 2.0f);  // 1 to 0 (moving left)
+    }
+
+    // Circle parameters, in view pixels
+    float viewWidth = width / scale;
+    float viewHeight = height / scale;
+    float leftEdge = 100.0f;
+    float rightEdge = viewWidth - 100.0f;
+
+    SceneCircle circle;
+    circle.cx = leftEdge + (progress * (rightEdge - leftEdge));  // X position
+    circle.cy = viewHeight / 2.0f;  // Center Y
+    circle.radius = 80.0f;          // Circle radius
+
+    // ...and in buffer pixels
+    circle.cx *= scale;
+    circle.cy *= scale;
+    circle.radius *= scale;
+    return circle;
+}
+
+void buildScene(DisplayList& list, int width, int height, const SceneState& state,
+                float scale) {
+    // Dark blue background: Color.rgb(20, 20, 30)
+    list.clear(0xFF14141E);
+
+    // Light blue circle: Color.rgb(100, 150, 255)
+    SceneCircle circle = sceneCircle(width, height, state, scale);
+    list.fillCircleAA(circle.cx, circle.cy, circle.radius, 0xFF6496FF);
+}
+
+void recordSnapshot(SceneSnapshot& snapshot, int width, int height, const SceneState& state,
+                    int64_t timestamp, uint64_t sequence, float scale) {
+    // Last lap's commands go away with the arena (no free())
+    snapshot.arena.reset();
+    snapshot.list.reset();
+    buildScene(snapshot.list, width, height, state, scale);
+    snapshot.list.cull(makeRect(0, 0, width, height));
+    snapshot.list.sortByLayer();
+
+    snapshot.state = state;
+    snapshot.width = width;
+    snapshot.height = height;
+    snapshot.scale = scale;
+    snapshot.timestamp = timestamp;
+    snapshot.sequence = sequence;
+}
+
+void renderScene(const Surface& surface, const SceneState& state) {
+    renderScene(surface, state, makeRect(0, 0, surface.width, surface.height));
+}
+
+void renderScene(const Surface& surface, const SceneState& state, const Rect& clip) {
+    // ========== DRAW BACKGROUND ==========
+    // Fill the (clipped) buffer with dark blue color
+    // Same as Phase 1/2: Color.rgb(20, 20, 30)
+    fillRect(surface, clip.left, clip.top, clip.right, clip.bottom,
+             packColor(surface.format, 20, 20, 30));
+
+    // ========== DRAW ANIMATED CIRCLE ==========
+    // Same animation as Phase 1/2: moving light blue circle
+    SceneCircle circle = sceneCircle(surface.width, surface.height, state);
+
+    // Circle color: light blue, edge anti-aliased
+    fillCircleAA(surface, circle.cx, circle.cy, circle.radius,
+                 packColor(surface.format, 100, 150, 255), clip);
+}
+
+} // namespace raster
@@ -0,0 +1,103 @@
+/**
+ * raster/scene.h: The Phase 1/2/3 bouncing circle animation
+ *
+ * Split up so the animation and the pixels can be measured apart:
+ * - advanceScene(): pure animation math, no pixels
+ * - interpolateScene(): the state between two steps, for drawing
+ * - sceneCircle(): where things go this frame (for damage tracking)
+ * - buildScene(): record the frame as a display list (no pixels)
+ * - renderScene(): draw the frame immediately (no window, no clock);
+ *   the reference the display list path is checked against
+ * - SceneSnapshot: one recorded frame that can be handed to another
+ *   thread (the pipelined renderer, frame/spsc_ring.h)
+ *
+ * SCALE: with dynamic resolution (frame/resolution_governor.h) the buffer
+ * is smaller than the view and the compositor stretches it back up. The
+ * scene is laid out for the full-size view (width / scale x height /
+ * scale) and then shrunk by `scale`, so the circle keeps its size and
+ * path on screen whatever the buffer resolution. scale 1 is exactly the
+ * original layout.
+ *
+ * TIME: the animation moves kSceneSpeed time units per second of
+ * simulated time (the original 0.05 per frame at 60 Hz), so the circle
+ * takes the same 1.33 s per sweep whatever the refresh rate. The
+ * renderer steps it on a fixed timestep (common/timeline.h) and draws
+ * interpolateScene() between the last two steps.
+ */
+
+#ifndef PHASE3_RASTER_SCENE_H
+#define PHASE3_RASTER_SCENE_H
+
+#include "display_list.h"
+#include "frame_arena.h"
+#include "rect.h"
+#include "surface.h"
+
+namespace raster {
+
+// Animation time units per second (one back-and-forth sweep is 4 units)
+static const float kSceneSpeed = 3.0f;
+
+// Animation state for the moving circle
+struct SceneState {
+    float time = 0.0f;  // Animation time counter, wraps at 100
+};
+
+// The circle's placement for one frame
+struct SceneCircle {
+    float cx;
+    float cy;
+    float radius;
+};
+
+// A frame recorded on one thread and rasterized on another
+//
+// Owns the memory its commands live in, so a ring of these can be filled
+// by the simulation thread while the render thread reads an older one.
+// Once recorded it is immutable until its slot comes around again.
+struct SceneSnapshot {
+    FrameArena arena;
+    DisplayList list;
+    SceneState state;        // Animation state the list was recorded from
+    int width = 0;           // Viewport the list was recorded (and culled) for
+    int height = 0;
+    float scale = 1.0f;      // Buffer pixels per view pixel it was recorded at
+    int64_t timestamp = 0;   // When the simulation produced it (CLOCK_MONOTONIC ns)
+    uint64_t sequence = 0;   // Simulation step number
+
+    SceneSnapshot() : list(arena) {}
+    SceneSnapshot(const SceneSnapshot&) = delete;
+    SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+};
+
+// Record `state` into `snapshot` for a width x height viewport: reset,
+// buildScene(), cull and sort by layer (everything but the pixels)
+void recordSnapshot(SceneSnapshot& snapshot, int width, int height, const SceneState& state,
+                    int64_t timestamp, uint64_t sequence, float scale = 1.0f);
+
+// Step the animation by `seconds` of simulated time
+void advanceScene(SceneState& state, float seconds);
+
+// Step the animation by one 60 Hz frame (what the benchmarks replay)
+void advanceScene(SceneState& state);
+
+// The state `alpha` (0-1) of the way from `from` to `to`, which are one
+// or more steps apart (across the wrap at 100 too)
+SceneState interpolateScene(const SceneState& from, const SceneState& to, float alpha);
+
+// Where the circle is on a width x height buffer
+SceneCircle sceneCircle(int width, int height, const SceneState& state, float scale = 1.0f);
+
+// Record the frame: background clear (id 0) + anti-aliased circle (id 1)
+void buildScene(DisplayList& list, int width, int height, const SceneState& state,
+                float scale = 1.0f);
+
+// Draw the dark blue background and the light blue circle (anti-aliased)
+void renderScene(const Surface& surface, const SceneState& state);
+
+// Same, but only repaint the pixels inside `clip`
+void renderScene(const Surface& surface, const SceneState& state, const Rect& clip);
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_SCENE_H
@@ -0,0 +1,67 @@
+/**
+ * raster/surface.h: The plain pixel target the software rasterizer draws into
+ *
+ * ANativeWindow_Buffer is an Android type, so code that touches it can only
+ * be built with the NDK. The raster core uses this struct instead, which has
+ * the same {bits, width, height, stride, format} shape but no Android
+ * dependency. native_renderer.cpp fills one in from the locked buffer; the
+ * host benchmarks fill one in from a plain heap allocation.
+ *
+ * Lookup: "ANativeWindow_Buffer", "row stride"
+ */
+
+#ifndef PHASE3_RASTER_SURFACE_H
+#define PHASE3_RASTER_SURFACE_H
+
+#include "pixel_format.h"
+
+#include <cstdint>
+
+namespace raster {
+
+// Surface: a locked pixel buffer
+//
+// IMPORTANT: stride is in PIXELS, not bytes, exactly like
+// ANativeWindow_Buffer. Row y starts at bits + y * stride pixels.
+struct Surface {
+    void* bits = nullptr;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t stride = 0;
+    PixelFormat format = PixelFormat::RGBA_8888;
+};
+
+// Pack an 8-bit-per-channel color for a runtime format
+//
+// For code that isn't specialized on a format (scene setup, benchmarks).
+// The result sits in the low bits for 16-bit formats. Pixel loops use the
+// compile-time Format::pack() instead.
+inline uint32_t packColor(PixelFormat format,
+                          uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    switch (format) {
+        case PixelFormat::RGBA_8888:
+            return Rgba8888::pack(r, g, b, a);
+        case PixelFormat::RGBX_8888:
+            return Rgbx8888::pack(r, g, b, a);
+        case PixelFormat::RGB_565:
+            return Rgb565::pack(r, g, b, a);
+    }
+    return 0;
+}
+
+// Row pointer helper: always go through stride, never width
+// (32-bit formats only; use rowPointer<Format>() in format-generic code)
+inline uint32_t* rowPointer(const Surface& surface, int y) {
+    return static_cast<uint32_t*>(surface.bits) +
+           static_cast<intptr_t>(y) * surface.stride;
+}
+
+template <class Format>
+inline typename Format::Pixel* rowPointer(const Surface& surface, int y) {
+    return static_cast<typename Format::Pixel*>(surface.bits) +
+           static_cast<intptr_t>(y) * surface.stride;
+}
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_SURFACE_H
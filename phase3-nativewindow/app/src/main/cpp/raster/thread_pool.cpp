@@ -0,0 +1,170 @@
+/**
+ * raster/thread_pool.cpp: Persistent work-stealing worker pool
+ */
+
+#include "thread_pool.h"
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace raster {
+
+int ThreadPool::hardwareThreads() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+ThreadPool::ThreadPool(int threadCount)
+    : m_queues(std::max(1, threadCount)) {
+    // Worker 0 is whoever calls run(); start the others
+    int workers = threadCount - 1;
+    m_starts.reserve(std::max(0, workers));
+    for (int i = 1; i <= workers; i++) {
+        m_starts.push_back(WorkerStart{this, i});
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, workerMain, &m_starts.back()) != 0) {
+            // Fewer workers is still correct: their queues get stolen from
+            break;
+        }
+        m_threads.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(m_wakeLock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (pthread_t thread : m_threads) {
+        pthread_join(thread, nullptr);
+    }
+}
+
+void* ThreadPool::workerMain(void* arg) {
+    auto* start = static_cast<WorkerStart*>(arg);
+
+    // Name the thread so it shows up in systrace / top -H
+    char name[16];
+    snprintf(name, sizeof(name), "raster-%d", start->index);
+    pthread_setname_np(pthread_self(), name);
+
+    start->pool->workerLoop(start->index);
+    return nullptr;
+}
+
+void ThreadPool::workerLoop(int self) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(m_wakeLock);
+            m_wake.wait(guard, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation;
+        }
+        drain(self);
+    }
+}
+
+bool ThreadPool::popLocal(int self, int* task) {
+    WorkerQueue& queue = m_queues[self];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.head == queue.tasks.size()) {
+        return false;
+    }
+    // LIFO for the owner
+    *task = queue.tasks.back();
+    queue.tasks.pop_back();
+    if (queue.head == queue.tasks.size()) {
+        queue.tasks.clear();
+        queue.head = 0;
+    }
+    return true;
+}
+
+bool ThreadPool::steal(int self, int* task) {
+    int count = threadCount();
+    for (int offset = 1; offset < count; offset++) {
+        WorkerQueue& victim = m_queues[(self + offset) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.head < victim.tasks.size()) {
+            // FIFO for thieves: take the work furthest from the owner
+            *task = victim.tasks[victim.head++];
+            if (victim.head == victim.tasks.size()) {
+                victim.tasks.clear();
+                victim.head = 0;
+            }
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(int task) {
+    m_fn(m_context, task);
+    m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::drain(int self) {
+    int task;
+    for (;;) {
+        if (popLocal(self, &task) || steal(self, &task)) {
+            execute(task);
+        } else {
+            return;
+        }
+    }
+}
+
+void ThreadPool::run(int taskCount, TaskFn fn, void* context) {
+    if (taskCount <= 0) {
+        return;
+    }
+
+    if (m_threads.empty() || taskCount == 1) {
+        for (int i = 0; i < taskCount; i++) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    // Visible to workers through the queue locks taken below
+    m_fn = fn;
+    m_context = context;
+    m_remaining.store(taskCount, std::memory_order_relaxed);
+
+    // Contiguous chunks: queue q gets tasks [q*n/Q, (q+1)*n/Q)
+    int queues = threadCount();
+    for (int q = 0; q < queues; q++) {
+        int begin = static_cast<int>(static_cast<int64_t>(taskCount) * q / queues);
+        int end = static_cast<int>(static_cast<int64_t>(taskCount) * (q + 1) / queues);
+        WorkerQueue& queue = m_queues[q];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        // Pushed in reverse so the owner's LIFO pops walk tiles in order
+        for (int i = end - 1; i >= begin; i--) {
+            queue.tasks.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_wakeLock);
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    // The caller is worker 0
+    drain(0);
+
+    // JOIN: wait for tasks other threads are still running
+    while (m_remaining.load(std::memory_order_acquire) > 0) {
+        sched_yield();
+    }
+}
+
+} // namespace raster
@@ -0,0 +1,98 @@
+/**
+ * raster/thread_pool.h: Persistent work-stealing worker pool
+ *
+ * drawFrame() runs on a single pthread while phones have 8 cores. The pool
+ * keeps N-1 workers alive for the lifetime of the renderer; the thread that
+ * calls run() is worker 0 and does its share of the work too.
+ *
+ * WORK STEALING:
+ * Each worker has its own queue of task indices. A job's tasks are split
+ * into contiguous chunks, one chunk per queue, so neighbouring tiles stay
+ * on the same core. A worker pops from the back of its own queue; when it
+ * runs dry it steals from the front of someone else's. Fast cores end up
+ * doing more tiles instead of waiting for the slowest one.
+ *
+ * run() is blocking and must only be called from one thread at a time
+ * (the render thread).
+ *
+ * Lookup: "work stealing scheduler", "Cilk deque", "fork-join"
+ */
+
+#ifndef PHASE3_RASTER_THREAD_POOL_H
+#define PHASE3_RASTER_THREAD_POOL_H
+
+#include <pthread.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace raster {
+
+class ThreadPool {
+public:
+    // Runs task `index` of a job; `context` is whatever run() was given
+    using TaskFn = void (*)(void* context, int index);
+
+    // threadCount includes the calling thread (1 = no workers, run inline)
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_queues.size()); }
+
+    // Run fn(context, 0..taskCount-1) across all threads and wait for all
+    // of them to finish (the join before ANativeWindow_unlockAndPost)
+    void run(int taskCount, TaskFn fn, void* context);
+
+    // Tasks taken from another worker's queue since construction
+    int64_t stealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+    // Online CPU count, for sizing the pool
+    static int hardwareThreads();
+
+private:
+    // One per thread; padded so two queues never share a cache line
+    struct alignas(64) WorkerQueue {
+        std::mutex lock;
+        std::vector<int> tasks;  // Indices; [head, size) are still pending
+        size_t head = 0;
+    };
+
+    struct WorkerStart {
+        ThreadPool* pool;
+        int index;
+    };
+
+    static void* workerMain(void* arg);
+    void workerLoop(int self);
+
+    bool popLocal(int self, int* task);
+    bool steal(int self, int* task);
+    void execute(int task);
+    void drain(int self);
+
+    std::vector<WorkerQueue> m_queues;
+    std::vector<pthread_t> m_threads;
+    std::vector<WorkerStart> m_starts;
+
+    // The current job
+    TaskFn m_fn = nullptr;
+    void* m_context = nullptr;
+    std::atomic<int> m_remaining{0};
+
+    // Sleeping between jobs
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;
+    uint64_t m_generation = 0;  // Bumped for every job
+    bool m_stop = false;
+
+    std::atomic<int64_t> m_steals{0};
+};
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_THREAD_POOL_H
@@ -0,0 +1,103 @@
+/**
+ * raster/tile_renderer.cpp: Split a frame into tiles and render them in parallel
+ */
+
+#include "tile_renderer.h"
+#include "pack565.h"
+
+#include <vector>
+
+namespace raster {
+
+void TileRenderer::render(const Surface& surface, const DisplayList& list,
+                          const DamageRegion& region) {
+    m_tiles.clear();
+    m_kernels = pixelKernels(surface.format);
+    if (!m_kernels) {
+        return;
+    }
+    m_binner.bin(list, surface.width, surface.height, m_tileSize);
+
+    // Cut each rect on the global tile grid. The region's rects never
+    // overlap, so neither do the tiles.
+    for (int i = 0; i < region.count(); i++) {
+        const Rect& rect = region[i];
+        int firstRow = rect.top / m_tileSize;
+        int firstCol = rect.left / m_tileSize;
+
+        for (int ty = firstRow * m_tileSize; ty < rect.bottom; ty += m_tileSize) {
+            for (int tx = firstCol * m_tileSize; tx < rect.right; tx += m_tileSize) {
+                Rect tile = intersectRects(
+                        rect, makeRect(tx, ty, tx + m_tileSize, ty + m_tileSize));
+                if (!tile.isEmpty()) {
+                    m_tiles.push_back({tile, m_binner.tileAt(tx, ty)});
+                }
+            }
+        }
+    }
+
+    m_surface = &surface;
+    m_list = &list;
+
+    bool dithered = m_dither && surface.format == PixelFormat::RGB_565;
+    if (dithered) {
+        // Tiles are drawn into RGBA_8888 scratch first
+        m_kernels = pixelKernels(PixelFormat::RGBA_8888);
+    }
+    m_pool.run(static_cast<int>(m_tiles.size()),
+               dithered ? renderTileDithered : renderTile, this);
+}
+
+void TileRenderer::render(const Surface& surface, const DisplayList& list) {
+    DamageRegion full;
+    full.add(makeRect(0, 0, surface.width, surface.height));
+    render(surface, list, full);
+}
+
+void TileRenderer::renderTile(void* context, int index) {
+    auto* self = static_cast<TileRenderer*>(context);
+    const TileJob& job = self->m_tiles[index];
+
+    size_t count = 0;
+    const uint32_t* commands = self->m_binner.commands(job.bin, &count);
+    executeCommands(*self->m_surface, *self->m_kernels, *self->m_list, commands, count,
+                    job.rect);
+}
+
+void TileRenderer::renderTileDithered(void* context, int index) {
+    auto* self = static_cast<TileRenderer*>(context);
+    const TileJob& job = self->m_tiles[index];
+    const Rect& rect = job.rect;
+    const int tileSize = self->m_tileSize;
+
+    // One scratch tile per thread, reused for every tile it renders
+    thread_local std::vector<uint32_t> scratch;
+    scratch.resize(static_cast<size_t>(tileSize) * tileSize);
+
+    // A Surface whose rows are tileSize pixels apart and whose origin is
+    // shifted so pixel (rect.left, rect.top) is scratch[0]. The commands
+    // keep their screen coordinates; clipping to `rect` keeps every write
+    // inside the scratch tile.
+    intptr_t origin = static_cast<intptr_t>(rect.top) * tileSize + rect.left;
+    Surface tile;
+    tile.bits = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(scratch.data()) -
+                                        origin * sizeof(uint32_t));
+    tile.width = rect.right;
+    tile.height = rect.bottom;
+    tile.stride = tileSize;
+    tile.format = PixelFormat::RGBA_8888;
+
+    size_t count = 0;
+    const uint32_t* commands = self->m_binner.commands(job.bin, &count);
+    executeCommands(tile, *self->m_kernels, *self->m_list, commands, count, rect);
+
+    // Pack + dither each row into the real buffer
+    const Surface& surface = *self->m_surface;
+    size_t width = static_cast<size_t>(rect.right - rect.left);
+    for (int y = rect.top; y < rect.bottom; y++) {
+        const uint32_t* src = scratch.data() + static_cast<size_t>(y - rect.top) * tileSize;
+        pack565Dither(rowPointer<Rgb565>(surface, y) + rect.left, src, width, rect.left, y);
+    }
+}
+
+} // namespace raster
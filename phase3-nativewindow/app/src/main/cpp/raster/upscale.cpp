@@ -0,0 +1,276 @@
+/**
+ * raster/upscale.cpp: Upscale dispatch, sample tables and the scalar kernels
+ */
+
+#include "upscale.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace raster {
+
+// Two channels at a time: the 0x00FF00FF lanes leave 16 bits per channel,
+// and 255 * 256 + 128 still fits in them, so this rounds exactly like
+// (a * (256 - w) + b * w + 128) >> 8 per channel.
+static inline uint32_t lerpPixel(uint32_t a, uint32_t b, uint32_t weight) {
+    const uint32_t mask = 0x00FF00FF;
+    uint32_t inverse = 256 - weight;
+    uint32_t even = ((a & mask) * inverse + (b & mask) * weight + 0x00800080) >> 8;
+    uint32_t odd = (((a >> 8) & mask) * inverse + ((b >> 8) & mask) * weight + 0x00800080) >> 8;
+    return (even & mask) | ((odd & mask) << 8);
+}
+
+void lerpRowsScalar(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, int weight) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = lerpPixel(a[i], b[i], weight);
+    }
+}
+
+void lerpColumnsScalar(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                       const uint16_t* weight, int count) {
+    for (int i = 0; i < count; i++) {
+        const uint32_t* pair = row + index[i];
+        dst[i] = lerpPixel(pair[0], pair[1], weight[i]);
+    }
+}
+
+namespace {
+
+struct KernelTable {
+    UpscaleKernel kernels[3];
+    size_t count = 0;
+
+    KernelTable() {
+        kernels[count++] = {"scalar", lerpRowsScalar, lerpColumnsScalar};
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels[count++] = {"sse2", lerpRowsSSE2, lerpColumnsSSE2};
+        }
+#endif
+
+#if defined(__ARM_NEON)
+        kernels[count++] = {"neon", lerpRowsNEON, lerpColumnsNEON};
+#endif
+    }
+};
+
+const KernelTable& kernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+std::atomic<const UpscaleKernel*> g_active{nullptr};
+
+const UpscaleKernel* active() {
+    const UpscaleKernel* kernel = g_active.load(std::memory_order_acquire);
+    if (!kernel) {
+        const KernelTable& table = kernelTable();
+        kernel = &table.kernels[table.count - 1];
+        g_active.store(kernel, std::memory_order_release);
+    }
+    return kernel;
+}
+
+// Source position of output pixel `i` in 16.16 fixed point, pixel
+// centers aligned: (i + 0.5) * step - 0.5
+inline int64_t samplePosition(int i, int64_t step) {
+    return i * step + step / 2 - 32768;
+}
+
+// Bilinear sample: the pair (index, index + 1) and the weight of the
+// second one. Clamped so index + 1 is always a real pixel; past the last
+// pixel that means "all of index + 1".
+inline void bilinearSample(int64_t position, int size, int32_t* index, uint16_t* weight) {
+    if (position <= 0) {
+        *index = 0;
+        *weight = 0;
+        return;
+    }
+    int32_t i = static_cast<int32_t>(position >> 16);
+    if (i >= size - 1) {
+        *index = size - 2;
+        *weight = 256;
+        return;
+    }
+    *index = i;
+    *weight = static_cast<uint16_t>(((position & 0xFFFF) + 128) >> 8);  // 0-256, rounded
+}
+
+} // namespace
+
+const UpscaleKernel* supportedUpscaleKernels(size_t* count) {
+    const KernelTable& table = kernelTable();
+    *count = table.count;
+    return table.kernels;
+}
+
+const UpscaleKernel& activeUpscaleKernel() {
+    return *active();
+}
+
+bool selectUpscaleKernel(const char* name) {
+    const KernelTable& table = kernelTable();
+    for (size_t i = 0; i < table.count; i++) {
+        if (strcmp(table.kernels[i].name, name) == 0) {
+            g_active.store(&table.kernels[i], std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Everything a band of rows needs
+struct Upscaler::Job {
+    Upscaler* self;
+    const UpscaleKernel* kernel;
+    const Surface* dst;
+    const Surface* src;
+    Rect rect;
+    bool bilinear;
+    int64_t stepY;
+    int rowsPerBand;
+};
+
+void Upscaler::prepareColumns(int dstWidth, int srcWidth) {
+    int filter = static_cast<int>(m_filter);
+    if (m_columnsFor[0] == dstWidth && m_columnsFor[1] == srcWidth && m_columnsFor[2] == filter) {
+        return;
+    }
+    m_index.resize(dstWidth);
+    m_weight.resize(dstWidth);
+    int64_t step = (static_cast<int64_t>(srcWidth) << 16) / dstWidth;
+    for (int x = 0; x < dstWidth; x++) {
+        if (m_filter == UpscaleFilter::Bilinear) {
+            bilinearSample(samplePosition(x, step), srcWidth, &m_index[x], &m_weight[x]);
+        } else {
+            int64_t position = x * step + step / 2;
+            m_index[x] = std::min(static_cast<int32_t>(position >> 16), srcWidth - 1);
+            m_weight[x] = 0;
+        }
+    }
+    m_columnsFor[0] = dstWidth;
+    m_columnsFor[1] = srcWidth;
+    m_columnsFor[2] = filter;
+}
+
+void Upscaler::runBand(void* context, int band) {
+    const Job& job = *static_cast<const Job*>(context);
+    const Surface& dst = *job.dst;
+    const Surface& src = *job.src;
+    Upscaler& self = *job.self;
+    int top = job.rect.top + band * job.rowsPerBand;
+    int bottom = std::min(top + job.rowsPerBand, job.rect.bottom);
+    int left = job.rect.left;
+    int width = job.rect.right - left;
+    const int32_t* index = self.m_index.data() + left;
+    const uint16_t* weight = self.m_weight.data() + left;
+
+    if (!job.bilinear) {
+        int64_t position = top * job.stepY + job.stepY / 2;
+        for (int y = top; y < bottom; y++, position += job.stepY) {
+            int sy = std::min(static_cast<int>(position >> 16), src.height - 1);
+            const uint32_t* row = rowPointer(src, sy);
+            uint32_t* out = rowPointer(dst, y) + left;
+            for (int i = 0; i < width; i++) {
+                out[i] = row[index[i]];
+            }
+        }
+        return;
+    }
+
+    // The vertical pass only needs the source columns this rect samples
+    int first = index[0];
+    int count = index[width - 1] + 2 - first;
+    uint32_t* scratch = self.m_rows.data() + static_cast<size_t>(band) * src.width;
+    for (int y = top; y < bottom; y++) {
+        int32_t sy = 0;
+        uint16_t fy = 0;
+        bilinearSample(samplePosition(y, job.stepY), src.height, &sy, &fy);
+        const uint32_t* row;
+        if (fy == 0) {
+            row = rowPointer(src, sy);
+        } else if (fy == 256) {
+            row = rowPointer(src, sy + 1);
+        } else {
+            job.kernel->lerpRows(scratch + first, rowPointer(src, sy) + first,
+                                 rowPointer(src, sy + 1) + first, count, fy);
+            row = scratch;
+        }
+        job.kernel->lerpColumns(rowPointer(dst, y) + left, row, index, weight, width);
+    }
+}
+
+bool Upscaler::upscale(const Surface& dst, const Surface& src, const Rect& rect,
+                       ThreadPool* pool) {
+    if (dst.format != src.format || bytesPerPixel(dst.format) != 4) {
+        return false;
+    }
+    Rect clipped = intersectRects(rect, makeRect(0, 0, dst.width, dst.height));
+    if (clipped.isEmpty() || src.width < 1 || src.height < 1) {
+        return true;
+    }
+
+    // Bilinear needs two source pixels per axis to blend between
+    UpscaleFilter filter = m_filter;
+    if (src.width < 2 || src.height < 2) {
+        m_filter = UpscaleFilter::Nearest;
+    }
+    prepareColumns(dst.width, src.width);
+
+    Job job;
+    job.self = this;
+    job.kernel = active();
+    job.dst = &dst;
+    job.src = &src;
+    job.rect = clipped;
+    job.bilinear = m_filter == UpscaleFilter::Bilinear;
+    job.stepY = (static_cast<int64_t>(src.height) << 16) / dst.height;
+
+    // A few bands per thread, so work stealing can even them out
+    int rows = clipped.bottom - clipped.top;
+    int bands = pool ? std::min(rows, pool->threadCount() * 4) : 1;
+    job.rowsPerBand = (rows + bands - 1) / bands;
+    bands = (rows + job.rowsPerBand - 1) / job.rowsPerBand;
+    if (job.bilinear) {
+        size_t scratch = static_cast<size_t>(bands) * src.width;
+        if (m_rows.size() < scratch) {
+            m_rows.resize(scratch);
+        }
+    }
+
+    if (pool && bands > 1) {
+        pool->run(bands, runBand, &job);
+    } else {
+        for (int band = 0; band < bands; band++) {
+            runBand(&job, band);
+        }
+    }
+    m_filter = filter;
+    return true;
+}
+
+Rect upscaledRect(const Rect& srcRect, int srcWidth, int srcHeight, int dstWidth,
+                  int dstHeight) {
+    if (srcRect.isEmpty()) {
+        return Rect();
+    }
+    // One source pixel of margin for the bilinear footprint, one output
+    // pixel for rounding; exactness doesn't matter, covering does
+    auto scaleDown = [](int value, int from, int to) {
+        return static_cast<int>((static_cast<int64_t>(value) * to) / from) - 1;
+    };
+    auto scaleUp = [](int value, int from, int to) {
+        return static_cast<int>((static_cast<int64_t>(value) * to + from - 1) / from) + 1;
+    };
+    Rect rect = makeRect(scaleDown(srcRect.left - 1, srcWidth, dstWidth),
+                         scaleDown(srcRect.top - 1, srcHeight, dstHeight),
+                         scaleUp(srcRect.right + 1, srcWidth, dstWidth),
+                         scaleUp(srcRect.bottom + 1, srcHeight, dstHeight));
+    return intersectRects(rect, makeRect(0, 0, dstWidth, dstHeight));
+}
+
+} // namespace raster
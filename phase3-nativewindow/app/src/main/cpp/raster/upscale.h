@@ -0,0 +1,132 @@
+/**
+ * raster/upscale.h: Stretch a small RGBA frame over a full-size buffer
+ *
+ * RENDER SCALE: shrinking the window's buffers (frame/resolution_governor.h)
+ * makes EVERYTHING blurry, overlays and text included. The other way to
+ * render fewer pixels is to rasterize the scene into a smaller INTERNAL
+ * buffer (0.5x per axis = a quarter of the pixels) and stretch it into the
+ * full-size window buffer ourselves while presenting. Anything drawn after
+ * the stretch stays sharp at native resolution.
+ *
+ * The stretch has to be cheap, or it eats what the smaller raster saved:
+ * - NEAREST: each output pixel copies the closest source pixel. One load
+ *   and one store per pixel, blocky.
+ * - BILINEAR: each output pixel blends the 2x2 source pixels around its
+ *   sample point, weighted by distance. Smooth, and separable: blend two
+ *   source rows into one (vertical pass, the same weight for the whole
+ *   row), then blend neighbouring pixels of that row (horizontal pass, a
+ *   weight per output column, computed once per frame).
+ *
+ * SAMPLE POSITIONS: pixel centers line up, i.e. output x maps to source
+ * (x + 0.5) * srcWidth / dstWidth - 0.5, in 16.16 fixed point. Weights are
+ * 8 bits (0-256), and both passes round the same way, so the SIMD kernels
+ * give exactly the scalar result and the same-size case is an exact copy.
+ *
+ * DISPATCH works like raster/pack565.h: scalar, SSE2 (x86) and NEON (ARM)
+ * row kernels, the best one picked once at startup.
+ *
+ * Only 32-bit formats (RGBA_8888 / RGBX_8888), and dst and src must have
+ * the same one. stride is honored on both sides.
+ *
+ * Lookup: "bilinear interpolation separable", "dynamic resolution upscale",
+ *         "render scale"
+ */
+
+#ifndef PHASE3_RASTER_UPSCALE_H
+#define PHASE3_RASTER_UPSCALE_H
+
+#include "rect.h"
+#include "surface.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace raster {
+
+class ThreadPool;
+
+enum class UpscaleFilter {
+    Nearest,
+    Bilinear,
+};
+
+// Vertical pass: dst[i] = a[i] blended towards b[i] by weight/256, per channel
+using LerpRowsFn = void (*)(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count,
+                            int weight);
+
+// Horizontal pass: dst[i] = row[index[i]] blended towards row[index[i] + 1]
+// by weight[i]/256, per channel
+using LerpColumnsFn = void (*)(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                               const uint16_t* weight, int count);
+
+struct UpscaleKernel {
+    const char* name;           // "scalar", "sse2", "neon"
+    LerpRowsFn lerpRows;
+    LerpColumnsFn lerpColumns;
+};
+
+// All kernels this CPU can run, from slowest to fastest
+const UpscaleKernel* supportedUpscaleKernels(size_t* count);
+
+// The kernel Upscaler uses
+const UpscaleKernel& activeUpscaleKernel();
+
+// Force a kernel by name. Returns false if this CPU can't run it.
+bool selectUpscaleKernel(const char* name);
+
+// Keeps the per-column sample tables and row scratch between frames, so
+// presenting doesn't allocate once the sizes stop changing.
+// One Upscaler per thread that uses it.
+class Upscaler {
+public:
+    explicit Upscaler(UpscaleFilter filter = UpscaleFilter::Bilinear) : m_filter(filter) {}
+
+    UpscaleFilter filter() const { return m_filter; }
+    void setFilter(UpscaleFilter filter) { m_filter = filter; }
+
+    // Stretch all of src over all of dst, writing only the dst pixels
+    // inside `rect` (clipped to dst). With a pool, bands of rows run on
+    // all of its threads. Returns false (and writes nothing) if the
+    // formats differ or aren't 32-bit.
+    bool upscale(const Surface& dst, const Surface& src, const Rect& rect,
+                 ThreadPool* pool = nullptr);
+
+private:
+    struct Job;
+    static void runBand(void* context, int band);
+    void prepareColumns(int dstWidth, int srcWidth);
+
+    UpscaleFilter m_filter;
+
+    // Per output column: source index and weight (bilinear: of index + 1)
+    std::vector<int32_t> m_index;
+    std::vector<uint16_t> m_weight;
+    int m_columnsFor[3] = {-1, -1, -1};   // dstWidth, srcWidth, filter they were made for
+
+    std::vector<uint32_t> m_rows;         // Vertical pass output, one row per band
+};
+
+// The dst rect whose pixels sample anything inside srcRect (so it covers
+// every output pixel that changes when srcRect changes), clipped to dst
+Rect upscaledRect(const Rect& srcRect, int srcWidth, int srcHeight, int dstWidth,
+                  int dstHeight);
+
+// ---- Kernels (defined in upscale*.cpp, only call through dispatch) ----
+void lerpRowsScalar(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, int weight);
+void lerpColumnsScalar(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                       const uint16_t* weight, int count);
+#if defined(__x86_64__) || defined(__i386__)
+void lerpRowsSSE2(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, int weight);
+void lerpColumnsSSE2(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                     const uint16_t* weight, int count);
+#endif
+#if defined(__ARM_NEON)
+void lerpRowsNEON(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, int weight);
+void lerpColumnsNEON(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                     const uint16_t* weight, int count);
+#endif
+
+} // namespace raster
+
+#endif // PHASE3_RASTER_UPSCALE_H
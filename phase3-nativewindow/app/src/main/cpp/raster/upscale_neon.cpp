@@ -0,0 +1,62 @@
+/**
+ * raster/upscale_neon.cpp: Bilinear row kernels for ARM
+ *
+ * Both passes widen bytes to 16-bit lanes, multiply with vmulq_u16 /
+ * vmlaq_u16 (255 * 256 fits, so the low 16 bits are the whole product)
+ * and narrow with vrshrn_n_u16(sum, 8), which is exactly
+ * (sum + 128) >> 8: the scalar kernel's rounding.
+ *
+ * The horizontal pass loads each output pixel's two source pixels with
+ * one vld1_u8, multiplies them by (256 - w) x 4 and w x 4, and adds the
+ * two halves of the register.
+ */
+
+#include "upscale.h"
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+namespace raster {
+
+void lerpRowsNEON(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, int weight) {
+    const uint16x8_t weightA = vdupq_n_u16(static_cast<uint16_t>(256 - weight));
+    const uint16x8_t weightB = vdupq_n_u16(static_cast<uint16_t>(weight));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t pa = vld1q_u8(reinterpret_cast<const uint8_t*>(a + i));
+        uint8x16_t pb = vld1q_u8(reinterpret_cast<const uint8_t*>(b + i));
+        uint16x8_t lo = vmulq_u16(vmovl_u8(vget_low_u8(pa)), weightA);
+        uint16x8_t hi = vmulq_u16(vmovl_u8(vget_high_u8(pa)), weightA);
+        lo = vmlaq_u16(lo, vmovl_u8(vget_low_u8(pb)), weightB);
+        hi = vmlaq_u16(hi, vmovl_u8(vget_high_u8(pb)), weightB);
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i),
+                 vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+    lerpRowsScalar(dst + i, a + i, b + i, count - i, weight);
+}
+
+// One output pixel, as 4 x 16-bit channel sums (not yet shifted)
+static inline uint16x4_t lerpPair(const uint32_t* pair, uint16_t weight) {
+    uint8x8_t pixels = vld1_u8(reinterpret_cast<const uint8_t*>(pair));
+    uint16x8_t weights = vcombine_u16(vdup_n_u16(static_cast<uint16_t>(256 - weight)),
+                                      vdup_n_u16(weight));
+    uint16x8_t products = vmulq_u16(vmovl_u8(pixels), weights);
+    return vadd_u16(vget_low_u16(products), vget_high_u16(products));
+}
+
+void lerpColumnsNEON(uint32_t* dst, const uint32_t* row, const int32_t* index,
+                     const uint16_t* weight, int count) {
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint16x8_t sums = vcombine_u16(lerpPair(row + index[i], weight[i]),
+                                       lerpPair(row + index[i + 1], weight[i + 1]));
+        vst1_u8(reinterpret_cast<uint8_t*>(dst + i), vrshrn_n_u16(sums, 8));
+    }
+    lerpColumnsScalar(dst + i, row, index + i, weight + i, count - i);
+}
+
+} // namespace raster
+
+#endif
@@ -0,0 +1,1123 @@
+/**
+ * renderer.cpp: One native renderer per Surface
+ *
+ * The frame itself (drawFrame) and the render loop are unchanged from
+ * when they lived in native_renderer.cpp; they just read members instead
+ * of globals now. simulationLoop() is the producer side of pipelined mode,
+ * presentLoop() the consumer side of the back buffers in present thread mode,
+ * applyResolution() carries out the dynamic resolution governor's decisions,
+ * drawUpscaled() the internal resolution mode.
+ */
+
+#include "renderer.h"
+
+#include <dlfcn.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "raster/pixel_kernels.h"
+#include "raster/raster.h"
+
+#define LOG_TAG "Phase3Native"
+#include "common/log.h"
+
+// raster::PixelFormat mirrors WINDOW_FORMAT_* so we can cast between them
+static_assert(static_cast<int>(raster::PixelFormat::RGBA_8888) == WINDOW_FORMAT_RGBA_8888,
+              "raster::PixelFormat must match WINDOW_FORMAT_RGBA_8888");
+static_assert(static_cast<int>(raster::PixelFormat::RGBX_8888) == WINDOW_FORMAT_RGBX_8888,
+              "raster::PixelFormat must match WINDOW_FORMAT_RGBX_8888");
+static_assert(static_cast<int>(raster::PixelFormat::RGB_565) == WINDOW_FORMAT_RGB_565,
+              "raster::PixelFormat must match WINDOW_FORMAT_RGB_565");
+
+// Upper bound on tile threads per renderer; more than the big+medium
+// cores of current phones just adds wakeup latency
+static const int kMaxRenderThreads = 8;
+
+// TRACE EVENTS: per-frame facts, recorded as numbers and formatted later.
+// Logging these every frame would format a string and write to logd
+// 60 times a second on the render thread.
+enum TraceEvent {
+    kTraceFrame,    // width, height, stride, format
+    kTraceDamage,   // pixels touched, dirty rects, buffer age, full repaint
+    kTraceSnapshot, // pipelined: sequence, snapshots skipped so far, age in us
+    kTraceEventCount
+};
+
+static const trace::EventInfo kTraceEvents[kTraceEventCount] = {
+    {"frame", "%dx%d, stride=%d, format=%d"},
+    {"damage", "%d px in %d rects, buffer age %d, full=%d"},
+    {"snapshot", "#%d, %d skipped so far, %d us old"},
+};
+
+// AChoreographer_postFrameCallback64 is API 29, and we support 28, so it
+// is looked up at runtime, once per process. (The older postFrameCallback
+// passes frame time as a 32-bit long on armeabi-v7a, which overflows after
+// ~2 seconds.) libandroid.so stays loaded for the life of the app anyway,
+// so the handle is never dlclose()d.
+using PostFrameCallback64Fn = void (*)(AChoreographer*, AChoreographer_frameCallback64, void*);
+
+static PostFrameCallback64Fn postFrameCallback64() {
+    static std::once_flag once;
+    static PostFrameCallback64Fn function = nullptr;
+    std::call_once(once, [] {
+        void* libandroid = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (libandroid) {
+            function = reinterpret_cast<PostFrameCallback64Fn>(
+                    dlsym(libandroid, "AChoreographer_postFrameCallback64"));
+        }
+    });
+    return function;
+}
+
+static int64_t monotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+static std::atomic<int> g_nextRendererId{1};
+
+const char* rendererStateName(RendererState state) {
+    switch (state) {
+        case RendererState::Created: return "created";
+        case RendererState::Running: return "running";
+        case RendererState::Paused: return "paused";
+        case RendererState::Destroyed: return "destroyed";
+    }
+    return "?";
+}
+
+Renderer::Renderer()
+    : m_id(g_nextRendererId.fetch_add(1)),
+      m_list(m_arena),
+      m_pacer(m_clock, frame::periodForHz(60.0)),
+      m_governor(frame::periodForHz(60.0)),
+      m_simPacer(m_clock, frame::periodForHz(60.0)),
+      m_frameTimer(m_clock, m_timings),
+      m_trace(kTraceEvents, kTraceEventCount) {
+    LOGI("[%d] Renderer created", m_id);
+}
+
+Renderer::~Renderer() {
+    destroy();
+}
+
+bool Renderer::transition(RendererState from, RendererState to) {
+    if (m_state.compare_exchange_strong(from, to, std::memory_order_acq_rel)) {
+        return true;
+    }
+    // `from` now holds the actual state
+    LOGE("[%d] Can't go %s -> %s while %s", m_id, rendererStateName(from),
+         rendererStateName(to), rendererStateName(state()));
+    return false;
+}
+
+void Renderer::setResolutionScaling(bool enabled, float minScale) {
+    m_minResolutionScale.store(minScale, std::memory_order_relaxed);
+    m_resolutionScaling.store(enabled, std::memory_order_relaxed);
+}
+
+void Renderer::setInternalScale(float scale, bool bilinear) {
+    m_internalScaleSetting.store(scale, std::memory_order_relaxed);
+    m_upscaleBilinear.store(bilinear, std::memory_order_relaxed);
+}
+
+void Renderer::setViewSize(int width, int height) {
+    m_viewWidth.store(width, std::memory_order_relaxed);
+    m_viewHeight.store(height, std::memory_order_relaxed);
+}
+
+bool Renderer::start(ANativeWindow* window) {
+    if (!window) {
+        LOGE("[%d] start() without a window", m_id);
+        return false;
+    }
+
+    // Created or Paused -> Running (the CAS fails if another call got in first)
+    RendererState previous = state();
+    if (previous != RendererState::Created && previous != RendererState::Paused) {
+        LOGE("[%d] Can't start while %s", m_id, rendererStateName(previous));
+        ANativeWindow_release(window);
+        return false;
+    }
+    if (!transition(previous, RendererState::Running)) {
+        ANativeWindow_release(window);
+        return false;
+    }
+
+    // Log window dimensions
+    m_window = window;
+    int width = ANativeWindow_getWidth(m_window);
+    int height = ANativeWindow_getHeight(m_window);
+    int format = ANativeWindow_getFormat(m_window);
+    LOGI("[%d] Window: %dx%d, format=%d", m_id, width, height, format);
+
+    // New window, new buffers: start with a full repaint
+    m_damage = raster::DamageTracker();
+
+    // Set buffer format (optional, but good practice)
+    // WINDOW_FORMAT_RGBA_8888: 32-bit RGBA (8 bits per channel)
+    // WINDOW_FORMAT_RGB_565: 16-bit, half the memory traffic (opt-in)
+    int outputMode = m_outputMode.load(std::memory_order_relaxed);
+    int bufferFormat = outputMode == kOutputRgba8888 ? WINDOW_FORMAT_RGBA_8888
+                                                     : WINDOW_FORMAT_RGB_565;
+    ANativeWindow_setBuffersGeometry(m_window, 0, 0, bufferFormat);
+    m_bufferFormat = bufferFormat;
+
+    // DYNAMIC RESOLUTION: start every surface at full resolution. (0, 0)
+    // above dropped any size a previous run asked for, so the window
+    // reports the view's size again.
+    m_scalingActive = m_resolutionScaling.load(std::memory_order_relaxed);
+    m_geometryWidth = ANativeWindow_getWidth(m_window);
+    m_geometryHeight = ANativeWindow_getHeight(m_window);
+    setViewSize(m_geometryWidth, m_geometryHeight);
+    m_renderScale.store(1.0f, std::memory_order_relaxed);
+    if (m_scalingActive) {
+        frame::GovernorConfig config;
+        config.minScale = m_minResolutionScale.load(std::memory_order_relaxed);
+        m_governor = frame::ResolutionGovernor(
+                frame::periodForHz(m_refreshRate.load(std::memory_order_relaxed)), config);
+        LOGI("[%d] Dynamic resolution: %d steps down to %.2fx, budget %.2f ms", m_id,
+             m_governor.levelCount() - 1, m_governor.config().minScale,
+             m_governor.budget() / 1e6);
+    }
+
+    // INTERNAL RESOLUTION: the upscale kernels are 32-bit only. Fixed for
+    // the whole run (the simulation thread reads it too).
+    m_internalScale = m_internalScaleSetting.load(std::memory_order_relaxed);
+    if (m_internalScale < 1.0f && bufferFormat != WINDOW_FORMAT_RGBA_8888) {
+        LOGE("[%d] Internal resolution needs RGBA_8888 output, rendering at full size", m_id);
+        m_internalScale = 1.0f;
+    }
+    if (m_internalScale < 1.0f) {
+        raster::UpscaleFilter filter = m_upscaleBilinear.load(std::memory_order_relaxed)
+                                               ? raster::UpscaleFilter::Bilinear
+                                               : raster::UpscaleFilter::Nearest;
+        m_upscaler.setFilter(filter);
+        m_presentUpscaler.setFilter(filter);
+        m_internalValid = false;
+        LOGI("[%d] Internal resolution %.2fx, %s upscale (%s)", m_id, m_internalScale,
+             filter == raster::UpscaleFilter::Bilinear ? "bilinear" : "nearest",
+             raster::activeUpscaleKernel().name);
+    }
+
+    // Persistent tile workers: created once per surface, not per frame
+    int threads = std::min(raster::ThreadPool::hardwareThreads(), kMaxRenderThreads);
+    m_pool = new raster::ThreadPool(threads);
+    m_tiles = new raster::TileRenderer(*m_pool);
+    m_tiles->setDither(outputMode == kOutputRgb565Dither);
+    LOGI("[%d] Tile renderer: %d threads, buffer format %d%s", m_id, m_pool->threadCount(),
+         bufferFormat, m_tiles->dither() ? " (dithered)" : "");
+
+    // PIPELINED MODE: the simulation thread starts first so the first
+    // snapshot is (usually) ready by the first vsync. Without it we just
+    // render the old way.
+    m_pipelineActive = m_pipelined.load(std::memory_order_relaxed);
+    m_timeline.reset();  // The time spent paused isn't simulated
+    if (m_pipelineActive) {
+        m_snapshots.reset();
+        int simResult = pthread_create(&m_simThread, nullptr, simulationMain, this);
+        if (simResult != 0) {
+            LOGE("[%d] Failed to create simulation thread: %d, not pipelining", m_id, simResult);
+            m_simThread = 0;
+            m_pipelineActive = false;
+        }
+    }
+
+    // PRESENT THREAD MODE: back buffers in the format we just asked for.
+    // The present thread starts first and waits for the first frame.
+    int presentBuffers = m_presentBuffers.load(std::memory_order_relaxed);
+    if (presentBuffers >= 2) {
+        m_backBufferFormat = static_cast<raster::PixelFormat>(bufferFormat);
+        m_presentQueue = new raster::PresentQueue(presentBuffers);
+        int presentResult = pthread_create(&m_presentThread, nullptr, presentMain, this);
+        if (presentResult != 0) {
+            LOGE("[%d] Failed to create present thread: %d, presenting from the render thread",
+                 m_id, presentResult);
+            m_presentThread = 0;
+            delete m_presentQueue;
+            m_presentQueue = nullptr;
+        }
+    }
+
+    // pthread_create(): Create a new thread
+    // Similar to new Thread().start() in Java
+    // Params: thread id, attributes, start function, argument
+    int result = pthread_create(&m_thread, nullptr, threadMain, this);
+    if (result != 0) {
+        LOGE("[%d] Failed to create render thread: %d", m_id, result);
+        m_thread = 0;
+        m_state.store(previous, std::memory_order_release);
+        if (m_pipelineActive) {
+            // It sees the state change at its next step
+            pthread_join(m_simThread, nullptr);
+            m_simThread = 0;
+            m_pipelineActive = false;
+        }
+        if (m_presentQueue) {
+            m_presentQueue->stop();
+            pthread_join(m_presentThread, nullptr);
+            m_presentThread = 0;
+            delete m_presentQueue;
+            m_presentQueue = nullptr;
+        }
+        delete m_tiles;
+        m_tiles = nullptr;
+        delete m_pool;
+        m_pool = nullptr;
+        ANativeWindow_release(m_window);
+        m_window = nullptr;
+        return false;
+    }
+
+    LOGI("[%d] Render thread created successfully", m_id);
+    return true;
+}
+
+bool Renderer::pause() {
+    if (!transition(RendererState::Running, RendererState::Paused)) {
+        return false;
+    }
+
+    // The render thread sees the state change at its next frame. In vsync
+    // mode it may be asleep in ALooper_pollOnce(): wake it up. (If it
+    // hasn't published its looper yet, the poll timeout catches it.)
+    if (ALooper* looper = m_looper.load(std::memory_order_acquire)) {
+        ALooper_wake(looper);
+    }
+
+    // It may also be waiting for a free back buffer: stop the queue, which
+    // wakes both it and the present thread
+    if (m_presentQueue) {
+        m_presentQueue->stop();
+    }
+
+    // pthread_join(): Block until thread terminates
+    // Similar to Thread.join() in Java
+    LOGI("[%d] Waiting for render thread to stop...", m_id);
+    pthread_join(m_thread, nullptr);
+    m_thread = 0;
+    LOGI("[%d] Render thread stopped", m_id);
+
+    // The simulation thread stops at its next step (at most one period)
+    if (m_pipelineActive) {
+        pthread_join(m_simThread, nullptr);
+        m_simThread = 0;
+        m_pipelineActive = false;
+        LOGI("[%d] Simulation thread stopped", m_id);
+    }
+
+    // The present thread finishes the frame it is posting (if any) and exits
+    if (m_presentQueue) {
+        pthread_join(m_presentThread, nullptr);
+        m_presentThread = 0;
+        delete m_presentQueue;
+        m_presentQueue = nullptr;
+        LOGI("[%d] Present thread stopped", m_id);
+    }
+
+    // The render thread took a reference so the looper outlived it
+    if (ALooper* looper = m_looper.exchange(nullptr, std::memory_order_acq_rel)) {
+        ALooper_release(looper);
+    }
+
+    // Stop the tile workers (the render thread no longer uses them)
+    delete m_tiles;
+    m_tiles = nullptr;
+    delete m_pool;
+    m_pool = nullptr;
+
+    // Release native window
+    // IMPORTANT: This frees resources!
+    // Failure to call this will leak memory
+    LOGI("[%d] Releasing native window", m_id);
+    ANativeWindow_release(m_window);
+    m_window = nullptr;
+    return true;
+}
+
+void Renderer::destroy() {
+    if (state() == RendererState::Running) {
+        pause();
+    }
+    RendererState previous = m_state.exchange(RendererState::Destroyed,
+                                              std::memory_order_acq_rel);
+    if (previous != RendererState::Destroyed) {
+        LOGI("[%d] Renderer destroyed (was %s)", m_id, rendererStateName(previous));
+    }
+}
+
+bool Renderer::copyTimingSnapshot(void* out, size_t capacity) {
+    if (capacity < sizeof(m_timingSnapshot)) {
+        return false;
+    }
+
+    // Sorting happens here, on the caller's thread; the render thread
+    // keeps publishing meanwhile and is never blocked by this
+    frame::TimingSummary summary = frame::summarizeTimings(m_timings);
+
+    // Packed and copied out under one lock: another caller can't rewrite
+    // the array while this one is copying it
+    std::lock_guard<std::mutex> guard(m_snapshotLock);
+    frame::packTimingSummary(summary, m_timingSnapshot);
+    memcpy(out, m_timingSnapshot, sizeof(m_timingSnapshot));
+    return true;
+}
+
+void Renderer::dumpTrace() {
+    // In release the LOGD below is compiled out, so formatting would be wasted
+    if (NATIVE_LOG_LEVEL > NATIVE_LOG_DEBUG) {
+        return;
+    }
+    int id = m_id;
+    size_t traced = m_trace.drain(
+            [](const char* line, void* user) {
+                LOGD("[%d] trace %s", *static_cast<int*>(user), line);
+            },
+            &id);
+    LOGI("[%d] Trace: %zu events drained, %llu lost", m_id, traced,
+         static_cast<unsigned long long>(m_trace.lost()));
+}
+
+void* Renderer::threadMain(void* self) {
+    static_cast<Renderer*>(self)->renderLoop();
+    return nullptr;
+}
+
+void* Renderer::simulationMain(void* self) {
+    static_cast<Renderer*>(self)->simulationLoop();
+    return nullptr;
+}
+
+void* Renderer::presentMain(void* self) {
+    static_cast<Renderer*>(self)->presentLoop();
+    return nullptr;
+}
+
+/**
+ * onVsync(): AChoreographer frame callback (VSYNC MODE)
+ *
+ * Runs on the render thread's ALooper once per display refresh.
+ * frameTimeNanos is the vsync timestamp on CLOCK_MONOTONIC.
+ * Each callback draws one frame and re-posts itself for the next vsync;
+ * if the frame took longer than a period, the vsyncs it overlapped are
+ * simply never delivered, which the pacer counts as missed.
+ */
+void Renderer::onVsync(int64_t frameTimeNanos, void* self) {
+    auto* renderer = static_cast<Renderer*>(self);
+    if (renderer->state() != RendererState::Running) {
+        return;  // Don't re-post; renderLoop() is about to exit
+    }
+
+    renderer->m_pacer.onVsync(frameTimeNanos);
+    renderer->drawFrame();
+    postFrameCallback64()(renderer->m_choreographer, onVsync, renderer);
+}
+
+/**
+ * renderLoop(): Continuous rendering thread
+ *
+ * Same concept as Phase 2's RenderThread.run()
+ * Runs in background, continuously draws frames
+ *
+ * FRAME PACING: The original loop was "drawFrame(); usleep(16666);" so
+ * the real period was draw time + 16.6 ms and drifted against the display.
+ * Now frames are driven one of two ways:
+ * - VSYNC MODE (API 29+): AChoreographer calls onVsync() every refresh.
+ *   That needs an ALooper on this thread, which we poll until stopped.
+ *   (Choreographer and looper are per thread, so each Renderer gets
+ *   its own callbacks.)
+ * - TIMER MODE (fallback): the pacer sleeps with clock_nanosleep until
+ *   absolute deadlines one refresh period apart.
+ *
+ * pthread: POSIX threads (standard C/C++ threading)
+ * Similar to Java's Thread class
+ *
+ * Lookup: "pthread tutorial", "AChoreographer", "clock_nanosleep"
+ */
+void Renderer::renderLoop() {
+    LOGI("[%d] Render loop started", m_id);
+
+    float refreshRate = m_refreshRate.load(std::memory_order_relaxed);
+    m_pacer.setPeriod(frame::periodForHz(refreshRate));
+    m_pacer.resetStats();
+
+    m_choreographer = nullptr;
+    if (postFrameCallback64()) {
+        // AChoreographer_getInstance() needs a looper on the calling thread.
+        // The extra reference keeps it valid for pause()'s ALooper_wake()
+        // even after this thread exits; pause() drops it.
+        ALooper* looper = ALooper_prepare(0);
+        ALooper_acquire(looper);
+        m_looper.store(looper, std::memory_order_release);
+        m_choreographer = AChoreographer_getInstance();
+    }
+
+    if (m_choreographer) {
+        LOGI("[%d] Frame pacing: AChoreographer vsync callbacks (%.1f Hz)", m_id, refreshRate);
+        postFrameCallback64()(m_choreographer, onVsync, this);
+
+        // Callbacks run inside pollOnce(). pause() wakes the looper; the
+        // timeout is only a fallback if vsyncs stop (screen off).
+        while (state() == RendererState::Running) {
+            ALooper_pollOnce(100, nullptr, nullptr, nullptr);
+        }
+    } else {
+        LOGI("[%d] Frame pacing: clock_nanosleep deadlines every %.2f ms", m_id,
+             m_pacer.period() / 1e6);
+        while (state() == RendererState::Running) {
+            // Draw one frame, then sleep until the next refresh deadline
+            // (however long the frame took)
+            drawFrame();
+            m_pacer.waitForNextFrame();
+        }
+    }
+
+    LOGI("[%d] Render loop stopped", m_id);
+}
+
+/**
+ * simulationLoop(): Producer side of PIPELINED MODE
+ *
+ * Wakes once per refresh period (its own FramePacer, on the same
+ * deadline grid idea as the render thread's timer mode), runs the fixed
+ * animation steps due by then (stepAnimation()) and records the
+ * interpolated state into a free SceneSnapshot: display list, culled and
+ * sorted, plus the time it was made. Everything drawFrame() would do
+ * before ANativeWindow_lock(), minus damage tracking (that depends on
+ * which buffer the render thread gets back, so it stays there).
+ *
+ * If all snapshots are taken (the render thread is behind and holding
+ * one, two more waiting), this step's snapshot is dropped; the animation
+ * advances anyway, so the render thread's next one is up to date.
+ *
+ * Lookup: "game loop simulation render thread", "pipelined rendering"
+ */
+void Renderer::simulationLoop() {
+    LOGI("[%d] Simulation loop started", m_id);
+
+    m_simPacer.setPeriod(frame::periodForHz(m_refreshRate.load(std::memory_order_relaxed)));
+    m_simPacer.resetStats();
+
+    while (state() == RendererState::Running) {
+        m_simPacer.waitForNextFrame();
+
+        // getWidth/getHeight are safe from any thread; the window stays
+        // valid until pause() has joined this thread
+        int width = 0;
+        int height = 0;
+        rasterSize(ANativeWindow_getWidth(m_window), ANativeWindow_getHeight(m_window), &width,
+                   &height);
+        float scale = m_renderScale.load(std::memory_order_relaxed) * m_internalScale;
+
+        int64_t now = m_clock.now();
+        raster::SceneState shown = stepAnimation(now);
+        if (raster::SceneSnapshot* snapshot = m_snapshots.beginWrite()) {
+            raster::recordSnapshot(*snapshot, width, height, shown, now, m_simSteps, scale);
+            m_snapshots.commitWrite();
+        }
+        m_simSteps++;
+    }
+
+    LOGI("[%d] Simulation loop stopped after %llu steps (%lld fixed animation steps)", m_id,
+         static_cast<unsigned long long>(m_simSteps),
+         static_cast<long long>(m_timeline.stats().steps));
+}
+
+/**
+ * presentLoop(): The present thread (PRESENT THREAD MODE)
+ *
+ * Takes the newest finished back buffer, locks the window with the
+ * region that changed since the last frame we posted, copies the rect
+ * the lock hands back (it can grow it, e.g. to the whole buffer when
+ * copy-back wasn't possible; the back buffer is always complete, so any
+ * rect can be copied), and posts. ANativeWindow_lock() blocking because
+ * SurfaceFlinger holds every window buffer only stalls this thread.
+ * A frame whose lock fails never reaches the window, so its damage is
+ * kept and merged into the next frame's: the window still gets every
+ * pixel that changed since the last frame it showed.
+ *
+ * Lookup: "ANativeWindow_lock blocking", "BufferQueue dequeue"
+ */
+void Renderer::presentLoop() {
+    LOGI("[%d] Present loop started: %d back buffers", m_id, m_presentQueue->bufferCount());
+    bool formatWarned = false;
+
+    raster::Rect damage;
+    raster::Rect unpresented;  // Damage of frames that never got a window buffer
+    while (raster::BackBuffer* back = m_presentQueue->acquireForPresent(&damage)) {
+        // Back buffer coordinates, like `damage` (clipped: the size may
+        // have changed since)
+        const raster::Surface& source = back->surface;
+        damage = raster::intersectRects(raster::uniteRects(damage, unpresented),
+                                        raster::makeRect(0, 0, source.width, source.height));
+        unpresented = raster::Rect();
+        if (damage.isEmpty()) {
+            // Nothing changed since the frame on screen
+            m_presentQueue->releasePresented(back);
+            continue;
+        }
+
+        // INTERNAL RESOLUTION (or a size change in flight): the back buffer
+        // is smaller than the window, so it is stretched instead of copied,
+        // and what changed in the window is the stretched damage
+        raster::Rect sourceDamage = damage;
+        int windowWidth = ANativeWindow_getWidth(m_window);
+        int windowHeight = ANativeWindow_getHeight(m_window);
+        if (source.width != windowWidth || source.height != windowHeight) {
+            damage = raster::upscaledRect(damage, source.width, source.height, windowWidth,
+                                          windowHeight);
+        }
+
+        int64_t start = monotonicNanos();
+        ANativeWindow_Buffer buffer;
+        ARect dirtyBounds = {damage.left, damage.top, damage.right, damage.bottom};
+        if (ANativeWindow_lock(m_window, &buffer, &dirtyBounds) < 0) {
+            LOGE("[%d] Failed to lock window buffer", m_id);
+            unpresented = sourceDamage;
+            m_presentQueue->releasePresented(back);
+            continue;
+        }
+        int64_t locked = monotonicNanos();
+
+        raster::Surface target;
+        target.bits = buffer.bits;
+        target.width = buffer.width;
+        target.height = buffer.height;
+        target.stride = buffer.stride;
+        target.format = static_cast<raster::PixelFormat>(buffer.format);
+        raster::Rect copyRect = raster::makeRect(dirtyBounds.left, dirtyBounds.top,
+                                                 dirtyBounds.right, dirtyBounds.bottom);
+        bool sameSize = target.width == source.width && target.height == source.height;
+        bool written = sameSize ? raster::copyPixels(target, source, copyRect)
+                                : m_presentUpscaler.upscale(target, source, copyRect);
+        if (!written && !formatWarned) {
+            LOGE("[%d] Window format %d differs from the back buffers' %d, not copying",
+                 m_id, buffer.format, static_cast<int>(back->surface.format));
+            formatWarned = true;
+        }
+        int64_t submitted = back->submitNanos;
+        m_presentQueue->releasePresented(back);
+        int64_t copied = monotonicNanos();
+
+        if (ANativeWindow_unlockAndPost(m_window) < 0) {
+            LOGE("[%d] Failed to unlock and post window buffer", m_id);
+        }
+        int64_t posted = monotonicNanos();
+
+        m_presentLockNanos += locked - start;
+        m_presentCopyNanos += copied - locked;
+        m_presentPostNanos += posted - copied;
+        // submitNanos is std::chrono::steady_clock, which is CLOCK_MONOTONIC
+        // on Android too
+        m_presentLatencyNanos += posted - submitted;
+        m_presentBytes += raster::intersectRects(copyRect, raster::makeRect(0, 0, target.width,
+                                                                    target.height)).area() *
+                          raster::bytesPerPixel(target.format);
+        if (++m_presentFrames >= 120) {
+            logPresentStats();
+        }
+    }
+
+    LOGI("[%d] Present loop stopped", m_id);
+}
+
+/**
+ * drawFrame(): Draw a single frame to the native window
+ *
+ * This is the C++ equivalent of Phase 1/2's Canvas drawing.
+ * But instead of Canvas.drawCircle(), we manipulate pixels directly.
+ *
+ * ANativeWindow API pattern:
+ * 1. ANativeWindow_lock() - Get buffer to draw into (just the dirty rect)
+ * 2. Manipulate pixels directly (only where something changed)
+ * 3. ANativeWindow_unlockAndPost() - Display the buffer
+ *
+ * KEY CONCEPT: ANativeWindow_Buffer
+ * This struct contains:
+ * - bits: Pointer to pixel data (ARGB_8888 format)
+ * - width, height: Buffer dimensions
+ * - stride: Bytes per row (may be > width*4 due to padding)
+ * - format: Pixel format (e.g., WINDOW_FORMAT_RGBA_8888)
+ *
+ * PIXEL FORMAT: RGBA_8888, RGBX_8888 or RGB_565
+ * RGBA/RGBX pixels are 4 bytes [R][G][B][A/X]; RGB_565 pixels are 2 bytes.
+ * The format is checked ONCE per lock: raster::pixelKernels() returns the
+ * kernels compiled for it, so the pixel loops never test the format.
+ *
+ * Lookup: "ANativeWindow_Buffer", "Android pixel formats"
+ */
+void Renderer::drawFrame() {
+    // DYNAMIC RESOLUTION: resize the buffers if the governor (or the view)
+    // asked for it last frame
+    applyResolution();
+    float scale = m_renderScale.load(std::memory_order_relaxed);
+
+    // PIPELINED: the simulation thread has already recorded the frame.
+    // Take the newest snapshot (older ones are skipped). If nothing new
+    // arrived since the last frame, nothing changed on screen either, so
+    // don't lock and post a buffer at all.
+    const raster::SceneSnapshot* snapshot = nullptr;
+    if (m_pipelineActive) {
+        snapshot = m_snapshots.acquireNewest();
+        if (!snapshot) {
+            return;
+        }
+    }
+
+    int64_t frameStart = monotonicNanos();
+    m_frameTimer.beginFrame();
+
+    // ========== DAMAGE TRACKING ==========
+    // Only the circle moves, so only the pixels it left and the pixels it
+    // now covers need repainting. Tell the tracker where every command goes
+    // this frame (before locking, since the lock needs the dirty rect up front).
+    // (With an internal resolution, all of it happens in the small buffer.)
+    int windowWidth = ANativeWindow_getWidth(m_window);
+    int windowHeight = ANativeWindow_getHeight(m_window);
+    int rasterWidth = 0;
+    int rasterHeight = 0;
+    rasterSize(windowWidth, windowHeight, &rasterWidth, &rasterHeight);
+    float sceneScale = scale * m_internalScale;
+    m_damage.beginFrame(rasterWidth, rasterHeight);
+
+    // ========== RECORD THE FRAME ==========
+    // Describe the frame as a display list first; no pixels yet.
+    // Last frame's commands are dropped by resetting the arena (no free()).
+    // In pipelined mode the snapshot's list is used as is, unless the
+    // window changed size (or resolution scale) since it was recorded;
+    // otherwise the animation is stepped up to this frame first.
+    const raster::DisplayList* list = &m_list;
+    raster::SceneState shown;
+    const raster::SceneState* scene = &shown;
+    if (!snapshot) {
+        shown = stepAnimation(frameStart);
+    } else {
+        scene = &snapshot->state;
+        m_snapshotAgeNanos += frameStart - snapshot->timestamp;
+        m_snapshotAges++;
+        m_trace.record(kTraceSnapshot, static_cast<int32_t>(snapshot->sequence),
+                       static_cast<int32_t>(m_snapshots.stats().skipped),
+                       static_cast<int32_t>((frameStart - snapshot->timestamp) / 1000));
+    }
+    if (snapshot && snapshot->width == rasterWidth && snapshot->height == rasterHeight &&
+        snapshot->scale == sceneScale) {
+        list = &snapshot->list;
+    } else {
+        m_arena.reset();
+        m_list.reset();
+        raster::buildScene(m_list, rasterWidth, rasterHeight, *scene, sceneScale);
+        m_list.cull(raster::makeRect(0, 0, rasterWidth, rasterHeight));
+        m_list.sortByLayer();
+    }
+
+    raster::addDisplayListDamage(m_damage, *list);
+    raster::Rect lockRect = m_damage.finishScene();
+    m_frameTimer.endStage(frame::kStageRecord);
+
+    // PRESENT THREAD MODE: draw into a back buffer, never touch the window
+    if (m_presentQueue) {
+        raster::Surface drawn;
+        bool submitted = drawToBackBuffer(*list, lockRect, rasterWidth, rasterHeight, &drawn);
+        if (snapshot) {
+            m_snapshots.release();
+        }
+        if (submitted) {
+            finishFrame(drawn, frameStart);
+        }
+        return;
+    }
+
+    // INTERNAL RESOLUTION: rasterize small, stretch into the window buffer
+    if (m_internalScale < 1.0f) {
+        raster::Surface drawn;
+        bool posted = drawUpscaled(*list, lockRect, rasterWidth, rasterHeight, &drawn);
+        if (snapshot) {
+            m_snapshots.release();
+        }
+        if (posted) {
+            finishFrame(drawn, frameStart);
+        }
+        return;
+    }
+
+    // ANativeWindow_Buffer: Struct that holds buffer info
+    ANativeWindow_Buffer buffer;
+
+    // LOCK: Get exclusive access to buffer
+    // Similar to SurfaceHolder.lockCanvas(dirty) or TextureView.lockCanvas(dirty)
+    // But this is the native C API
+    //
+    // inOutDirtyBounds: the region we intend to redraw. The Surface copies
+    // the last posted frame into everything outside it, and writes back the
+    // region we actually MUST redraw (the whole buffer if it couldn't copy).
+    // Returns 0 on success, negative on error
+    ARect dirtyBounds = {lockRect.left, lockRect.top, lockRect.right, lockRect.bottom};
+    if (ANativeWindow_lock(m_window, &buffer, &dirtyBounds) < 0) {
+        LOGE("[%d] Failed to lock window buffer", m_id);
+        if (snapshot) {
+            m_snapshots.release();
+        }
+        return;
+    }
+    m_frameTimer.endStage(frame::kStageLock);
+
+    // BUFFER INFO:
+    // buffer.bits: Pointer to pixel data
+    // buffer.width: Width in pixels
+    // buffer.height: Height in pixels
+    // buffer.stride: Row stride in PIXELS (not bytes!)
+    // buffer.format: Pixel format (WINDOW_FORMAT_*)
+    //
+    // IMPORTANT: stride may be > width due to alignment requirements
+    // Always use stride when calculating row offsets
+
+    int width = buffer.width;
+    int height = buffer.height;
+    int stride = buffer.stride;
+
+    m_trace.record(kTraceFrame, width, height, stride, buffer.format);
+
+    // Hand the locked buffer to the raster core as a plain Surface
+    // Everything from here to unlockAndPost is pure pixel work that
+    // also runs on the Linux host build (see raster/ and bench/)
+    raster::Surface surface;
+    surface.bits = buffer.bits;
+    surface.width = width;
+    surface.height = height;
+    surface.stride = stride;
+    surface.format = static_cast<raster::PixelFormat>(buffer.format);
+
+    // Pick the raster kernels for this buffer's format (once per lock)
+    if (!raster::pixelKernels(surface.format)) {
+        LOGE("[%d] Unsupported buffer format %d", m_id, buffer.format);
+        ANativeWindow_unlockAndPost(m_window);
+        if (snapshot) {
+            m_snapshots.release();
+        }
+        return;
+    }
+
+    // The buffer can come back a different size than the window reported
+    // (e.g. mid-rotation); re-record so the scene matches the real buffer
+    if (width != windowWidth || height != windowHeight) {
+        m_arena.reset();
+        m_list.reset();
+        raster::buildScene(m_list, width, height, *scene, scale);
+        list = &m_list;
+    }
+
+    // Which rects of THIS buffer are stale (depends on how many frames ago
+    // we last drew into it; an unfamiliar buffer gets the whole dirty rect)
+    raster::Rect returnedBounds = raster::makeRect(dirtyBounds.left, dirtyBounds.top,
+                                                   dirtyBounds.right, dirtyBounds.bottom);
+    const raster::DamageRegion& repaint = m_damage.resolve(surface, returnedBounds);
+
+    // Clear + draw every dirty tile on the worker pool. render() returns
+    // only after all tiles are done, so the buffer is complete before
+    // we post it below.
+    m_tiles->render(surface, *list, repaint);
+    m_frameTimer.endStage(frame::kStageRaster);
+
+    // The pixels are done, so the snapshot's slot can be refilled
+    if (snapshot) {
+        m_snapshots.release();
+    }
+
+    // UNLOCK: Post buffer to display
+    // Similar to unlockCanvasAndPost() in Phase 2
+    // This makes the frame visible on screen
+    if (ANativeWindow_unlockAndPost(m_window) < 0) {
+        LOGE("[%d] Failed to unlock and post window buffer", m_id);
+    }
+    m_frameTimer.endStage(frame::kStagePost);
+    finishFrame(surface, frameStart);
+}
+
+/**
+ * drawToBackBuffer(): PRESENT THREAD MODE half of drawFrame()
+ *
+ * Same pixels, different target: one of our own back buffers instead of
+ * the locked window buffer. The stage timings keep their slots, with
+ * "lock" meaning "wait for a free back buffer" and "post" meaning
+ * "submit to the present thread".
+ *
+ * A back buffer has no copy-back. Outside the damage rect it holds
+ * whatever we drew into it `age` frames ago, which the DamageTracker
+ * knows how to patch up (it recognizes the buffer by its bits pointer,
+ * just like window buffers). New or reallocated memory has unknown
+ * contents, so it is declared fully dirty.
+ */
+bool Renderer::drawToBackBuffer(const raster::DisplayList& list, const raster::Rect& damage,
+                                int width, int height, raster::Surface* drawn) {
+    // Waits only if every back buffer is queued for (or being) presented
+    raster::BackBuffer* back = m_presentQueue->acquireForRaster(width, height, m_backBufferFormat);
+    if (!back) {
+        return false;  // Stopping (or out of memory)
+    }
+    m_frameTimer.endStage(frame::kStageLock);
+
+    const raster::Surface& surface = back->surface;
+    m_trace.record(kTraceFrame, surface.width, surface.height, surface.stride,
+                   static_cast<int32_t>(surface.format));
+
+    bool knownContents = back->age > 0 && back->age <= raster::DamageTracker::kMaxBufferAge;
+    raster::Rect returnedBounds = knownContents ? damage
+                                                : raster::makeRect(0, 0, width, height);
+    const raster::DamageRegion& repaint = m_damage.resolve(surface, returnedBounds);
+    m_tiles->render(surface, list, repaint);
+    m_frameTimer.endStage(frame::kStageRaster);
+
+    // `damage` covers everything that changed since the previous frame,
+    // which is what the present thread has to copy into the window
+    *drawn = surface;
+    m_presentQueue->submit(back, damage);
+    m_frameTimer.endStage(frame::kStagePost);
+    return true;
+}
+
+/**
+ * drawUpscaled(): INTERNAL RESOLUTION half of drawFrame()
+ *
+ * The scene goes into m_internal, a buffer of our own at rasterWidth x
+ * rasterHeight. It is the only buffer, so after the first frame it always
+ * holds the previous frame and only the damage needs repainting. Then the
+ * window is locked with the damage scaled up to window pixels, and
+ * whatever rect the lock hands back is stretched in (the internal buffer
+ * is always complete, so any rect can be). The stretch is timed as part
+ * of the raster stage.
+ */
+bool Renderer::drawUpscaled(const raster::DisplayList& list, const raster::Rect& damage,
+                            int width, int height, raster::Surface* drawn) {
+    if (m_internal.width != width || m_internal.height != height) {
+        m_internalPixels.assign(static_cast<size_t>(width) * height, 0);
+        m_internal.bits = m_internalPixels.data();
+        m_internal.width = width;
+        m_internal.height = height;
+        m_internal.stride = width;
+        m_internal.format = static_cast<raster::PixelFormat>(m_bufferFormat);
+        m_internalValid = false;
+    }
+    raster::Rect returnedBounds = m_internalValid ? damage : raster::makeRect(0, 0, width, height);
+    const raster::DamageRegion& repaint = m_damage.resolve(m_internal, returnedBounds);
+    m_tiles->render(m_internal, list, repaint);
+    m_internalValid = true;
+    m_frameTimer.endStage(frame::kStageRaster);
+
+    raster::Rect windowDamage = raster::upscaledRect(returnedBounds, width, height,
+                                                     ANativeWindow_getWidth(m_window),
+                                                     ANativeWindow_getHeight(m_window));
+    ANativeWindow_Buffer buffer;
+    ARect dirtyBounds = {windowDamage.left, windowDamage.top, windowDamage.right,
+                         windowDamage.bottom};
+    if (ANativeWindow_lock(m_window, &buffer, &dirtyBounds) < 0) {
+        LOGE("[%d] Failed to lock window buffer", m_id);
+        return false;
+    }
+    m_frameTimer.endStage(frame::kStageLock);
+
+    raster::Surface surface;
+    surface.bits = buffer.bits;
+    surface.width = buffer.width;
+    surface.height = buffer.height;
+    surface.stride = buffer.stride;
+    surface.format = static_cast<raster::PixelFormat>(buffer.format);
+    m_trace.record(kTraceFrame, surface.width, surface.height, surface.stride, buffer.format);
+
+    raster::Rect stretchRect = raster::makeRect(dirtyBounds.left, dirtyBounds.top,
+                                                dirtyBounds.right, dirtyBounds.bottom);
+    if (!m_upscaler.upscale(surface, m_internal, stretchRect, m_pool)) {
+        LOGE("[%d] Can't upscale into buffer format %d", m_id, buffer.format);
+    }
+    m_frameTimer.endStage(frame::kStageRaster);
+
+    if (ANativeWindow_unlockAndPost(m_window) < 0) {
+        LOGE("[%d] Failed to unlock and post window buffer", m_id);
+    }
+    m_frameTimer.endStage(frame::kStagePost);
+    *drawn = surface;
+    return true;
+}
+
+// What the scene is rasterized at for a window this size
+void Renderer::rasterSize(int windowWidth, int windowHeight, int* width, int* height) const {
+    if (m_internalScale < 1.0f) {
+        frame::scaledSize(windowWidth, windowHeight, m_internalScale, width, height);
+    } else {
+        *width = windowWidth;
+        *height = windowHeight;
+    }
+}
+
+// Common end of a drawn frame: timings, statistics, resolution
+void Renderer::finishFrame(const raster::Surface& surface, int64_t frameStart) {
+    m_frameTimer.endFrame();
+    m_frameNanos += monotonicNanos() - frameStart;
+    m_timedFrames++;
+
+    // Work that scales with the pixel count: recording and rasterizing.
+    // Waiting in lock/post (or for a back buffer) is the compositor's
+    // time, and fewer pixels wouldn't make it shorter.
+    if (m_scalingActive) {
+        const frame::FrameTiming& timing = m_frameTimer.current();
+        m_governor.onFrame(timing.nanos[frame::kStageRecord] +
+                           timing.nanos[frame::kStageRaster]);
+    }
+
+    logStats(surface);
+}
+
+/**
+ * stepAnimation(): UPDATE ANIMATION for a frame at `now`
+ *
+ * Runs the fixed steps of simulated time that have come due since the
+ * last frame (common/timeline.h), so the circle moves at the same speed
+ * at 60, 90 or 120 Hz, and a late frame catches up instead of leaving the
+ * animation behind for good. Returns what to draw: the state between the
+ * last two steps, as far along as the leftover time.
+ *
+ * Render thread, or the simulation thread in pipelined mode (whichever
+ * owns m_scene this run).
+ */
+raster::SceneState Renderer::stepAnimation(int64_t now) {
+    int steps = m_timeline.advance(now);
+    for (int i = 0; i < steps; i++) {
+        m_previousScene = m_scene;
+        raster::advanceScene(m_scene, m_timeline.stepSeconds());
+    }
+    return raster::interpolateScene(m_previousScene, m_scene, m_timeline.alpha());
+}
+
+/**
+ * applyResolution(): DYNAMIC RESOLUTION, render thread, before each frame
+ *
+ * ANativeWindow_setBuffersGeometry(window, w, h, format) with a nonzero
+ * size makes the window dequeue w x h buffers from now on, whatever the
+ * view's size; SurfaceFlinger scales them to the view when compositing.
+ * ANativeWindow_getWidth/Height report the new size right away, so the
+ * rest of drawFrame() (and the simulation thread) just follow it. The new
+ * buffers have no usable previous contents: the DamageTracker sees the
+ * size change and repaints everything once.
+ *
+ * Lookup: "ANativeWindow_setBuffersGeometry scaling", "dynamic resolution"
+ */
+void Renderer::applyResolution() {
+    if (!m_scalingActive) {
+        return;
+    }
+    float scale = m_governor.scale();
+    int width = 0;
+    int height = 0;
+    frame::scaledSize(m_viewWidth.load(std::memory_order_relaxed),
+                      m_viewHeight.load(std::memory_order_relaxed), scale, &width, &height);
+    if (width == m_geometryWidth && height == m_geometryHeight) {
+        return;
+    }
+
+    if (ANativeWindow_setBuffersGeometry(m_window, width, height, m_bufferFormat) < 0) {
+        LOGE("[%d] Failed to set buffer geometry %dx%d", m_id, width, height);
+        return;
+    }
+    LOGI("[%d] Resolution: %.2fx, buffers %dx%d (was %dx%d)", m_id, scale, width, height,
+         m_geometryWidth, m_geometryHeight);
+    m_geometryWidth = width;
+    m_geometryHeight = height;
+    m_renderScale.store(scale, std::memory_order_relaxed);
+}
+
+// Report how much of the screen we actually touched, every ~2 seconds
+void Renderer::logStats(const raster::Surface& surface) {
+    const raster::DamageStats& stats = m_damage.stats();
+    m_trace.record(kTraceDamage, static_cast<int32_t>(stats.pixelsTouched), stats.rectCount,
+                   stats.bufferAge, stats.fullRepaint);
+    m_damageTouched += stats.pixelsTouched;
+    m_damageTotal += stats.pixelsTotal;
+    m_bytesWritten += stats.pixelsTouched * raster::bytesPerPixel(surface.format);
+    if (++m_damageFrames < 120) {
+        return;
+    }
+
+    LOGI("[%d] Damage: touched %.1f%% of pixels over %d frames (last frame: %lld px in %d rects, age %d%s)",
+         m_id, m_damageTotal > 0 ? 100.0 * m_damageTouched / m_damageTotal : 0.0,
+         m_damageFrames, static_cast<long long>(stats.pixelsTouched),
+         stats.rectCount, stats.bufferAge, stats.fullRepaint ? ", full" : "");
+    LOGI("[%d] Output %s%s: %.1f KB written/frame, %.3f ms/frame", m_id,
+         raster::pixelKernels(surface.format)->name, m_tiles->dither() ? " + dither" : "",
+         m_bytesWritten / 1024.0 / m_damageFrames,
+         m_timedFrames > 0 ? m_frameNanos / 1e6 / m_timedFrames : 0.0);
+    frame::PacerStats pacing = m_pacer.stats();
+    LOGI("[%d] Pacing: %lld missed deadlines, %lld refreshes without a new frame, "
+         "interval %.2f ms (jitter %.2f, max %.2f)", m_id,
+         static_cast<long long>(pacing.missedDeadlines),
+         static_cast<long long>(pacing.skippedVsyncs), pacing.meanIntervalMs,
+         pacing.jitterMs, pacing.maxIntervalMs);
+    m_pacer.resetStats();
+    if (!m_pipelineActive) {
+        timeline::TimelineStats animation = m_timeline.stats();
+        LOGI("[%d] Animation: %lld fixed steps in %lld frames (at most %d per frame), "
+             "%.1f ms of stalls skipped", m_id, static_cast<long long>(animation.steps),
+             static_cast<long long>(animation.frames), animation.maxSteps,
+             animation.droppedNanos / 1e6);
+    }
+    if (m_scalingActive) {
+        frame::GovernorStats governor = m_governor.stats();
+        LOGI("[%d] Resolution: %.2fx (level %d of %d), work %.2f ms of %.2f ms budget, "
+             "%lld downscales, %lld upscales", m_id, m_governor.scale(), m_governor.level(),
+             m_governor.levelCount() - 1, governor.meanWorkMs, m_governor.budget() / 1e6,
+             static_cast<long long>(governor.downscales),
+             static_cast<long long>(governor.upscales));
+    }
+    if (m_pipelineActive) {
+        logPipelineStats();
+    }
+    m_damageTouched = 0;
+    m_damageTotal = 0;
+    m_bytesWritten = 0;
+    m_frameNanos = 0;
+    m_timedFrames = 0;
+    m_damageFrames = 0;
+}
+
+// Pipelined mode: how well the simulation and render threads keep in step
+// (totals since start(); the render thread only logs, never resets them)
+void Renderer::logPipelineStats() {
+    frame::QueueStats queue = m_snapshots.stats();
+    LOGI("[%d] Pipeline: %lld snapshots recorded, %lld rasterized, %lld skipped as stale, "
+         "%lld dropped (ring full), %lld refreshes with nothing new", m_id,
+         static_cast<long long>(queue.committed), static_cast<long long>(queue.consumed),
+         static_cast<long long>(queue.skipped), static_cast<long long>(queue.rejected),
+         static_cast<long long>(queue.empty));
+    LOGI("[%d] Pipeline: queue depth mean %.2f max %lld, snapshot age %.2f ms", m_id,
+         queue.meanDepth, static_cast<long long>(queue.maxDepth),
+         m_snapshotAges > 0 ? m_snapshotAgeNanos / 1e6 / m_snapshotAges : 0.0);
+    m_snapshotAgeNanos = 0;
+    m_snapshotAges = 0;
+}
+
+// Present thread mode: who waits for whom, and what presenting costs
+// (wait totals since start(); the per-frame costs since the last line)
+void Renderer::logPresentStats() {
+    raster::PresentStats queue = m_presentQueue->stats();
+    LOGI("[%d] Present: %lld frames rasterized, %lld presented, %lld skipped as stale", m_id,
+         static_cast<long long>(queue.submitted), static_cast<long long>(queue.presented),
+         static_cast<long long>(queue.skipped));
+    LOGI("[%d] Present: raster thread waited %lld times for a back buffer (%.2f ms total, max %.2f), "
+         "present thread waited %lld times for a frame (%.2f ms total, max %.2f)", m_id,
+         static_cast<long long>(queue.rasterWaits), queue.rasterWaitNanos / 1e6,
+         queue.rasterWaitMaxNanos / 1e6, static_cast<long long>(queue.presentWaits),
+         queue.presentWaitNanos / 1e6, queue.presentWaitMaxNanos / 1e6);
+    double frames = m_presentFrames;
+    LOGI("[%d] Present: lock %.2f ms, copy %.2f ms (%.1f KB), post %.2f ms, "
+         "submit -> posted %.2f ms per frame", m_id, m_presentLockNanos / 1e6 / frames,
+         m_presentCopyNanos / 1e6 / frames, m_presentBytes / 1024.0 / frames,
+         m_presentPostNanos / 1e6 / frames, m_presentLatencyNanos / 1e6 / frames);
+    m_presentLockNanos = 0;
+    m_presentCopyNanos = 0;
+    m_presentPostNanos = 0;
+    m_presentLatencyNanos = 0;
+    m_presentBytes = 0;
+    m_presentFrames = 0;
+}
@@ -0,0 +1,288 @@
+/**
+ * renderer.h: One native renderer per Surface
+ *
+ * Everything drawFrame() needs used to be a file-level static in
+ * native_renderer.cpp (g_window, g_render_thread, g_running, ...), so the
+ * whole process could only ever render ONE surface. A Renderer owns all of
+ * it instead: window, render thread, tile workers, pacing, timings, trace.
+ * Java holds a pointer to it as a jlong handle (NativeRenderer.java), so
+ * two SurfaceViews (a preview and a main view, say) simply have two
+ * Renderers, each with its own thread and its own frame pacing.
+ *
+ * LIFECYCLE: an atomic state machine
+ *
+ *     Created --start()--> Running --pause()--> Paused --start()--> Running
+ *        |                    |                    |
+ *        +----------------destroy()----------------+--> Destroyed
+ *
+ * - start():   surfaceCreated. Takes the ANativeWindow, starts the thread.
+ * - pause():   surfaceDestroyed. Stops and joins the thread, releases the
+ *              window. The animation state and timings are kept, so the
+ *              next surface continues where this one stopped.
+ * - destroy(): the view goes away for good.
+ *
+ * Transitions are compare-and-swap on m_state, so an out-of-order call
+ * (say, surfaceDestroyed without surfaceCreated) is refused and logged
+ * instead of racing. The render thread polls the same atomic, which
+ * replaces the old plain "bool g_running" read across threads.
+ *
+ * THREADS: start/pause/destroy and the setters come from the Java UI
+ * thread. The render thread only touches the per-frame members. Only the
+ * atomics and the timing/trace rings (lock-free, see frame/ and
+ * native-common/) are shared between the two.
+ *
+ * PIPELINED MODE (setPipelined(true), off by default): normally the render
+ * thread records the frame, rasterizes it, then steps the animation, all
+ * back to back. In pipelined mode a third thread, the SIMULATION thread,
+ * steps the animation and records each frame into a SceneSnapshot (display
+ * list + timestamp) on its own refresh-rate grid, and hands it over through
+ * a lock-free SPSC ring (frame/spsc_ring.h). The render thread takes the
+ * NEWEST snapshot each frame and only rasterizes, so recording frame N+1
+ * overlaps with rasterizing frame N:
+ *
+ *     simulation:  [rec 1][rec 2][rec 3][rec 4] ...
+ *     render:             [raster 1][raster 2][raster 3] ...
+ *
+ * Snapshots the render thread never got to are skipped (counted), and a
+ * full ring makes the simulation drop that step's snapshot (counted too);
+ * the animation itself keeps going either way.
+ *
+ * PRESENT THREAD (setPresentBuffers(2 or 3), 0 = off by default): the
+ * render thread rasterizes into back buffers of its own instead of the
+ * locked window buffer, and a PRESENT thread does lock / copy / post
+ * (raster/present_queue.h). A BufferQueue that has run out of buffers
+ * then blocks only the present thread; the render thread keeps drawing
+ * until all of its back buffers are waiting to be shown.
+ *
+ * DYNAMIC RESOLUTION (setResolutionScaling(true, minScale), off by
+ * default): a frame::ResolutionGovernor watches each frame's work time
+ * (record + raster) against the refresh period. When it decides to go
+ * down (or back up) a step, the render thread asks the window for smaller
+ * buffers with ANativeWindow_setBuffersGeometry() before the next frame,
+ * and the compositor stretches them over the view. The scene is laid out
+ * for the view and shrunk by the same factor, so it looks the same, just
+ * softer. resolutionScale() is the current factor (1 = full resolution).
+ *
+ * INTERNAL RESOLUTION (setInternalScale(scale, bilinear), 1 = off by
+ * default): the window keeps full-size buffers, but the scene is
+ * rasterized into a smaller buffer of our own (0.5 = a quarter of the
+ * pixels) and stretched into the window buffer with raster::Upscaler,
+ * after locking (or on the present thread, in present thread mode). Only
+ * the upscaled damage rect is stretched each frame. RGBA_8888 output only.
+ *
+ * Lookup: "JNI native handle jlong pattern", "std::atomic compare_exchange"
+ */
+
+#ifndef PHASE3_RENDERER_H
+#define PHASE3_RENDERER_H
+
+#include <android/choreographer.h>
+#include <android/looper.h>
+#include <android/native_window.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "common/timeline.h"
+#include "common/trace.h"
+#include "frame/frame_pacer.h"
+#include "frame/frame_timing.h"
+#include "frame/resolution_governor.h"
+#include "frame/spsc_ring.h"
+#include "raster/damage.h"
+#include "raster/display_list.h"
+#include "raster/frame_arena.h"
+#include "raster/present_queue.h"
+#include "raster/scene.h"
+#include "raster/thread_pool.h"
+#include "raster/tile_renderer.h"
+#include "raster/upscale.h"
+
+#include <vector>
+
+enum class RendererState : int {
+    Created,
+    Running,
+    Paused,
+    Destroyed,
+};
+
+const char* rendererStateName(RendererState state);
+
+// OUTPUT MODE: which buffer format we ask the window for
+// Values match NativeRenderer.OUTPUT_* on the Java side. RGB_565 halves the
+// bytes written per frame (memory bandwidth is the bottleneck on low-end
+// phones); the dithered variant hides the 565 banding. Takes effect at the
+// next start().
+enum OutputMode {
+    kOutputRgba8888 = 0,
+    kOutputRgb565 = 1,
+    kOutputRgb565Dither = 2,
+};
+
+class Renderer {
+public:
+    Renderer();
+    ~Renderer();  // destroy()s if the caller didn't
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    // Small number for log lines ("[2] Render loop started")
+    int id() const { return m_id; }
+
+    RendererState state() const { return m_state.load(std::memory_order_acquire); }
+
+    // Created/Paused -> Running. Takes over the caller's reference to
+    // window (released on pause/destroy, or right away on failure).
+    bool start(ANativeWindow* window);
+
+    // Running -> Paused. Returns once the render thread has exited.
+    bool pause();
+
+    // Anything -> Destroyed (pausing first if running). Idempotent.
+    void destroy();
+
+    // Settings for the next start()
+    void setOutputMode(int mode) { m_outputMode.store(mode, std::memory_order_relaxed); }
+    void setRefreshRate(float hz) { m_refreshRate.store(hz, std::memory_order_relaxed); }
+    void setPipelined(bool pipelined) { m_pipelined.store(pipelined, std::memory_order_relaxed); }
+    void setPresentBuffers(int count) { m_presentBuffers.store(count, std::memory_order_relaxed); }
+    void setResolutionScaling(bool enabled, float minScale);
+    void setInternalScale(float scale, bool bilinear);
+
+    // surfaceChanged: the size of the view the buffers are stretched over.
+    // Any thread; the render thread picks it up at its next frame.
+    void setViewSize(int width, int height);
+
+    // Buffer pixels per view pixel right now (1 = full resolution). Any thread.
+    float resolutionScale() const { return m_renderScale.load(std::memory_order_relaxed); }
+
+    // Summarize the last frames' stage timings into a flat array of
+    // frame::kTimingSnapshotLongs longs (see frame/frame_timing.h) and copy
+    // it to `out`. False (nothing written) if `capacity` bytes can't hold it.
+    // Any thread; concurrent callers each get a whole snapshot.
+    bool copyTimingSnapshot(void* out, size_t capacity);
+
+    // Format the trace ring into logcat (LOGD, so debug builds only)
+    void dumpTrace();
+
+private:
+    bool transition(RendererState from, RendererState to);
+
+    static void* threadMain(void* self);
+    static void* simulationMain(void* self);
+    static void* presentMain(void* self);
+    static void onVsync(int64_t frameTimeNanos, void* self);
+    void renderLoop();
+    void simulationLoop();
+    void presentLoop();
+    void drawFrame();
+    bool drawToBackBuffer(const raster::DisplayList& list, const raster::Rect& damage,
+                          int width, int height, raster::Surface* drawn);
+    bool drawUpscaled(const raster::DisplayList& list, const raster::Rect& damage, int width,
+                      int height, raster::Surface* drawn);
+    void rasterSize(int windowWidth, int windowHeight, int* width, int* height) const;
+    void finishFrame(const raster::Surface& surface, int64_t frameStart);
+    raster::SceneState stepAnimation(int64_t now);
+    void applyResolution();
+    void logStats(const raster::Surface& surface);
+    void logPipelineStats();
+    void logPresentStats();
+
+    const int m_id;
+    std::atomic<RendererState> m_state{RendererState::Created};
+
+    // Settings (UI thread writes, render thread reads at start)
+    std::atomic<int> m_outputMode{kOutputRgba8888};
+    std::atomic<float> m_refreshRate{60.0f};
+    std::atomic<bool> m_pipelined{false};
+    std::atomic<int> m_presentBuffers{0};
+    std::atomic<bool> m_resolutionScaling{false};
+    std::atomic<float> m_minResolutionScale{0.5f};
+    std::atomic<float> m_internalScaleSetting{1.0f};
+    std::atomic<bool> m_upscaleBilinear{true};
+
+    // DYNAMIC RESOLUTION: view size (UI thread), current scale (render thread)
+    std::atomic<int> m_viewWidth{0};
+    std::atomic<int> m_viewHeight{0};
+    std::atomic<float> m_renderScale{1.0f};
+
+    // Owned while Running (created in start(), freed in pause())
+    ANativeWindow* m_window = nullptr;
+    pthread_t m_thread = 0;
+    raster::ThreadPool* m_pool = nullptr;          // Tile workers (+ the render thread)
+    raster::TileRenderer* m_tiles = nullptr;       // Cuts each frame into 64x64 tiles
+    AChoreographer* m_choreographer = nullptr;     // Render thread's, in vsync mode
+    std::atomic<ALooper*> m_looper{nullptr};       // Woken by pause()
+    bool m_pipelineActive = false;                 // This run has a simulation thread
+    pthread_t m_simThread = 0;
+    raster::PresentQueue* m_presentQueue = nullptr;  // This run has a present thread
+    pthread_t m_presentThread = 0;
+    raster::PixelFormat m_backBufferFormat = raster::PixelFormat::RGBA_8888;
+    int m_bufferFormat = WINDOW_FORMAT_RGBA_8888;  // What setBuffersGeometry() asked for
+    bool m_scalingActive = false;                  // This run has a governor
+    float m_internalScale = 1.0f;                  // This run's internal resolution (< 1: upscaled)
+
+    // Render thread state (kept across pause/start)
+    raster::SceneState m_scene;                    // Animation state (simulation thread's when pipelined)
+    raster::SceneState m_previousScene;            // ...one fixed step earlier
+    timeline::Timeline m_timeline;                 // Fixed steps for m_scene (same owner)
+    raster::DamageTracker m_damage;                // What changed since each buffer was drawn
+    raster::FrameArena m_arena;                    // Per-frame command memory
+    raster::DisplayList m_list;                    // This frame's drawing commands
+
+    // INTERNAL RESOLUTION: the small buffer the scene is rasterized into
+    std::vector<uint32_t> m_internalPixels;
+    raster::Surface m_internal;
+    bool m_internalValid = false;                  // Holds the previous frame
+    raster::Upscaler m_upscaler;                   // Render thread's
+    raster::Upscaler m_presentUpscaler;            // Present thread's
+
+    // FRAME PACING: frames start on a grid of vsync-period deadlines
+    frame::MonotonicClock m_clock;
+    frame::FramePacer m_pacer;
+
+    // DYNAMIC RESOLUTION: picks the buffer scale from measured work time
+    frame::ResolutionGovernor m_governor;
+    int m_geometryWidth = 0;                       // Last setBuffersGeometry() size
+    int m_geometryHeight = 0;
+
+    // PIPELINE: simulation thread -> render thread (pipelined mode only)
+    // 3 slots: one being rasterized, one being recorded, one ready
+    frame::SpscRing<raster::SceneSnapshot, 3> m_snapshots;
+    frame::FramePacer m_simPacer;                  // Simulation thread's deadlines
+    uint64_t m_simSteps = 0;                       // Simulation thread only
+
+    // STAGE TIMING: record / lock / raster / post of the last 256 frames
+    frame::FrameTimingRing m_timings;
+    frame::FrameTimer m_frameTimer;
+    std::mutex m_snapshotLock;                     // Readers only: packing + copying out
+    int64_t m_timingSnapshot[frame::kTimingSnapshotLongs] = {};
+
+    // Per-frame events, formatted later (see dumpTrace())
+    trace::TraceRing m_trace;
+
+    // Statistics, accumulated between log lines (render thread only)
+    int64_t m_damageTouched = 0;
+    int64_t m_damageTotal = 0;
+    int64_t m_bytesWritten = 0;   // Framebuffer bytes repainted
+    int64_t m_frameNanos = 0;     // drawFrame() CPU time...
+    int m_timedFrames = 0;        // ...over this many frames
+    int m_damageFrames = 0;
+    int64_t m_snapshotAgeNanos = 0;   // Pipelined: snapshot timestamp -> raster start...
+    int m_snapshotAges = 0;           // ...over this many frames
+
+    // Present thread statistics, between its log lines (present thread only)
+    int64_t m_presentLockNanos = 0;     // ANativeWindow_lock
+    int64_t m_presentCopyNanos = 0;     // Back buffer -> window buffer
+    int64_t m_presentPostNanos = 0;     // ANativeWindow_unlockAndPost
+    int64_t m_presentLatencyNanos = 0;  // submit() -> posted
+    int64_t m_presentBytes = 0;         // Bytes copied
+    int m_presentFrames = 0;
+};
+
+#endif // PHASE3_RENDERER_H
@@ -9,6 +9,10 @@ import androidx.appcompat.app.AppCompatActivity;
 // Log: For logging
 import android.util.Log;
 
+// FrameLayout + Gravity: Stack a small preview view on top of the main one
+import android.view.Gravity;
+import android.widget.FrameLayout;
+
 /**
  * Phase 3: MainActivity with Native Rendering
  *
@@ -45,6 +49,11 @@ import android.util.Log;
 public class MainActivity extends AppCompatActivity {
     private static final String TAG = "MainActivity";
 
+    // Show a second, smaller MySurfaceView in the corner. Each view has
+    // its own native Renderer (own thread, own pacing), so both animate
+    // independently at the same time.
+    private static final boolean SHOW_PREVIEW = false;
+
     /**
      * onCreate(): Activity entry point
      *
@@ -65,7 +74,22 @@ public class MainActivity extends AppCompatActivity {
 
         // Set as content view
         // Android will create Surface and trigger surfaceCreated()
-        setContentView(surfaceView);
+        if (SHOW_PREVIEW) {
+            FrameLayout layout = new FrameLayout(this);
+            layout.addView(surfaceView);
+
+            // A SurfaceView's surface sits behind the window by default;
+            // a media overlay is composited above the other SurfaceView
+            MySurfaceView preview = new MySurfaceView(this);
+            preview.setZOrderMediaOverlay(true);
+            FrameLayout.LayoutParams params = new FrameLayout.LayoutParams(
+                    480, 320, Gravity.TOP | Gravity.END);
+            layout.addView(preview, params);
+
+            setContentView(layout);
+        } else {
+            setContentView(surfaceView);
+        }
 
         // WHAT HAPPENS NEXT:
         // 1. Android allocates Surface for SurfaceView
@@ -13,6 +13,9 @@ import android.view.SurfaceHolder;
 // Log: For logging
 import android.util.Log;
 
+// ByteBuffer: Native frame timing snapshot
+import java.nio.ByteBuffer;
+
 /**
  * Phase 3: MySurfaceView with Native Rendering
  *
@@ -45,6 +48,29 @@ import android.util.Log;
 public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback {
     private static final String TAG = "MySurfaceView";
 
+    // Buffer format for the native renderer. Switch to
+    // NativeRenderer.OUTPUT_RGB_565_DITHER on bandwidth-starved devices.
+    private static final int OUTPUT_MODE = NativeRenderer.OUTPUT_RGBA_8888;
+
+    // Record frames on a native simulation thread, overlapping with the
+    // rasterization of the previous frame (see NativeRenderer.setPipelined)
+    private static final boolean PIPELINED = false;
+
+    // 0: the native render thread posts frames itself. 2 or 3: it draws
+    // into that many back buffers and a present thread posts them, so a
+    // full BufferQueue doesn't stall rasterization
+    private static final int PRESENT_BUFFERS = 0;
+
+    // Shrink the native buffers (down to MIN_RESOLUTION_SCALE per axis)
+    // while frames don't fit in a refresh period
+    private static final boolean RESOLUTION_SCALING = false;
+    private static final float MIN_RESOLUTION_SCALE = 0.5f;
+
+    // Below 1: rasterize the scene at this fraction of the window's width
+    // and height and stretch it into full-size window buffers
+    private static final float INTERNAL_SCALE = 1.0f;
+    private static final boolean UPSCALE_BILINEAR = true;
+
     // NativeRenderer: Our JNI bridge to C++ code
     private final NativeRenderer nativeRenderer;
 
@@ -64,6 +90,11 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
         // Create native renderer
         // This will load the native library via System.loadLibrary()
         nativeRenderer = new NativeRenderer();
+        nativeRenderer.setOutputMode(OUTPUT_MODE);
+        nativeRenderer.setPipelined(PIPELINED);
+        nativeRenderer.setPresentBuffers(PRESENT_BUFFERS);
+        nativeRenderer.setResolutionScaling(RESOLUTION_SCALING, MIN_RESOLUTION_SCALE);
+        nativeRenderer.setInternalScale(INTERNAL_SCALE, UPSCALE_BILINEAR);
 
         // Get SurfaceHolder and register for callbacks
         // Same as Phase 2 - this is how we know when Surface is ready
@@ -108,6 +139,12 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
         // -> C++ receives it
         // -> C++ converts to ANativeWindow* via ANativeWindow_fromSurface()
         // -> C++ starts render thread
+        //
+        // The native frame pacer needs the refresh rate first
+        // (60, 90, 120 Hz...) so frames start once per display refresh
+        if (getDisplay() != null) {
+            nativeRenderer.setRefreshRate(getDisplay().getRefreshRate());
+        }
         nativeRenderer.onSurfaceCreated(holder.getSurface());
 
         // At this point:
@@ -132,8 +169,8 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
         Log.d(TAG, "surfaceChanged: " + width + "x" + height + ", format=" + format);
 
         // Notify native code of new dimensions
-        // Native code can use this to update projection matrices, etc.
-        // Our simple animation adapts automatically, so native code ignores this
+        // Our simple animation adapts automatically; native code only needs
+        // the view size as the full-resolution size for dynamic resolution
         nativeRenderer.onSurfaceChanged(width, height);
     }
 
@@ -143,10 +180,10 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
      * CRITICAL: Must tell native code to stop rendering and clean up!
      * Same pattern as Phase 2's cleanup.
      *
-     * Native code will:
+     * Native code will (Renderer::pause()):
      * - Stop render thread (pthread_join)
      * - Release ANativeWindow (ANativeWindow_release)
-     * - Clean up resources
+     * - Keep the Renderer itself, Paused, for the next surface
      *
      * IMPORTANT: If we don't clean up, we'll:
      * - Leak memory (ANativeWindow not released)
@@ -160,9 +197,12 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
     public void surfaceDestroyed(SurfaceHolder holder) {
         Log.d(TAG, "surfaceDestroyed");
 
-        // Tell native code to clean up
-        // This will:
-        // 1. Set g_running = false (stop render loop)
+        // Where did the frame time go? (last 256 frames, milliseconds)
+        logFrameTimings();
+
+        // Pause our native Renderer (found through NativeRenderer's jlong
+        // handle): Running -> Paused, which
+        // 1. Flips the Renderer's atomic state (the render loop polls it and exits)
         // 2. pthread_join() (wait for thread to finish)
         // 3. ANativeWindow_release() (free native window)
         nativeRenderer.onSurfaceDestroyed();
@@ -170,7 +210,42 @@ public class MySurfaceView extends SurfaceView implements SurfaceHolder.Callback
         // After this call returns:
         // - C++ render thread has stopped
         // - ANativeWindow has been released
-        // - All native resources cleaned up
+        // - The Renderer is Paused, keeping its animation state for the
+        //   next surfaceCreated(); release() destroys it for good
         // - Safe for Android to destroy Surface
     }
+
+    /**
+     * onDetachedFromWindow(): The view is gone for good
+     *
+     * surfaceDestroyed() only pauses the native renderer (its surface may
+     * come back, e.g. after the app returns from the background). Once the
+     * view leaves the window, free the native side too.
+     */
+    @Override
+    protected void onDetachedFromWindow() {
+        super.onDetachedFromWindow();
+        Log.d(TAG, "onDetachedFromWindow");
+        nativeRenderer.release();
+    }
+
+    /**
+     * logFrameTimings(): Log the native stage timing percentiles
+     */
+    private void logFrameTimings() {
+        ByteBuffer timings = nativeRenderer.getFrameTimings();
+        if (timings == null) {
+            return;
+        }
+        String[] names = {"record", "lock", "raster", "post", "total"};
+        Log.i(TAG, "Frame timings over " + timings.getLong(0) + " frames:");
+        for (int stage = 0; stage < NativeRenderer.TIMING_STAGE_COUNT; stage++) {
+            Log.i(TAG, String.format("  %-6s p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                    names[stage],
+                    NativeRenderer.timingNanos(timings, stage, NativeRenderer.TIMING_P50) / 1e6,
+                    NativeRenderer.timingNanos(timings, stage, NativeRenderer.TIMING_P95) / 1e6,
+                    NativeRenderer.timingNanos(timings, stage, NativeRenderer.TIMING_P99) / 1e6,
+                    NativeRenderer.timingNanos(timings, stage, NativeRenderer.TIMING_MAX) / 1e6));
+        }
+    }
 }
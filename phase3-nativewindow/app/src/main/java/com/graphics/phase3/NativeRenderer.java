@@ -7,6 +7,10 @@ import android.view.Surface;
 // Log: For logging (we'll see logs from both Java and C++)
 import android.util.Log;
 
+// ByteBuffer: Frame timings are copied into a direct buffer Java allocates
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
 /**
  * Phase 3: NativeRenderer - JNI Bridge
  *
@@ -35,6 +39,34 @@ import android.util.Log;
 public class NativeRenderer {
     private static final String TAG = "NativeRenderer";
 
+    // OUTPUT MODES for setOutputMode()
+    // RGBA_8888 is the default. RGB_565 writes half the bytes per frame,
+    // which helps when memory bandwidth is the bottleneck (low-end phones),
+    // at the cost of color depth; the dithered variant hides the banding.
+    public static final int OUTPUT_RGBA_8888 = 0;
+    public static final int OUTPUT_RGB_565 = 1;
+    public static final int OUTPUT_RGB_565_DITHER = 2;
+
+    // FRAME TIMING SNAPSHOT LAYOUT (see getFrameTimings())
+    // A buffer of longs: [0] frames summarized, [1] frames ever drawn,
+    // then TIMING_FIELD_COUNT values (nanoseconds) per stage.
+    // Must match frame/frame_timing.h on the native side.
+    public static final int TIMING_STAGE_RECORD = 0;  // Build the display list
+    public static final int TIMING_STAGE_LOCK = 1;    // ANativeWindow_lock
+    public static final int TIMING_STAGE_RASTER = 2;  // Clear + draw the tiles
+    public static final int TIMING_STAGE_POST = 3;    // ANativeWindow_unlockAndPost
+    public static final int TIMING_STAGE_TOTAL = 4;   // Whole frame
+    public static final int TIMING_STAGE_COUNT = 5;
+
+    public static final int TIMING_P50 = 0;
+    public static final int TIMING_P95 = 1;
+    public static final int TIMING_P99 = 2;
+    public static final int TIMING_MAX = 3;
+    public static final int TIMING_MEAN = 4;
+    public static final int TIMING_FIELD_COUNT = 5;
+    public static final int TIMING_SNAPSHOT_BYTES =
+            (2 + TIMING_STAGE_COUNT * TIMING_FIELD_COUNT) * 8;
+
     // STATIC BLOCK: Runs once when class is first loaded
     // This is where we load the native library (.so file)
     static {
@@ -62,6 +94,21 @@ public class NativeRenderer {
         }
     }
 
+    // NATIVE HANDLE: pointer to this instance's C++ Renderer (renderer.h)
+    // Each NativeRenderer owns one, so several SurfaceViews can render at
+    // once, each with its own native thread. 0 once released.
+    private long nativeHandle;
+
+    /**
+     * Constructor: Create the native Renderer
+     *
+     * Call release() when done with it, or it leaks (the Java garbage
+     * collector knows nothing about native memory).
+     */
+    public NativeRenderer() {
+        nativeHandle = nativeCreate();
+    }
+
     // ========== NATIVE METHOD DECLARATIONS ==========
     // These methods have no body - they're implemented in C++
     // The "native" keyword tells Java to look for C++ implementation
@@ -77,6 +124,18 @@ public class NativeRenderer {
     // IMPORTANT: The Java compiler generates JNI headers
     // But modern Android doesn't require them - just follow the naming pattern
 
+    /**
+     * nativeCreate(): Allocate a native Renderer, return its handle
+     */
+    private native long nativeCreate();
+
+    /**
+     * nativeDestroy(): Stop and free the native Renderer
+     *
+     * The handle is invalid afterwards.
+     */
+    private native void nativeDestroy(long handle);
+
     /**
      * nativeOnSurfaceCreated(): Called when Surface is created
      *
@@ -91,7 +150,90 @@ public class NativeRenderer {
      *
      * Lookup: "Android Surface class", "ANativeWindow_fromSurface"
      */
-    public native void nativeOnSurfaceCreated(Surface surface);
+    public native void nativeOnSurfaceCreated(long handle, Surface surface);
+
+    /**
+     * nativeSetOutputMode(): Choose the buffer format (OUTPUT_* constant)
+     *
+     * The native side requests the format with
+     * ANativeWindow_setBuffersGeometry() when the Surface is created, so
+     * call this BEFORE onSurfaceCreated() (or expect it on the next Surface).
+     */
+    public native void nativeSetOutputMode(long handle, int mode);
+
+    /**
+     * nativeSetRefreshRate(): Tell native code the display refresh rate
+     *
+     * The native frame pacer starts frames one refresh period apart
+     * (and counts missed refreshes against it). Call before
+     * onSurfaceCreated(); it applies when the render thread starts.
+     *
+     * @param hz Display.getRefreshRate(), e.g. 60, 90 or 120
+     */
+    public native void nativeSetRefreshRate(long handle, float hz);
+
+    /**
+     * nativeSetPipelined(): Record frames on a separate simulation thread
+     *
+     * Off: the native render thread steps the animation, records the frame
+     * and rasterizes it, back to back. On: a simulation thread records
+     * frames into a small lock-free ring and the render thread rasterizes
+     * the newest one, so the two overlap. Call before onSurfaceCreated().
+     */
+    public native void nativeSetPipelined(long handle, boolean pipelined);
+
+    /**
+     * nativeSetPresentBuffers(): Present from a separate native thread
+     *
+     * 0 (default): the render thread locks, draws into and posts the
+     * window buffer itself, so it stalls whenever the BufferQueue does.
+     * 2 or 3: it draws into that many private back buffers instead, and a
+     * present thread copies the newest one into the window and posts it.
+     * Call before onSurfaceCreated().
+     */
+    public native void nativeSetPresentBuffers(long handle, int count);
+
+    /**
+     * nativeSetResolutionScaling(): Render fewer pixels when frames run late
+     *
+     * On: while the native frame work doesn't fit in the refresh period,
+     * the buffers shrink step by step (down to minScale of the view's width
+     * and height) and the compositor stretches them over the view; they
+     * grow back once there is headroom again. Call before onSurfaceCreated().
+     *
+     * @param minScale Smallest scale per axis, 0.1 to 1 (0.5 = a quarter of the pixels)
+     */
+    public native void nativeSetResolutionScaling(long handle, boolean enabled, float minScale);
+
+    /**
+     * nativeSetInternalScale(): Rasterize at a lower internal resolution
+     *
+     * Below 1: the native renderer draws the scene into a buffer of its own,
+     * scale times the window's width and height (0.5 = a quarter of the
+     * pixels), and stretches it into the full-size window buffer when
+     * presenting. Unlike setResolutionScaling() the window buffers stay at
+     * full resolution. 1 turns it off. RGBA_8888 output only.
+     * Call before onSurfaceCreated().
+     *
+     * @param scale 0.25 to 1
+     * @param bilinear Smooth (bilinear) stretch, or blocky (nearest) and cheaper
+     */
+    public native void nativeSetInternalScale(long handle, float scale, boolean bilinear);
+
+    /**
+     * nativeGetResolutionScale(): Current buffer scale, 1.0 = full resolution
+     */
+    public native float nativeGetResolutionScale(long handle);
+
+    /**
+     * nativeGetFrameTimings(): Per-stage percentiles of the last 256 frames
+     *
+     * Copies them into `out`, a DIRECT ByteBuffer of at least
+     * TIMING_SNAPSHOT_BYTES, as longs in native byte order. Returns false
+     * (and writes nothing) if `out` isn't direct or is too small. Use
+     * getFrameTimings(), which allocates the buffer and sets its order.
+     */
+    public native boolean nativeGetFrameTimings(long handle, ByteBuffer out);
 
     /**
      * nativeOnSurfaceChanged(): Called when Surface size changes
@@ -102,7 +244,7 @@ public class NativeRenderer {
      * @param width New width in pixels
      * @param height New height in pixels
      */
-    public native void nativeOnSurfaceChanged(int width, int height);
+    public native void nativeOnSurfaceChanged(long handle, int width, int height);
 
     /**
      * nativeOnSurfaceDestroyed(): Called when Surface is destroyed
@@ -114,7 +256,7 @@ public class NativeRenderer {
      *
      * Failure to clean up will leak memory and threads.
      */
-    public native void nativeOnSurfaceDestroyed();
+    public native void nativeOnSurfaceDestroyed(long handle);
 
     // ========== CONVENIENCE METHODS ==========
     // These methods provide a nicer API for Java callers
@@ -136,7 +278,89 @@ public class NativeRenderer {
         }
 
         // Call native implementation
-        nativeOnSurfaceCreated(surface);
+        nativeOnSurfaceCreated(nativeHandle, surface);
+    }
+
+    /**
+     * setOutputMode(): Public wrapper for the buffer format choice
+     */
+    public void setOutputMode(int mode) {
+        Log.d(TAG, "setOutputMode: " + mode);
+        nativeSetOutputMode(nativeHandle, mode);
+    }
+
+    /**
+     * setRefreshRate(): Public wrapper for the refresh rate
+     */
+    public void setRefreshRate(float hz) {
+        Log.d(TAG, "setRefreshRate: " + hz);
+        nativeSetRefreshRate(nativeHandle, hz);
+    }
+
+    /**
+     * setPipelined(): Public wrapper for the pipelined mode switch
+     */
+    public void setPipelined(boolean pipelined) {
+        Log.d(TAG, "setPipelined: " + pipelined);
+        nativeSetPipelined(nativeHandle, pipelined);
+    }
+
+    /**
+     * setPresentBuffers(): Public wrapper for the present thread switch
+     */
+    public void setPresentBuffers(int count) {
+        Log.d(TAG, "setPresentBuffers: " + count);
+        nativeSetPresentBuffers(nativeHandle, count);
+    }
+
+    /**
+     * setResolutionScaling(): Public wrapper for dynamic resolution
+     */
+    public void setResolutionScaling(boolean enabled, float minScale) {
+        Log.d(TAG, "setResolutionScaling: " + enabled + ", min " + minScale);
+        nativeSetResolutionScaling(nativeHandle, enabled, minScale);
+    }
+
+    /**
+     * setInternalScale(): Public wrapper for the internal resolution
+     */
+    public void setInternalScale(float scale, boolean bilinear) {
+        Log.d(TAG, "setInternalScale: " + scale + (bilinear ? ", bilinear" : ", nearest"));
+        nativeSetInternalScale(nativeHandle, scale, bilinear);
+    }
+
+    /**
+     * getResolutionScale(): Current buffer scale (1.0 after release())
+     */
+    public float getResolutionScale() {
+        return nativeHandle != 0 ? nativeGetResolutionScale(nativeHandle) : 1.0f;
+    }
+
+    /**
+     * getFrameTimings(): Snapshot of the native frame stage timings
+     *
+     * Read values with timingNanos(). Every call returns a new buffer,
+     * owned by Java like any other object: it stays valid after the next
+     * call and after release(). Returns null after release().
+     */
+    public ByteBuffer getFrameTimings() {
+        if (nativeHandle == 0) {
+            return null;
+        }
+        ByteBuffer timings = ByteBuffer.allocateDirect(TIMING_SNAPSHOT_BYTES)
+                .order(ByteOrder.nativeOrder());
+        return nativeGetFrameTimings(nativeHandle, timings) ? timings : null;
+    }
+
+    /**
+     * timingNanos(): One value from a getFrameTimings() snapshot
+     *
+     * @param stage TIMING_STAGE_* constant
+     * @param field TIMING_P50, TIMING_P95, TIMING_P99, TIMING_MAX or TIMING_MEAN
+     */
+    public static long timingNanos(ByteBuffer timings, int stage, int field) {
+        int index = 2 + stage * TIMING_FIELD_COUNT + field;
+        return timings.getLong(index * 8);
     }
 
     /**
@@ -152,7 +376,7 @@ public class NativeRenderer {
         }
 
         // Call native implementation
-        nativeOnSurfaceChanged(width, height);
+        nativeOnSurfaceChanged(nativeHandle, width, height);
     }
 
     /**
@@ -162,6 +386,19 @@ public class NativeRenderer {
         Log.d(TAG, "onSurfaceDestroyed called from Java");
 
         // Call native cleanup
-        nativeOnSurfaceDestroyed();
+        nativeOnSurfaceDestroyed(nativeHandle);
+    }
+
+    /**
+     * release(): Free the native Renderer (after the last surface is gone)
+     *
+     * Safe to call twice; every other method must not be called after it.
+     */
+    public void release() {
+        Log.d(TAG, "release");
+        if (nativeHandle != 0) {
+            nativeDestroy(nativeHandle);
+            nativeHandle = 0;
+        }
     }
 }
@@ -0,0 +1,365 @@
+/**
+ * bench/gl_state_bench.cpp: The GL state cache against a mock GL context
+ *
+ * Checked (exit code 1 on failure):
+ * 1. The circle frame through GlStateCache (gl/circle_pass.h) produces
+ *    exactly the clears and draws of the original uncached renderFrame()
+ *    (bench/mock_gl.h compares the state each one sees), frame after
+ *    frame, with no call GL would reject.
+ * 2. After the first frame only clear, the MVP matrix and the draw reach
+ *    GL; no glGet*Location is called per frame; the cache's "issued"
+ *    count equals the calls the mock actually received.
+ * 3. A new context: after invalidate() everything is sent again and the
+ *    frames still match.
+ * 4. Link-time locations: every active attribute and uniform answered
+ *    from the table with GL's own value, "name" for "name[0]", -1 for
+ *    unknown names, and lookups the table can't answer (too many
+ *    uniforms, unregistered program) go to GL.
+ * 5. Two programs drawn alternately: uniform values are remembered per
+ *    program, so switching programs doesn't resend unchanged uniforms.
+ * 6. Deleting the bound buffer or the current program makes the cache
+ *    bind again, even when GL hands the same name back.
+ *
+ * Prints the calls per frame with and without the cache.
+ *
+ * Usage: gl_state_bench [frames]
+ */
+
+#include "mock_gl.h"
+#include "../gl/circle_pass.h"
+#include "../gl/gl_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using mockgl::MockGl;
+
+// The circle program as the driver would report it. Locations are
+// deliberately not 0, 1, 2 so that mixing up an index and a location
+// shows up.
+static const GLuint kCircleProgram = 3;
+static const GLuint kCircleVbo = 7;
+static const GLsizei kCircleVertices = 64 + 2;
+static const float kCircleColor[4] = {1.0f, 0.5f, 0.0f, 1.0f};
+
+static void addCircleProgram(MockGl& mock, GLuint id) {
+    mock.addProgram(id, {{"aPosition", 2, 1, GL_FLOAT_VEC4}},
+                    {{"uColor", 5, 1, GL_FLOAT_VEC4}, {"uMVPMatrix", 9, 1, GL_FLOAT_MAT4}});
+}
+
+// A moving circle's MVP: a translation that changes every frame
+static void frameMatrix(int frame, float* mvp) {
+    memset(mvp, 0, 16 * sizeof(float));
+    mvp[0] = 0.1f;
+    mvp[5] = 0.1f;
+    mvp[10] = -1.0f;
+    mvp[12] = sinf(frame * 0.05f);
+    mvp[13] = cosf(frame * 0.07f);
+    mvp[15] = 1.0f;
+}
+
+// The setup initGL() and onSurfaceChanged() do, through either path
+static void setupReference(const gl::GlDispatch& gl) {
+    gl.bindBuffer(GL_ARRAY_BUFFER, kCircleVbo);
+    gl.clearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    gl.viewport(0, 0, 1080, 2400);
+}
+
+static void setupCached(gl::GlStateCache& gl) {
+    gl.bindBuffer(GL_ARRAY_BUFFER, kCircleVbo);
+    gl.clearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    gl.viewport(0, 0, 1080, 2400);
+}
+
+// The original renderFrame(), call for call (its uniform locations were
+// looked up once in initGL(); the attribute's every frame)
+struct ReferenceProgram {
+    GLuint program;
+    GLint mvpLocation;
+    GLint colorLocation;
+};
+
+static ReferenceProgram referenceProgram(const gl::GlDispatch& gl, GLuint program) {
+    return {program, gl.getUniformLocation(program, "uMVPMatrix"),
+            gl.getUniformLocation(program, "uColor")};
+}
+
+static void referenceFrame(const gl::GlDispatch& gl, const ReferenceProgram& p,
+                           const float* mvp, const float* color) {
+    GLuint program = p.program;
+    gl.clear(GL_COLOR_BUFFER_BIT);
+    gl.useProgram(program);
+    gl.uniformMatrix4fv(p.mvpLocation, 1, GL_FALSE, mvp);
+    gl.uniform4f(p.colorLocation, color[0], color[1], color[2], color[3]);
+    gl.bindBuffer(GL_ARRAY_BUFFER, kCircleVbo);
+    GLint position = gl.getAttribLocation(program, "aPosition");
+    gl.enableVertexAttribArray(position);
+    gl.vertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    gl.drawArrays(GL_TRIANGLE_FAN, 0, kCircleVertices);
+    gl.disableVertexAttribArray(position);
+}
+
+// Compare two effect lists, printing the first difference
+static bool sameEffects(const MockGl& expected, const MockGl& actual) {
+    const std::vector<std::string>& a = expected.effects();
+    const std::vector<std::string>& b = actual.effects();
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        if (a[i] != b[i]) {
+            printf("  effect %zu differs:\n    expected %s\n    got      %s\n", i, a[i].c_str(),
+                   b[i].c_str());
+            return false;
+        }
+    }
+    if (a.size() != b.size()) {
+        printf("  %zu effects expected, got %zu\n", a.size(), b.size());
+        return false;
+    }
+    return true;
+}
+
+static uint64_t locationQueries(const MockGl& mock) {
+    return mock.calls(mockgl::kGetAttribLocation) + mock.calls(mockgl::kGetUniformLocation);
+}
+
+// Checks 1-3
+static bool checkCircleFrames(int frames) {
+    float mvp[16];
+
+    MockGl reference;
+    addCircleProgram(reference, kCircleProgram);
+    ReferenceProgram program = referenceProgram(MockGl::dispatch(), kCircleProgram);
+    setupReference(MockGl::dispatch());
+    uint64_t referenceStart = reference.totalCalls();
+    for (int frame = 0; frame < frames; frame++) {
+        frameMatrix(frame, mvp);
+        referenceFrame(MockGl::dispatch(), program, mvp, kCircleColor);
+    }
+    double referencePerFrame =
+            static_cast<double>(reference.totalCalls() - referenceStart) / frames;
+
+    // The same frames twice through one cache, with a context loss between
+    // (a fresh mock: GL state back to defaults, programs relinked)
+    gl::GlStateCache cache(MockGl::dispatch());
+    bool ok = true;
+    for (int context = 0; context < 2; context++) {
+        MockGl mock;
+        addCircleProgram(mock, kCircleProgram);
+        cache.invalidate();
+        cache.registerProgram(kCircleProgram);
+        setupCached(cache);
+
+        gl::CirclePass pass;
+        if (!gl::prepareCirclePass(cache, kCircleProgram, kCircleVbo, kCircleVertices, &pass)) {
+            printf("  aPosition not found\n");
+            return false;
+        }
+
+        uint64_t queriesBefore = locationQueries(mock);
+        uint32_t firstIssued = 0;
+        uint32_t steadyIssued = 0;
+        uint32_t steadySkipped = 0;
+        bool countsOk = true;
+        for (int frame = 0; frame < frames; frame++) {
+            frameMatrix(frame, mvp);
+            uint64_t before = mock.totalCalls();
+            cache.beginFrame();
+            gl::drawCirclePass(cache, pass, mvp, kCircleColor);
+            const gl::GlCallStats& stats = cache.frameStats();
+            countsOk &= stats.issued == mock.totalCalls() - before;
+            if (frame == 0) {
+                firstIssued = stats.issued;
+            } else {
+                steadyIssued = std::max(steadyIssued, stats.issued);
+                steadySkipped = stats.skipped;
+            }
+        }
+
+        bool effectsOk = sameEffects(reference, mock) && mock.errors() == 0;
+        bool noQueries = locationQueries(mock) == queriesBefore;
+        // clear + uniformMatrix4fv + drawArrays
+        bool steadyOk = steadyIssued == 3;
+        printf("  %-13s %d frames identical: %s, first frame %u calls, then %u issued + %u "
+               "skipped (%s), location queries per frame: %s, counts match GL: %s\n",
+               context == 0 ? "first context" : "new context", frames,
+               effectsOk ? "yes" : "NO", firstIssued, steadyIssued, steadySkipped,
+               steadyOk ? "ok" : "WRONG", noQueries ? "none" : "SOME",
+               countsOk ? "yes" : "NO");
+        ok &= effectsOk && noQueries && steadyOk && countsOk;
+    }
+
+    printf("  GL calls per frame: %.1f uncached, 3 cached\n", referencePerFrame);
+    return ok;
+}
+
+// Check 4
+static bool checkLocations() {
+    MockGl mock;
+    // More uniforms than the cache has room for, and an array
+    std::vector<mockgl::Variable> uniforms;
+    uniforms.push_back({"uLights[0]", 40, 4, GL_FLOAT_VEC4});
+    for (int i = 0; i < gl::GlStateCache::kMaxUniforms + 4; i++) {
+        uniforms.push_back({"uParam" + std::to_string(i), 100 + 3 * i, 1, GL_FLOAT});
+    }
+    mock.addProgram(11, {{"aPosition", 4, 1, GL_FLOAT_VEC4}, {"aColor", 1, 1, GL_FLOAT_VEC4}},
+                    uniforms);
+    addCircleProgram(mock, 12);  // Never registered
+
+    gl::GlStateCache cache(MockGl::dispatch());
+    bool ok = cache.registerProgram(11);
+
+    // Every lookup must return what GL would
+    struct Lookup {
+        bool attrib;
+        std::string name;
+    };
+    std::vector<Lookup> lookups = {{true, "aPosition"}, {true, "aColor"}, {true, "aMissing"},
+                                   {false, "uLights"},  {false, "uLights[0]"},
+                                   {false, "uMissing"}};
+    for (int i = 0; i < gl::GlStateCache::kMaxUniforms + 4; i++) {
+        lookups.push_back({false, "uParam" + std::to_string(i)});
+    }
+
+    int fromGl = 0;
+    for (const Lookup& lookup : lookups) {
+        const gl::GlDispatch& direct = MockGl::dispatch();
+        GLint expected = lookup.attrib ? direct.getAttribLocation(11, lookup.name.c_str())
+                                       : direct.getUniformLocation(11, lookup.name.c_str());
+        uint64_t before = locationQueries(mock);
+        GLint cached = lookup.attrib ? cache.attribLocation(11, lookup.name.c_str())
+                                     : cache.uniformLocation(11, lookup.name.c_str());
+        fromGl += static_cast<int>(locationQueries(mock) - before);
+        if (cached != expected) {
+            printf("  %s: cached %d, GL %d\n", lookup.name.c_str(), cached, expected);
+            ok = false;
+        }
+    }
+
+    // The table holds the first kMaxUniforms uniforms (the array and
+    // uParam0-14); the rest, and names it can't rule out, go to GL
+    int expectedFromGl =
+            static_cast<int>(lookups.size()) - 3 - 2 - (gl::GlStateCache::kMaxUniforms - 1);
+    bool tableOk = fromGl == expectedFromGl;
+
+    uint64_t before = locationQueries(mock);
+    bool fallbackOk = cache.uniformLocation(12, "uColor") == 5 &&
+                      locationQueries(mock) == before + 1;
+
+    printf("  %zu lookups match GL: %s, %d answered by GL (expected %d), unregistered "
+           "program falls back: %s\n",
+           lookups.size(), ok ? "yes" : "NO", fromGl, expectedFromGl,
+           fallbackOk ? "yes" : "NO");
+    return ok && tableOk && fallbackOk && mock.errors() == 0;
+}
+
+// Check 5
+static bool checkTwoPrograms(int frames) {
+    const GLuint programs[2] = {3, 4};
+    const float colors[2][4] = {{1.0f, 0.5f, 0.0f, 1.0f}, {0.0f, 0.5f, 1.0f, 1.0f}};
+    float mvp[16];
+
+    MockGl reference;
+    addCircleProgram(reference, programs[0]);
+    addCircleProgram(reference, programs[1]);
+    const ReferenceProgram referencePrograms[2] = {
+            referenceProgram(MockGl::dispatch(), programs[0]),
+            referenceProgram(MockGl::dispatch(), programs[1])};
+    setupReference(MockGl::dispatch());
+    for (int frame = 0; frame < frames; frame++) {
+        frameMatrix(frame / 2, mvp);
+        referenceFrame(MockGl::dispatch(), referencePrograms[frame % 2], mvp,
+                       colors[frame % 2]);
+    }
+
+    MockGl mock;
+    addCircleProgram(mock, programs[0]);
+    addCircleProgram(mock, programs[1]);
+    gl::GlStateCache cache(MockGl::dispatch());
+    gl::CirclePass passes[2];
+    for (int p = 0; p < 2; p++) {
+        cache.registerProgram(programs[p]);
+        gl::prepareCirclePass(cache, programs[p], kCircleVbo, kCircleVertices, &passes[p]);
+    }
+    setupCached(cache);
+    uint64_t colorsBefore = mock.calls(mockgl::kUniform4f);
+    uint64_t switchesBefore = mock.calls(mockgl::kUseProgram);
+    for (int frame = 0; frame < frames; frame++) {
+        frameMatrix(frame / 2, mvp);
+        gl::drawCirclePass(cache, passes[frame % 2], mvp, colors[frame % 2]);
+    }
+    uint64_t colorCalls = mock.calls(mockgl::kUniform4f) - colorsBefore;
+    uint64_t switches = mock.calls(mockgl::kUseProgram) - switchesBefore;
+
+    bool effectsOk = sameEffects(reference, mock) && mock.errors() == 0;
+    printf("  %d alternating frames identical: %s, %llu program switches, uColor sent %llu "
+           "times (expected 2)\n",
+           frames, effectsOk ? "yes" : "NO", static_cast<unsigned long long>(switches),
+           static_cast<unsigned long long>(colorCalls));
+    return effectsOk && switches == static_cast<uint64_t>(frames) && colorCalls == 2;
+}
+
+// Check 6
+static bool checkDeletes() {
+    MockGl mock;
+    addCircleProgram(mock, kCircleProgram);
+    gl::GlStateCache cache(MockGl::dispatch());
+    cache.registerProgram(kCircleProgram);
+    gl::CirclePass pass;
+    gl::prepareCirclePass(cache, kCircleProgram, kCircleVbo, kCircleVertices, &pass);
+    setupCached(cache);
+    float mvp[16];
+    frameMatrix(0, mvp);
+    gl::drawCirclePass(cache, pass, mvp, kCircleColor);
+
+    // Buffer deleted and the name handed out again: bind and pointer again
+    cache.deleteBuffer(kCircleVbo);
+    uint64_t binds = mock.calls(mockgl::kBindBuffer);
+    uint64_t pointers = mock.calls(mockgl::kVertexAttribPointer);
+    gl::drawCirclePass(cache, pass, mvp, kCircleColor);
+    bool bufferOk = mock.calls(mockgl::kBindBuffer) == binds + 1 &&
+                    mock.calls(mockgl::kVertexAttribPointer) == pointers + 1;
+
+    // Program deleted, relinked under the same name: use it again, and
+    // its uniforms are unset
+    cache.deleteProgram(kCircleProgram);
+    addCircleProgram(mock, kCircleProgram);
+    cache.registerProgram(kCircleProgram);
+    uint64_t uses = mock.calls(mockgl::kUseProgram);
+    uint64_t colors = mock.calls(mockgl::kUniform4f);
+    gl::drawCirclePass(cache, pass, mvp, kCircleColor);
+    bool programOk = mock.calls(mockgl::kUseProgram) == uses + 1 &&
+                     mock.calls(mockgl::kUniform4f) == colors + 1;
+
+    printf("  deleted buffer rebound: %s, deleted program reused: %s\n",
+           bufferOk ? "yes" : "NO", programOk ? "yes" : "NO");
+    return bufferOk && programOk && mock.errors() == 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = 240;
+    if (argc > 1 && atoi(argv[1]) > 0) {
+        frames = atoi(argv[1]);
+    }
+
+    printf("Circle frame, uncached vs GlStateCache:\n");
+    bool framesOk = checkCircleFrames(frames);
+
+    printf("\nLink-time locations:\n");
+    bool locationsOk = checkLocations();
+
+    printf("\nTwo programs:\n");
+    bool programsOk = checkTwoPrograms(frames);
+
+    printf("\nDeletes:\n");
+    bool deletesOk = checkDeletes();
+
+    if (!(framesOk && locationsOk && programsOk && deletesOk)) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * bench/instancing_bench.cpp: Instanced circles against a mock GL context
+ *
+ * Checked (exit code 1 on failure):
+ * 1. One instanced draw puts exactly what one draw per circle would on
+ *    screen (bench/mock_gl.h expands the instanced draw and reads each
+ *    circle's attributes out of the uploaded buffer), at several times,
+ *    with no call GL would reject.
+ * 2. A frame's GL calls don't depend on the circle count: 1,000, 10,000
+ *    and 100,000 circles all cost the same calls and one draw after the
+ *    first frame.
+ * 3. bounce(), the vertex shader's closed-form motion, follows a circle
+ *    stepped in small increments and reflected off the edges.
+ *
+ * Prints calls, draws and host CPU time per frame for each count, with
+ * and without instancing. (The mock does no GPU work, so the CPU time is
+ * only the cost of issuing the frame; on a device the GPU's time grows
+ * with the count either way.)
+ *
+ * Usage: instancing_bench [frames]
+ */
+
+#include "mock_gl.h"
+#include "../gl/instanced_circles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using mockgl::MockGl;
+
+static const GLuint kProgram = 21;
+static const int kWidth = 1080;
+static const int kHeight = 2400;
+
+static double nowSeconds() {
+    using Clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
+
+// The program as a driver would report it (locations in no useful order)
+static void addCircleProgram(MockGl& mock) {
+    mock.addProgram(kProgram,
+                    {{"aMotion", 0, 1, GL_FLOAT_VEC4},
+                     {"aColor", 1, 1, GL_FLOAT_VEC4},
+                     {"aPosition", 3, 1, GL_FLOAT_VEC2},
+                     {"aRadius", 5, 1, GL_FLOAT}},
+                    {{"uTime", 2, 1, GL_FLOAT}, {"uRadiusScale", 7, 1, GL_FLOAT_VEC2}});
+}
+
+// A fresh context with the scene set up, as after onSurfaceCreated()
+struct Scene {
+    MockGl mock;
+    gl::GlStateCache cache;
+    gl::InstancedCircles circles;
+    bool ok;
+
+    Scene(const gl::GlDispatch& dispatch, int count) : cache(dispatch) {
+        addCircleProgram(mock);
+        cache.registerProgram(kProgram);
+        cache.clearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        cache.viewport(0, 0, kWidth, kHeight);
+        ok = circles.init(cache, kProgram, gl::randomCircles(count, 42));
+    }
+};
+
+// Check 1
+static bool checkSamePixels() {
+    const int count = 300;
+    const float times[] = {0.0f, 1.7f, 12.3f, 95.0f};
+
+    Scene instanced(MockGl::dispatch(), count);
+    for (float t : times) {
+        instanced.cache.beginFrame();
+        instanced.circles.draw(instanced.cache, t, kWidth, kHeight);
+    }
+    uint32_t instancedDraws = instanced.cache.frameStats().draws;
+    std::vector<std::string> expected = instanced.mock.effects();
+    bool instancedOk = instanced.ok && instanced.mock.errors() == 0;
+
+    Scene oneByOne(MockGl::dispatchGles2(), count);
+    for (float t : times) {
+        oneByOne.cache.beginFrame();
+        oneByOne.circles.draw(oneByOne.cache, t, kWidth, kHeight);
+    }
+    uint32_t separateDraws = oneByOne.cache.frameStats().draws;
+    const std::vector<std::string>& actual = oneByOne.mock.effects();
+    bool separateOk = oneByOne.ok && oneByOne.mock.errors() == 0;
+
+    bool same = expected == actual;
+    if (!same) {
+        for (size_t i = 0; i < expected.size() && i < actual.size(); i++) {
+            if (expected[i] != actual[i]) {
+                printf("  effect %zu differs:\n    instanced   %s\n    one by one  %s\n", i,
+                       expected[i].c_str(), actual[i].c_str());
+                break;
+            }
+        }
+        printf("  %zu vs %zu effects\n", expected.size(), actual.size());
+    }
+
+    printf("  %d circles at %zu times: instanced (%u draw per frame) and one by one (%u "
+           "draws) identical: %s, mock GL errors: %s\n",
+           count, sizeof(times) / sizeof(times[0]), instancedDraws, separateDraws,
+           same ? "yes" : "NO", instancedOk && separateOk ? "none" : "SOME");
+    return same && instancedOk && separateOk && instancedDraws == 1 &&
+           separateDraws == static_cast<uint32_t>(count);
+}
+
+struct FrameCost {
+    uint32_t issued;
+    uint32_t skipped;
+    uint32_t draws;
+    double microseconds;
+};
+
+// Steady-state frame: calls of the last frame, best CPU time of `frames`
+static FrameCost measureFrames(const gl::GlDispatch& dispatch, int count, int frames) {
+    Scene scene(dispatch, count);
+    scene.mock.setRecording(false);
+    FrameCost cost = {0, 0, 0, 1e30};
+    for (int frame = 0; frame < frames; frame++) {
+        scene.cache.beginFrame();
+        double start = nowSeconds();
+        scene.circles.draw(scene.cache, frame / 60.0f, kWidth, kHeight);
+        double elapsed = (nowSeconds() - start) * 1e6;
+        if (frame > 0) {
+            cost.microseconds = std::min(cost.microseconds, elapsed);
+        }
+        cost.issued = scene.cache.frameStats().issued;
+        cost.skipped = scene.cache.frameStats().skipped;
+        cost.draws = scene.cache.frameStats().draws;
+    }
+    return cost;
+}
+
+// Check 2
+static bool checkFlatCost(int frames) {
+    const int counts[] = {1000, 10000, 100000};
+
+    printf("  %-8s %-11s %9s %9s %7s %12s\n", "circles", "path", "issued", "skipped", "draws",
+           "CPU us/frame");
+    bool ok = true;
+    FrameCost first = {};
+    for (int count : counts) {
+        FrameCost instanced = measureFrames(MockGl::dispatch(), count, frames);
+        // One by one is only there for contrast: fewer frames will do
+        FrameCost separate =
+                measureFrames(MockGl::dispatchGles2(), count, std::min(frames, 5));
+        printf("  %-8d %-11s %9u %9u %7u %12.2f\n", count, "instanced", instanced.issued,
+               instanced.skipped, instanced.draws, instanced.microseconds);
+        printf("  %-8d %-11s %9u %9u %7u %12.2f\n", count, "one by one", separate.issued,
+               separate.skipped, separate.draws, separate.microseconds);
+        if (count == counts[0]) {
+            first = instanced;
+        }
+        ok &= instanced.draws == 1 && instanced.issued == first.issued &&
+              instanced.skipped == first.skipped;
+    }
+    printf("  instanced calls per frame independent of the count: %s\n", ok ? "yes" : "NO");
+    return ok;
+}
+
+// Check 3: step each coordinate by a small dt, reflecting off r and 1 - r
+static bool checkBounce() {
+    std::vector<gl::CircleInstance> circles = gl::randomCircles(200, 7);
+    const double dt = 1.0 / 2000.0;
+    const int seconds = 30;
+    float worst = 0.0f;
+    for (const gl::CircleInstance& circle : circles) {
+        double x = circle.x;
+        double v = circle.velocityX;
+        double r = circle.radius;
+        for (int step = 1; step <= seconds * 2000; step++) {
+            x += v * dt;
+            if (x < r) {
+                x = 2.0 * r - x;
+                v = -v;
+            } else if (x > 1.0 - r) {
+                x = 2.0 * (1.0 - r) - x;
+                v = -v;
+            }
+            if (step % 2000 == 0) {
+                float t = static_cast<float>(step * dt);
+                float closed = gl::bounce(circle.x, circle.velocityX, circle.radius, t);
+                worst = std::max(worst, std::fabs(closed - static_cast<float>(x)));
+            }
+        }
+    }
+    bool ok = worst < 1e-4f;
+    printf("  200 circles over %d s: worst difference from stepping %.2g (%s)\n", seconds,
+           worst, ok ? "ok" : "TOO FAR");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int frames = 50;
+    if (argc > 1 && atoi(argv[1]) > 0) {
+        frames = atoi(argv[1]);
+    }
+
+    printf("Instanced vs one draw per circle:\n");
+    bool pixelsOk = checkSamePixels();
+
+    printf("\nCost per frame:\n");
+    bool flatOk = checkFlatCost(frames);
+
+    printf("\nClosed-form motion:\n");
+    bool bounceOk = checkBounce();
+
+    if (!(pixelsOk && flatOk && bounceOk)) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1026 @@
+/**
+ * bench/mock_gl.cpp: MockGl
+ */
+
+#include "mock_gl.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+
+namespace mockgl {
+
+namespace {
+
+MockGl* g_current = nullptr;
+
+const char* const kEntryNames[kEntryCount] = {
+    "glClear",
+    "glClearColor",
+    "glViewport",
+    "glEnable",
+    "glDisable",
+    "glBlendFunc",
+    "glUseProgram",
+    "glBindBuffer",
+    "glDeleteBuffers",
+    "glDeleteProgram",
+    "glGenBuffers",
+    "glBufferData",
+    "glEnableVertexAttribArray",
+    "glDisableVertexAttribArray",
+    "glVertexAttribPointer",
+    "glVertexAttrib4f",
+    "glUniform1f",
+    "glUniform2f",
+    "glUniform4f",
+    "glUniformMatrix4fv",
+    "glDrawArrays",
+    "glDrawArraysInstanced",
+    "glVertexAttribDivisor",
+    "glBufferSubData",
+    "glDrawElements",
+    "glMapBufferRange",
+    "glUnmapBuffer",
+    "glFenceSync",
+    "glClientWaitSync",
+    "glDeleteSync",
+    "glGetProgramiv",
+    "glGetActiveAttrib",
+    "glGetActiveUniform",
+    "glGetAttribLocation",
+    "glGetUniformLocation",
+    "glCreateProgram",
+    "glGetProgramBinary",
+    "glProgramBinary",
+    "glProgramParameteri",
+};
+
+// "name" finds "name[0]" too, as in GL
+const Variable* findVariable(const std::vector<Variable>& variables, const char* name) {
+    for (const Variable& variable : variables) {
+        if (variable.name == name ||
+            (variable.size > 1 && variable.name == std::string(name) + "[0]")) {
+            return &variable;
+        }
+    }
+    return nullptr;
+}
+
+void copyActive(const Variable& variable, GLsizei bufSize, GLsizei* length, GLint* size,
+                GLenum* type, GLchar* name) {
+    GLsizei n = 0;
+    if (bufSize > 0) {
+        n = static_cast<GLsizei>(variable.name.size());
+        if (n > bufSize - 1) {
+            n = bufSize - 1;
+        }
+        memcpy(name, variable.name.data(), n);
+        name[n] = '\0';
+    }
+    if (length) {
+        *length = n;
+    }
+    *size = variable.size;
+    *type = variable.type;
+}
+
+} // namespace
+
+const char* entryName(Entry entry) {
+    return entry < kEntryCount ? kEntryNames[entry] : "?";
+}
+
+// ============================================================================
+// THE DISPATCH FUNCTIONS
+// ============================================================================
+
+struct MockGl::Calls {
+    static MockGl& gl(Entry entry) {
+        g_current->m_calls[entry]++;
+        return *g_current;
+    }
+
+    static void GL_APIENTRY clear(GLbitfield mask) {
+        MockGl& gl = Calls::gl(kClear);
+        if (!gl.m_recording) {
+            return;
+        }
+        char line[160];
+        snprintf(line, sizeof(line), "clear 0x%x color %g %g %g %g viewport %d %d %d %d", mask,
+                 gl.m_clearColor[0], gl.m_clearColor[1], gl.m_clearColor[2],
+                 gl.m_clearColor[3], gl.m_viewport[0], gl.m_viewport[1], gl.m_viewport[2],
+                 gl.m_viewport[3]);
+        gl.m_effects.push_back(line);
+    }
+
+    static void GL_APIENTRY clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+        MockGl& gl = Calls::gl(kClearColor);
+        const float color[4] = {r, g, b, a};
+        memcpy(gl.m_clearColor, color, sizeof(color));
+    }
+
+    static void GL_APIENTRY viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        MockGl& gl = Calls::gl(kViewport);
+        const GLint rect[4] = {x, y, width, height};
+        memcpy(gl.m_viewport, rect, sizeof(rect));
+    }
+
+    static void GL_APIENTRY enable(GLenum cap) {
+        MockGl& gl = Calls::gl(kEnable);
+        if (cap != GL_BLEND) {
+            gl.error("glEnable of a capability the mock doesn't keep");
+            return;
+        }
+        gl.m_blend = true;
+    }
+
+    static void GL_APIENTRY disable(GLenum cap) {
+        MockGl& gl = Calls::gl(kDisable);
+        if (cap != GL_BLEND) {
+            gl.error("glDisable of a capability the mock doesn't keep");
+            return;
+        }
+        gl.m_blend = false;
+    }
+
+    static void GL_APIENTRY blendFunc(GLenum sfactor, GLenum dfactor) {
+        MockGl& gl = Calls::gl(kBlendFunc);
+        gl.m_blendFunc[0] = sfactor;
+        gl.m_blendFunc[1] = dfactor;
+    }
+
+    static void GL_APIENTRY useProgram(GLuint program) {
+        MockGl& gl = Calls::gl(kUseProgram);
+        auto it = gl.m_programs.find(program);
+        if (program != 0 &&
+            (it == gl.m_programs.end() || it->second.deleted || !it->second.linked)) {
+            gl.error("glUseProgram of a program that isn't linked");
+            return;
+        }
+        // A program deleted while current goes away once it isn't
+        auto previous = gl.m_programs.find(gl.m_program);
+        if (previous != gl.m_programs.end() && previous->second.deleted &&
+            gl.m_program != program) {
+            gl.m_programs.erase(previous);
+        }
+        gl.m_program = program;
+    }
+
+    static void GL_APIENTRY bindBuffer(GLenum target, GLuint buffer) {
+        MockGl& gl = Calls::gl(kBindBuffer);
+        if (target == GL_ARRAY_BUFFER) {
+            gl.m_arrayBuffer = buffer;
+        } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            gl.m_elementBuffer = buffer;
+        } else {
+            gl.error("glBindBuffer target");
+        }
+    }
+
+    static void GL_APIENTRY deleteBuffers(GLsizei n, const GLuint* buffers) {
+        MockGl& gl = Calls::gl(kDeleteBuffers);
+        for (GLsizei i = 0; i < n; i++) {
+            GLuint buffer = buffers[i];
+            if (buffer == 0) {
+                continue;
+            }
+            if (gl.m_arrayBuffer == buffer) {
+                gl.m_arrayBuffer = 0;
+            }
+            if (gl.m_elementBuffer == buffer) {
+                gl.m_elementBuffer = 0;
+            }
+            for (AttribPointer& pointer : gl.m_pointers) {
+                if (pointer.buffer == buffer) {
+                    pointer.buffer = 0;
+                }
+            }
+            gl.m_buffers.erase(buffer);
+            gl.m_storage.erase(buffer);
+            if (gl.m_mapping.active && gl.m_mapping.buffer == buffer) {
+                gl.m_mapping.active = false;
+            }
+        }
+    }
+
+    static void GL_APIENTRY genBuffers(GLsizei n, GLuint* buffers) {
+        MockGl& gl = Calls::gl(kGenBuffers);
+        for (GLsizei i = 0; i < n; i++) {
+            buffers[i] = gl.m_nextBuffer++;
+        }
+    }
+
+    static void GL_APIENTRY bufferData(GLenum target, GLsizeiptr size, const void* data,
+                                       GLenum /*usage*/) {
+        MockGl& gl = Calls::gl(kBufferData);
+        GLuint buffer = gl.bound(target);
+        if (buffer == 0 || size < 0) {
+            gl.error("glBufferData with no buffer bound");
+            return;
+        }
+        if (gl.m_mapping.active && gl.m_mapping.buffer == buffer) {
+            gl.error("glBufferData of a mapped buffer");
+            return;
+        }
+        // New storage: draws still pending read the old one (orphaning)
+        gl.m_storage[buffer]++;
+        std::vector<uint8_t>& contents = gl.m_buffers[buffer];
+        contents.assign(size, 0);
+        if (data) {
+            memcpy(contents.data(), data, size);
+        }
+    }
+
+    static void GL_APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                                          const void* data) {
+        MockGl& gl = Calls::gl(kBufferSubData);
+        GLuint buffer = gl.bound(target);
+        auto contents = gl.m_buffers.find(buffer);
+        if (contents == gl.m_buffers.end() || offset < 0 || size < 0 ||
+            static_cast<size_t>(offset + size) > contents->second.size()) {
+            gl.error("glBufferSubData outside the bound buffer");
+            return;
+        }
+        if (gl.m_mapping.active && gl.m_mapping.buffer == buffer) {
+            gl.error("glBufferSubData of a mapped buffer");
+            return;
+        }
+        // The driver has to wait for (or copy around) draws that read it
+        if (gl.inFlight(buffer, offset, offset + size)) {
+            gl.m_stalls++;
+            gl.finishGpu();
+        }
+        memcpy(contents->second.data() + offset, data, size);
+    }
+
+    static void* GL_APIENTRY mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+                                            GLbitfield access) {
+        MockGl& gl = Calls::gl(kMapBufferRange);
+        GLuint buffer = gl.bound(target);
+        auto contents = gl.m_buffers.find(buffer);
+        if (contents == gl.m_buffers.end() || offset < 0 || length <= 0 ||
+            static_cast<size_t>(offset + length) > contents->second.size() ||
+            !(access & GL_MAP_WRITE_BIT) || gl.m_mapping.active) {
+            gl.error("glMapBufferRange range, access, or buffer already mapped");
+            return nullptr;
+        }
+        if (access & GL_MAP_INVALIDATE_BUFFER_BIT) {
+            gl.m_storage[buffer]++;
+        } else if (!(access & GL_MAP_UNSYNCHRONIZED_BIT) &&
+                   gl.inFlight(buffer, offset, offset + length)) {
+            gl.m_stalls++;
+            gl.finishGpu();
+        }
+
+        Mapping& mapping = gl.m_mapping;
+        mapping.active = true;
+        mapping.target = target;
+        mapping.buffer = buffer;
+        mapping.offset = offset;
+        mapping.access = access;
+        if (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)) {
+            mapping.bytes.assign(length, 0xCD);  // Undefined: anything not written shows
+        } else {
+            mapping.bytes.assign(contents->second.begin() + offset,
+                                 contents->second.begin() + offset + length);
+        }
+        return mapping.bytes.data();
+    }
+
+    static GLboolean GL_APIENTRY unmapBuffer(GLenum target) {
+        MockGl& gl = Calls::gl(kUnmapBuffer);
+        Mapping& mapping = gl.m_mapping;
+        if (!mapping.active || gl.bound(target) != mapping.buffer) {
+            gl.error("glUnmapBuffer of a buffer that isn't mapped");
+            return GL_FALSE;
+        }
+        mapping.active = false;
+        size_t end = mapping.offset + mapping.bytes.size();
+        if ((mapping.access & GL_MAP_UNSYNCHRONIZED_BIT) &&
+            gl.inFlight(mapping.buffer, mapping.offset, end)) {
+            gl.error("unsynchronized write over bytes a pending draw reads");
+        }
+        std::vector<uint8_t>& contents = gl.m_buffers[mapping.buffer];
+        std::copy(mapping.bytes.begin(), mapping.bytes.end(), contents.begin() + mapping.offset);
+        return GL_TRUE;
+    }
+
+    static GLsync GL_APIENTRY fenceSync(GLenum condition, GLbitfield flags) {
+        MockGl& gl = Calls::gl(kFenceSync);
+        if (condition != GL_SYNC_GPU_COMMANDS_COMPLETE || flags != 0) {
+            gl.error("glFenceSync condition or flags");
+            return nullptr;
+        }
+        uint64_t id = ++gl.m_fences;
+        gl.m_syncs.insert(id);
+        // The GPU has caught up to `latency` fences behind this one
+        if (gl.m_fences > static_cast<uint64_t>(gl.m_gpuLatency)) {
+            gl.m_signalled = std::max(gl.m_signalled, gl.m_fences - gl.m_gpuLatency);
+        }
+        return reinterpret_cast<GLsync>(static_cast<uintptr_t>(id));
+    }
+
+    static GLenum GL_APIENTRY clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+        MockGl& gl = Calls::gl(kClientWaitSync);
+        uint64_t id = reinterpret_cast<uintptr_t>(sync);
+        if (gl.m_syncs.count(id) == 0 || (flags & ~GL_SYNC_FLUSH_COMMANDS_BIT) != 0) {
+            gl.error("glClientWaitSync of an unknown fence, or flags");
+            return GL_WAIT_FAILED;
+        }
+        if (id <= gl.m_signalled) {
+            return GL_ALREADY_SIGNALED;
+        }
+        if (timeout == 0) {
+            return GL_TIMEOUT_EXPIRED;
+        }
+        // Blocked until the GPU got there
+        gl.m_signalled = id;
+        gl.m_syncWaits++;
+        return GL_CONDITION_SATISFIED;
+    }
+
+    static void GL_APIENTRY deleteSync(GLsync sync) {
+        MockGl& gl = Calls::gl(kDeleteSync);
+        uint64_t id = reinterpret_cast<uintptr_t>(sync);
+        if (id != 0 && gl.m_syncs.erase(id) == 0) {
+            gl.error("glDeleteSync of an unknown fence");
+        }
+    }
+
+    static void GL_APIENTRY deleteProgram(GLuint program) {
+        MockGl& gl = Calls::gl(kDeleteProgram);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end()) {
+            return;
+        }
+        if (program == gl.m_program) {
+            it->second.deleted = true;
+        } else {
+            gl.m_programs.erase(it);
+        }
+    }
+
+    static void GL_APIENTRY enableVertexAttribArray(GLuint index) {
+        MockGl& gl = Calls::gl(kEnableVertexAttribArray);
+        if (index >= kMaxAttribs) {
+            gl.error("glEnableVertexAttribArray index");
+            return;
+        }
+        gl.m_enabled[index] = true;
+    }
+
+    static void GL_APIENTRY disableVertexAttribArray(GLuint index) {
+        MockGl& gl = Calls::gl(kDisableVertexAttribArray);
+        if (index >= kMaxAttribs) {
+            gl.error("glDisableVertexAttribArray index");
+            return;
+        }
+        gl.m_enabled[index] = false;
+    }
+
+    static void GL_APIENTRY vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                                               GLboolean normalized, GLsizei stride,
+                                               const void* pointer) {
+        MockGl& gl = Calls::gl(kVertexAttribPointer);
+        if (index >= kMaxAttribs || size < 1 || size > 4) {
+            gl.error("glVertexAttribPointer index or size");
+            return;
+        }
+        AttribPointer& p = gl.m_pointers[index];
+        p.size = size;
+        p.type = type;
+        p.normalized = normalized;
+        p.stride = stride;
+        p.pointer = pointer;
+        p.buffer = gl.m_arrayBuffer;
+    }
+
+    static void GL_APIENTRY vertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z,
+                                           GLfloat w) {
+        MockGl& gl = Calls::gl(kVertexAttrib4f);
+        if (index >= kMaxAttribs) {
+            gl.error("glVertexAttrib4f index");
+            return;
+        }
+        const float values[4] = {x, y, z, w};
+        memcpy(gl.m_pointers[index].constant, values, sizeof(values));
+    }
+
+    static void GL_APIENTRY vertexAttribDivisor(GLuint index, GLuint divisor) {
+        MockGl& gl = Calls::gl(kVertexAttribDivisor);
+        if (index >= kMaxAttribs) {
+            gl.error("glVertexAttribDivisor index");
+            return;
+        }
+        gl.m_pointers[index].divisor = divisor;
+    }
+
+    static void GL_APIENTRY uniform1f(GLint location, GLfloat x) {
+        gl(kUniform1f).setUniform(location, &x, 1);
+    }
+
+    static void GL_APIENTRY uniform2f(GLint location, GLfloat x, GLfloat y) {
+        const float values[2] = {x, y};
+        gl(kUniform2f).setUniform(location, values, 2);
+    }
+
+    static void GL_APIENTRY uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z,
+                                      GLfloat w) {
+        const float values[4] = {x, y, z, w};
+        gl(kUniform4f).setUniform(location, values, 4);
+    }
+
+    static void GL_APIENTRY uniformMatrix4fv(GLint location, GLsizei count,
+                                             GLboolean transpose, const GLfloat* value) {
+        MockGl& gl = Calls::gl(kUniformMatrix4fv);
+        if (count != 1 || transpose != GL_FALSE) {
+            gl.error("glUniformMatrix4fv count or transpose");
+            return;
+        }
+        gl.setUniform(location, value, 16);
+    }
+
+    static void GL_APIENTRY drawArrays(GLenum mode, GLint first, GLsizei count) {
+        MockGl& gl = Calls::gl(kDrawArrays);
+        if (!gl.current()) {
+            gl.error("glDrawArrays without a program");
+            return;
+        }
+        gl.addReads(first, count, 1);
+        if (gl.m_recording) {
+            char what[64];
+            snprintf(what, sizeof(what), "draw 0x%x %d+%d", mode, first, count);
+            gl.recordDraw(what, 0);
+        }
+    }
+
+    static void GL_APIENTRY drawElements(GLenum mode, GLsizei count, GLenum type,
+                                         const void* indices) {
+        MockGl& gl = Calls::gl(kDrawElements);
+        size_t indexBytes = type == GL_UNSIGNED_BYTE    ? 1
+                            : type == GL_UNSIGNED_SHORT ? 2
+                            : type == GL_UNSIGNED_INT   ? 4
+                                                        : 0;
+        size_t offset = reinterpret_cast<uintptr_t>(indices);
+        auto contents = gl.m_buffers.find(gl.m_elementBuffer);
+        if (!gl.current() || indexBytes == 0 || count < 0 ||
+            contents == gl.m_buffers.end() || offset % indexBytes != 0 ||
+            offset + count * indexBytes > contents->second.size()) {
+            gl.error("glDrawElements without a program, or indices outside the element buffer");
+            return;
+        }
+        gl.addRead(gl.m_elementBuffer, offset, offset + count * indexBytes);
+
+        std::string what;
+        char part[64];
+        snprintf(part, sizeof(part), "draw 0x%x elements", mode);
+        what = part;
+        uint32_t lowest = 0xFFFFFFFFu;
+        uint32_t highest = 0;
+        for (GLsizei i = 0; i < count; i++) {
+            uint32_t index = 0;
+            memcpy(&index, contents->second.data() + offset + i * indexBytes, indexBytes);
+            lowest = std::min(lowest, index);
+            highest = std::max(highest, index);
+            if (gl.m_recording) {
+                snprintf(part, sizeof(part), " %u", index);
+                what += part;
+            }
+        }
+        if (count > 0) {
+            gl.addReads(lowest, highest - lowest + 1, 1);
+        }
+        gl.recordDraw(what.c_str(), 0);
+    }
+
+    // Recorded as the `instances` draws it replaces
+    static void GL_APIENTRY drawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+                                                GLsizei instances) {
+        MockGl& gl = Calls::gl(kDrawArraysInstanced);
+        if (!gl.current()) {
+            gl.error("glDrawArraysInstanced without a program");
+            return;
+        }
+        gl.addReads(first, count, instances);
+        char what[64] = "";
+        if (gl.m_recording) {
+            snprintf(what, sizeof(what), "draw 0x%x %d+%d", mode, first, count);
+        }
+        for (GLsizei i = 0; gl.m_recording && i < instances; i++) {
+            gl.recordDraw(what, i);
+        }
+    }
+
+    static void GL_APIENTRY getProgramiv(GLuint program, GLenum pname, GLint* params) {
+        MockGl& gl = Calls::gl(kGetProgramiv);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end()) {
+            gl.error("glGetProgramiv of an unknown program");
+            return;
+        }
+        switch (pname) {
+            case GL_LINK_STATUS:
+                *params = it->second.linked ? GL_TRUE : GL_FALSE;
+                break;
+            case GL_PROGRAM_BINARY_LENGTH:
+                *params = it->second.linked && it->second.retrievable
+                                  ? static_cast<GLint>(gl.saveBinary(it->second).size())
+                                  : 0;
+                break;
+            case GL_ACTIVE_ATTRIBUTES:
+                *params = static_cast<GLint>(it->second.attribs.size());
+                break;
+            case GL_ACTIVE_UNIFORMS:
+                *params = static_cast<GLint>(it->second.uniforms.size());
+                break;
+            default:
+                gl.error("glGetProgramiv pname");
+                break;
+        }
+    }
+
+    static void GL_APIENTRY getActiveAttrib(GLuint program, GLuint index, GLsizei bufSize,
+                                            GLsizei* length, GLint* size, GLenum* type,
+                                            GLchar* name) {
+        MockGl& gl = Calls::gl(kGetActiveAttrib);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end() || index >= it->second.attribs.size()) {
+            gl.error("glGetActiveAttrib program or index");
+            return;
+        }
+        copyActive(it->second.attribs[index], bufSize, length, size, type, name);
+    }
+
+    static void GL_APIENTRY getActiveUniform(GLuint program, GLuint index, GLsizei bufSize,
+                                             GLsizei* length, GLint* size, GLenum* type,
+                                             GLchar* name) {
+        MockGl& gl = Calls::gl(kGetActiveUniform);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end() || index >= it->second.uniforms.size()) {
+            gl.error("glGetActiveUniform program or index");
+            return;
+        }
+        copyActive(it->second.uniforms[index], bufSize, length, size, type, name);
+    }
+
+    static GLint GL_APIENTRY getAttribLocation(GLuint program, const GLchar* name) {
+        MockGl& gl = Calls::gl(kGetAttribLocation);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end()) {
+            gl.error("glGetAttribLocation of an unknown program");
+            return -1;
+        }
+        const Variable* attrib = findVariable(it->second.attribs, name);
+        return attrib ? attrib->location : -1;
+    }
+
+    static GLint GL_APIENTRY getUniformLocation(GLuint program, const GLchar* name) {
+        MockGl& gl = Calls::gl(kGetUniformLocation);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end()) {
+            gl.error("glGetUniformLocation of an unknown program");
+            return -1;
+        }
+        const Variable* uniform = findVariable(it->second.uniforms, name);
+        return uniform ? uniform->location : -1;
+    }
+
+    static GLuint GL_APIENTRY createProgram() {
+        MockGl& gl = Calls::gl(kCreateProgram);
+        GLuint id = gl.m_nextProgram++;
+        gl.m_programs[id].linked = false;
+        return id;
+    }
+
+    static void GL_APIENTRY getProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length,
+                                             GLenum* binaryFormat, void* binary) {
+        MockGl& gl = Calls::gl(kGetProgramBinary);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end() || !it->second.linked || !it->second.retrievable) {
+            gl.error("glGetProgramBinary of a program that isn't linked, or keeps no binary");
+            return;
+        }
+        std::vector<uint8_t> bytes = gl.saveBinary(it->second);
+        if (bufSize < static_cast<GLsizei>(bytes.size())) {
+            gl.error("glGetProgramBinary buffer smaller than GL_PROGRAM_BINARY_LENGTH");
+            return;
+        }
+        memcpy(binary, bytes.data(), bytes.size());
+        if (length) {
+            *length = static_cast<GLsizei>(bytes.size());
+        }
+        *binaryFormat = kBinaryFormat;
+    }
+
+    static void GL_APIENTRY programBinary(GLuint program, GLenum binaryFormat,
+                                          const void* binary, GLsizei length) {
+        MockGl& gl = Calls::gl(kProgramBinary);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end() || binaryFormat != kBinaryFormat || length < 0) {
+            gl.error("glProgramBinary of an unknown program or format");
+            return;
+        }
+        // Not an error: the program just doesn't link
+        Program& target = it->second;
+        target.values.clear();
+        target.linked = gl.loadBinary(static_cast<const uint8_t*>(binary), length, &target);
+        if (!target.linked) {
+            target.attribs.clear();
+            target.uniforms.clear();
+        }
+    }
+
+    static void GL_APIENTRY programParameteri(GLuint program, GLenum pname, GLint value) {
+        MockGl& gl = Calls::gl(kProgramParameteri);
+        auto it = gl.m_programs.find(program);
+        if (it == gl.m_programs.end() || pname != GL_PROGRAM_BINARY_RETRIEVABLE_HINT ||
+            (value != GL_TRUE && value != GL_FALSE)) {
+            gl.error("glProgramParameteri program, pname or value");
+            return;
+        }
+        // Takes effect at the next link (addProgram())
+        it->second.hinted = value == GL_TRUE;
+    }
+};
+
+const gl::GlDispatch& MockGl::dispatch() {
+    static const gl::GlDispatch table = {
+        Calls::clear,
+        Calls::clearColor,
+        Calls::viewport,
+
+        Calls::enable,
+        Calls::disable,
+        Calls::blendFunc,
+
+        Calls::useProgram,
+        Calls::bindBuffer,
+        Calls::deleteBuffers,
+        Calls::deleteProgram,
+
+        Calls::genBuffers,
+        Calls::bufferData,
+        Calls::bufferSubData,
+
+        Calls::enableVertexAttribArray,
+        Calls::disableVertexAttribArray,
+        Calls::vertexAttribPointer,
+        Calls::vertexAttrib4f,
+
+        Calls::uniform1f,
+        Calls::uniform2f,
+        Calls::uniform4f,
+        Calls::uniformMatrix4fv,
+
+        Calls::drawArrays,
+        Calls::drawElements,
+
+        Calls::drawArraysInstanced,
+        Calls::vertexAttribDivisor,
+
+        Calls::mapBufferRange,
+        Calls::unmapBuffer,
+        Calls::fenceSync,
+        Calls::clientWaitSync,
+        Calls::deleteSync,
+
+        Calls::getProgramiv,
+        Calls::getActiveAttrib,
+        Calls::getActiveUniform,
+        Calls::getAttribLocation,
+        Calls::getUniformLocation,
+
+        Calls::createProgram,
+        Calls::getProgramBinary,
+        Calls::programBinary,
+        Calls::programParameteri,
+    };
+    return table;
+}
+
+const gl::GlDispatch& MockGl::dispatchGles2() {
+    static const gl::GlDispatch table = [] {
+        gl::GlDispatch gles2 = dispatch();
+        gles2.drawArraysInstanced = nullptr;
+        gles2.vertexAttribDivisor = nullptr;
+        gles2.mapBufferRange = nullptr;
+        gles2.unmapBuffer = nullptr;
+        gles2.fenceSync = nullptr;
+        gles2.clientWaitSync = nullptr;
+        gles2.deleteSync = nullptr;
+        gles2.getProgramBinary = nullptr;
+        gles2.programBinary = nullptr;
+        gles2.programParameteri = nullptr;
+        return gles2;
+    }();
+    return table;
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+MockGl::MockGl() {
+    g_current = this;
+}
+
+MockGl::~MockGl() {
+    if (g_current == this) {
+        g_current = nullptr;
+    }
+}
+
+void MockGl::addProgram(GLuint id, std::vector<Variable> attribs,
+                        std::vector<Variable> uniforms) {
+    Program& program = m_programs[id];
+    program.attribs = std::move(attribs);
+    program.uniforms = std::move(uniforms);
+    program.values.clear();
+    program.deleted = false;
+    program.linked = true;
+    program.retrievable = program.hinted;
+}
+
+// "mockbin", the driver build, then the attributes and uniforms:
+// location, size, type (4 bytes each) and the name, null terminated
+std::vector<uint8_t> MockGl::saveBinary(const Program& program) const {
+    std::vector<uint8_t> bytes;
+    auto append = [&bytes](const void* data, size_t size) {
+        size_t at = bytes.size();
+        bytes.resize(at + size);
+        memcpy(bytes.data() + at, data, size);
+    };
+    auto text = [&append](const std::string& s) { append(s.c_str(), s.size() + 1); };
+    auto word = [&append](uint32_t value) { append(&value, sizeof(value)); };
+    text("mockbin");
+    text(m_driverBuild);
+    for (const std::vector<Variable>* variables : {&program.attribs, &program.uniforms}) {
+        word(static_cast<uint32_t>(variables->size()));
+        for (const Variable& v : *variables) {
+            word(static_cast<uint32_t>(v.location));
+            word(static_cast<uint32_t>(v.size));
+            word(v.type);
+            text(v.name);
+        }
+    }
+    return bytes;
+}
+
+bool MockGl::loadBinary(const uint8_t* bytes, size_t length, Program* program) const {
+    size_t at = 0;
+    auto text = [&](std::string* s) {
+        const void* end = memchr(bytes + at, '\0', length - at);
+        if (!end) {
+            return false;
+        }
+        size_t size = static_cast<const uint8_t*>(end) - (bytes + at);
+        s->assign(reinterpret_cast<const char*>(bytes + at), size);
+        at += size + 1;
+        return true;
+    };
+    auto word = [&](uint32_t* value) {
+        if (length - at < sizeof(*value)) {
+            return false;
+        }
+        memcpy(value, bytes + at, sizeof(*value));
+        at += sizeof(*value);
+        return true;
+    };
+
+    std::string magic;
+    std::string build;
+    if (!text(&magic) || magic != "mockbin" || !text(&build) || build != m_driverBuild) {
+        return false;
+    }
+    for (std::vector<Variable>* variables : {&program->attribs, &program->uniforms}) {
+        uint32_t count = 0;
+        if (!word(&count) || count > 64) {
+            return false;
+        }
+        variables->clear();
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t location, size, type;
+            Variable v;
+            if (!word(&location) || !word(&size) || !word(&type) || !text(&v.name)) {
+                return false;
+            }
+            v.location = static_cast<GLint>(location);
+            v.size = static_cast<GLint>(size);
+            v.type = type;
+            variables->push_back(v);
+        }
+    }
+    return at == length;
+}
+
+const std::vector<uint8_t>* MockGl::bufferContents(GLuint buffer) const {
+    auto it = m_buffers.find(buffer);
+    return it == m_buffers.end() ? nullptr : &it->second;
+}
+
+uint64_t MockGl::totalCalls() const {
+    uint64_t total = 0;
+    for (uint64_t count : m_calls) {
+        total += count;
+    }
+    return total;
+}
+
+void MockGl::error(const char* what) {
+    // Only the first few: a broken sequence tends to repeat every frame
+    if (m_errors++ < 5) {
+        fprintf(stderr, "  mock GL error: %s\n", what);
+    }
+}
+
+MockGl::Program* MockGl::current() {
+    auto it = m_programs.find(m_program);
+    return m_program != 0 && it != m_programs.end() ? &it->second : nullptr;
+}
+
+void MockGl::setUniform(GLint location, const float* values, int count) {
+    Program* program = current();
+    if (!program) {
+        error("glUniform* without a program");
+        return;
+    }
+    if (location == -1) {
+        return;  // Silently ignored, as in GL
+    }
+    for (const Variable& uniform : program->uniforms) {
+        if (uniform.location == location) {
+            program->values[location].assign(values, values + count);
+            return;
+        }
+    }
+    error("glUniform* location not in the current program");
+}
+
+void MockGl::recordDraw(const char* what, GLsizei instance) {
+    if (!m_recording) {
+        return;
+    }
+    char part[96];
+    std::string text = what;
+    snprintf(part, sizeof(part), " program %u", m_program);
+    text += part;
+    // The blend function only matters while blending is on
+    if (m_blend) {
+        snprintf(part, sizeof(part), " blend 0x%x 0x%x", m_blendFunc[0], m_blendFunc[1]);
+        text += part;
+    }
+
+    // Attributes in location order, whatever order they were declared in
+    Program& program = *current();
+    std::map<GLint, const Variable*> attribs;
+    for (const Variable& attrib : program.attribs) {
+        attribs[attrib.location] = &attrib;
+    }
+    for (const auto& attrib : attribs) {
+        describeAttrib(text, attrib.first, instance);
+    }
+
+    for (const auto& value : program.values) {
+        snprintf(part, sizeof(part), " | uniform %d:", value.first);
+        text += part;
+        for (float v : value.second) {
+            snprintf(part, sizeof(part), " %g", v);
+            text += part;
+        }
+    }
+    m_effects.push_back(text);
+}
+
+bool MockGl::Range::operator<(const Range& other) const {
+    return std::tie(buffer, storage, begin, end) <
+           std::tie(other.buffer, other.storage, other.begin, other.end);
+}
+
+GLuint MockGl::bound(GLenum target) const {
+    return target == GL_ARRAY_BUFFER           ? m_arrayBuffer
+           : target == GL_ELEMENT_ARRAY_BUFFER ? m_elementBuffer
+                                               : 0;
+}
+
+void MockGl::addReads(GLint first, GLsizei count, GLsizei instances) {
+    Program* program = current();
+    if (!program || count <= 0) {
+        return;
+    }
+    for (const Variable& attrib : program->attribs) {
+        GLint index = attrib.location;
+        if (index < 0 || index >= kMaxAttribs || !m_enabled[index] ||
+            m_pointers[index].buffer == 0) {
+            continue;
+        }
+        const AttribPointer& p = m_pointers[index];
+        size_t componentBytes = p.type == GL_FLOAT                                    ? 4
+                                : p.type == GL_SHORT || p.type == GL_UNSIGNED_SHORT ? 2
+                                                                                      : 1;
+        size_t element = p.size * componentBytes;
+        size_t stride = p.stride ? p.stride : element;
+        size_t base = reinterpret_cast<uintptr_t>(p.pointer);
+        size_t elements = count;
+        if (p.divisor == 0) {
+            base += first * stride;
+        } else {
+            elements = (instances + p.divisor - 1) / p.divisor;
+        }
+        if (elements > 0) {
+            addRead(p.buffer, base, base + (elements - 1) * stride + element);
+        }
+    }
+}
+
+void MockGl::addRead(GLuint buffer, size_t begin, size_t end) {
+    if (m_mapping.active && m_mapping.buffer == buffer) {
+        error("draw reading a mapped buffer");
+    }
+    auto contents = m_buffers.find(buffer);
+    if (contents != m_buffers.end() && end > contents->second.size()) {
+        error("draw reading past the end of a buffer");
+    }
+    // Same bytes read again: pending until the later draw runs. (The
+    // same as the last draw's is the common case: skip the lookup.)
+    auto storage = m_storage.find(buffer);
+    Range range = {buffer, storage == m_storage.end() ? 0 : storage->second, begin, end};
+    if (m_lastReadValid && !(m_lastRead->first < range) && !(range < m_lastRead->first)) {
+        m_lastRead->second = m_fences;
+        return;
+    }
+    m_lastRead = m_reads.insert_or_assign(range, m_fences).first;
+    m_lastReadValid = true;
+}
+
+bool MockGl::inFlight(GLuint buffer, size_t begin, size_t end) {
+    auto storage = m_storage.find(buffer);
+    uint32_t current = storage == m_storage.end() ? 0 : storage->second;
+    bool found = false;
+    for (auto it = m_reads.begin(); it != m_reads.end();) {
+        const Range& range = it->first;
+        // Run by the GPU, or of storage orphaned since: can't conflict
+        bool stale = range.buffer == buffer && range.storage != current;
+        if (it->second < m_signalled || stale) {
+            m_lastReadValid &= it != m_lastRead;
+            it = m_reads.erase(it);
+            continue;
+        }
+        found |= range.buffer == buffer && range.begin < end && begin < range.end;
+        ++it;
+    }
+    return found;
+}
+
+void MockGl::finishGpu() {
+    m_signalled = m_fences;
+    m_reads.clear();
+    m_lastReadValid = false;
+}
+
+void MockGl::describeAttrib(std::string& text, GLint index, GLsizei instance) {
+    char part[96];
+    if (index < 0 || index >= kMaxAttribs) {
+        error("attribute location out of range");
+        return;
+    }
+    const AttribPointer& p = m_pointers[index];
+
+    // Per-vertex array: the array itself is the state
+    if (m_enabled[index] && p.divisor == 0) {
+        snprintf(part, sizeof(part), " | attrib %d: %dx0x%x%s stride %d @%p buffer %u", index,
+                 p.size, p.type, p.normalized ? " norm" : "", p.stride, p.pointer, p.buffer);
+        text += part;
+        return;
+    }
+
+    // Constant, or per instance: the value this instance reads
+    float value[4] = {p.constant[0], p.constant[1], p.constant[2], p.constant[3]};
+    if (m_enabled[index]) {
+        auto buffer = m_buffers.find(p.buffer);
+        int componentBytes = p.type == GL_FLOAT ? 4 : p.type == GL_UNSIGNED_BYTE ? 1 : 0;
+        size_t stride = p.stride ? p.stride : p.size * componentBytes;
+        size_t offset = reinterpret_cast<uintptr_t>(p.pointer) + stride * (instance / p.divisor);
+        if (buffer == m_buffers.end() || componentBytes == 0 ||
+            offset + p.size * componentBytes > buffer->second.size()) {
+            error("instanced attribute outside its buffer (or not float/ubyte)");
+            return;
+        }
+        const float defaults[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        memcpy(value, defaults, sizeof(value));
+        const uint8_t* bytes = buffer->second.data() + offset;
+        for (int c = 0; c < p.size; c++) {
+            if (p.type == GL_FLOAT) {
+                memcpy(&value[c], bytes + 4 * c, 4);
+            } else {
+                value[c] = p.normalized ? bytes[c] / 255.0f : bytes[c];
+            }
+        }
+    }
+    snprintf(part, sizeof(part), " | attrib %d = %g %g %g %g", index, value[0], value[1],
+             value[2], value[3]);
+    text += part;
+}
+
+} // namespace mockgl
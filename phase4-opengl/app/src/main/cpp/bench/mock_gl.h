@@ -0,0 +1,253 @@
+/**
+ * bench/mock_gl.h: A pretend GL context for running GL code on a host
+ *
+ * Fills a gl::GlDispatch (gl/gl_dispatch.h) with functions that keep the
+ * state real GL would keep (current program, buffer bindings, enabled
+ * attribute arrays and their pointers, per-program uniform values, clear
+ * color, viewport, blending) and draw nothing. What it records instead:
+ *
+ * - how many times each entry point was called,
+ * - calls real GL would reject (errors()): using a program it never
+ *   linked, setting a uniform with no program or at a location the
+ *   program doesn't have, drawing without a program...
+ * - an "effect" line for every clear and draw, spelling out all the
+ *   state that reaches the GPU at that moment: the program, blending, its uniforms
+ *   and, for each of its attributes, either the array it reads or the
+ *   constant value it gets (glVertexAttrib4f).
+ *
+ * An instanced draw of N instances is recorded as the N draws it stands
+ * for, reading each instance's attribute values out of the buffer data,
+ * so an instanced pass can be compared with one draw per instance.
+ *
+ * A GPU THAT LAGS BEHIND: every draw remembers the buffer bytes it reads
+ * (vertex arrays, indices) until the GPU "runs" it. The pretend GPU is
+ * setGpuLatency() fences behind: when fence k is inserted, fence k -
+ * latency signals, and with it every draw before that. Writing over bytes
+ * a pending draw reads is then:
+ * - with glBufferSubData() or a synchronized map: a stall (stalls()): the
+ *   driver would wait for the GPU, which the mock does at once;
+ * - with GL_MAP_UNSYNCHRONIZED_BIT: an error, the draw would read the
+ *   new bytes.
+ * glBufferData() gives the buffer new storage (orphaning): pending draws
+ * keep the old one. Blocking in glClientWaitSync() counts as a sync wait
+ * (syncWaits()) and signals the fence.
+ *
+ * Two call sequences that produce the same effects draw the same pixels
+ * on a real GPU, whatever calls they made on the way: that's how the
+ * state cache is checked against the uncached renderer.
+ *
+ * Programs aren't compiled: addProgram() declares one as linked with
+ * the given attributes and uniforms. glGetProgramBinary() spells those
+ * out, tagged with the driver build (setDriverBuild()), and
+ * glProgramBinary() links a program from such bytes; bytes it can't
+ * parse, or from another build, leave the program unlinked, as a driver
+ * refusing a binary does. Like some real drivers, it keeps no binary
+ * (GL_PROGRAM_BINARY_LENGTH 0) of a program that wasn't given
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT before addProgram(). Only one MockGl can be the target
+ * of dispatch() at a time (the most recently constructed), like one
+ * current context per thread.
+ */
+
+#ifndef PHASE4_BENCH_MOCK_GL_H
+#define PHASE4_BENCH_MOCK_GL_H
+
+#include "../gl/gl_dispatch.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mockgl {
+
+enum Entry {
+    kClear,
+    kClearColor,
+    kViewport,
+    kEnable,
+    kDisable,
+    kBlendFunc,
+    kUseProgram,
+    kBindBuffer,
+    kDeleteBuffers,
+    kDeleteProgram,
+    kGenBuffers,
+    kBufferData,
+    kEnableVertexAttribArray,
+    kDisableVertexAttribArray,
+    kVertexAttribPointer,
+    kVertexAttrib4f,
+    kUniform1f,
+    kUniform2f,
+    kUniform4f,
+    kUniformMatrix4fv,
+    kDrawArrays,
+    kDrawArraysInstanced,
+    kVertexAttribDivisor,
+    kBufferSubData,
+    kDrawElements,
+    kMapBufferRange,
+    kUnmapBuffer,
+    kFenceSync,
+    kClientWaitSync,
+    kDeleteSync,
+    kGetProgramiv,
+    kGetActiveAttrib,
+    kGetActiveUniform,
+    kGetAttribLocation,
+    kGetUniformLocation,
+    kCreateProgram,
+    kGetProgramBinary,
+    kProgramBinary,
+    kProgramParameteri,
+    kEntryCount
+};
+
+const char* entryName(Entry entry);
+
+// An active attribute or uniform as glGetActive* reports it
+struct Variable {
+    std::string name;  // Arrays as "name[0]"
+    GLint location;
+    GLint size;        // Array length, 1 otherwise
+    GLenum type;
+};
+
+class MockGl {
+public:
+    static constexpr int kMaxAttribs = 16;
+    static constexpr GLenum kBinaryFormat = 0x4D4F;  // The one program binary format
+
+
+    MockGl();
+    ~MockGl();
+
+    // The table to hand to gl::GlStateCache (or to call directly): a
+    // GLES 3 context, or a GLES 2 one (no instancing, mapping, fences or
+    // program binaries)
+    static const gl::GlDispatch& dispatch();
+    static const gl::GlDispatch& dispatchGles2();
+
+    // Declare program `id` as successfully linked
+    void addProgram(GLuint id, std::vector<Variable> attribs, std::vector<Variable> uniforms);
+    // Program binaries saved by another build are refused (default "1")
+    void setDriverBuild(const std::string& build) { m_driverBuild = build; }
+
+    uint64_t calls(Entry entry) const { return m_calls[entry]; }
+    uint64_t totalCalls() const;
+    int errors() const { return m_errors; }
+
+    const std::vector<std::string>& effects() const { return m_effects; }
+    // Off: draws are counted and checked but not described (for timing)
+    void setRecording(bool recording) { m_recording = recording; }
+
+    // How many fences the GPU runs behind (default 2)
+    void setGpuLatency(int fences) { m_gpuLatency = fences; }
+    uint64_t stalls() const { return m_stalls; }
+    uint64_t syncWaits() const { return m_syncWaits; }
+    // A buffer's current contents, or null if it has none
+    const std::vector<uint8_t>* bufferContents(GLuint buffer) const;
+
+private:
+    struct Program {
+        std::vector<Variable> attribs;
+        std::vector<Variable> uniforms;
+        std::map<GLint, std::vector<float>> values;  // By location
+        bool deleted = false;      // Deleted while current: freed at the next switch
+        bool linked = true;        // False from glCreateProgram until a binary loads
+        bool hinted = false;       // GL_PROGRAM_BINARY_RETRIEVABLE_HINT, for the next link
+        bool retrievable = false;  // Linked with the hint: the binary can be read back
+    };
+
+    // A linked program as glGetProgramBinary() hands it out, and back
+    std::vector<uint8_t> saveBinary(const Program& program) const;
+    bool loadBinary(const uint8_t* bytes, size_t length, Program* program) const;
+
+    struct AttribPointer {
+        GLint size = 4;
+        GLenum type = GL_FLOAT;
+        GLboolean normalized = GL_FALSE;
+        GLsizei stride = 0;
+        const void* pointer = nullptr;
+        GLuint buffer = 0;
+        GLuint divisor = 0;
+        float constant[4] = {0.0f, 0.0f, 0.0f, 1.0f};  // When the array is disabled
+    };
+
+    // Bytes [begin, end) of a buffer's storage that a draw reads
+    struct Range {
+        GLuint buffer;
+        uint32_t storage;  // Which glBufferData() of it
+        size_t begin;
+        size_t end;
+        bool operator<(const Range& other) const;
+    };
+
+    struct Mapping {
+        bool active = false;
+        GLenum target = 0;
+        GLuint buffer = 0;
+        size_t offset = 0;
+        GLbitfield access = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Calls;  // The dispatch functions (mock_gl.cpp)
+    friend struct Calls;
+
+    void error(const char* what);
+    // The current program if it was linked (or was, before a delete), or null
+    Program* current();
+    void setUniform(GLint location, const float* values, int count);
+    void recordDraw(const char* what, GLsizei instance);
+    // Remember what a draw of vertices [first, first + count) and
+    // `instances` instances reads, until the GPU gets to it
+    void addReads(GLint first, GLsizei count, GLsizei instances);
+    void addRead(GLuint buffer, size_t begin, size_t end);
+    // Whether a draw the GPU hasn't run reads [begin, end) of the buffer
+    bool inFlight(GLuint buffer, size_t begin, size_t end);
+    // Wait for the GPU to run everything so far
+    void finishGpu();
+    GLuint bound(GLenum target) const;
+    // One attribute as instance `instance` reads it, appended to `text`
+    void describeAttrib(std::string& text, GLint index, GLsizei instance);
+
+    uint64_t m_calls[kEntryCount] = {};
+    int m_errors = 0;
+    std::vector<std::string> m_effects;
+    bool m_recording = true;
+
+    std::map<GLuint, Program> m_programs;
+    GLuint m_nextProgram = 1000;  // glCreateProgram names (addProgram() ids stay below)
+    std::string m_driverBuild = "1";
+    GLuint m_program = 0;
+    GLuint m_arrayBuffer = 0;
+    GLuint m_elementBuffer = 0;
+    std::map<GLuint, std::vector<uint8_t>> m_buffers;  // Contents by name
+    std::map<GLuint, uint32_t> m_storage;               // glBufferData() count by name
+    Mapping m_mapping;
+    GLuint m_nextBuffer = 1000;
+    bool m_enabled[kMaxAttribs] = {};
+    AttribPointer m_pointers[kMaxAttribs];
+    float m_clearColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    GLint m_viewport[4] = {0, 0, 0, 0};
+    bool m_blend = false;                     // GL_BLEND, the one capability kept
+    GLenum m_blendFunc[2] = {GL_ONE, GL_ZERO};
+
+    // The pretend GPU: draws issued while `m_fences` fences existed run
+    // once fence m_fences + 1 signals, i.e. once m_signalled > m_fences
+    std::map<Range, uint64_t> m_reads;  // Pending reads, by the fence count at the draw
+    std::map<Range, uint64_t>::iterator m_lastRead;  // Valid while m_lastReadValid
+    bool m_lastReadValid = false;
+    uint64_t m_fences = 0;              // Fences inserted (fence k is GLsync k)
+    uint64_t m_signalled = 0;           // Fences 1..m_signalled have signalled
+    std::set<uint64_t> m_syncs;         // Fences not deleted yet
+    int m_gpuLatency = 2;
+    uint64_t m_stalls = 0;
+    uint64_t m_syncWaits = 0;
+};
+
+} // namespace mockgl
+
+#endif // PHASE4_BENCH_MOCK_GL_H
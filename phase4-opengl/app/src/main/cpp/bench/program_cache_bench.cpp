@@ -0,0 +1,239 @@
+/**
+ * bench/program_cache_bench.cpp: Program binaries saved and loaded across launches
+ *
+ * Each "launch" is a fresh mock GL context (bench/mock_gl.h) and a fresh
+ * gl::ProgramCache on the same directory, getting the SDF circle and the
+ * instanced circle programs the way initGL() does, then drawing with
+ * them. "Compiling" declares the program linked in the mock and is
+ * counted; like createProgram() in gl_renderer.cpp, it sets
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT first where the context has it.
+ *
+ * Checked (exit code 1 on failure), in order on one directory:
+ * 1. First launch: both compile, both binaries are saved.
+ * 2. Second launch: both load from their binaries, nothing compiles,
+ *    and the frame drawn with them is identical to the first launch's.
+ * 3. An edited shader misses (its key changed); the other still loads.
+ * 4. Another GL_RENDERER / GL_VERSION string misses: compiles, saves.
+ * 5. A driver that refuses the saved binaries under the same strings:
+ *    both rejected, compiled, saved again; the launch after loads.
+ * 6. A damaged and a truncated file are rejected without reaching the
+ *    driver; both programs compile and are saved again.
+ * 7. No binary support (GLES 2 without the extension) and no cache
+ *    directory: everything compiles, nothing is saved.
+ * 8. Linked without the retrievable hint, in a new directory: the mock
+ *    keeps no binary, so nothing is saved and the next launch compiles.
+ * Every launch draws correctly with no call GL would reject.
+ *
+ * The mock compiles for free, so this checks behavior, not time: on a
+ * device, logcat's "First frame" line has both (see gl_renderer.cpp).
+ *
+ * Usage: program_cache_bench
+ */
+
+#include "mock_gl.h"
+#include "../gl/instanced_circles.h"
+#include "../gl/program_cache.h"
+#include "../gl/sdf_circle.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using mockgl::MockGl;
+
+static const int kWidth = 1080;
+static const int kHeight = 2400;
+static const char* const kRenderer = "Mock GPU 640";
+static const char* const kVersion = "OpenGL ES 3.2 V@0615.0";
+static const float kColor[4] = {1.0f, 0.5f, 0.0f, 1.0f};
+
+// What "compiling" produced this launch
+static MockGl* g_mock = nullptr;
+static const gl::GlDispatch* g_dispatch = nullptr;
+static bool g_hint = true;  // Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking
+static int g_compiles = 0;
+
+// Link a program as the driver would report it: the SDF circle's or the
+// instanced circle's interface, by which shader it is
+static GLuint compile(const char* vertexSource, const char* /*fragmentSource*/) {
+    g_compiles++;
+    GLuint program = g_dispatch->createProgram();
+    if (g_hint && g_dispatch->programParameteri != nullptr) {
+        g_dispatch->programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if (strstr(vertexSource, "aCorner")) {
+        g_mock->addProgram(program, {{"aCorner", 1, 1, GL_FLOAT_VEC2}},
+                           {{"uCenter", 0, 1, GL_FLOAT_VEC2},
+                            {"uColor", 3, 1, GL_FLOAT_VEC4},
+                            {"uRadius", 4, 1, GL_FLOAT},
+                            {"uStroke", 6, 1, GL_FLOAT_VEC2},
+                            {"uViewport", 8, 1, GL_FLOAT_VEC2}});
+    } else {
+        g_mock->addProgram(program,
+                           {{"aMotion", 0, 1, GL_FLOAT_VEC4},
+                            {"aColor", 1, 1, GL_FLOAT_VEC4},
+                            {"aPosition", 3, 1, GL_FLOAT_VEC2},
+                            {"aRadius", 5, 1, GL_FLOAT}},
+                           {{"uTime", 2, 1, GL_FLOAT}, {"uRadiusScale", 7, 1, GL_FLOAT_VEC2}});
+    }
+    return program;
+}
+
+struct Launch {
+    gl::ProgramCacheStats stats;
+    int compiles;
+    uint64_t binaryLoads;  // glProgramBinary calls
+    std::string frame;  // The SDF circle's draw
+    bool ok;            // Both programs usable, no call GL would reject
+};
+
+struct Driver {
+    const gl::GlDispatch* dispatch;
+    const char* renderer;
+    const char* version;
+    const char* build;  // What the mock accepts binaries from
+};
+
+static const Driver kDriver = {&MockGl::dispatch(), kRenderer, kVersion, "1"};
+
+static Launch launch(const Driver& driver, const char* directory,
+                     const std::string& sdfVertex = gl::kSdfCircleVertexShader) {
+    MockGl mock;
+    mock.setDriverBuild(driver.build);
+    g_mock = &mock;
+    g_dispatch = driver.dispatch;
+    g_compiles = 0;
+
+    gl::ProgramCache programs;
+    programs.init(directory, driver.renderer, driver.version);
+    GLuint sdf = programs.getProgram(*driver.dispatch, sdfVertex.c_str(),
+                                     gl::kSdfCircleFragmentShader, compile);
+    GLuint instanced = programs.getProgram(*driver.dispatch, gl::kInstancedCircleVertexShader,
+                                           gl::kInstancedCircleFragmentShader, compile);
+
+    // Use them as initGL() and renderFrame() do
+    gl::GlStateCache cache(*driver.dispatch);
+    cache.registerProgram(sdf);
+    cache.registerProgram(instanced);
+    gl::SdfCirclePass pass;
+    gl::InstancedCircles circles;
+    bool ok = sdf != 0 && instanced != 0 && gl::prepareSdfCirclePass(cache, sdf, &pass) &&
+              circles.init(cache, instanced, gl::randomCircles(10, 1));
+    cache.viewport(0, 0, kWidth, kHeight);
+    gl::drawSdfCircle(cache, pass, 300.0f, 700.0f, 108.0f, gl::SdfCircleStyle(), kColor, kWidth,
+                      kHeight);
+
+    Launch result = {programs.stats(), g_compiles, mock.calls(mockgl::kProgramBinary), "", ok};
+    if (!mock.effects().empty()) {
+        result.frame = mock.effects().back();
+    }
+    gl::releaseSdfCirclePass(cache, &pass);
+    circles.release(cache);
+    result.ok &= mock.errors() == 0;
+    g_mock = nullptr;
+    g_dispatch = nullptr;
+    return result;
+}
+
+// Flip one byte `offset` from the end of a file, or cut it `offset` short
+static void damage(const std::string& path, long offset, bool truncate) {
+    std::vector<char> bytes;
+    if (FILE* in = fopen(path.c_str(), "rb")) {
+        int c;
+        while ((c = fgetc(in)) != EOF) {
+            bytes.push_back(static_cast<char>(c));
+        }
+        fclose(in);
+    }
+    if (bytes.size() <= static_cast<size_t>(offset)) {
+        return;
+    }
+    if (truncate) {
+        bytes.resize(bytes.size() - offset);
+    } else {
+        bytes[bytes.size() - offset] ^= 0x20;
+    }
+    if (FILE* out = fopen(path.c_str(), "wb")) {
+        fwrite(bytes.data(), 1, bytes.size(), out);
+        fclose(out);
+    }
+}
+
+static bool g_ok = true;
+
+// Print a launch and check its counts
+static void expect(const char* name, const Launch& l, int loaded, int compiled, int rejected,
+                   int stored) {
+    const gl::ProgramCacheStats& s = l.stats;
+    bool ok = l.ok && s.loaded == loaded && s.compiled == compiled && l.compiles == compiled &&
+              s.rejected == rejected && s.stored == stored;
+    printf("  %-44s %6d %8d %8d %6d  %s\n", name, s.loaded, s.compiled, s.rejected, s.stored,
+           ok ? "ok" : "<- FAIL");
+    g_ok &= ok;
+}
+
+int main() {
+    char pattern[] = "/tmp/program_cache_bench.XXXXXX";
+    const char* directory = mkdtemp(pattern);
+    if (!directory) {
+        printf("Can't create a temporary directory\n");
+        return 1;
+    }
+
+    printf("Launches on one cache directory:\n");
+    printf("  %-44s %6s %8s %8s %6s\n", "", "loaded", "compiled", "rejected", "stored");
+
+    Launch first = launch(kDriver, directory);
+    expect("1. first launch", first, 0, 2, 0, 2);
+    Launch second = launch(kDriver, directory);
+    expect("2. second launch", second, 2, 0, 0, 0);
+    bool sameFrame = !first.frame.empty() && first.frame == second.frame;
+
+    std::string edited = std::string(gl::kSdfCircleVertexShader) + "// edited\n";
+    expect("3. SDF vertex shader edited", launch(kDriver, directory, edited), 1, 1, 0, 1);
+
+    Driver updated = {&MockGl::dispatch(), kRenderer, "OpenGL ES 3.2 V@0702.0", "2"};
+    expect("4. driver update, new GL_VERSION", launch(updated, directory), 0, 2, 0, 2);
+
+    Driver silent = {&MockGl::dispatch(), kRenderer, kVersion, "3"};
+    expect("5. driver refuses binaries, same GL_VERSION", launch(silent, directory), 0, 2, 2, 2);
+    expect("   launch after", launch(silent, directory), 2, 0, 0, 0);
+
+    gl::ProgramCache names;
+    names.init(directory, kRenderer, kVersion);
+    damage(names.path(names.key(gl::kSdfCircleVertexShader, gl::kSdfCircleFragmentShader)), 9,
+           false);
+    damage(names.path(names.key(gl::kInstancedCircleVertexShader,
+                                gl::kInstancedCircleFragmentShader)),
+           5, true);
+    Launch damaged = launch(silent, directory);
+    expect("6. one file damaged, one truncated", damaged, 0, 2, 2, 2);
+    g_ok &= damaged.binaryLoads == 0;
+
+    Driver gles2 = {&MockGl::dispatchGles2(), kRenderer, "OpenGL ES 2.0 V@0615.0", "3"};
+    expect("7. GLES 2, no program binaries", launch(gles2, directory), 0, 2, 0, 0);
+    expect("   no cache directory", launch(kDriver, nullptr), 0, 2, 0, 0);
+
+    std::string unhinted = std::string(directory) + "/unhinted";
+    std::error_code created;
+    std::filesystem::create_directory(unhinted, created);
+    g_hint = false;
+    expect("8. linked without the retrievable hint", launch(kDriver, unhinted.c_str()), 0, 2,
+           0, 0);
+    expect("   launch after", launch(kDriver, unhinted.c_str()), 0, 2, 0, 0);
+    g_hint = true;
+
+    printf("  second launch draws the same frame as the first: %s\n", sameFrame ? "yes" : "NO");
+
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+
+    if (!(g_ok && sameFrame)) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    return 0;
+}
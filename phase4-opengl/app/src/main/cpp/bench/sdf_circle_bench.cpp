@@ -0,0 +1,276 @@
+/**
+ * bench/sdf_circle_bench.cpp: The SDF circle against the triangle fan
+ *
+ * Checked (exit code 1 on failure):
+ * 1. Coverage: summed over a pixel grid, sdfCoverage() (the fragment
+ *    shader's math) gives the exact area of a disc, a stroke and a set of
+ *    rings within 1%, at radii from 6 to 200 pixels, and the edge pixels
+ *    get partial coverage (the fan's are all or nothing).
+ * 2. Draws (bench/mock_gl.h): an SDF frame is a clear and one 4-vertex
+ *    strip with premultiplied blending; after the first frame only the
+ *    circle's center and the draw reach GL. Switching between the fan
+ *    and the SDF circle every frame draws exactly what either one alone
+ *    does, blending included, with no call GL would reject.
+ *
+ * Prints vertices and fragments per circle for both, by radius: the
+ * numbers behind choosing one or the other per device.
+ *
+ * Usage: sdf_circle_bench
+ */
+
+#include "mock_gl.h"
+#include "../gl/circle_pass.h"
+#include "../gl/sdf_circle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using mockgl::MockGl;
+
+static const GLuint kFanProgram = 3;
+static const GLuint kSdfProgram = 4;
+static const int kWidth = 1080;
+static const int kHeight = 2400;
+static const int kFanSegments = 64;
+static const float kColor[4] = {1.0f, 0.5f, 0.0f, 1.0f};
+
+static const double kPi = 3.14159265358979;
+
+// ============================================================================
+// CHECK 1: COVERAGE
+// ============================================================================
+
+// Exact area of what `style` draws at `radius`
+static double exactArea(const gl::SdfCircleStyle& style, double radius) {
+    if (style.shape == gl::kCircleFilled) {
+        return kPi * radius * radius;
+    }
+    // Bands of strokeWidth, the outermost ending at the edge, repeated
+    // inwards every ringSpacing (rings) down to the center
+    double width = style.strokeWidth;
+    double area = 0.0;
+    for (double outer = radius; outer > 0.0; outer -= style.ringSpacing) {
+        double inner = std::max(0.0, outer - width);
+        area += kPi * (outer * outer - inner * inner);
+        if (style.shape != gl::kCircleRings) {
+            break;
+        }
+    }
+    return area;
+}
+
+struct Coverage {
+    double area;   // Sum of coverage over the grid
+    int partial;   // Pixels strictly between 0 and 1
+};
+
+// Sample at pixel centers around a circle centered off the pixel grid
+static Coverage measureCoverage(const gl::SdfCircleStyle& style, float radius) {
+    const double cx = 0.37;
+    const double cy = 0.81;
+    int extent = static_cast<int>(radius) + 3;
+    Coverage coverage = {0.0, 0};
+    for (int y = -extent; y <= extent; y++) {
+        for (int x = -extent; x <= extent; x++) {
+            double dx = x + 0.5 - cx;
+            double dy = y + 0.5 - cy;
+            float distance = static_cast<float>(std::sqrt(dx * dx + dy * dy));
+            float c = gl::sdfCoverage(style, radius, distance);
+            coverage.area += c;
+            coverage.partial += c > 0.0f && c < 1.0f;
+        }
+    }
+    return coverage;
+}
+
+static bool checkCoverage() {
+    struct Case {
+        const char* name;
+        gl::SdfCircleStyle style;
+    };
+    gl::SdfCircleStyle filled;
+    gl::SdfCircleStyle stroke;
+    stroke.shape = gl::kCircleStroke;
+    stroke.strokeWidth = 3.0f;
+    gl::SdfCircleStyle rings;
+    rings.shape = gl::kCircleRings;
+    rings.strokeWidth = 2.0f;
+    rings.ringSpacing = 6.0f;
+    const Case cases[] = {{"filled", filled}, {"stroke 3px", stroke}, {"rings 2px/6px", rings}};
+    const float radii[] = {6.0f, 24.0f, 96.0f, 200.0f};
+
+    printf("  %-14s %7s %12s %12s %8s %9s\n", "shape", "radius", "exact area", "coverage",
+           "error", "AA pixels");
+    bool ok = true;
+    for (const Case& c : cases) {
+        for (float radius : radii) {
+            double exact = exactArea(c.style, radius);
+            Coverage measured = measureCoverage(c.style, radius);
+            double error = std::fabs(measured.area - exact) / exact;
+            bool caseOk = error < 0.01 && measured.partial > 0;
+            printf("  %-14s %7.0f %12.1f %12.1f %7.3f%% %9d%s\n", c.name, radius, exact,
+                   measured.area, error * 100.0, measured.partial, caseOk ? "" : "  <- FAIL");
+            ok &= caseOk;
+        }
+    }
+    return ok;
+}
+
+// ============================================================================
+// CHECK 2: DRAWS
+// ============================================================================
+
+// Both pipelines set up, as initGL() does
+struct Scene {
+    MockGl mock;
+    gl::GlStateCache cache;
+    gl::CirclePass fan;
+    gl::SdfCirclePass sdf;
+    bool ok;
+
+    Scene() : cache(MockGl::dispatch()) {
+        mock.addProgram(kFanProgram, {{"aPosition", 2, 1, GL_FLOAT_VEC4}},
+                        {{"uColor", 5, 1, GL_FLOAT_VEC4}, {"uMVPMatrix", 9, 1, GL_FLOAT_MAT4}});
+        mock.addProgram(kSdfProgram, {{"aCorner", 1, 1, GL_FLOAT_VEC2}},
+                        {{"uCenter", 0, 1, GL_FLOAT_VEC2},
+                         {"uColor", 3, 1, GL_FLOAT_VEC4},
+                         {"uRadius", 4, 1, GL_FLOAT},
+                         {"uStroke", 6, 1, GL_FLOAT_VEC2},
+                         {"uViewport", 8, 1, GL_FLOAT_VEC2}});
+        cache.registerProgram(kFanProgram);
+        cache.registerProgram(kSdfProgram);
+
+        GLuint fanVbo = cache.genBuffer();
+        cache.bindBuffer(GL_ARRAY_BUFFER, fanVbo);
+        std::vector<float> vertices((kFanSegments + 2) * 2, 0.0f);
+        cache.bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(),
+                         GL_STATIC_DRAW);
+        ok = gl::prepareCirclePass(cache, kFanProgram, fanVbo, kFanSegments + 2, &fan) &&
+             gl::prepareSdfCirclePass(cache, kSdfProgram, &sdf);
+
+        cache.clearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        cache.viewport(0, 0, kWidth, kHeight);
+    }
+
+    // One frame of the moving circle, as renderFrame() draws it
+    void frame(int n, bool useSdf) {
+        float x = 0.5f + 0.4f * std::sin(n * 0.05f);
+        float y = 0.5f + 0.4f * std::cos(n * 0.07f);
+        cache.beginFrame();
+        cache.clear(GL_COLOR_BUFFER_BIT);
+        if (useSdf) {
+            gl::drawSdfCircle(cache, sdf, x * kWidth, y * kHeight, 108.0f, gl::SdfCircleStyle(),
+                              kColor, kWidth, kHeight);
+        } else {
+            float mvp[16] = {};
+            mvp[0] = 0.2f;
+            mvp[5] = 0.09f;
+            mvp[10] = -1.0f;
+            mvp[12] = x * 2.0f - 1.0f;
+            mvp[13] = y * 2.0f - 1.0f;
+            mvp[15] = 1.0f;
+            gl::drawCircle(cache, fan, mvp, kColor);
+        }
+    }
+};
+
+// What a run of frames drew (only one MockGl is current at a time, so
+// runs go one after the other)
+struct Run {
+    std::vector<std::string> effects;
+    uint32_t firstIssued;
+    uint32_t steadyIssued;  // Most calls of any later frame
+    bool ok;                // Set up, and no call GL would reject
+};
+
+// `pattern` 0 = fan only, 1 = SDF only, 2 = switching every frame
+static Run runFrames(int frames, int pattern) {
+    Scene scene;
+    Run run = {{}, 0, 0, scene.ok};
+    for (int n = 0; n < frames; n++) {
+        scene.frame(n, pattern == 1 || (pattern == 2 && n % 2 == 1));
+        uint32_t issued = scene.cache.frameStats().issued;
+        if (n == 0) {
+            run.firstIssued = issued;
+        } else {
+            run.steadyIssued = std::max(run.steadyIssued, issued);
+        }
+    }
+    run.effects = scene.mock.effects();
+    run.ok &= scene.mock.errors() == 0;
+    return run;
+}
+
+static bool checkDraws() {
+    const int frames = 60;
+    Run fanOnly = runFrames(frames, 0);
+    Run sdfOnly = runFrames(frames, 1);
+    Run alternating = runFrames(frames, 2);
+
+    // Every frame is a clear and a draw: frame n is effects 2n and 2n + 1
+    const size_t expected = 2 * frames;
+    bool same = alternating.effects.size() == expected && fanOnly.effects.size() == expected &&
+                sdfOnly.effects.size() == expected;
+    for (size_t i = 0; same && i < expected; i++) {
+        const Run& alone = (i / 2) % 2 == 1 ? sdfOnly : fanOnly;
+        if (alternating.effects[i] != alone.effects[i]) {
+            printf("  effect %zu differs:\n    alone        %s\n    alternating  %s\n", i,
+                   alone.effects[i].c_str(), alternating.effects[i].c_str());
+            same = false;
+        }
+    }
+
+    // GL_TRIANGLE_STRIP, GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+    bool blended = sdfOnly.effects.size() > 1 &&
+                   sdfOnly.effects[1].find("draw 0x5 0+4 program 4 blend 0x1 0x303") == 0;
+    bool fanOpaque = fanOnly.effects.size() > 1 &&
+                     fanOnly.effects[1].find(" blend") == std::string::npos;
+    bool ok = fanOnly.ok && sdfOnly.ok && alternating.ok;
+
+    printf("  SDF frame: 4-vertex strip, premultiplied blend: %s; fan opaque: %s\n",
+           blended ? "yes" : "NO", fanOpaque ? "yes" : "NO");
+    printf("  SDF calls: first frame %u, then %u issued (clear, center, draw)\n",
+           sdfOnly.firstIssued, sdfOnly.steadyIssued);
+    printf("  %d frames switching fan/SDF every frame identical to each alone: %s, mock GL "
+           "errors: %s\n",
+           frames, same ? "yes" : "NO", ok ? "none" : "SOME");
+    return same && blended && fanOpaque && ok && sdfOnly.steadyIssued == 3;
+}
+
+// ============================================================================
+// LOAD
+// ============================================================================
+
+static void printLoad() {
+    const float radii[] = {4.0f, 16.0f, 64.0f, 256.0f, 1024.0f};
+    printf("  %7s | %-19s | %-19s | %s\n", "radius", "fan (64 segments)", "SDF quad",
+           "SDF fragments / fan");
+    printf("  %7s | %8s %10s | %8s %10s |\n", "px", "vertices", "fragments", "vertices",
+           "fragments");
+    for (float radius : radii) {
+        gl::CircleLoad fan = gl::fanLoad(kFanSegments, radius);
+        gl::CircleLoad sdf = gl::sdfLoad(radius);
+        printf("  %7.0f | %8d %10.0f | %8d %10.0f | %.2fx\n", radius, fan.vertices,
+               fan.fragments, sdf.vertices, sdf.fragments, sdf.fragments / fan.fragments);
+    }
+}
+
+int main() {
+    printf("Coverage (the fragment shader's math, summed over pixels):\n");
+    bool coverageOk = checkCoverage();
+
+    printf("\nDraws:\n");
+    bool drawsOk = checkDraws();
+
+    printf("\nLoad per circle:\n");
+    printLoad();
+
+    if (!(coverageOk && drawsOk)) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * bench/stream_ring_bench.cpp: Per-frame vertex and index uploads through StreamRing
+ *
+ * Every frame uploads a different amount of vertex and index data (1-3
+ * uploads of 20-240 vertices and their triangle indices) and draws each
+ * with glDrawElements, the way a trail or UI would. The mock GPU
+ * (bench/mock_gl.h) runs a few fences behind, so writing over bytes a
+ * pending draw reads is caught.
+ *
+ * Checked (exit code 1 on failure):
+ * 1. GLES 3 (mapped + fenced), ring ample for the frames in flight: every
+ *    draw reads exactly the bytes uploaded for it, the ring wraps, and
+ *    there are no stalls, no fence waits and no call GL would reject.
+ * 2. GLES 3, ring too small for the frames in flight: the same, except
+ *    the ring waits on fences instead (counted, never overwriting).
+ * 3. GLES 2 (orphaning): the same, one orphan per wrap, no stalls.
+ * 4. The naive way, glBufferSubData() over the same bytes every frame,
+ *    stalls: what the ring is for.
+ * 5. An unsynchronized map over bytes a pending draw reads is reported:
+ *    the mock would let a broken ring through otherwise.
+ *
+ * Prints bytes streamed, wraps, orphans, fences, fence waits and stalls.
+ *
+ * Usage: stream_ring_bench [frames]
+ */
+
+#include "mock_gl.h"
+#include "../gl/stream_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using mockgl::MockGl;
+
+static const GLuint kProgram = 31;
+static const GLuint kPositionLocation = 2;
+
+// Two rings each fence every frame: 6 fences is 3 frames in flight
+static const int kGpuLatencyFences = 6;
+
+// One upload's worth: a strip of `vertices` points and the GL_TRIANGLES
+// indices covering it, values unique to frame and draw
+struct Geometry {
+    std::vector<float> vertices;    // x, y
+    std::vector<uint16_t> indices;  // From 0: the attribute pointer is at the upload
+};
+
+static Geometry makeGeometry(int frame, int draw) {
+    Geometry g;
+    int count = 20 + (frame * 37 + draw * 53) % 221;
+    for (int i = 0; i < count; i++) {
+        g.vertices.push_back(static_cast<float>(frame) + i * 0.001f);
+        g.vertices.push_back(static_cast<float>(draw) - i * 0.001f);
+    }
+    for (int i = 0; i + 2 < count; i++) {
+        uint16_t a = static_cast<uint16_t>(i);
+        g.indices.insert(g.indices.end(), {a, static_cast<uint16_t>(a + 1 + i % 2),
+                                           static_cast<uint16_t>(a + 2 - i % 2)});
+    }
+    return g;
+}
+
+struct Result {
+    const char* name;
+    gl::StreamStats vertexStats;
+    gl::StreamStats indexStats;
+    uint64_t stalls;
+    int errors;
+    int mismatches;  // Draws whose buffer bytes weren't what was uploaded
+};
+
+// Whether `buffer` holds `size` bytes of `data` at `offset`
+static bool holds(const MockGl& mock, GLuint buffer, GLintptr offset, const void* data,
+                  size_t size) {
+    const std::vector<uint8_t>* contents = mock.bufferContents(buffer);
+    return contents && offset >= 0 && offset + size <= contents->size() &&
+           memcmp(contents->data() + offset, data, size) == 0;
+}
+
+// Checks 1-3: `frames` frames through a vertex ring and an index ring
+static Result runRings(const char* name, const gl::GlDispatch& dispatch, int frames,
+                       GLsizeiptr vertexCapacity, GLsizeiptr indexCapacity) {
+    MockGl mock;
+    mock.setGpuLatency(kGpuLatencyFences);
+    mock.addProgram(kProgram, {{"aPosition", kPositionLocation, 1, GL_FLOAT_VEC2}}, {});
+    gl::GlStateCache cache(dispatch);
+    cache.registerProgram(kProgram);
+
+    gl::StreamRing vertexRing;
+    gl::StreamRing indexRing;
+    vertexRing.init(cache, GL_ARRAY_BUFFER, vertexCapacity);
+    indexRing.init(cache, GL_ELEMENT_ARRAY_BUFFER, indexCapacity);
+
+    Result result = {name, {}, {}, 0, 0, 0};
+    for (int n = 0; n < frames; n++) {
+        cache.beginFrame();
+        cache.useProgram(kProgram);
+        cache.enableVertexAttribArray(kPositionLocation);
+        for (int draw = 0; draw < 1 + n % 3; draw++) {
+            Geometry g = makeGeometry(n, draw);
+            size_t vertexBytes = g.vertices.size() * sizeof(float);
+            size_t indexBytes = g.indices.size() * sizeof(uint16_t);
+            GLintptr vertexOffset = vertexRing.upload(cache, g.vertices.data(), vertexBytes);
+            GLintptr indexOffset = indexRing.upload(cache, g.indices.data(), indexBytes, 2);
+            if (vertexOffset < 0 || indexOffset < 0) {
+                result.mismatches++;
+                continue;
+            }
+            cache.vertexAttribBuffer(kPositionLocation, vertexRing.buffer(), 2, GL_FLOAT,
+                                     GL_FALSE, 0, reinterpret_cast<const void*>(vertexOffset));
+            cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexRing.buffer());
+            cache.drawElements(GL_TRIANGLES, static_cast<GLsizei>(g.indices.size()),
+                               GL_UNSIGNED_SHORT, indexOffset);
+            if (!holds(mock, vertexRing.buffer(), vertexOffset, g.vertices.data(), vertexBytes) ||
+                !holds(mock, indexRing.buffer(), indexOffset, g.indices.data(), indexBytes)) {
+                result.mismatches++;
+            }
+        }
+        vertexRing.endFrame(cache);
+        indexRing.endFrame(cache);
+    }
+
+    result.vertexStats = vertexRing.stats();
+    result.indexStats = indexRing.stats();
+    vertexRing.release(cache);
+    indexRing.release(cache);
+    result.stalls = mock.stalls();
+    result.errors = mock.errors();
+    return result;
+}
+
+// Check 4: the same vertex data, glBufferSubData() at offset 0 every frame
+static Result runNaive(int frames) {
+    MockGl mock;
+    mock.setGpuLatency(kGpuLatencyFences);
+    mock.addProgram(kProgram, {{"aPosition", kPositionLocation, 1, GL_FLOAT_VEC2}}, {});
+    gl::GlStateCache cache(MockGl::dispatch());
+    cache.registerProgram(kProgram);
+
+    const size_t capacity = 240 * 2 * sizeof(float);
+    GLuint vbo = cache.genBuffer();
+    cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    cache.bufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+
+    Result result = {"naive glBufferSubData", {}, {}, 0, 0, 0};
+    for (int n = 0; n < frames; n++) {
+        Geometry g = makeGeometry(n, 0);
+        size_t bytes = g.vertices.size() * sizeof(float);
+        cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        cache.bufferSubData(GL_ARRAY_BUFFER, 0, bytes, g.vertices.data());
+        result.vertexStats.bytes += bytes;
+        result.vertexStats.allocations++;
+
+        cache.useProgram(kProgram);
+        cache.enableVertexAttribArray(kPositionLocation);
+        cache.vertexAttribBuffer(kPositionLocation, vbo, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        cache.drawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(g.vertices.size() / 2));
+        if (!holds(mock, vbo, 0, g.vertices.data(), bytes)) {
+            result.mismatches++;
+        }
+    }
+    cache.deleteBuffer(vbo);
+    result.stalls = mock.stalls();
+    result.errors = mock.errors();
+    return result;
+}
+
+// Check 5: the mistake the fences prevent, made on purpose
+static bool unsynchronizedOverwriteCaught() {
+    MockGl mock;
+    mock.addProgram(kProgram, {{"aPosition", kPositionLocation, 1, GL_FLOAT_VEC2}}, {});
+    gl::GlStateCache cache(MockGl::dispatch());
+    cache.registerProgram(kProgram);
+
+    Geometry g = makeGeometry(0, 0);
+    size_t bytes = g.vertices.size() * sizeof(float);
+    GLuint vbo = cache.genBuffer();
+    cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    cache.bufferData(GL_ARRAY_BUFFER, bytes, g.vertices.data(), GL_STREAM_DRAW);
+    cache.useProgram(kProgram);
+    cache.enableVertexAttribArray(kPositionLocation);
+    cache.vertexAttribBuffer(kPositionLocation, vbo, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    cache.drawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(g.vertices.size() / 2));
+
+    // No fence, no wait: the draw above may not have run
+    void* data = cache.mapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (data) {
+        memset(data, 0, bytes);
+    }
+    cache.unmapBuffer(GL_ARRAY_BUFFER);
+    cache.deleteBuffer(vbo);
+    return data != nullptr && mock.errors() > 0;
+}
+
+static void printResult(const Result& r, int frames) {
+    const gl::StreamStats& v = r.vertexStats;
+    const gl::StreamStats& i = r.indexStats;
+    printf("  %-24s %9.1f %6u %7u %6u %6u %11.3f %6llu %6d %s\n", r.name,
+           (v.bytes + i.bytes) / 1024.0 / frames, v.wraps + i.wraps, v.orphans + i.orphans,
+           v.fences + i.fences, v.fenceWaits + i.fenceWaits,
+           (v.fenceWaitNanos + i.fenceWaitNanos) / 1e6, static_cast<unsigned long long>(r.stalls),
+           r.errors, r.mismatches == 0 ? "yes" : "NO");
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::max(10, atoi(argv[1])) : 600;
+
+    Result ample = runRings("GLES 3 ring 64K/16K", MockGl::dispatch(), frames, 64 * 1024,
+                            16 * 1024);
+    Result tight = runRings("GLES 3 ring 6K/4K", MockGl::dispatch(), frames, 6 * 1024,
+                            4 * 1024);
+    Result orphaning = runRings("GLES 2 orphaning 64K/16K", MockGl::dispatchGles2(), frames,
+                                64 * 1024, 16 * 1024);
+    Result naive = runNaive(frames);
+
+    printf("%d frames, GPU %d fences behind:\n", frames, kGpuLatencyFences);
+    printf("  %-24s %9s %6s %7s %6s %6s %11s %6s %6s %s\n", "", "KB/frame", "wraps", "orphans",
+           "fences", "waits", "waited (ms)", "stalls", "errors", "data ok");
+    for (const Result* r : {&ample, &tight, &orphaning, &naive}) {
+        printResult(*r, frames);
+    }
+    printf("\nUnsynchronized overwrite of a pending draw, on purpose:\n");
+    bool caught = unsynchronizedOverwriteCaught();
+    printf("  reported: %s\n", caught ? "yes" : "NO");
+
+    auto clean = [](const Result& r) {
+        return r.errors == 0 && r.mismatches == 0 && r.stalls == 0 &&
+               r.vertexStats.wraps > 0 && r.indexStats.wraps > 0;
+    };
+    uint32_t tightWaits = tight.vertexStats.fenceWaits + tight.indexStats.fenceWaits;
+    bool ok = clean(ample) && ample.vertexStats.fenceWaits + ample.indexStats.fenceWaits == 0 &&
+              clean(tight) && tightWaits > 0 && clean(orphaning) &&
+              orphaning.vertexStats.orphans == orphaning.vertexStats.wraps &&
+              orphaning.indexStats.orphans == orphaning.indexStats.wraps &&
+              orphaning.vertexStats.fences == 0 && naive.stalls > 0 && naive.errors == 0 &&
+              caught;
+    if (!ok) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    return 0;
+}
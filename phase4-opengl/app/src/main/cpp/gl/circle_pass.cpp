@@ -0,0 +1,49 @@
+/**
+ * gl/circle_pass.cpp: Circle draw sequence
+ */
+
+#include "circle_pass.h"
+
+namespace gl {
+
+bool prepareCirclePass(GlStateCache& gl, GLuint program, GLuint vbo, GLsizei vertexCount,
+                       CirclePass* pass) {
+    pass->program = program;
+    pass->vbo = vbo;
+    pass->vertexCount = vertexCount;
+    pass->positionLocation = gl.attribLocation(program, "aPosition");
+    pass->mvpLocation = gl.uniformLocation(program, "uMVPMatrix");
+    pass->colorLocation = gl.uniformLocation(program, "uColor");
+    return pass->positionLocation >= 0;
+}
+
+void drawCircle(GlStateCache& gl, const CirclePass& pass, const float* mvp, const float* color) {
+    // Hard polygon edges: nothing to blend (and the SDF circle turns it on)
+    gl.disable(GL_BLEND);
+
+    gl.useProgram(pass.program);
+    gl.uniformMatrix4fv(pass.mvpLocation, mvp);
+    gl.uniform4f(pass.colorLocation, color[0], color[1], color[2], color[3]);
+
+    // 2 components (x, y), float, not normalized, tightly packed, from
+    // the start of the buffer
+    GLuint position = static_cast<GLuint>(pass.positionLocation);
+    gl.bindBuffer(GL_ARRAY_BUFFER, pass.vbo);
+    gl.enableVertexAttribArray(position);
+    gl.vertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    if (gl.hasInstancing()) {
+        // Per vertex, in case an instanced pass used this index
+        gl.vertexAttribDivisor(position, 0);
+    }
+
+    // GL_TRIANGLE_FAN: first vertex is center, subsequent vertices form triangles
+    gl.drawArrays(GL_TRIANGLE_FAN, 0, pass.vertexCount);
+}
+
+void drawCirclePass(GlStateCache& gl, const CirclePass& pass, const float* mvp,
+                    const float* color) {
+    gl.clear(GL_COLOR_BUFFER_BIT);
+    drawCircle(gl, pass, mvp, color);
+}
+
+} // namespace gl
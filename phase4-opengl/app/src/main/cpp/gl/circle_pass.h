@@ -0,0 +1,51 @@
+/**
+ * gl/circle_pass.h: The GL calls that draw the scene's circle
+ *
+ * Everything renderFrame() sends to GL for one frame, apart from the
+ * matrix math: clear, bind the program and the circle's vertex buffer,
+ * set the two uniforms, draw the triangle fan. It takes a GlStateCache
+ * rather than calling GL, so on the device the unchanged state costs
+ * nothing after the first frame, and on a host the same sequence runs
+ * against a mock (bench/gl_state_bench.cpp).
+ *
+ * The vertex attribute array is left enabled after the draw. Disabling
+ * it every frame (as the first version did) only forces the next frame
+ * to enable it again; the cache knows it's on.
+ *
+ * gl/sdf_circle.h draws the same circle another way (one quad, edge
+ * computed per pixel); the renderer can switch between the two.
+ */
+
+#ifndef PHASE4_GL_CIRCLE_PASS_H
+#define PHASE4_GL_CIRCLE_PASS_H
+
+#include "gl_state.h"
+
+namespace gl {
+
+// Locations and objects, looked up once after the program is linked
+struct CirclePass {
+    GLuint program = 0;
+    GLuint vbo = 0;                // Unit circle as a triangle fan, 2 floats per vertex
+    GLsizei vertexCount = 0;
+    GLint positionLocation = -1;   // attribute vec4 aPosition
+    GLint mvpLocation = -1;        // uniform mat4 uMVPMatrix
+    GLint colorLocation = -1;      // uniform vec4 uColor
+};
+
+// Fill in `pass` from the cache's location table (registerProgram() the
+// program first). Returns false if the program lacks aPosition.
+bool prepareCirclePass(GlStateCache& gl, GLuint program, GLuint vbo, GLsizei vertexCount,
+                       CirclePass* pass);
+
+// Draw the circle with `mvp` (column-major 4x4) and `color` (RGBA 0-1),
+// opaque (blending off)
+void drawCircle(GlStateCache& gl, const CirclePass& pass, const float* mvp, const float* color);
+
+// Clear the frame, then drawCircle()
+void drawCirclePass(GlStateCache& gl, const CirclePass& pass, const float* mvp,
+                    const float* color);
+
+} // namespace gl
+
+#endif // PHASE4_GL_CIRCLE_PASS_H
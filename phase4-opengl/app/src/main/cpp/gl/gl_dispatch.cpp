@@ -0,0 +1,178 @@
+/**
+ * gl/gl_dispatch.cpp: The dispatch table filled with libGLESv2
+ *
+ * Android build only (see CMakeLists.txt): the host has no GLES library
+ * to link, and runs the renderer against bench/mock_gl.h instead.
+ */
+
+#include "gl_dispatch.h"
+
+#include <EGL/egl.h>
+
+#include <cstring>
+
+namespace gl {
+
+namespace {
+
+GlDispatch& table() {
+    static GlDispatch table = {
+        glClear,
+        glClearColor,
+        glViewport,
+
+        glEnable,
+        glDisable,
+        glBlendFunc,
+
+        glUseProgram,
+        glBindBuffer,
+        glDeleteBuffers,
+        glDeleteProgram,
+
+        glGenBuffers,
+        glBufferData,
+        glBufferSubData,
+
+        glEnableVertexAttribArray,
+        glDisableVertexAttribArray,
+        glVertexAttribPointer,
+        glVertexAttrib4f,
+
+        glUniform1f,
+        glUniform2f,
+        glUniform4f,
+        glUniformMatrix4fv,
+
+        glDrawArrays,
+        glDrawElements,
+
+        nullptr,  // drawArraysInstanced: loadInstancing()
+        nullptr,  // vertexAttribDivisor
+
+        nullptr,  // mapBufferRange: loadBufferMapping()
+        nullptr,  // unmapBuffer
+        nullptr,  // fenceSync
+        nullptr,  // clientWaitSync
+        nullptr,  // deleteSync
+
+        glGetProgramiv,
+        glGetActiveAttrib,
+        glGetActiveUniform,
+        glGetAttribLocation,
+        glGetUniformLocation,
+
+        glCreateProgram,
+        nullptr,  // getProgramBinary: loadProgramBinary()
+        nullptr,  // programBinary
+        nullptr,  // programParameteri
+    };
+    return table;
+}
+
+// Whole-word match in the space-separated GL_EXTENSIONS string
+bool hasExtension(const char* name) {
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!extensions) {
+        return false;
+    }
+    size_t length = strlen(name);
+    for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+        bool starts = p == extensions || p[-1] == ' ';
+        bool ends = p[length] == ' ' || p[length] == '\0';
+        if (starts && ends) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class Fn>
+bool lookUp(Fn* fn, const char* name) {
+    *fn = reinterpret_cast<Fn>(eglGetProcAddress(name));
+    return *fn != nullptr;
+}
+
+// "OpenGL ES 3.2 ..." (GLES 2 contexts say "OpenGL ES 2.0 ...")
+int glesMajorVersion() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version && strncmp(version, "OpenGL ES ", 10) == 0) {
+        return version[10] - '0';
+    }
+    return 0;
+}
+
+} // namespace
+
+const GlDispatch& systemGl() {
+    return table();
+}
+
+const char* loadInstancing() {
+    GlDispatch& gl = table();
+
+    // Android's eglGetProcAddress also returns core functions
+    // (EGL_KHR_get_all_proc_addresses)
+    if (glesMajorVersion() >= 3 && lookUp(&gl.drawArraysInstanced, "glDrawArraysInstanced") &&
+        lookUp(&gl.vertexAttribDivisor, "glVertexAttribDivisor")) {
+        return "GLES 3";
+    }
+    if (hasExtension("GL_EXT_instanced_arrays") &&
+        lookUp(&gl.drawArraysInstanced, "glDrawArraysInstancedEXT") &&
+        lookUp(&gl.vertexAttribDivisor, "glVertexAttribDivisorEXT")) {
+        return "GL_EXT_instanced_arrays";
+    }
+    if (hasExtension("GL_ANGLE_instanced_arrays") &&
+        lookUp(&gl.drawArraysInstanced, "glDrawArraysInstancedANGLE") &&
+        lookUp(&gl.vertexAttribDivisor, "glVertexAttribDivisorANGLE")) {
+        return "GL_ANGLE_instanced_arrays";
+    }
+    gl.drawArraysInstanced = nullptr;
+    gl.vertexAttribDivisor = nullptr;
+    return nullptr;
+}
+
+const char* loadBufferMapping() {
+    GlDispatch& gl = table();
+    if (glesMajorVersion() >= 3 && lookUp(&gl.mapBufferRange, "glMapBufferRange") &&
+        lookUp(&gl.unmapBuffer, "glUnmapBuffer") && lookUp(&gl.fenceSync, "glFenceSync") &&
+        lookUp(&gl.clientWaitSync, "glClientWaitSync") &&
+        lookUp(&gl.deleteSync, "glDeleteSync")) {
+        return "GLES 3";
+    }
+    gl.mapBufferRange = nullptr;
+    gl.unmapBuffer = nullptr;
+    gl.fenceSync = nullptr;
+    gl.clientWaitSync = nullptr;
+    gl.deleteSync = nullptr;
+    return nullptr;
+}
+
+const char* loadProgramBinary() {
+    GlDispatch& gl = table();
+
+    // Both can be there with no format to save in (some drivers): then
+    // there's nothing to load either. (GL_NUM_PROGRAM_BINARY_FORMATS_OES
+    // is the same enum.)
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats > 0) {
+        if (glesMajorVersion() >= 3 && lookUp(&gl.getProgramBinary, "glGetProgramBinary") &&
+            lookUp(&gl.programBinary, "glProgramBinary") &&
+            lookUp(&gl.programParameteri, "glProgramParameteri")) {
+            return "GLES 3";
+        }
+        gl.programParameteri = nullptr;
+        if (hasExtension("GL_OES_get_program_binary") &&
+            lookUp(&gl.getProgramBinary, "glGetProgramBinaryOES") &&
+            lookUp(&gl.programBinary, "glProgramBinaryOES")) {
+            return "GL_OES_get_program_binary";
+        }
+    }
+    gl.getProgramBinary = nullptr;
+    gl.programBinary = nullptr;
+    gl.programParameteri = nullptr;
+    return nullptr;
+}
+
+} // namespace gl
@@ -0,0 +1,151 @@
+/**
+ * gl/gl_dispatch.h: The GL entry points the renderer calls, as a table
+ *
+ * The renderer never calls glUseProgram() and friends directly on its hot
+ * path: it goes through GlStateCache (gl/gl_state.h), which calls GL
+ * through one of these tables. On the device the table holds the real
+ * libGLESv2 functions (systemGl()); on a Linux host a test double fills
+ * it instead (bench/mock_gl.h), so the state cache and the frame's draw
+ * sequence run and can be checked without a GPU, an EGL context or an
+ * emulator.
+ *
+ * Only entry points that are called every frame, that the cache needs to
+ * read a program's interface at link time, or that a draw pass needs to
+ * create its buffers are in here. Compiling shaders still calls GL
+ * directly: it isn't worth abstracting and has nothing to cache. Loading
+ * a linked program from a saved binary (gl/program_cache.h) goes through
+ * the table, so the program cache can be checked on the host.
+ *
+ * INSTANCING is core in GLES 3.0 and an extension on some GLES 2.0
+ * drivers, under another name. Its two entries start out null;
+ * loadInstancing() fills them for the current context if it can.
+ * BUFFER MAPPING AND FENCES (glMapBufferRange, glFenceSync...) are GLES
+ * 3.0 only: loadBufferMapping() fills them on a GLES 3 context. The GLES3
+ * header is included for their types and enums (GLsync, GL_MAP_*); being
+ * looked up at run time, they don't stop the library from loading on a
+ * GLES 2 device.
+ * PROGRAM BINARIES (glGetProgramBinary, glProgramBinary) are core in GLES
+ * 3.0 and GL_OES_get_program_binary on GLES 2.0: loadProgramBinary().
+ * On GLES 3 it also fills glProgramParameteri, for setting
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking: some drivers keep no
+ * binary of a program linked without it.
+ *
+ * A function pointer call costs the same as the PLT call into libGLESv2
+ * that a plain glUseProgram() compiles to, so the indirection is free.
+ *
+ * Lookup: "GL dispatch table", "glad / libepoxy function pointers",
+ *         "mocking OpenGL in unit tests"
+ */
+
+#ifndef PHASE4_GL_DISPATCH_H
+#define PHASE4_GL_DISPATCH_H
+
+#include <GLES3/gl3.h>
+
+namespace gl {
+
+struct GlDispatch {
+    // Framebuffer
+    void (GL_APIENTRYP clear)(GLbitfield mask);
+    void (GL_APIENTRYP clearColor)(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+    void (GL_APIENTRYP viewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Per-fragment operations
+    void (GL_APIENTRYP enable)(GLenum cap);
+    void (GL_APIENTRYP disable)(GLenum cap);
+    void (GL_APIENTRYP blendFunc)(GLenum sfactor, GLenum dfactor);
+
+    // Bindings
+    void (GL_APIENTRYP useProgram)(GLuint program);
+    void (GL_APIENTRYP bindBuffer)(GLenum target, GLuint buffer);
+    void (GL_APIENTRYP deleteBuffers)(GLsizei n, const GLuint* buffers);
+    void (GL_APIENTRYP deleteProgram)(GLuint program);
+
+    // Buffer contents (of the buffer bound to `target`)
+    void (GL_APIENTRYP genBuffers)(GLsizei n, GLuint* buffers);
+    void (GL_APIENTRYP bufferData)(GLenum target, GLsizeiptr size, const void* data,
+                                   GLenum usage);
+    void (GL_APIENTRYP bufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size,
+                                      const void* data);
+
+    // Vertex attributes
+    void (GL_APIENTRYP enableVertexAttribArray)(GLuint index);
+    void (GL_APIENTRYP disableVertexAttribArray)(GLuint index);
+    void (GL_APIENTRYP vertexAttribPointer)(GLuint index, GLint size, GLenum type,
+                                            GLboolean normalized, GLsizei stride,
+                                            const void* pointer);
+    // The value a disabled attribute array reads as, for every vertex
+    void (GL_APIENTRYP vertexAttrib4f)(GLuint index, GLfloat x, GLfloat y, GLfloat z,
+                                       GLfloat w);
+
+    // Uniforms (of the program in use)
+    void (GL_APIENTRYP uniform1f)(GLint location, GLfloat x);
+    void (GL_APIENTRYP uniform2f)(GLint location, GLfloat x, GLfloat y);
+    void (GL_APIENTRYP uniform4f)(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void (GL_APIENTRYP uniformMatrix4fv)(GLint location, GLsizei count, GLboolean transpose,
+                                         const GLfloat* value);
+
+    // Draws
+    void (GL_APIENTRYP drawArrays)(GLenum mode, GLint first, GLsizei count);
+    void (GL_APIENTRYP drawElements)(GLenum mode, GLsizei count, GLenum type,
+                                     const void* indices);
+
+    // Instancing: null unless the context has it (see loadInstancing())
+    void (GL_APIENTRYP drawArraysInstanced)(GLenum mode, GLint first, GLsizei count,
+                                            GLsizei instanceCount);
+    void (GL_APIENTRYP vertexAttribDivisor)(GLuint index, GLuint divisor);
+
+    // Buffer mapping and fences: null unless the context has them (see
+    // loadBufferMapping())
+    void* (GL_APIENTRYP mapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length,
+                                        GLbitfield access);
+    GLboolean (GL_APIENTRYP unmapBuffer)(GLenum target);
+    GLsync (GL_APIENTRYP fenceSync)(GLenum condition, GLbitfield flags);
+    GLenum (GL_APIENTRYP clientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    void (GL_APIENTRYP deleteSync)(GLsync sync);
+
+    // Program introspection (link time)
+    void (GL_APIENTRYP getProgramiv)(GLuint program, GLenum pname, GLint* params);
+    void (GL_APIENTRYP getActiveAttrib)(GLuint program, GLuint index, GLsizei bufSize,
+                                        GLsizei* length, GLint* size, GLenum* type,
+                                        GLchar* name);
+    void (GL_APIENTRYP getActiveUniform)(GLuint program, GLuint index, GLsizei bufSize,
+                                         GLsizei* length, GLint* size, GLenum* type,
+                                         GLchar* name);
+    GLint (GL_APIENTRYP getAttribLocation)(GLuint program, const GLchar* name);
+    GLint (GL_APIENTRYP getUniformLocation)(GLuint program, const GLchar* name);
+
+    // Program binaries: the last three null unless the context can save and
+    // load them (see loadProgramBinary()); programParameteri also null
+    // with GL_OES_get_program_binary, which has no hint to set
+    GLuint (GL_APIENTRYP createProgram)();
+    void (GL_APIENTRYP getProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                         GLenum* binaryFormat, void* binary);
+    void (GL_APIENTRYP programBinary)(GLuint program, GLenum binaryFormat, const void* binary,
+                                      GLsizei length);
+    void (GL_APIENTRYP programParameteri)(GLuint program, GLenum pname, GLint value);
+};
+
+// The real libGLESv2 entry points (Android build only: gl/gl_dispatch.cpp)
+const GlDispatch& systemGl();
+
+// Fill (or clear) systemGl()'s instancing entries for the current
+// context. Call with the context current, after every context creation.
+// Returns where they came from ("GLES 3", "GL_EXT_instanced_arrays",
+// "GL_ANGLE_instanced_arrays"), or null if the context can't instance.
+const char* loadInstancing();
+
+// Fill (or clear) systemGl()'s buffer mapping and fence entries for the
+// current context, like loadInstancing(). Returns "GLES 3", or null on a
+// GLES 2 context.
+const char* loadBufferMapping();
+
+// Fill (or clear) systemGl()'s program binary entries (and on GLES 3,
+// programParameteri) for the current context, like loadInstancing(). Returns "GLES 3" or
+// "GL_OES_get_program_binary", or null if the context has neither or
+// supports no binary format.
+const char* loadProgramBinary();
+
+} // namespace gl
+
+#endif // PHASE4_GL_DISPATCH_H
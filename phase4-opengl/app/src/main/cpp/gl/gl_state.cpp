@@ -0,0 +1,514 @@
+/**
+ * gl/gl_state.cpp: GlStateCache
+ */
+
+#include "gl_state.h"
+
+#include <cstring>
+
+namespace gl {
+
+namespace {
+
+// Copy a GL-reported name into a fixed slot; false if it doesn't fit
+bool copyName(char* slot, const char* name, GLsizei length) {
+    if (length <= 0 || length >= GlStateCache::kMaxNameLength) {
+        return false;
+    }
+    memcpy(slot, name, length);
+    slot[length] = '\0';
+    return true;
+}
+
+// GL reports array uniforms as "name[0]" and accepts both spellings
+bool nameMatches(const char* stored, const char* wanted) {
+    size_t length = strlen(wanted);
+    if (strncmp(stored, wanted, length) != 0) {
+        return false;
+    }
+    return stored[length] == '\0' || strcmp(stored + length, "[0]") == 0;
+}
+
+} // namespace
+
+GlStateCache::GlStateCache(const GlDispatch& dispatch) : m_gl(dispatch) {
+    invalidate();
+}
+
+void GlStateCache::invalidate() {
+    for (Program& program : m_programs) {
+        program.id = 0;
+    }
+    m_program = kUnknown;
+    m_arrayBuffer = kUnknown;
+    m_elementBuffer = kUnknown;
+    m_attribsKnown = 0;
+    m_attribsEnabled = 0;
+    for (AttribPointer& pointer : m_pointers) {
+        pointer.known = false;
+        pointer.divisorKnown = false;
+    }
+    m_clearColorKnown = false;
+    m_viewportKnown = false;
+    m_blend = kUnknown;
+    m_blendFunc[0] = kUnknown;
+    m_blendFunc[1] = kUnknown;
+}
+
+// ============================================================================
+// PROGRAMS AND LOCATIONS
+// ============================================================================
+
+GlStateCache::Program* GlStateCache::findProgram(GLuint program) {
+    if (program == 0) {
+        return nullptr;
+    }
+    for (Program& entry : m_programs) {
+        if (entry.id == program) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool GlStateCache::registerProgram(GLuint program) {
+    Program* entry = findProgram(program);
+    if (!entry) {
+        for (Program& slot : m_programs) {
+            if (slot.id == 0) {
+                entry = &slot;
+                break;
+            }
+        }
+        if (!entry) {
+            return false;
+        }
+    }
+    entry->id = program;
+    entry->attribCount = 0;
+    entry->uniformCount = 0;
+
+    // One glGetActive* and one glGet*Location per variable, once per link.
+    // Variables that don't fit (too many, name too long) are left out and
+    // their lookups fall through to GL.
+    char name[kMaxNameLength];
+    GLint active = 0;
+    m_gl.getProgramiv(program, GL_ACTIVE_ATTRIBUTES, &active);
+    issued();
+    for (GLint i = 0; i < active && entry->attribCount < kMaxAttribs; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        m_gl.getActiveAttrib(program, i, sizeof(name), &length, &size, &type, name);
+        issued();
+        Variable& attrib = entry->attribs[entry->attribCount];
+        if (copyName(attrib.name, name, length)) {
+            attrib.location = m_gl.getAttribLocation(program, attrib.name);
+            issued();
+            entry->attribCount++;
+        }
+    }
+
+    active = 0;
+    m_gl.getProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+    issued();
+    for (GLint i = 0; i < active && entry->uniformCount < kMaxUniforms; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        m_gl.getActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+        issued();
+        Uniform& uniform = entry->uniforms[entry->uniformCount];
+        if (copyName(uniform.name, name, length)) {
+            uniform.location = m_gl.getUniformLocation(program, uniform.name);
+            uniform.known = false;
+            issued();
+            entry->uniformCount++;
+        }
+    }
+    return true;
+}
+
+GLint GlStateCache::attribLocation(GLuint program, const char* name) {
+    if (Program* entry = findProgram(program)) {
+        for (int i = 0; i < entry->attribCount; i++) {
+            if (strcmp(entry->attribs[i].name, name) == 0) {
+                skipped();
+                return entry->attribs[i].location;
+            }
+        }
+        // Not active, or didn't fit: only GL knows which
+        if (entry->attribCount < kMaxAttribs) {
+            skipped();
+            return -1;
+        }
+    }
+    issued();
+    return m_gl.getAttribLocation(program, name);
+}
+
+GLint GlStateCache::uniformLocation(GLuint program, const char* name) {
+    if (Program* entry = findProgram(program)) {
+        for (int i = 0; i < entry->uniformCount; i++) {
+            if (nameMatches(entry->uniforms[i].name, name)) {
+                skipped();
+                return entry->uniforms[i].location;
+            }
+        }
+        if (entry->uniformCount < kMaxUniforms) {
+            skipped();
+            return -1;
+        }
+    }
+    issued();
+    return m_gl.getUniformLocation(program, name);
+}
+
+void GlStateCache::deleteProgram(GLuint program) {
+    if (Program* entry = findProgram(program)) {
+        entry->id = 0;
+    }
+    // GL keeps a deleted program current until the next glUseProgram, but
+    // its name may come back from glCreateProgram: don't trust a match
+    if (m_program == program) {
+        m_program = kUnknown;
+    }
+    m_gl.deleteProgram(program);
+    issued();
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+void GlStateCache::useProgram(GLuint program) {
+    if (program == m_program) {
+        skipped();
+        return;
+    }
+    m_gl.useProgram(program);
+    m_program = program;
+    issued();
+}
+
+void GlStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* bound = target == GL_ARRAY_BUFFER           ? &m_arrayBuffer
+                    : target == GL_ELEMENT_ARRAY_BUFFER ? &m_elementBuffer
+                                                        : nullptr;
+    if (bound && *bound == buffer) {
+        skipped();
+        return;
+    }
+    m_gl.bindBuffer(target, buffer);
+    if (bound) {
+        *bound = buffer;
+    }
+    issued();
+}
+
+void GlStateCache::deleteBuffer(GLuint buffer) {
+    if (buffer == 0) {
+        skipped();
+        return;
+    }
+    // Deleting a bound buffer resets every binding to it to 0, vertex
+    // attribute pointers included (ES 2.0 section 2.9)
+    if (m_arrayBuffer == buffer) {
+        m_arrayBuffer = 0;
+    }
+    if (m_elementBuffer == buffer) {
+        m_elementBuffer = 0;
+    }
+    for (AttribPointer& pointer : m_pointers) {
+        if (pointer.known && pointer.buffer == buffer) {
+            pointer.known = false;
+        }
+    }
+    m_gl.deleteBuffers(1, &buffer);
+    issued();
+}
+
+void GlStateCache::enableVertexAttribArray(GLuint index) {
+    uint32_t bit = index < kMaxAttribs ? 1u << index : 0;
+    if (bit && (m_attribsKnown & bit) && (m_attribsEnabled & bit)) {
+        skipped();
+        return;
+    }
+    m_gl.enableVertexAttribArray(index);
+    m_attribsKnown |= bit;
+    m_attribsEnabled |= bit;
+    issued();
+}
+
+void GlStateCache::disableVertexAttribArray(GLuint index) {
+    uint32_t bit = index < kMaxAttribs ? 1u << index : 0;
+    if (bit && (m_attribsKnown & bit) && !(m_attribsEnabled & bit)) {
+        skipped();
+        return;
+    }
+    m_gl.disableVertexAttribArray(index);
+    m_attribsKnown |= bit;
+    m_attribsEnabled &= ~bit;
+    issued();
+}
+
+void GlStateCache::vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                                       GLboolean normalized, GLsizei stride,
+                                       const void* pointer) {
+    if (index < kMaxAttribs) {
+        AttribPointer& cached = m_pointers[index];
+        // An unknown array buffer binding makes the pointer unknown too
+        bool same = cached.known && m_arrayBuffer != kUnknown &&
+                    cached.buffer == m_arrayBuffer && cached.size == size &&
+                    cached.type == type && cached.normalized == normalized &&
+                    cached.stride == stride && cached.pointer == pointer;
+        if (same) {
+            skipped();
+            return;
+        }
+        cached.buffer = m_arrayBuffer;
+        cached.size = size;
+        cached.type = type;
+        cached.normalized = normalized;
+        cached.stride = stride;
+        cached.pointer = pointer;
+        cached.known = m_arrayBuffer != kUnknown;
+    }
+    m_gl.vertexAttribPointer(index, size, type, normalized, stride, pointer);
+    issued();
+}
+
+void GlStateCache::vertexAttribBuffer(GLuint index, GLuint buffer, GLint size, GLenum type,
+                                      GLboolean normalized, GLsizei stride,
+                                      const void* pointer) {
+    if (index < kMaxAttribs) {
+        const AttribPointer& cached = m_pointers[index];
+        if (cached.known && cached.buffer == buffer && cached.size == size &&
+            cached.type == type && cached.normalized == normalized &&
+            cached.stride == stride && cached.pointer == pointer) {
+            skipped();  // Both calls
+            skipped();
+            return;
+        }
+    }
+    bindBuffer(GL_ARRAY_BUFFER, buffer);
+    vertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void GlStateCache::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (index < kMaxAttribs) {
+        AttribPointer& cached = m_pointers[index];
+        if (cached.divisorKnown && cached.divisor == divisor) {
+            skipped();
+            return;
+        }
+        cached.divisor = divisor;
+        cached.divisorKnown = true;
+    }
+    m_gl.vertexAttribDivisor(index, divisor);
+    issued();
+}
+
+bool GlStateCache::uniformChanged(GLint location, const float* values, int count) {
+    // Location -1 is silently ignored by GL: nothing to send
+    if (location == -1) {
+        return false;
+    }
+    Program* entry = m_program != kUnknown ? findProgram(m_program) : nullptr;
+    if (!entry) {
+        return true;
+    }
+    for (int i = 0; i < entry->uniformCount; i++) {
+        Uniform& uniform = entry->uniforms[i];
+        if (uniform.location == location) {
+            size_t bytes = count * sizeof(float);
+            if (uniform.known && memcmp(uniform.values, values, bytes) == 0) {
+                return false;
+            }
+            memcpy(uniform.values, values, bytes);
+            uniform.known = true;
+            return true;
+        }
+    }
+    return true;
+}
+
+void GlStateCache::uniform1f(GLint location, GLfloat x) {
+    if (!uniformChanged(location, &x, 1)) {
+        skipped();
+        return;
+    }
+    m_gl.uniform1f(location, x);
+    issued();
+}
+
+void GlStateCache::uniform2f(GLint location, GLfloat x, GLfloat y) {
+    const float values[2] = {x, y};
+    if (!uniformChanged(location, values, 2)) {
+        skipped();
+        return;
+    }
+    m_gl.uniform2f(location, x, y);
+    issued();
+}
+
+void GlStateCache::uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    const float values[4] = {x, y, z, w};
+    if (!uniformChanged(location, values, 4)) {
+        skipped();
+        return;
+    }
+    m_gl.uniform4f(location, x, y, z, w);
+    issued();
+}
+
+void GlStateCache::uniformMatrix4fv(GLint location, const GLfloat* matrix) {
+    if (!uniformChanged(location, matrix, 16)) {
+        skipped();
+        return;
+    }
+    m_gl.uniformMatrix4fv(location, 1, GL_FALSE, matrix);
+    issued();
+}
+
+void GlStateCache::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    const float color[4] = {r, g, b, a};
+    if (m_clearColorKnown && memcmp(m_clearColor, color, sizeof(color)) == 0) {
+        skipped();
+        return;
+    }
+    m_gl.clearColor(r, g, b, a);
+    memcpy(m_clearColor, color, sizeof(color));
+    m_clearColorKnown = true;
+    issued();
+}
+
+void GlStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint rect[4] = {x, y, width, height};
+    if (m_viewportKnown && memcmp(m_viewport, rect, sizeof(rect)) == 0) {
+        skipped();
+        return;
+    }
+    m_gl.viewport(x, y, width, height);
+    memcpy(m_viewport, rect, sizeof(rect));
+    m_viewportKnown = true;
+    issued();
+}
+
+void GlStateCache::enable(GLenum cap) {
+    if (cap == GL_BLEND) {
+        if (m_blend == GL_TRUE) {
+            skipped();
+            return;
+        }
+        m_blend = GL_TRUE;
+    }
+    m_gl.enable(cap);
+    issued();
+}
+
+void GlStateCache::disable(GLenum cap) {
+    if (cap == GL_BLEND) {
+        if (m_blend == GL_FALSE) {
+            skipped();
+            return;
+        }
+        m_blend = GL_FALSE;
+    }
+    m_gl.disable(cap);
+    issued();
+}
+
+void GlStateCache::blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (m_blendFunc[0] == sfactor && m_blendFunc[1] == dfactor) {
+        skipped();
+        return;
+    }
+    m_gl.blendFunc(sfactor, dfactor);
+    m_blendFunc[0] = sfactor;
+    m_blendFunc[1] = dfactor;
+    issued();
+}
+
+// ============================================================================
+// ALWAYS ISSUED
+// ============================================================================
+
+void GlStateCache::clear(GLbitfield mask) {
+    m_gl.clear(mask);
+    issued();
+}
+
+void GlStateCache::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    m_gl.drawArrays(mode, first, count);
+    issued();
+    m_frame.draws++;
+    m_total.draws++;
+}
+
+void GlStateCache::drawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+                                       GLsizei instances) {
+    m_gl.drawArraysInstanced(mode, first, count, instances);
+    issued();
+    m_frame.draws++;
+    m_total.draws++;
+}
+
+void GlStateCache::drawElements(GLenum mode, GLsizei count, GLenum type, GLintptr offset) {
+    m_gl.drawElements(mode, count, type, reinterpret_cast<const void*>(offset));
+    issued();
+    m_frame.draws++;
+    m_total.draws++;
+}
+
+GLuint GlStateCache::genBuffer() {
+    GLuint buffer = 0;
+    m_gl.genBuffers(1, &buffer);
+    issued();
+    return buffer;
+}
+
+void GlStateCache::bufferData(GLenum target, GLsizeiptr size, const void* data,
+                              GLenum usage) {
+    m_gl.bufferData(target, size, data, usage);
+    issued();
+}
+
+void GlStateCache::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                                 const void* data) {
+    m_gl.bufferSubData(target, offset, size, data);
+    issued();
+}
+
+void GlStateCache::vertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    m_gl.vertexAttrib4f(index, x, y, z, w);
+    issued();
+}
+
+void* GlStateCache::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+                                   GLbitfield access) {
+    issued();
+    return m_gl.mapBufferRange(target, offset, length, access);
+}
+
+GLboolean GlStateCache::unmapBuffer(GLenum target) {
+    issued();
+    return m_gl.unmapBuffer(target);
+}
+
+GLsync GlStateCache::fenceSync() {
+    issued();
+    return m_gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLenum GlStateCache::clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeoutNanos) {
+    issued();
+    return m_gl.clientWaitSync(sync, flags, timeoutNanos);
+}
+
+void GlStateCache::deleteSync(GLsync sync) {
+    m_gl.deleteSync(sync);
+    issued();
+}
+
+} // namespace gl
@@ -0,0 +1,248 @@
+/**
+ * gl/gl_state.h: A shadow copy of GL state that drops redundant calls
+ *
+ * GL is a state machine, and setting state to the value it already has
+ * still costs a trip into the driver: argument validation, a lock, often
+ * a dirty flag that makes the next draw re-validate everything. The
+ * original renderFrame() paid that every frame for state that never
+ * changed: glUseProgram, glBindBuffer, glEnable/DisableVertexAttribArray,
+ * the same color uniform, and a glGetAttribLocation string lookup.
+ *
+ * GlStateCache keeps the last value it sent for each piece of state it
+ * wraps and only calls GL when a request differs:
+ *
+ *     gl.useProgram(p);    // issued
+ *     gl.useProgram(p);    // skipped: already current
+ *
+ * WHAT IS TRACKED
+ * - The current program and the GL_ARRAY_BUFFER / GL_ELEMENT_ARRAY_BUFFER
+ *   bindings.
+ * - Which vertex attribute arrays are enabled, each one's pointer (size,
+ *   type, stride, offset and the buffer bound when it was set) and its
+ *   instance divisor.
+ * - Uniform values per program: GLES2 uniforms are program state, so a
+ *   color set once stays set across glUseProgram switches.
+ * - Clear color, viewport, whether GL_BLEND is on and the blend function.
+ * Draws, clears, buffer uploads, maps, fences and constant attribute
+ * values have no state worth comparing; they're always issued and only
+ * counted.
+ *
+ * LOCATIONS AT LINK TIME: registerProgram() asks GL once for every
+ * active attribute and uniform of a freshly linked program and keeps
+ * their locations. attribLocation() / uniformLocation() then answer from
+ * that table instead of a glGet*Location string search in the driver.
+ *
+ * THE RULE: the cache is only right while every change to the state it
+ * tracks goes through it. A stray glBindBuffer() behind its back would
+ * make it skip a bind that is needed. When GL state becomes unknown (a
+ * new EGL context after the surface was recreated), call invalidate():
+ * everything is sent again and programs must be registered again.
+ *
+ * COUNTERS: every call is counted as issued (forwarded to GL) or skipped
+ * (answered by the cache), per frame (beginFrame() resets) and in total.
+ * Draw calls are also counted on their own.
+ *
+ * Lookup: "OpenGL redundant state change", "GL state cache / shadow
+ *         state", "glGetActiveUniform", "driver validation overhead"
+ */
+
+#ifndef PHASE4_GL_STATE_H
+#define PHASE4_GL_STATE_H
+
+#include "gl_dispatch.h"
+
+#include <cstdint>
+
+namespace gl {
+
+struct GlCallStats {
+    uint32_t issued = 0;   // Calls forwarded to GL
+    uint32_t skipped = 0;  // Calls the cache made unnecessary
+    uint32_t draws = 0;    // Draw calls among the issued ones (instanced or not)
+};
+
+class GlStateCache {
+public:
+    // Fixed capacities: this renderer has one program with one attribute
+    // and two uniforms, later ones a handful. Anything beyond these is
+    // passed through to GL uncached.
+    static constexpr int kMaxPrograms = 8;
+    static constexpr int kMaxAttribs = 16;   // Vertex attributes per program (and indices)
+    static constexpr int kMaxUniforms = 16;  // Uniforms per program
+    static constexpr int kMaxNameLength = 48;
+
+    explicit GlStateCache(const GlDispatch& dispatch);
+
+    // Forget all state and all registered programs: the next call of
+    // each kind is issued. Call on a new (or lost) GL context.
+    void invalidate();
+
+    // Whether drawArraysInstanced() / vertexAttribDivisor() can be called
+    bool hasInstancing() const {
+        return m_gl.drawArraysInstanced != nullptr && m_gl.vertexAttribDivisor != nullptr;
+    }
+
+    // Whether mapBufferRange() and the fence calls can be
+    bool hasBufferMapping() const {
+        return m_gl.mapBufferRange != nullptr && m_gl.unmapBuffer != nullptr &&
+               m_gl.fenceSync != nullptr && m_gl.clientWaitSync != nullptr &&
+               m_gl.deleteSync != nullptr;
+    }
+
+    // Start a new frame's counters
+    void beginFrame() { m_frame = GlCallStats(); }
+    const GlCallStats& frameStats() const { return m_frame; }
+    const GlCallStats& totalStats() const { return m_total; }
+
+    // ------------------------------------------------------------------
+    // Programs and locations
+    // ------------------------------------------------------------------
+
+    // Read a linked program's active attributes and uniforms and cache
+    // their locations. Returns false if the program table is full (the
+    // program still works, its lookups just go to GL).
+    bool registerProgram(GLuint program);
+
+    // Cached locations, -1 if the program has no such active variable.
+    // Array uniforms match with or without "[0]". Unregistered programs
+    // fall back to glGet*Location.
+    GLint attribLocation(GLuint program, const char* name);
+    GLint uniformLocation(GLuint program, const char* name);
+
+    // glDeleteProgram, dropping its cached locations and uniform values
+    void deleteProgram(GLuint program);
+
+    // ------------------------------------------------------------------
+    // State (each skips the GL call when it wouldn't change anything)
+    // ------------------------------------------------------------------
+
+    void useProgram(GLuint program);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void deleteBuffer(GLuint buffer);  // Also unbinds it, as GL does
+
+    void enableVertexAttribArray(GLuint index);
+    void disableVertexAttribArray(GLuint index);
+    // Stored with the GL_ARRAY_BUFFER bound at the time, like GL does
+    void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                             GLsizei stride, const void* pointer);
+    // glBindBuffer(GL_ARRAY_BUFFER, buffer) + glVertexAttribPointer, both
+    // skipped when attribute `index` already reads exactly this: like a
+    // vertex array object, several buffers' attributes cost nothing per
+    // frame once set, instead of a rebind of each buffer every frame
+    void vertexAttribBuffer(GLuint index, GLuint buffer, GLint size, GLenum type,
+                            GLboolean normalized, GLsizei stride, const void* pointer);
+    // 0 = per vertex, n = advance every n instances (needs hasInstancing())
+    void vertexAttribDivisor(GLuint index, GLuint divisor);
+
+    // Uniforms of the current program
+    void uniform1f(GLint location, GLfloat x);
+    void uniform2f(GLint location, GLfloat x, GLfloat y);
+    void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void uniformMatrix4fv(GLint location, const GLfloat* matrix);  // One, not transposed
+
+    void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Only GL_BLEND is tracked; other capabilities are passed through
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+    void blendFunc(GLenum sfactor, GLenum dfactor);
+
+    // ------------------------------------------------------------------
+    // Always issued
+    // ------------------------------------------------------------------
+
+    void clear(GLbitfield mask);
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    // `offset` bytes into the bound GL_ELEMENT_ARRAY_BUFFER
+    void drawElements(GLenum mode, GLsizei count, GLenum type, GLintptr offset);
+
+    GLuint genBuffer();
+    // Upload to the buffer bound to `target` (bind it through the cache)
+    void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+    void vertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+    // GLES 3 only (needs hasBufferMapping())
+    void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    GLboolean unmapBuffer(GLenum target);
+    GLsync fenceSync();  // GL_SYNC_GPU_COMMANDS_COMPLETE
+    GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeoutNanos);
+    void deleteSync(GLsync sync);
+
+private:
+    struct Variable {
+        char name[kMaxNameLength];
+        GLint location;
+    };
+
+    // A uniform's location and the last value set (up to a mat4)
+    struct Uniform {
+        char name[kMaxNameLength];
+        GLint location;
+        float values[16];
+        bool known;
+    };
+
+    struct Program {
+        GLuint id;  // 0 = free slot
+        Variable attribs[kMaxAttribs];
+        int attribCount;
+        Uniform uniforms[kMaxUniforms];
+        int uniformCount;
+    };
+
+    struct AttribPointer {
+        GLuint buffer;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+        const void* pointer;
+        bool known;
+        GLuint divisor;
+        bool divisorKnown;
+    };
+
+    void issued() {
+        m_frame.issued++;
+        m_total.issued++;
+    }
+    void skipped() {
+        m_frame.skipped++;
+        m_total.skipped++;
+    }
+
+    Program* findProgram(GLuint program);
+    // Compare-and-store a uniform's value; true if GL must be called
+    bool uniformChanged(GLint location, const float* values, int count);
+
+    const GlDispatch& m_gl;
+    GlCallStats m_frame;
+    GlCallStats m_total;
+
+    Program m_programs[kMaxPrograms];
+
+    // "Unknown" is a value GL never reports, so any real value differs
+    static constexpr GLuint kUnknown = 0xFFFFFFFFu;
+    GLuint m_program = kUnknown;
+    GLuint m_arrayBuffer = kUnknown;
+    GLuint m_elementBuffer = kUnknown;
+
+    uint32_t m_attribsKnown = 0;    // Bit i: enabled state of attribute i is known...
+    uint32_t m_attribsEnabled = 0;  // ...and is this
+    AttribPointer m_pointers[kMaxAttribs];
+
+    float m_clearColor[4];
+    bool m_clearColorKnown = false;
+    GLint m_viewport[4];
+    bool m_viewportKnown = false;
+
+    GLenum m_blend = kUnknown;  // GL_TRUE / GL_FALSE once known
+    GLenum m_blendFunc[2] = {kUnknown, kUnknown};
+};
+
+} // namespace gl
+
+#endif // PHASE4_GL_STATE_H
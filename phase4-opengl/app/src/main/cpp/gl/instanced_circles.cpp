@@ -0,0 +1,198 @@
+/**
+ * gl/instanced_circles.cpp: Instanced circle scene
+ */
+
+#include "instanced_circles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+namespace gl {
+
+const char* const kInstancedCircleVertexShader = R"(
+    attribute vec2 aPosition;   // Unit circle fan vertex (per vertex)
+    attribute vec4 aMotion;     // Start x, y and velocity x, y (per instance)
+    attribute float aRadius;    // (per instance)
+    attribute vec4 aColor;      // (per instance, bytes normalized to 0-1)
+
+    uniform float uTime;        // Seconds since the scene started
+    uniform vec2 uRadiusScale;  // Shorter side / width, / height
+
+    varying vec4 vColor;
+
+    // Bounce between r and 1 - r: a triangle wave with period 2 (1 - 2r)
+    // (same math as bounce() in instanced_circles.cpp)
+    float bounce(float start, float velocity, float r) {
+        float span = max(1.0 - 2.0 * r, 0.0001);
+        float x = start - r + velocity * uTime;
+        return r + span - abs(mod(x, 2.0 * span) - span);
+    }
+
+    void main() {
+        vec2 radius = aRadius * uRadiusScale;
+        vec2 center = vec2(bounce(aMotion.x, aMotion.z, radius.x),
+                           bounce(aMotion.y, aMotion.w, radius.y));
+        // 0-1 surface coordinates to -1..1 clip space
+        gl_Position = vec4((center + aPosition * radius) * 2.0 - 1.0, 0.0, 1.0);
+        vColor = aColor;
+    }
+)";
+
+const char* const kInstancedCircleFragmentShader = R"(
+    precision mediump float;
+
+    varying vec4 vColor;
+
+    void main() {
+        gl_FragColor = vColor;
+    }
+)";
+
+float bounce(float start, float velocity, float radius, float seconds) {
+    float span = std::max(1.0f - 2.0f * radius, 0.0001f);
+    float x = start - radius + velocity * seconds;
+    // GLSL mod(): x - y * floor(x / y), never negative for y > 0
+    float period = 2.0f * span;
+    float wrapped = x - period * std::floor(x / period);
+    return radius + span - std::fabs(wrapped - span);
+}
+
+std::vector<CircleInstance> randomCircles(int count, uint32_t seed) {
+    // std::mt19937's output is fixed by the standard (the distributions
+    // aren't), so the scene is the same on the device and the host
+    std::mt19937 rng(seed);
+    auto unit = [&rng]() { return (rng() >> 8) * (1.0f / 16777216.0f); };
+
+    // Keep the total area about the same at any count (roughly a third of
+    // the screen), so the stress is on vertices and calls, not fill rate
+    float radius = 0.5f / std::sqrt(static_cast<float>(std::max(count, 1)));
+    radius = std::min(0.05f, std::max(0.002f, radius));
+
+    std::vector<CircleInstance> circles(std::max(count, 0));
+    for (CircleInstance& circle : circles) {
+        circle.x = 0.05f + 0.9f * unit();
+        circle.y = 0.05f + 0.9f * unit();
+        float angle = 6.2831853f * unit();
+        float speed = 0.1f + 0.3f * unit();
+        circle.velocityX = speed * std::cos(angle);
+        circle.velocityY = speed * std::sin(angle);
+        circle.radius = radius * (0.5f + unit());
+        circle.color[0] = static_cast<uint8_t>(64 + rng() % 192);
+        circle.color[1] = static_cast<uint8_t>(64 + rng() % 192);
+        circle.color[2] = static_cast<uint8_t>(64 + rng() % 192);
+        circle.color[3] = 255;
+    }
+    return circles;
+}
+
+bool InstancedCircles::init(GlStateCache& gl, GLuint program,
+                            std::vector<CircleInstance> circles) {
+    m_circles = std::move(circles);
+    m_program = program;
+
+    m_positionLocation = gl.attribLocation(program, "aPosition");
+    m_motionLocation = gl.attribLocation(program, "aMotion");
+    m_radiusLocation = gl.attribLocation(program, "aRadius");
+    m_colorLocation = gl.attribLocation(program, "aColor");
+    m_timeLocation = gl.uniformLocation(program, "uTime");
+    m_scaleLocation = gl.uniformLocation(program, "uRadiusScale");
+    if (m_positionLocation < 0 || m_motionLocation < 0 || m_radiusLocation < 0 ||
+        m_colorLocation < 0) {
+        return false;
+    }
+
+    // Unit circle as a triangle fan: center, then the rim, closed
+    float fan[kFanVertices * 2];
+    fan[0] = 0.0f;
+    fan[1] = 0.0f;
+    for (int i = 0; i <= kSegments; i++) {
+        float angle = 6.2831853f * i / kSegments;
+        fan[(i + 1) * 2 + 0] = std::cos(angle);
+        fan[(i + 1) * 2 + 1] = std::sin(angle);
+    }
+    m_fanVbo = gl.genBuffer();
+    gl.bindBuffer(GL_ARRAY_BUFFER, m_fanVbo);
+    gl.bufferData(GL_ARRAY_BUFFER, sizeof(fan), fan, GL_STATIC_DRAW);
+
+    // Uploaded once: the shader does the animating
+    m_instanceVbo = gl.genBuffer();
+    gl.bindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+    gl.bufferData(GL_ARRAY_BUFFER, m_circles.size() * sizeof(CircleInstance), m_circles.data(),
+                  GL_STATIC_DRAW);
+    return true;
+}
+
+void InstancedCircles::release(GlStateCache& gl) {
+    if (m_fanVbo != 0) {
+        gl.deleteBuffer(m_fanVbo);
+        m_fanVbo = 0;
+    }
+    if (m_instanceVbo != 0) {
+        gl.deleteBuffer(m_instanceVbo);
+        m_instanceVbo = 0;
+    }
+}
+
+void InstancedCircles::draw(GlStateCache& gl, float seconds, int width, int height) {
+    gl.clear(GL_COLOR_BUFFER_BIT);
+
+    gl.useProgram(m_program);
+    gl.uniform1f(m_timeLocation, seconds);
+    float shorter = static_cast<float>(std::min(width, height));
+    gl.uniform2f(m_scaleLocation, shorter / width, shorter / height);
+
+    GLuint position = static_cast<GLuint>(m_positionLocation);
+    GLuint motion = static_cast<GLuint>(m_motionLocation);
+    GLuint radius = static_cast<GLuint>(m_radiusLocation);
+    GLuint color = static_cast<GLuint>(m_colorLocation);
+
+    // The fan, per vertex
+    gl.enableVertexAttribArray(position);
+    gl.vertexAttribBuffer(position, m_fanVbo, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    if (!gl.hasInstancing()) {
+        drawOneByOne(gl);
+        return;
+    }
+    gl.vertexAttribDivisor(position, 0);
+
+    // The circles, one record per instance
+    const GLsizei stride = sizeof(CircleInstance);
+    gl.enableVertexAttribArray(motion);
+    gl.vertexAttribBuffer(motion, m_instanceVbo, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const void*>(offsetof(CircleInstance, x)));
+    gl.vertexAttribDivisor(motion, 1);
+    gl.enableVertexAttribArray(radius);
+    gl.vertexAttribBuffer(radius, m_instanceVbo, 1, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const void*>(offsetof(CircleInstance, radius)));
+    gl.vertexAttribDivisor(radius, 1);
+    gl.enableVertexAttribArray(color);
+    gl.vertexAttribBuffer(color, m_instanceVbo, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          reinterpret_cast<const void*>(offsetof(CircleInstance, color)));
+    gl.vertexAttribDivisor(color, 1);
+
+    gl.drawArraysInstanced(GL_TRIANGLE_FAN, 0, kFanVertices, count());
+}
+
+void InstancedCircles::drawOneByOne(GlStateCache& gl) {
+    GLuint motion = static_cast<GLuint>(m_motionLocation);
+    GLuint radius = static_cast<GLuint>(m_radiusLocation);
+    GLuint color = static_cast<GLuint>(m_colorLocation);
+
+    // Disabled arrays read the constant value instead
+    gl.disableVertexAttribArray(motion);
+    gl.disableVertexAttribArray(radius);
+    gl.disableVertexAttribArray(color);
+
+    for (const CircleInstance& circle : m_circles) {
+        gl.vertexAttrib4f(motion, circle.x, circle.y, circle.velocityX, circle.velocityY);
+        gl.vertexAttrib4f(radius, circle.radius, 0.0f, 0.0f, 1.0f);
+        gl.vertexAttrib4f(color, circle.color[0] / 255.0f, circle.color[1] / 255.0f,
+                          circle.color[2] / 255.0f, circle.color[3] / 255.0f);
+        gl.drawArrays(GL_TRIANGLE_FAN, 0, kFanVertices);
+    }
+}
+
+} // namespace gl
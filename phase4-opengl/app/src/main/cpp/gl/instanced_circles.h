@@ -0,0 +1,106 @@
+/**
+ * gl/instanced_circles.h: Thousands of bouncing circles in one draw call
+ *
+ * The single-circle scene computes an MVP matrix on the CPU and draws one
+ * triangle fan. Doing that per circle would cost a uniform upload and a
+ * draw call each: 10,000 circles would be 20,000+ calls into the driver
+ * per frame, and the CPU, not the GPU, would set the frame rate.
+ *
+ * INSTANCING draws the same mesh (a unit circle fan) N times in one call.
+ * Attributes with a divisor of 1 advance once per instance instead of
+ * once per vertex, so each copy reads its own record from a second
+ * buffer:
+ *
+ *     buffer 1 (per vertex)    fan: center, 24 points on the rim
+ *     buffer 2 (per instance)  start x y, velocity x y, radius, RGBA
+ *     glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 26, N)
+ *
+ * MOTION ON THE GPU: the instance buffer is uploaded once and never
+ * changes. The vertex shader computes where each circle is at time t,
+ * bouncing between the edges, from its start and velocity alone
+ * (bounce(): a triangle wave). So a frame is the same handful of calls
+ * (clear, one float uniform, one draw) whether there are 10 circles or
+ * 100,000; only the GPU's work grows.
+ *
+ * WITHOUT INSTANCING (a GLES 2.0 context lacking GL_EXT/ANGLE_instanced_
+ * arrays) the same program draws one circle per call: the per-instance
+ * attribute arrays are disabled and each circle's values are set as
+ * constant attributes (glVertexAttrib4f). Same pixels, N draw calls.
+ *
+ * Positions are 0-1 across the surface; radii are fractions of the
+ * shorter side, so circles stay round in any aspect ratio.
+ *
+ * Lookup: "glDrawArraysInstanced", "glVertexAttribDivisor",
+ *         "GL_EXT_instanced_arrays", "draw call overhead"
+ */
+
+#ifndef PHASE4_GL_INSTANCED_CIRCLES_H
+#define PHASE4_GL_INSTANCED_CIRCLES_H
+
+#include "gl_state.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gl {
+
+// One circle as stored in the instance buffer (24 bytes: 5 floats, RGBA)
+struct CircleInstance {
+    float x;          // Center at time 0, 0-1 across the surface
+    float y;
+    float velocityX;  // Surface widths / heights per second
+    float velocityY;
+    float radius;     // Fraction of the shorter surface side
+    uint8_t color[4]; // RGBA
+};
+
+// GLSL ES 1.00: runs on GLES 2 and 3 contexts alike
+extern const char* const kInstancedCircleVertexShader;
+extern const char* const kInstancedCircleFragmentShader;
+
+// The vertex shader's motion, on the CPU: one coordinate bouncing
+// between radius and 1 - radius, `seconds` after starting at `start`
+float bounce(float start, float velocity, float radius, float seconds);
+
+// `count` random circles, the same for the same seed on every platform
+std::vector<CircleInstance> randomCircles(int count, uint32_t seed);
+
+class InstancedCircles {
+public:
+    static constexpr int kSegments = 24;  // Small circles don't need 64
+    static constexpr int kFanVertices = kSegments + 2;
+
+    // Create the fan and instance buffers for a linked program built from
+    // the shaders above (registerProgram() it first). Returns false if
+    // the program lacks an attribute.
+    bool init(GlStateCache& gl, GLuint program, std::vector<CircleInstance> circles);
+
+    // Delete the buffers (the program belongs to the caller)
+    void release(GlStateCache& gl);
+
+    // Clear and draw every circle at time `seconds` on a width x height
+    // surface: one instanced draw, or one draw per circle without
+    // instancing
+    void draw(GlStateCache& gl, float seconds, int width, int height);
+
+    int count() const { return static_cast<int>(m_circles.size()); }
+
+private:
+    void drawOneByOne(GlStateCache& gl);
+
+    std::vector<CircleInstance> m_circles;  // Kept for drawing without instancing
+    GLuint m_program = 0;
+    GLuint m_fanVbo = 0;
+    GLuint m_instanceVbo = 0;
+
+    GLint m_positionLocation = -1;  // attribute vec2 aPosition (per vertex)
+    GLint m_motionLocation = -1;    // attribute vec4 aMotion: start, velocity
+    GLint m_radiusLocation = -1;    // attribute float aRadius
+    GLint m_colorLocation = -1;     // attribute vec4 aColor
+    GLint m_timeLocation = -1;      // uniform float uTime
+    GLint m_scaleLocation = -1;     // uniform vec2 uRadiusScale
+};
+
+} // namespace gl
+
+#endif // PHASE4_GL_INSTANCED_CIRCLES_H
@@ -0,0 +1,195 @@
+/**
+ * gl/program_cache.cpp: ProgramCache
+ */
+
+#include "program_cache.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace gl {
+
+namespace {
+
+// Bump when the file layout (or what goes into the key) changes
+const uint32_t kFileVersion = 1;
+
+// Real program binaries are kilobytes to a few hundred; anything past
+// this is a damaged length field, not a program
+const uint32_t kMaxBinaryBytes = 16 * 1024 * 1024;
+
+// Written as-is: the file only ever goes back to the device that wrote it
+struct FileHeader {
+    char magic[4];      // "P4PB"
+    uint32_t version;   // kFileVersion
+    uint64_t key;       // ProgramCache::key() of the sources it was built from
+    uint32_t format;    // binaryFormat from glGetProgramBinary
+    uint32_t length;    // Bytes of binary after the header
+    uint64_t checksum;  // FNV-1a of those bytes
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader has padding");
+
+const char kMagic[4] = {'P', '4', 'P', 'B'};
+
+// FNV-1a, 64 bit: one multiply and xor per byte, and any change to the
+// input changes the result. Not cryptographic, which a cache key doesn't
+// need to be.
+const uint64_t kFnvOffset = 14695981039346656037ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+// The string and its terminator, so "ab" + "c" and "a" + "bc" differ
+uint64_t fnv1a(const char* text, uint64_t hash) {
+    return fnv1a(text ? text : "", text ? strlen(text) + 1 : 1, hash);
+}
+
+int64_t nanosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+}
+
+} // namespace
+
+void ProgramCache::init(const char* directory, const char* renderer, const char* version) {
+    m_directory = directory ? directory : "";
+    m_driverHash = fnv1a(version, fnv1a(renderer, kFnvOffset));
+    m_stats = ProgramCacheStats();
+}
+
+uint64_t ProgramCache::key(const char* vertexSource, const char* fragmentSource) const {
+    return fnv1a(fragmentSource, fnv1a(vertexSource, m_driverHash));
+}
+
+std::string ProgramCache::path(uint64_t key) const {
+    char name[40];
+    snprintf(name, sizeof(name), "/program-%016" PRIx64 ".bin", key);
+    return m_directory + name;
+}
+
+GLuint ProgramCache::getProgram(const GlDispatch& gl, const char* vertexSource,
+                                const char* fragmentSource, CompileFn compile) {
+    using Clock = std::chrono::steady_clock;
+    bool binaries = enabled() && gl.getProgramBinary != nullptr && gl.programBinary != nullptr;
+    uint64_t programKey = binaries ? key(vertexSource, fragmentSource) : 0;
+
+    if (binaries) {
+        Clock::time_point start = Clock::now();
+        GLuint program = load(gl, programKey);
+        m_stats.loadNanos += nanosSince(start);
+        if (program != 0) {
+            m_stats.loaded++;
+            return program;
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    GLuint program = compile(vertexSource, fragmentSource);
+    if (program != 0) {
+        m_stats.compiled++;
+        if (binaries) {
+            store(gl, program, programKey);
+        }
+    }
+    m_stats.compileNanos += nanosSince(start);
+    return program;
+}
+
+GLuint ProgramCache::load(const GlDispatch& gl, uint64_t key) {
+    std::string file = path(key);
+    FILE* in = fopen(file.c_str(), "rb");
+    if (!in) {
+        return 0;  // Never saved: a plain miss
+    }
+
+    FileHeader header;
+    std::vector<uint8_t> binary;
+    bool valid = fread(&header, sizeof(header), 1, in) == 1 &&
+                 memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header.version == kFileVersion && header.key == key && header.length > 0 &&
+                 header.length <= kMaxBinaryBytes;
+    if (valid) {
+        binary.resize(header.length);
+        // All of it, nothing after it, and the bytes as they were written
+        valid = fread(binary.data(), 1, binary.size(), in) == binary.size() &&
+                fgetc(in) == EOF &&
+                fnv1a(binary.data(), binary.size(), kFnvOffset) == header.checksum;
+    }
+    fclose(in);
+
+    GLuint program = 0;
+    if (valid) {
+        program = gl.createProgram();
+        if (program == 0) {
+            return 0;  // Out of names: not the file's fault
+        }
+        gl.programBinary(program, header.format, binary.data(),
+                         static_cast<GLsizei>(binary.size()));
+        // The driver's verdict: it refuses binaries it can't use
+        GLint linked = GL_FALSE;
+        gl.getProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE) {
+            gl.deleteProgram(program);
+            program = 0;
+        }
+    }
+    if (program == 0) {
+        // It would fail the same way next time: compile and save anew
+        remove(file.c_str());
+        m_stats.rejected++;
+    }
+    return program;
+}
+
+void ProgramCache::store(const GlDispatch& gl, GLuint program, uint64_t key) {
+    // (GL_PROGRAM_BINARY_LENGTH_OES is the same enum)
+    GLint length = 0;
+    gl.getProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || static_cast<uint32_t>(length) > kMaxBinaryBytes) {
+        return;
+    }
+    std::vector<uint8_t> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    gl.getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.resize(written);
+
+    FileHeader header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFileVersion;
+    header.key = key;
+    header.format = format;
+    header.length = static_cast<uint32_t>(binary.size());
+    header.checksum = fnv1a(binary.data(), binary.size(), kFnvOffset);
+
+    // Under another name until complete: a reader never sees half a file
+    std::string file = path(key);
+    std::string temporary = file + ".tmp";
+    FILE* out = fopen(temporary.c_str(), "wb");
+    if (!out) {
+        return;  // Read-only or full: run without saving
+    }
+    bool saved = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                 fwrite(binary.data(), 1, binary.size(), out) == binary.size();
+    saved &= fclose(out) == 0;
+    if (saved && rename(temporary.c_str(), file.c_str()) == 0) {
+        m_stats.stored++;
+    } else {
+        remove(temporary.c_str());
+    }
+}
+
+} // namespace gl
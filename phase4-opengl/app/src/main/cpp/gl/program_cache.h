@@ -0,0 +1,92 @@
+/**
+ * gl/program_cache.h: Linked shader programs saved to disk, for a faster start
+ *
+ * Every onSurfaceCreated() (app start, and every time the EGL context is
+ * lost: backgrounding, rotation on some devices) compiles and links each
+ * program from GLSL source. The driver's compiler is slow, often tens of
+ * milliseconds per program on a cold start, and all of it is before the
+ * first frame.
+ *
+ * PROGRAM BINARIES: after linking, glGetProgramBinary() hands back the
+ * driver's compiled form of the program, in a format only that driver
+ * understands. glProgramBinary() turns those bytes back into a linked
+ * program, skipping the compiler.
+ *
+ *     first launch:  source -> compile + link -> program -> save binary
+ *     later:         file -> glProgramBinary -> program  (no compiler)
+ *
+ * THE KEY: a binary is only good for the same shader sources on the same
+ * driver. The file name is a 64-bit FNV-1a hash of both sources, the
+ * GL_RENDERER string (the GPU) and the GL_VERSION string (which carries
+ * the driver build on Android), so a shader edit or a driver update
+ * simply misses and compiles again.
+ *
+ * VALIDATION: a file is used only if its header matches (magic, format
+ * version, key, length) and a checksum of the binary matches, so a
+ * truncated or damaged file isn't handed to the driver. The driver may
+ * still refuse a binary (GL_LINK_STATUS false: an update under the same
+ * version string); then the file is deleted and the program compiled
+ * from source, as without a cache. Files are written to a temporary
+ * name and renamed into place, so a crash mid-write leaves no half file.
+ *
+ * Lookup: "glProgramBinary shader cache", "GL_OES_get_program_binary",
+ *         "FNV-1a hash", "atomic file write rename"
+ */
+
+#ifndef PHASE4_GL_PROGRAM_CACHE_H
+#define PHASE4_GL_PROGRAM_CACHE_H
+
+#include "gl_dispatch.h"
+
+#include <cstdint>
+#include <string>
+
+namespace gl {
+
+struct ProgramCacheStats {
+    int loaded = 0;              // Programs made from a saved binary
+    int compiled = 0;            // Programs compiled from source (misses included)
+    int rejected = 0;            // Saved binaries that failed validation or glProgramBinary
+    int stored = 0;              // Binaries saved
+    int64_t loadNanos = 0;       // Time making programs from binaries (file read included)
+    int64_t compileNanos = 0;    // Time compiling and linking (saving the binary included)
+};
+
+class ProgramCache {
+public:
+    // Compile and link a program from source; 0 on failure
+    using CompileFn = GLuint (*)(const char* vertexSource, const char* fragmentSource);
+
+    // Save binaries in `directory` (the app's cache directory) for the
+    // driver described by `renderer` and `version` (GL_RENDERER and
+    // GL_VERSION). A null or empty directory turns the cache off: every
+    // program compiles. Resets the stats.
+    void init(const char* directory, const char* renderer, const char* version);
+
+    // A linked program for these sources: loaded from a saved binary if
+    // there's a valid one, else from compile() (and its binary saved).
+    // Without binary support in `gl` (loadProgramBinary()), just compile().
+    // 0 if compiling failed.
+    GLuint getProgram(const GlDispatch& gl, const char* vertexSource,
+                      const char* fragmentSource, CompileFn compile);
+
+    // The key for these sources on this driver, and the file it names
+    uint64_t key(const char* vertexSource, const char* fragmentSource) const;
+    std::string path(uint64_t key) const;
+
+    bool enabled() const { return !m_directory.empty(); }
+    const ProgramCacheStats& stats() const { return m_stats; }
+
+private:
+    // 0 if there's no valid binary for `key` (a bad one is deleted)
+    GLuint load(const GlDispatch& gl, uint64_t key);
+    void store(const GlDispatch& gl, GLuint program, uint64_t key);
+
+    std::string m_directory;
+    uint64_t m_driverHash = 0;  // Renderer and version, hashed once
+    ProgramCacheStats m_stats;
+};
+
+} // namespace gl
+
+#endif // PHASE4_GL_PROGRAM_CACHE_H
@@ -0,0 +1,149 @@
+/**
+ * gl/sdf_circle.cpp: SDF circle shaders and draw sequence
+ */
+
+#include "sdf_circle.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gl {
+
+const char* const kSdfCircleVertexShader = R"(
+    attribute vec2 aCorner;    // -1..1 square corner
+
+    uniform vec2 uCenter;      // Pixels
+    uniform float uRadius;     // Pixels
+    uniform vec2 uViewport;    // Pixels
+
+    varying vec2 vOffset;      // Pixels from the center
+
+    void main() {
+        // One pixel beyond the edge: room for the anti-aliasing ramp
+        vOffset = aCorner * (uRadius + 1.0);
+        gl_Position = vec4((uCenter + vOffset) / uViewport * 2.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+// mediump can be as coarse as 1 part in 1024: a pixel off at a radius of
+// 1000 px. Use highp where the fragment stage has it.
+// (Same math as sdfCoverage() below.)
+const char* const kSdfCircleFragmentShader = R"(
+    #ifdef GL_FRAGMENT_PRECISION_HIGH
+    precision highp float;
+    #else
+    precision mediump float;
+    #endif
+
+    uniform float uRadius;
+    uniform vec2 uStroke;      // Width (0 = filled), ring spacing (0 = one stroke)
+    uniform vec4 uColor;
+
+    varying vec2 vOffset;
+
+    void main() {
+        float d = length(vOffset);
+        float coverage;
+        if (uStroke.x <= 0.0) {
+            // Disc: 1 inside, 0 outside, a 1 pixel ramp across the edge
+            coverage = clamp(uRadius - d + 0.5, 0.0, 1.0);
+        } else {
+            float halfWidth = 0.5 * uStroke.x;
+            // Distance inwards from the middle of the outermost stroke
+            float band = uRadius - halfWidth - d;
+            if (uStroke.y > 0.0 && band > 0.0) {
+                // Fold onto the nearest ring further in
+                band = mod(band + 0.5 * uStroke.y, uStroke.y) - 0.5 * uStroke.y;
+            }
+            coverage = clamp(halfWidth - abs(band) + 0.5, 0.0, 1.0);
+        }
+        // Premultiplied, for glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+        gl_FragColor = vec4(uColor.rgb, 1.0) * (uColor.a * coverage);
+    }
+)";
+
+float sdfCoverage(const SdfCircleStyle& style, float radius, float distance) {
+    if (style.shape == kCircleFilled || style.strokeWidth <= 0.0f) {
+        return std::min(1.0f, std::max(0.0f, radius - distance + 0.5f));
+    }
+    float halfWidth = 0.5f * style.strokeWidth;
+    float band = radius - halfWidth - distance;
+    float spacing = style.shape == kCircleRings ? style.ringSpacing : 0.0f;
+    if (spacing > 0.0f && band > 0.0f) {
+        // GLSL mod() of a positive value
+        float shifted = band + 0.5f * spacing;
+        band = shifted - spacing * std::floor(shifted / spacing) - 0.5f * spacing;
+    }
+    return std::min(1.0f, std::max(0.0f, halfWidth - std::fabs(band) + 0.5f));
+}
+
+bool prepareSdfCirclePass(GlStateCache& gl, GLuint program, SdfCirclePass* pass) {
+    pass->program = program;
+    pass->cornerLocation = gl.attribLocation(program, "aCorner");
+    pass->centerLocation = gl.uniformLocation(program, "uCenter");
+    pass->radiusLocation = gl.uniformLocation(program, "uRadius");
+    pass->viewportLocation = gl.uniformLocation(program, "uViewport");
+    pass->strokeLocation = gl.uniformLocation(program, "uStroke");
+    pass->colorLocation = gl.uniformLocation(program, "uColor");
+    if (pass->cornerLocation < 0) {
+        return false;
+    }
+
+    // Triangle strip: bottom left, bottom right, top left, top right
+    static const float kQuad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    pass->quadVbo = gl.genBuffer();
+    gl.bindBuffer(GL_ARRAY_BUFFER, pass->quadVbo);
+    gl.bufferData(GL_ARRAY_BUFFER, sizeof(kQuad), kQuad, GL_STATIC_DRAW);
+    return true;
+}
+
+void releaseSdfCirclePass(GlStateCache& gl, SdfCirclePass* pass) {
+    if (pass->quadVbo != 0) {
+        gl.deleteBuffer(pass->quadVbo);
+        pass->quadVbo = 0;
+    }
+}
+
+void drawSdfCircle(GlStateCache& gl, const SdfCirclePass& pass, float centerX, float centerY,
+                   float radius, const SdfCircleStyle& style, const float* color, int width,
+                   int height) {
+    // Edge pixels are partly covered: blend them over what's behind
+    gl.enable(GL_BLEND);
+    gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    gl.useProgram(pass.program);
+    gl.uniform2f(pass.centerLocation, centerX, centerY);
+    gl.uniform1f(pass.radiusLocation, radius);
+    gl.uniform2f(pass.viewportLocation, static_cast<float>(width), static_cast<float>(height));
+    float strokeWidth = style.shape == kCircleFilled ? 0.0f : style.strokeWidth;
+    float ringSpacing = style.shape == kCircleRings ? style.ringSpacing : 0.0f;
+    gl.uniform2f(pass.strokeLocation, strokeWidth, ringSpacing);
+    gl.uniform4f(pass.colorLocation, color[0], color[1], color[2], color[3]);
+
+    GLuint corner = static_cast<GLuint>(pass.cornerLocation);
+    gl.enableVertexAttribArray(corner);
+    gl.vertexAttribBuffer(corner, pass.quadVbo, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    if (gl.hasInstancing()) {
+        // Per vertex, in case an instanced pass used this index
+        gl.vertexAttribDivisor(corner, 0);
+    }
+
+    gl.drawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+// ============================================================================
+// FAN OR QUAD
+// ============================================================================
+
+CircleLoad fanLoad(int segments, float radius) {
+    // The polygon's area: `segments` triangles of two radii and an angle
+    float angle = 6.2831853f / segments;
+    return {segments + 2, 0.5f * segments * radius * radius * std::sin(angle)};
+}
+
+CircleLoad sdfLoad(float radius) {
+    float side = 2.0f * (radius + 1.0f);
+    return {4, side * side};
+}
+
+} // namespace gl
@@ -0,0 +1,117 @@
+/**
+ * gl/sdf_circle.h: A circle drawn as one quad, its edge computed per pixel
+ *
+ * The original circle is a triangle fan: a center and 65 points on the
+ * rim, 66 vertices. Its edge is a polygon, and every pixel is either in
+ * or out, so the rim shows stair steps (aliasing). More segments make the
+ * polygon rounder but not smoother, and cost more vertices.
+ *
+ * SIGNED DISTANCE: a circle is fully described by its center and radius.
+ * For any pixel, `distance to center - radius` says how far outside the
+ * edge it is (negative = inside). So draw just a square around the circle
+ * (4 vertices, a triangle strip) and let the fragment shader decide for
+ * each pixel:
+ *
+ *     +---------+   per pixel: d = length(pixel - center)
+ *     |  .---.  |     d < r - 0.5   fully inside   (coverage 1)
+ *     | /     \ |     d > r + 0.5   fully outside  (coverage 0)
+ *     | \     / |     in between    partly covered: 0-1, a 1 pixel ramp
+ *     |  '---'  |
+ *     +---------+
+ *
+ * The ramp is the anti-aliasing: the edge pixels get the fraction of the
+ * pixel the circle covers (approximately: a box filter across the edge),
+ * blended over the background with premultiplied alpha. Distances are in
+ * pixels, so the ramp is exactly one pixel wide at any size without
+ * fwidth() (which GLES 2 only has with OES_standard_derivatives).
+ *
+ * SHAPES for free, from the same distance:
+ * - filled:  coverage of the disc
+ * - stroke:  an outline `strokeWidth` pixels wide, inside the edge
+ *            (coverage of |d - middle of the band| < strokeWidth / 2)
+ * - rings:   the stroke repeated inwards every `ringSpacing` pixels
+ *            (the distance taken modulo the spacing)
+ *
+ * THE TRADE: 4 vertices instead of 66, but the shader runs on the whole
+ * square, (2r + 2)^2 pixels instead of the ~pi r^2 the fan covers (27%
+ * more), and does a square root per pixel plus blending. Small circles
+ * are vertex/setup bound and big ones fill bound, and where the line
+ * falls depends on the GPU: circleLoad() counts both sides, and the
+ * renderer can time them on the device and keep the cheaper one.
+ *
+ * Lookup: "signed distance field circle shader", "analytic anti-aliasing",
+ *         "premultiplied alpha blending", "fill rate vs vertex throughput"
+ */
+
+#ifndef PHASE4_GL_SDF_CIRCLE_H
+#define PHASE4_GL_SDF_CIRCLE_H
+
+#include "gl_state.h"
+
+namespace gl {
+
+enum CircleShape {
+    kCircleFilled,
+    kCircleStroke,
+    kCircleRings,
+};
+
+struct SdfCircleStyle {
+    CircleShape shape = kCircleFilled;
+    float strokeWidth = 0.0f;  // Pixels (stroke and rings)
+    float ringSpacing = 0.0f;  // Pixels from one ring to the next (rings)
+};
+
+// GLSL ES 1.00
+extern const char* const kSdfCircleVertexShader;
+extern const char* const kSdfCircleFragmentShader;
+
+// The fragment shader's coverage, on the CPU: how much of a pixel whose
+// center is `distance` pixels from the circle's center is drawn (0-1)
+float sdfCoverage(const SdfCircleStyle& style, float radius, float distance);
+
+// Locations and the quad, looked up / created once after linking
+struct SdfCirclePass {
+    GLuint program = 0;
+    GLuint quadVbo = 0;           // 4 corners, -1..1, as a triangle strip
+    GLint cornerLocation = -1;    // attribute vec2 aCorner
+    GLint centerLocation = -1;    // uniform vec2 uCenter (pixels)
+    GLint radiusLocation = -1;    // uniform float uRadius (pixels)
+    GLint viewportLocation = -1;  // uniform vec2 uViewport (pixels)
+    GLint strokeLocation = -1;    // uniform vec2 uStroke: width, ring spacing
+    GLint colorLocation = -1;     // uniform vec4 uColor
+};
+
+// Fill in `pass` for a linked program built from the shaders above
+// (registerProgram() it first) and upload the quad. Returns false if the
+// program lacks aCorner.
+bool prepareSdfCirclePass(GlStateCache& gl, GLuint program, SdfCirclePass* pass);
+
+// Delete the quad (the program belongs to the caller)
+void releaseSdfCirclePass(GlStateCache& gl, SdfCirclePass* pass);
+
+// Draw one circle, center and radius in pixels of a width x height
+// viewport (origin bottom left, as GL's), `color` RGBA 0-1 (straight
+// alpha). Turns blending on.
+void drawSdfCircle(GlStateCache& gl, const SdfCirclePass& pass, float centerX, float centerY,
+                   float radius, const SdfCircleStyle& style, const float* color, int width,
+                   int height);
+
+// ============================================================================
+// FAN OR QUAD
+// ============================================================================
+
+// What one circle asks of the GPU
+struct CircleLoad {
+    int vertices;     // Vertex shader runs
+    float fragments;  // Fragment shader runs (pixels covered by the geometry)
+};
+
+// A `segments`-sided fan (the original circle) or the SDF quad, for a
+// circle of `radius` pixels
+CircleLoad fanLoad(int segments, float radius);
+CircleLoad sdfLoad(float radius);
+
+} // namespace gl
+
+#endif // PHASE4_GL_SDF_CIRCLE_H
@@ -0,0 +1,182 @@
+/**
+ * gl/stream_ring.cpp: StreamRing
+ */
+
+#include "stream_ring.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace gl {
+
+namespace {
+
+// A fence that hasn't signalled after a second means a hung GPU: give up
+// waiting (the frame is garbage either way)
+const GLuint64 kFenceTimeoutNanos = 1000000000ull;
+
+uint64_t alignUp(uint64_t position, GLsizeiptr alignment) {
+    uint64_t mask = static_cast<uint64_t>(alignment) - 1;
+    return (position + mask) & ~mask;
+}
+
+} // namespace
+
+void StreamRing::init(GlStateCache& gl, GLenum target, GLsizeiptr capacity) {
+    m_target = target;
+    // A multiple of the largest alignment, so aligned positions stay
+    // aligned in the buffer after a wrap
+    m_capacity = static_cast<GLsizeiptr>(alignUp(capacity, kMaxAlignment));
+    m_mapping = gl.hasBufferMapping();
+    m_mapped = false;
+    m_stats = StreamStats();
+    m_head = 0;
+    m_tail = 0;
+    m_fencedHead = 0;
+    m_lap = 0;
+    m_firstFence = 0;
+    m_fenceCount = 0;
+    m_staging.assign(m_mapping ? 0 : m_capacity, 0);
+
+    m_buffer = gl.genBuffer();
+    gl.bindBuffer(m_target, m_buffer);
+    gl.bufferData(m_target, m_capacity, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamRing::release(GlStateCache& gl) {
+    while (m_fenceCount > 0) {
+        gl.deleteSync(m_fences[m_firstFence].sync);
+        m_firstFence = (m_firstFence + 1) % kMaxFences;
+        m_fenceCount--;
+    }
+    if (m_buffer != 0) {
+        gl.deleteBuffer(m_buffer);
+        m_buffer = 0;
+    }
+}
+
+StreamRing::Allocation StreamRing::allocate(GlStateCache& gl, GLsizeiptr size,
+                                            GLsizeiptr alignment) {
+    Allocation allocation;
+    if (size <= 0 || size > m_capacity || m_mapped) {
+        return allocation;
+    }
+
+    // Next aligned position; past the end of the lap, the start of the next
+    uint64_t capacity = static_cast<uint64_t>(m_capacity);
+    uint64_t start = alignUp(m_head, alignment);
+    if (start % capacity + size > capacity) {
+        start = (start / capacity + 1) * capacity;
+    }
+    uint64_t end = start + size;
+    bool wrapped = start / capacity != m_lap;
+    m_lap = start / capacity;
+
+    gl.bindBuffer(m_target, m_buffer);
+
+    if (m_mapping) {
+        // The bytes one lap back from [start, end) must be out of the GPU's
+        // hands: everything before m_tail is. (If nothing is in flight,
+        // m_tail == m_head and nothing overlaps.)
+        while (m_tail < m_head && end - m_tail > capacity) {
+            if (m_fenceCount == 0) {
+                // This frame alone goes round the ring: fence its draws so far
+                insertFence(gl);
+            }
+            retireOldest(gl);
+        }
+    } else if (wrapped) {
+        // New storage for the same buffer name; queued draws keep the old
+        gl.bufferData(m_target, m_capacity, nullptr, GL_STREAM_DRAW);
+        m_stats.orphans++;
+    }
+    if (wrapped) {
+        m_stats.wraps++;
+    }
+    m_head = end;
+
+    allocation.offset = static_cast<GLintptr>(start % capacity);
+    allocation.size = size;
+    if (m_mapping) {
+        // No sync (the fences did that), and the old contents can go
+        const GLbitfield access =
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        allocation.data = gl.mapBufferRange(m_target, allocation.offset, size, access);
+        m_mapped = allocation.data != nullptr;
+    } else {
+        allocation.data = m_staging.data() + allocation.offset;
+    }
+    if (allocation.data) {
+        m_stats.allocations++;
+        m_stats.bytes += size;
+    }
+    return allocation;
+}
+
+void StreamRing::commit(GlStateCache& gl, const Allocation& allocation) {
+    if (!allocation.data) {
+        return;
+    }
+    gl.bindBuffer(m_target, m_buffer);
+    if (m_mapping) {
+        // GL_FALSE: the storage was lost (display mode change...); the
+        // frame draws garbage once, nothing worse
+        gl.unmapBuffer(m_target);
+        m_mapped = false;
+    } else {
+        gl.bufferSubData(m_target, allocation.offset, allocation.size, allocation.data);
+    }
+}
+
+GLintptr StreamRing::upload(GlStateCache& gl, const void* data, GLsizeiptr size,
+                            GLsizeiptr alignment) {
+    Allocation allocation = allocate(gl, size, alignment);
+    if (!allocation.data) {
+        return -1;
+    }
+    memcpy(allocation.data, data, size);
+    commit(gl, allocation);
+    return allocation.offset;
+}
+
+void StreamRing::endFrame(GlStateCache& gl) {
+    if (!m_mapping || m_head == m_fencedHead) {
+        return;
+    }
+    if (m_fenceCount == kMaxFences) {
+        retireOldest(gl);
+    }
+    insertFence(gl);
+}
+
+void StreamRing::insertFence(GlStateCache& gl) {
+    int index = (m_firstFence + m_fenceCount) % kMaxFences;
+    m_fences[index] = {gl.fenceSync(), m_head};
+    m_fenceCount++;
+    m_fencedHead = m_head;
+    m_stats.fences++;
+}
+
+void StreamRing::retireOldest(GlStateCache& gl) {
+    Fence& fence = m_fences[m_firstFence];
+
+    // Usually long signalled: a zero-timeout check doesn't block
+    GLenum status = gl.clientWaitSync(fence.sync, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        // Flush, or the fence may never reach the GPU to signal
+        gl.clientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNanos);
+        m_stats.fenceWaits++;
+        m_stats.fenceWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          Clock::now() - start)
+                                          .count();
+    }
+
+    gl.deleteSync(fence.sync);
+    m_tail = fence.end;
+    m_firstFence = (m_firstFence + 1) % kMaxFences;
+    m_fenceCount--;
+}
+
+} // namespace gl
@@ -0,0 +1,142 @@
+/**
+ * gl/stream_ring.h: Per-frame vertex and index data without GPU stalls
+ *
+ * The circle's vertices are uploaded once (GL_STATIC_DRAW). Content that
+ * changes every frame (a trail, text, UI quads) has to be uploaded every
+ * frame, and the obvious way, glBufferSubData() into the same buffer,
+ * can stall: the GPU runs a frame or two behind the CPU, so the draw that
+ * reads last frame's data may not have run yet. The driver then either
+ * waits for it (a pipeline stall) or copies the buffer behind our back.
+ *
+ * A RING BUFFER avoids touching data in flight: one big buffer, and each
+ * upload takes the next free bytes after the previous one. By the time
+ * the writes come round to the start again, the GPU is long done with
+ * what was there... unless it isn't, which is what the two ways of
+ * reaching the start again differ in:
+ *
+ * GLES 2, ORPHANING: at the end of the buffer, glBufferData(NULL) gives
+ * the buffer name fresh storage. Draws already queued keep reading the
+ * old storage, which the driver frees once they're done; uploads go on
+ * with glBufferSubData() into the new one. The driver does the tracking.
+ *
+ * GLES 3, UNSYNCHRONIZED MAPPING + FENCES: glMapBufferRange() with
+ * GL_MAP_UNSYNCHRONIZED_BIT hands back a pointer into the buffer without
+ * the driver checking anything, so it's on us not to write where a
+ * pending draw reads. After each frame's draws a fence (glFenceSync)
+ * marks how far the ring had been written; a region is reused only once
+ * the fence after it has signalled. Normally it has long since; if the
+ * ring is too small for the frames in flight, we wait on the fence
+ * (glClientWaitSync) and count it.
+ *
+ *     ring:  [ frame N-2 | frame N-1 | frame N ->      free      ]
+ *              fence A     fence B     (fenced at endFrame())
+ *     wrap:  reuse frame N-2's bytes once fence A has signalled
+ *
+ * An allocation never straddles the end: if it doesn't fit, the rest of
+ * the lap is skipped (a "wrap").
+ *
+ * USE (one ring per target; a mapping must be committed before the next
+ * allocate()):
+ *
+ *     StreamRing::Allocation a = ring.allocate(gl, bytes);
+ *     memcpy(a.data, vertices, bytes);
+ *     ring.commit(gl, a);
+ *     gl.vertexAttribBuffer(i, ring.buffer(), ..., (const void*)a.offset);
+ *     ...draw...
+ *     ring.endFrame(gl);  // after the frame's last draw reading the ring
+ *
+ * Lookup: "buffer orphaning", "GL_MAP_UNSYNCHRONIZED_BIT ring buffer",
+ *         "glFenceSync glClientWaitSync", "streaming vertex data OpenGL ES"
+ */
+
+#ifndef PHASE4_GL_STREAM_RING_H
+#define PHASE4_GL_STREAM_RING_H
+
+#include "gl_state.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gl {
+
+struct StreamStats {
+    uint64_t bytes = 0;           // Bytes uploaded
+    uint32_t allocations = 0;
+    uint32_t wraps = 0;           // Times the writes went back to the start
+    uint32_t orphans = 0;         // glBufferData(NULL) calls (GLES 2 path)
+    uint32_t fences = 0;          // Fences inserted (GLES 3 path)
+    uint32_t fenceWaits = 0;      // Times a fence hadn't signalled and we blocked
+    uint64_t fenceWaitNanos = 0;  // Time spent blocked
+};
+
+class StreamRing {
+public:
+    static constexpr int kMaxFences = 8;  // Frames in flight before endFrame() blocks
+    static constexpr GLsizeiptr kMaxAlignment = 16;
+
+    struct Allocation {
+        void* data = nullptr;  // Write `size` bytes here, then commit()
+        GLintptr offset = 0;   // ...where they'll be in buffer()
+        GLsizeiptr size = 0;
+    };
+
+    // Create the buffer for `target` (GL_ARRAY_BUFFER or
+    // GL_ELEMENT_ARRAY_BUFFER): mapped + fenced if the context has
+    // buffer mapping (gl.hasBufferMapping()), orphaned otherwise
+    void init(GlStateCache& gl, GLenum target, GLsizeiptr capacity);
+
+    // Delete the buffer and any fences
+    void release(GlStateCache& gl);
+
+    // `size` bytes at an `alignment` (power of two, at most kMaxAlignment)
+    // offset, bound to the target. data is null if size is more than the
+    // capacity or the map failed.
+    Allocation allocate(GlStateCache& gl, GLsizeiptr size, GLsizeiptr alignment = 4);
+    // Send the written bytes to GL (unmap, or glBufferSubData)
+    void commit(GlStateCache& gl, const Allocation& allocation);
+    // allocate() + copy + commit(); returns the offset, or -1
+    GLintptr upload(GlStateCache& gl, const void* data, GLsizeiptr size,
+                    GLsizeiptr alignment = 4);
+
+    // Fence this frame's uploads (GLES 3 path; nothing on GLES 2)
+    void endFrame(GlStateCache& gl);
+
+    bool mapping() const { return m_mapping; }
+    GLuint buffer() const { return m_buffer; }
+    GLsizeiptr capacity() const { return m_capacity; }
+    const StreamStats& stats() const { return m_stats; }
+
+private:
+    struct Fence {
+        GLsync sync;
+        uint64_t end;  // m_head when it was inserted
+    };
+
+    void insertFence(GlStateCache& gl);
+    // Wait for the oldest fence (if it hasn't signalled) and free what it covers
+    void retireOldest(GlStateCache& gl);
+
+    GLenum m_target = GL_ARRAY_BUFFER;
+    GLuint m_buffer = 0;
+    GLsizeiptr m_capacity = 0;
+    bool m_mapping = false;
+    bool m_mapped = false;  // Between allocate() and commit() (GLES 3 path)
+    StreamStats m_stats;
+
+    // Positions count bytes since init(), laps included: the offset in the
+    // buffer is position % capacity
+    uint64_t m_head = 0;        // End of the last allocation
+    uint64_t m_tail = 0;        // The GPU is done with everything before this
+    uint64_t m_fencedHead = 0;  // m_head at the last fence
+    uint64_t m_lap = 0;         // m_head / capacity, as of the last allocation
+
+    Fence m_fences[kMaxFences];  // Oldest first, from m_firstFence
+    int m_firstFence = 0;
+    int m_fenceCount = 0;
+
+    std::vector<uint8_t> m_staging;  // GLES 2 path: written here, then glBufferSubData
+};
+
+} // namespace gl
+
+#endif // PHASE4_GL_STREAM_RING_H
@@ -11,16 +11,42 @@
 // 4. GPU Parallelism: Thousands of fragments processed simultaneously
 
 #include <jni.h>
-#include <android/log.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <string>
 
-// Logging macros for debugging
+// Logging macros for debugging (shared with Phase 3, see native-common/)
+// LOGD/LOGV compile to nothing in release builds
 #define LOG_TAG "Phase4-OpenGL"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "common/log.h"
+#include "common/timeline.h"
+#include "common/trace.h"
+#include "gl/circle_pass.h"
+#include "gl/gl_state.h"
+#include "gl/instanced_circles.h"
+#include "gl/program_cache.h"
+#include "gl/sdf_circle.h"
+#include "gl/stream_ring.h"
+
+// Per-frame trace events: recorded as numbers on the GL thread, formatted
+// into logcat only when the view pauses (see common/trace.h)
+enum TraceEvent {
+    kTraceFrame,    // frame number, surface width, height, animation steps
+    kTraceGlCalls,  // frame number, GL calls issued, skipped by the state cache, draws
+    kTraceEventCount
+};
+
+static const trace::EventInfo kTraceEvents[kTraceEventCount] = {
+    {"frame", "#%d %dx%d, %d steps"},
+    {"gl", "#%d %d calls issued, %d skipped, %d draws"},
+};
+
+static trace::TraceRing g_trace(kTraceEvents, kTraceEventCount);
+static int g_frameNumber = 0;
 
 // ============================================================================
 // SHADERS: Programs that run on the GPU
@@ -65,27 +91,105 @@ const char* fragmentShaderSource = R"(
 // OpenGL State
 // ============================================================================
 
+// Every per-frame GL call goes through this: it remembers the state GL
+// is in and drops calls that wouldn't change it (see gl/gl_state.h)
+static gl::GlStateCache g_gl(gl::systemGl());
+
 // Shader program handle
 static GLuint g_shaderProgram = 0;
 
-// Shader uniform locations (handles to pass data to shaders)
-static GLint g_mvpMatrixLocation = -1;
-static GLint g_colorLocation = -1;
-
 // Vertex buffer object (GPU memory holding circle vertices)
 static GLuint g_vbo = 0;
 
+// Program, buffer and shader variable locations for the circle draw
+// (looked up once, right after linking)
+static gl::CirclePass g_circlePass;
+static const float g_circleColor[4] = {1.0f, 0.5f, 0.0f, 1.0f};  // Orange
+
+// The same circle as one quad with a per-pixel, anti-aliased edge
+// (see gl/sdf_circle.h)
+static GLuint g_sdfProgram = 0;
+static gl::SdfCirclePass g_sdfPass;
+
+// Which of the two draws the circle. Set from the launch intent:
+//     adb shell am start -n com.graphics.phase4/.MainActivity --es circle <mode>
+// fan (default), sdf, stroke, rings, or auto: time both on this device
+// once the surface size is known and keep the cheaper one.
+enum CircleMode {
+    kCircleModeFan,
+    kCircleModeSdf,
+    kCircleModeAuto,
+};
+static CircleMode g_circleMode = kCircleModeFan;
+static gl::SdfCircleStyle g_sdfStyle;
+static bool g_useSdf = false;            // The pipeline in use now
+static bool g_circleModeChosen = true;   // False until auto mode has timed both
+
+// Stress scene: this many circles instead of the one above, animated by
+// the GPU and drawn with one instanced draw call (see
+// gl/instanced_circles.h). 0 = normal scene. Set from the launch intent:
+//     adb shell am start -n com.graphics.phase4/.MainActivity --ei circles 100000
+static int g_stressCircles = 0;
+static GLuint g_instancedProgram = 0;
+static gl::InstancedCircles g_instancedCircles;
+
+// Stress report, averaged and logged every 2 seconds
+struct StressStats {
+    int64_t windowStartNanos = 0;  // 0 = not started
+    int frames = 0;
+    int64_t cpuNanos = 0;          // Time spent in nativeOnDrawFrame
+};
+static StressStats g_stressStats;
+
+// Trail: a ribbon through the circle's last positions, narrowing towards
+// the oldest, drawn semi-transparent under the circle. Its vertices and
+// indices change every frame, so they're streamed through two ring
+// buffers (see gl/stream_ring.h). Set from the launch intent:
+//     adb shell am start -n com.graphics.phase4/.MainActivity --ez trail true
+static bool g_trail = false;
+static const int g_trailLength = 48;  // Positions kept (one per frame)
+struct TrailPoint {
+    float x;                          // Normalized, as g_circleX/Y
+    float y;
+};
+static TrailPoint g_trailPoints[g_trailLength];  // Ring, oldest at g_trailNext once full
+static int g_trailCount = 0;
+static int g_trailNext = 0;
+static gl::StreamRing g_vertexRing;
+static gl::StreamRing g_indexRing;
+static const float g_trailColor[4] = {0.35f, 0.175f, 0.0f, 0.35f};  // Orange, 35%, premultiplied
+static int64_t g_streamReportNanos = 0;   // Last stream stats log (0 = none yet)
+
+// Linked programs saved in the app's cache directory and loaded on the
+// next start instead of compiled (see gl/program_cache.h). On unless:
+//     adb shell am start -n com.graphics.phase4/.MainActivity --ez programCache false
+static gl::ProgramCache g_programCache;
+static std::string g_programCacheDir;  // Empty = off
+
+// Time to first frame: onSurfaceCreated until the first onDrawFrame
+// returns (0 = reported)
+static int64_t g_surfaceCreatedNanos = 0;
+
 // Screen dimensions
 static int g_width = 0;
 static int g_height = 0;
 
-// Circle animation state
-static float g_circleX = 0.5f;  // Normalized coordinates (0-1)
-static float g_circleY = 0.5f;
-static float g_velocityX = 0.01f;
-static float g_velocityY = 0.015f;
+// Circle animation state, advanced in fixed steps (see updateAnimation())
+struct CircleState {
+    float x = 0.5f;           // Normalized coordinates (0-1)
+    float y = 0.5f;
+    float velocityX = 0.6f;   // Normalized units per second
+    float velocityY = 0.9f;   // (0.01 and 0.015 per frame at 60 Hz)
+};
+static CircleState g_circle;          // After the latest step
+static CircleState g_previousCircle;  // One step earlier
+static timeline::Timeline g_timeline; // 120 Hz steps on CLOCK_MONOTONIC
 static const float g_circleRadius = 0.1f;  // Normalized radius
 
+// Where this frame draws the circle: between the last two steps
+static float g_circleX = 0.5f;
+static float g_circleY = 0.5f;
+
 // ============================================================================
 // HELPER FUNCTIONS
 // ============================================================================
@@ -153,6 +257,13 @@ static GLuint createProgram(const char* vertexSource, const char* fragmentSource
     // Attach shaders and link them together
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+
+    // The program cache saves what it links: on GLES 3, ask the driver to
+    // keep the binary, which some only do when asked before linking
+    const gl::GlDispatch& dispatch = gl::systemGl();
+    if (g_programCache.enabled() && dispatch.programParameteri != nullptr) {
+        dispatch.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(program);
 
     // Check link status
@@ -259,20 +370,78 @@ static void multiplyMatrix(float* result, const float* a, const float* b) {
 // RENDERING
 // ============================================================================
 
+// A linked program for these sources: from the program cache if it has
+// a binary for this driver, else compiled by createProgram() (and saved)
+static GLuint buildProgram(const char* vertexSource, const char* fragmentSource) {
+    return g_programCache.getProgram(gl::systemGl(), vertexSource, fragmentSource,
+                                     createProgram);
+}
+
+// Build the stress scene's program and buffers
+static bool initStressScene() {
+    // glDrawArraysInstanced for this context, or one draw per circle
+    const char* instancing = gl::loadInstancing();
+    LOGI("Stress scene: %d circles, instancing: %s", g_stressCircles,
+         instancing ? instancing : "not available (one draw call per circle)");
+
+    g_instancedProgram = buildProgram(gl::kInstancedCircleVertexShader,
+                                      gl::kInstancedCircleFragmentShader);
+    if (g_instancedProgram == 0) {
+        LOGE("Failed to create instanced circle program");
+        return false;
+    }
+    g_gl.registerProgram(g_instancedProgram);
+
+    // Same seed every launch: runs are comparable
+    if (!g_instancedCircles.init(g_gl, g_instancedProgram,
+                                 gl::randomCircles(g_stressCircles, 1))) {
+        LOGE("Instanced circle program is missing an attribute");
+        return false;
+    }
+    g_stressStats = StressStats();
+    return true;
+}
+
+// Create the trail's ring buffers
+static void initTrail() {
+    // glMapBufferRange + fences for this context, or orphaning
+    const char* mapping = gl::loadBufferMapping();
+    LOGI("Trail: streaming through %s%s", mapping ? "mapped ring buffers with fences, " : "",
+         mapping ? mapping : "orphaned buffers (no buffer mapping)");
+
+    // ~1.3 KB a frame: 64 + 16 KB go round every ~60 frames, with room
+    // for many more frames in flight than a GPU keeps
+    g_vertexRing.init(g_gl, GL_ARRAY_BUFFER, 64 * 1024);
+    g_indexRing.init(g_gl, GL_ELEMENT_ARRAY_BUFFER, 16 * 1024);
+    g_trailCount = 0;
+    g_trailNext = 0;
+    g_streamReportNanos = 0;
+}
+
 // Initialize OpenGL resources
 static bool initGL() {
     LOGI("Initializing OpenGL ES");
 
+    // Saved binaries are only good for this GPU and driver build: both
+    // go into the key
+    const char* binaries = gl::loadProgramBinary();
+    g_programCache.init(g_programCacheDir.c_str(),
+                        reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                        reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    LOGI("Program cache: %s, program binaries: %s",
+         g_programCache.enabled() ? g_programCacheDir.c_str() : "off",
+         binaries ? binaries : "not supported (every program compiles)");
+
     // Create shader program
-    g_shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    g_shaderProgram = buildProgram(vertexShaderSource, fragmentShaderSource);
     if (g_shaderProgram == 0) {
         LOGE("Failed to create shader program");
         return false;
     }
 
-    // Get uniform locations (how we pass data to shaders)
-    g_mvpMatrixLocation = glGetUniformLocation(g_shaderProgram, "uMVPMatrix");
-    g_colorLocation = glGetUniformLocation(g_shaderProgram, "uColor");
+    // Read the program's attribute and uniform locations once, instead of
+    // asking GL by name every frame
+    g_gl.registerProgram(g_shaderProgram);
 
     // Generate circle vertices
     const int segmentCount = 64;  // More segments = smoother circle
@@ -281,15 +450,42 @@ static bool initGL() {
     generateCircleVertices(vertices, segmentCount, 1.0f);  // Unit circle (we'll scale with matrix)
 
     // Create Vertex Buffer Object (VBO) - GPU memory for vertices
+    // (bound through the cache, so it knows the buffer is bound)
     glGenBuffers(1, &g_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+    g_gl.bindBuffer(GL_ARRAY_BUFFER, g_vbo);
 
     // Upload vertices to GPU memory
     // GL_STATIC_DRAW tells GPU this data won't change often
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
+    if (!gl::prepareCirclePass(g_gl, g_shaderProgram, g_vbo, vertexCount, &g_circlePass)) {
+        LOGE("Shader program has no aPosition attribute");
+        return false;
+    }
+
     // Set clear color (background)
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);  // Dark gray
+    g_gl.clearColor(0.1f, 0.1f, 0.1f, 1.0f);  // Dark gray
+
+    // Circle as a quad + signed distance (cheap to build: always ready, so
+    // the mode can switch without relinking)
+    g_sdfProgram = buildProgram(gl::kSdfCircleVertexShader, gl::kSdfCircleFragmentShader);
+    if (g_sdfProgram == 0) {
+        LOGE("Failed to create SDF circle program");
+        return false;
+    }
+    g_gl.registerProgram(g_sdfProgram);
+    if (!gl::prepareSdfCirclePass(g_gl, g_sdfProgram, &g_sdfPass)) {
+        LOGE("SDF circle program has no aCorner attribute");
+        return false;
+    }
+
+    if (g_stressCircles > 0 && !initStressScene()) {
+        return false;
+    }
+
+    if (g_trail) {
+        initTrail();
+    }
 
     LOGI("OpenGL ES initialized successfully");
     return true;
@@ -298,30 +494,33 @@ static bool initGL() {
 // Clean up OpenGL resources
 static void cleanupGL() {
     if (g_vbo != 0) {
-        glDeleteBuffers(1, &g_vbo);
+        g_gl.deleteBuffer(g_vbo);
         g_vbo = 0;
     }
 
     if (g_shaderProgram != 0) {
-        glDeleteProgram(g_shaderProgram);
+        g_gl.deleteProgram(g_shaderProgram);
         g_shaderProgram = 0;
     }
-}
 
-// Render one frame
-static void renderFrame() {
-    // Clear the screen
-    glClear(GL_COLOR_BUFFER_BIT);
+    gl::releaseSdfCirclePass(g_gl, &g_sdfPass);
+    if (g_sdfProgram != 0) {
+        g_gl.deleteProgram(g_sdfProgram);
+        g_sdfProgram = 0;
+    }
 
-    // Use our shader program
-    glUseProgram(g_shaderProgram);
+    g_vertexRing.release(g_gl);
+    g_indexRing.release(g_gl);
 
-    // Create matrices for transformations
-    float projectionMatrix[16];
-    float modelMatrix[16];
-    float mvpMatrix[16];
+    g_instancedCircles.release(g_gl);
+    if (g_instancedProgram != 0) {
+        g_gl.deleteProgram(g_instancedProgram);
+        g_instancedProgram = 0;
+    }
+}
 
-    // Projection: map normalized coords to screen
+// Projection: map normalized coords to screen. Returns the aspect ratio.
+static float createSceneProjection(float* projectionMatrix) {
     // Use aspect ratio to maintain circle shape
     float aspect = static_cast<float>(g_width) / static_cast<float>(g_height);
     if (aspect >= 1.0f) {
@@ -329,6 +528,17 @@ static void renderFrame() {
     } else {
         createOrthoMatrix(projectionMatrix, -1.0f, 1.0f, -1.0f / aspect, 1.0f / aspect);
     }
+    return aspect;
+}
+
+// Draw the scene's circle (no clear), with the fan or the SDF quad
+static void drawSceneCircle(bool sdf) {
+    // Create matrices for transformations
+    float projectionMatrix[16];
+    float modelMatrix[16];
+    float mvpMatrix[16];
+
+    float aspect = createSceneProjection(projectionMatrix);
 
     // Model: position and scale the circle
     float circleX = (g_circleX * 2.0f - 1.0f) * aspect;  // Convert 0-1 to screen coords
@@ -342,48 +552,295 @@ static void renderFrame() {
     // Combine: MVP = Projection * Model
     multiplyMatrix(mvpMatrix, projectionMatrix, modelMatrix);
 
-    // Pass MVP matrix to shader
-    glUniformMatrix4fv(g_mvpMatrixLocation, 1, GL_FALSE, mvpMatrix);
+    if (!sdf) {
+        // Program, buffer, attribute setup and color are unchanged from
+        // the last frame: only the matrix and the draw reach GL
+        gl::drawCircle(g_gl, g_circlePass, mvpMatrix, g_circleColor);
+        return;
+    }
 
-    // Pass color to shader (orange)
-    glUniform4f(g_colorLocation, 1.0f, 0.5f, 0.0f, 1.0f);
+    // The SDF circle works in pixels: the fan's center, and a true circle
+    // with the smaller of the fan's two pixel radii (the fan is scaled
+    // per axis, so it isn't quite round on a non-square surface)
+    float centerX = (mvpMatrix[12] + 1.0f) * 0.5f * g_width;
+    float centerY = (mvpMatrix[13] + 1.0f) * 0.5f * g_height;
+    float radius = std::min(std::fabs(mvpMatrix[0]) * 0.5f * g_width,
+                            std::fabs(mvpMatrix[5]) * 0.5f * g_height);
+    gl::drawSdfCircle(g_gl, g_sdfPass, centerX, centerY, radius, g_sdfStyle, g_circleColor,
+                      g_width, g_height);
+}
 
-    // Bind vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+// Add this frame's circle position and draw the trail through the last
+// g_trailLength of them
+static void drawTrail() {
+    g_trailPoints[g_trailNext] = {g_circleX, g_circleY};
+    g_trailNext = (g_trailNext + 1) % g_trailLength;
+    g_trailCount = std::min(g_trailCount + 1, g_trailLength);
+    if (g_trailCount < 2) {
+        return;
+    }
 
-    // Enable vertex attribute array
-    GLint positionLocation = glGetAttribLocation(g_shaderProgram, "aPosition");
-    glEnableVertexAttribArray(positionLocation);
+    float projectionMatrix[16];
+    float aspect = createSceneProjection(projectionMatrix);
+
+    // Two vertices per position, either side of the path, half a width
+    // apart: a full circle radius at the newest, nothing at the oldest
+    //
+    //     0---2---4 ...      triangles (0 1 2) (1 3 2), (2 3 4) (3 5 4)...
+    //     | \ | \ |
+    //     1---3---5 ...
+    const int count = g_trailCount;
+    const int first = (g_trailNext - count + g_trailLength) % g_trailLength;
+    float vertices[g_trailLength * 4];
+    uint16_t indices[(g_trailLength - 1) * 6];
+    auto at = [first](int n) -> const TrailPoint& {  // n-th oldest
+        return g_trailPoints[(first + n) % g_trailLength];
+    };
+    float normalX = 0.0f;
+    float normalY = 1.0f;
+    for (int i = 0; i < count; i++) {
+        const TrailPoint& p = at(i);
+        const TrailPoint& previous = at(std::max(i - 1, 0));
+        const TrailPoint& next = at(std::min(i + 1, count - 1));
+
+        // Screen coords as drawSceneCircle() places the circle
+        float x = (p.x * 2.0f - 1.0f) * aspect;
+        float y = p.y * 2.0f - 1.0f;
+        float dx = (next.x - previous.x) * 2.0f * aspect;
+        float dy = (next.y - previous.y) * 2.0f;
+        float length = std::sqrt(dx * dx + dy * dy);
+        if (length > 1e-6f) {
+            // Perpendicular to the direction of travel (else: keep the last)
+            normalX = -dy / length;
+            normalY = dx / length;
+        }
+        float halfWidth = g_circleRadius * static_cast<float>(i + 1) / count;
+        vertices[i * 4 + 0] = x + normalX * halfWidth;
+        vertices[i * 4 + 1] = y + normalY * halfWidth;
+        vertices[i * 4 + 2] = x - normalX * halfWidth;
+        vertices[i * 4 + 3] = y - normalY * halfWidth;
+    }
+    const int indexCount = (count - 1) * 6;
+    for (int i = 0; i < count - 1; i++) {
+        uint16_t v = static_cast<uint16_t>(i * 2);
+        const uint16_t quad[6] = {v, static_cast<uint16_t>(v + 1), static_cast<uint16_t>(v + 2),
+                                  static_cast<uint16_t>(v + 1), static_cast<uint16_t>(v + 3),
+                                  static_cast<uint16_t>(v + 2)};
+        memcpy(&indices[i * 6], quad, sizeof(quad));
+    }
 
-    // Specify vertex attribute format
-    // 2 components (x, y), float type, not normalized, tightly packed
-    glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    // Into bytes of the rings the GPU is done with: no stall, no copy
+    GLintptr vertexOffset = g_vertexRing.upload(g_gl, vertices, count * 4 * sizeof(float));
+    GLintptr indexOffset = g_indexRing.upload(g_gl, indices, indexCount * sizeof(uint16_t), 2);
+    if (vertexOffset < 0 || indexOffset < 0) {
+        return;
+    }
+
+    gl::GlStateCache& gl = g_gl;
+    gl.enable(GL_BLEND);
+    gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gl.useProgram(g_circlePass.program);
+    gl.uniformMatrix4fv(g_circlePass.mvpLocation, projectionMatrix);
+    gl.uniform4f(g_circlePass.colorLocation, g_trailColor[0], g_trailColor[1], g_trailColor[2],
+                 g_trailColor[3]);
+
+    // The attribute reads from this frame's offset in the ring; indices
+    // count from there
+    GLuint position = static_cast<GLuint>(g_circlePass.positionLocation);
+    gl.enableVertexAttribArray(position);
+    gl.vertexAttribBuffer(position, g_vertexRing.buffer(), 2, GL_FLOAT, GL_FALSE, 0,
+                          reinterpret_cast<const void*>(vertexOffset));
+    if (gl.hasInstancing()) {
+        gl.vertexAttribDivisor(position, 0);
+    }
+    gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_indexRing.buffer());
+    gl.drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, indexOffset);
+}
 
-    // Draw the circle
-    // GL_TRIANGLE_FAN: first vertex is center, subsequent vertices form triangles
-    const int vertexCount = 64 + 2;
-    glDrawArrays(GL_TRIANGLE_FAN, 0, vertexCount);
+// Milliseconds for the GPU to finish `draws` circles with one pipeline
+// (glFinish() waits for it: only acceptable in a one-off measurement)
+static double timeCircleDraws(bool sdf, int draws) {
+    g_gl.clear(GL_COLOR_BUFFER_BIT);
+    drawSceneCircle(sdf);  // Warm up: first use of the program and buffer
+    glFinish();
 
-    // Disable vertex attribute array
-    glDisableVertexAttribArray(positionLocation);
+    int64_t start = timeline::monotonicNanos();
+    for (int i = 0; i < draws; i++) {
+        drawSceneCircle(sdf);
+    }
+    glFinish();
+    return (timeline::monotonicNanos() - start) / 1e6;
 }
 
-// Update animation
-static void updateAnimation() {
+// Auto mode: which pipeline is cheaper depends on the GPU (vertex and
+// setup cost against fill rate), and on the circle's size on this
+// surface, so measure both and keep the faster
+static void chooseCircleMode() {
+    const int kDraws = 200;
+    double fanMs = timeCircleDraws(false, kDraws);
+    double sdfMs = timeCircleDraws(true, kDraws);
+    g_useSdf = sdfMs < fanMs;
+    g_circleModeChosen = true;
+
+    gl::CircleLoad fan = gl::fanLoad(64, g_circleRadius * std::min(g_width, g_height) * 0.5f);
+    gl::CircleLoad sdf = gl::sdfLoad(g_circleRadius * std::min(g_width, g_height) * 0.5f);
+    LOGI("Circle pipeline: %d circles in %.2f ms as fans (%d vertices, ~%.0f px each), "
+         "%.2f ms as SDF quads (%d vertices, ~%.0f px each): using %s",
+         kDraws, fanMs, fan.vertices, fan.fragments, sdfMs, sdf.vertices, sdf.fragments,
+         g_useSdf ? "SDF" : "fan");
+}
+
+// Apply the launch intent's "circle" extra (null: the default fan)
+static void setCircleMode(const char* mode) {
+    g_circleMode = kCircleModeFan;
+    g_sdfStyle = gl::SdfCircleStyle();
+    if (!mode || strcmp(mode, "fan") == 0) {
+        // Default
+    } else if (strcmp(mode, "sdf") == 0) {
+        g_circleMode = kCircleModeSdf;
+    } else if (strcmp(mode, "stroke") == 0) {
+        g_circleMode = kCircleModeSdf;
+        g_sdfStyle.shape = gl::kCircleStroke;
+        g_sdfStyle.strokeWidth = 8.0f;
+    } else if (strcmp(mode, "rings") == 0) {
+        g_circleMode = kCircleModeSdf;
+        g_sdfStyle.shape = gl::kCircleRings;
+        g_sdfStyle.strokeWidth = 6.0f;
+        g_sdfStyle.ringSpacing = 16.0f;
+    } else if (strcmp(mode, "auto") == 0) {
+        g_circleMode = kCircleModeAuto;
+    } else {
+        LOGW("Unknown circle mode \"%s\", drawing the fan", mode);
+    }
+
+    g_useSdf = g_circleMode == kCircleModeSdf;
+    g_circleModeChosen = g_circleMode != kCircleModeAuto;
+}
+
+// Render one frame
+static void renderFrame() {
+    if (g_stressCircles > 0) {
+        // The circles' motion is a function of time, evaluated in the
+        // vertex shader; time is interpolated between the last two steps
+        // like the single circle's position is
+        double stepNanos = static_cast<double>(g_timeline.stepNanos());
+        double nanos = g_timeline.simulatedNanos() - stepNanos * (1.0 - g_timeline.alpha());
+        float seconds = static_cast<float>(std::max(0.0, nanos) / 1e9);
+        g_instancedCircles.draw(g_gl, seconds, g_width, g_height);
+        return;
+    }
+
+    if (!g_circleModeChosen) {
+        chooseCircleMode();
+    }
+
+    g_gl.clear(GL_COLOR_BUFFER_BIT);
+    if (g_trail) {
+        drawTrail();
+    }
+    drawSceneCircle(g_useSdf);
+
+    if (g_trail) {
+        // After the frame's last draw from the rings
+        g_vertexRing.endFrame(g_gl);
+        g_indexRing.endFrame(g_gl);
+    }
+}
+
+// Move the circle by `seconds` of simulated time
+static void stepCircle(CircleState& circle, float seconds) {
     // Update position
-    g_circleX += g_velocityX;
-    g_circleY += g_velocityY;
+    circle.x += circle.velocityX * seconds;
+    circle.y += circle.velocityY * seconds;
 
     // Bounce off edges
-    if (g_circleX - g_circleRadius < 0.0f || g_circleX + g_circleRadius > 1.0f) {
-        g_velocityX = -g_velocityX;
-        g_circleX = std::max(g_circleRadius, std::min(1.0f - g_circleRadius, g_circleX));
+    if (circle.x - g_circleRadius < 0.0f || circle.x + g_circleRadius > 1.0f) {
+        circle.velocityX = -circle.velocityX;
+        circle.x = std::max(g_circleRadius, std::min(1.0f - g_circleRadius, circle.x));
+    }
+
+    if (circle.y - g_circleRadius < 0.0f || circle.y + g_circleRadius > 1.0f) {
+        circle.velocityY = -circle.velocityY;
+        circle.y = std::max(g_circleRadius, std::min(1.0f - g_circleRadius, circle.y));
+    }
+}
+
+// Update animation
+//
+// GLSurfaceView calls onDrawFrame at whatever rate the display runs
+// (60, 90, 120 Hz...) and skips frames when we're slow, so moving "a bit
+// per frame" would change speed with the panel. Instead the circle is
+// stepped in fixed 1/120 s steps, as many as the elapsed time covers
+// (common/timeline.h), and drawn interpolated between the last two.
+// Returns the number of steps run.
+static int updateAnimation() {
+    int steps = g_timeline.advance(timeline::monotonicNanos());
+    for (int i = 0; i < steps; i++) {
+        g_previousCircle = g_circle;
+        stepCircle(g_circle, g_timeline.stepSeconds());
     }
 
-    if (g_circleY - g_circleRadius < 0.0f || g_circleY + g_circleRadius > 1.0f) {
-        g_velocityY = -g_velocityY;
-        g_circleY = std::max(g_circleRadius, std::min(1.0f - g_circleRadius, g_circleY));
+    float alpha = g_timeline.alpha();
+    g_circleX = timeline::lerp(g_previousCircle.x, g_circle.x, alpha);
+    g_circleY = timeline::lerp(g_previousCircle.y, g_circle.y, alpha);
+    return steps;
+}
+
+// Log the stress scene's averages every 2 seconds. CPU time is the time
+// spent in onDrawFrame (GL calls are mostly queued, not executed, so this
+// is what grows with the number of calls); the frame rate also includes
+// the GPU and the display.
+static void reportStress(int64_t startNanos, int64_t endNanos, const gl::GlCallStats& calls) {
+    StressStats& stats = g_stressStats;
+    if (stats.windowStartNanos == 0) {
+        stats.windowStartNanos = startNanos;
     }
+    stats.frames++;
+    stats.cpuNanos += endNanos - startNanos;
+
+    int64_t window = endNanos - stats.windowStartNanos;
+    if (window >= 2000000000LL) {
+        LOGI("Stress: %d circles, %u draw calls and %u GL calls per frame, "
+             "CPU %.3f ms per frame, %.1f fps",
+             g_instancedCircles.count(), calls.draws, calls.issued,
+             stats.cpuNanos / 1e6 / stats.frames, stats.frames * 1e9 / window);
+        stats = StressStats();
+    }
+}
+
+// Log how long the surface took to its first frame, and how much of it
+// went into getting the shader programs. The frame is timed on the CPU:
+// its swap and GPU work come after. Launch once with --ez programCache
+// false (everything compiles) and twice without (the second loads) to
+// compare.
+static void reportFirstFrame(int64_t nowNanos) {
+    const gl::ProgramCacheStats& programs = g_programCache.stats();
+    LOGI("First frame %.1f ms after surface created, %.1f ms of it programs "
+         "(%d loaded in %.1f ms, %d compiled in %.1f ms, %d rejected; program cache %s)",
+         (nowNanos - g_surfaceCreatedNanos) / 1e6,
+         (programs.loadNanos + programs.compileNanos) / 1e6, programs.loaded,
+         programs.loadNanos / 1e6, programs.compiled, programs.compileNanos / 1e6,
+         programs.rejected, g_programCache.enabled() ? "on" : "off");
+    g_surfaceCreatedNanos = 0;
+}
+
+// Log the trail's streaming totals every 2 seconds
+static void reportStream(int64_t nowNanos) {
+    if (g_streamReportNanos != 0 && nowNanos - g_streamReportNanos < 2000000000LL) {
+        return;
+    }
+    bool first = g_streamReportNanos == 0;
+    g_streamReportNanos = nowNanos;
+    if (first) {
+        return;
+    }
+    const gl::StreamStats& v = g_vertexRing.stats();
+    const gl::StreamStats& i = g_indexRing.stats();
+    LOGI("Trail stream: %.1f KB in %u uploads, %u wraps, %u orphans, %u fences, "
+         "%u fence waits (%.3f ms)",
+         (v.bytes + i.bytes) / 1024.0, v.allocations + i.allocations, v.wraps + i.wraps,
+         v.orphans + i.orphans, v.fences + i.fences, v.fenceWaits + i.fenceWaits,
+         (v.fenceWaitNanos + i.fenceWaitNanos) / 1e6);
 }
 
 // ============================================================================
@@ -395,14 +852,40 @@ extern "C" {
 // Called when GLSurfaceView's surface is created
 JNIEXPORT void JNICALL
 Java_com_graphics_phase4_GLRenderer_nativeOnSurfaceCreated(
-        JNIEnv* /*env*/, jobject /*obj*/) {
+        JNIEnv* env, jobject /*obj*/, jint stressCircles, jstring circleMode, jboolean trail,
+        jstring programCacheDir) {
     LOGI("Surface created");
+    g_surfaceCreatedNanos = timeline::monotonicNanos();
+
+    g_stressCircles = std::max(0, static_cast<int>(stressCircles));
+    g_trail = trail == JNI_TRUE && g_stressCircles == 0;
+
+    const char* mode = circleMode ? env->GetStringUTFChars(circleMode, nullptr) : nullptr;
+    setCircleMode(mode);
+    if (mode) {
+        env->ReleaseStringUTFChars(circleMode, mode);
+    }
+
+    g_programCacheDir.clear();
+    if (programCacheDir) {
+        const char* directory = env->GetStringUTFChars(programCacheDir, nullptr);
+        g_programCacheDir = directory;
+        env->ReleaseStringUTFChars(programCacheDir, directory);
+    }
+
+    // A new EGL context starts from GL defaults, whatever the cache
+    // remembers from the previous one
+    g_gl.invalidate();
 
     if (!initGL()) {
         LOGE("Failed to initialize OpenGL");
         return;
     }
 
+    // Pick the animation up where it was, without simulating the time
+    // the surface was gone
+    g_timeline.reset();
+
     // Note: GLSurfaceView handles threading - no manual thread management needed
 }
 
@@ -415,24 +898,56 @@ Java_com_graphics_phase4_GLRenderer_nativeOnSurfaceChanged(
     g_width = width;
     g_height = height;
 
+    // The circle's size in pixels changed: time the two pipelines again
+    if (g_circleMode == kCircleModeAuto) {
+        g_circleModeChosen = false;
+    }
+
     // Set viewport to match surface dimensions
-    glViewport(0, 0, width, height);
+    g_gl.viewport(0, 0, width, height);
 }
 
 // Called every frame by GLSurfaceView
 JNIEXPORT void JNICALL
 Java_com_graphics_phase4_GLRenderer_nativeOnDrawFrame(
         JNIEnv* /*env*/, jobject /*obj*/) {
-    updateAnimation();
+    int64_t start = timeline::monotonicNanos();
+    int steps = updateAnimation();
+    g_trace.record(kTraceFrame, g_frameNumber, g_width, g_height, steps);
+
+    g_gl.beginFrame();
     renderFrame();
+    const gl::GlCallStats& calls = g_gl.frameStats();
+    g_trace.record(kTraceGlCalls, g_frameNumber++, static_cast<int32_t>(calls.issued),
+                   static_cast<int32_t>(calls.skipped), static_cast<int32_t>(calls.draws));
+
+    if (g_stressCircles > 0) {
+        reportStress(start, timeline::monotonicNanos(), calls);
+    }
+    if (g_trail) {
+        reportStream(timeline::monotonicNanos());
+    }
+    if (g_surfaceCreatedNanos != 0) {
+        reportFirstFrame(timeline::monotonicNanos());
+    }
 }
 
-// Called when surface is destroyed
+// Called on the GL thread just before GLSurfaceView pauses and drops the
+// context (MyGLSurfaceView.onPause() queues it), so GL calls still work
 JNIEXPORT void JNICALL
 Java_com_graphics_phase4_GLRenderer_nativeOnSurfaceDestroyed(
         JNIEnv* /*env*/, jobject /*obj*/) {
     LOGI("Surface destroyed");
     cleanupGL();
+
+    // Format the last frames' trace events (debug builds only; in release
+    // the LOGD is compiled out and the formatting would be wasted)
+    if (NATIVE_LOG_LEVEL <= NATIVE_LOG_DEBUG) {
+        size_t traced = g_trace.drain(
+                [](const char* line, void*) { LOGD("trace %s", line); }, nullptr);
+        LOGI("Trace: %zu events drained, %llu lost", traced,
+             static_cast<unsigned long long>(g_trace.lost()));
+    }
 }
 
 } // extern "C"
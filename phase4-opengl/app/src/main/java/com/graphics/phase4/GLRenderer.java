@@ -21,14 +21,49 @@ public class GLRenderer implements GLSurfaceView.Renderer {
         System.loadLibrary("phase4opengl");
     }
 
+    // Circles in the stress scene (0 = the normal single-circle scene)
+    private final int stressCircles;
+
+    // How the single circle is drawn: "fan", "sdf", "stroke", "rings" or
+    // "auto" (null = fan)
+    private final String circleMode;
+
+    // Whether the single circle leaves a trail
+    private final boolean trail;
+
+    // Where linked shader programs are saved between launches (null = not
+    // saved: every program compiles from source)
+    private final String programCacheDir;
+
+    /**
+     * @param stressCircles Circles to draw instead of the single one
+     *                      (0 = normal scene)
+     * @param circleMode    How the single circle is drawn (null = fan)
+     * @param trail         Whether the single circle leaves a trail
+     * @param programCacheDir Directory for saved shader programs (null = off)
+     */
+    public GLRenderer(int stressCircles, String circleMode, boolean trail,
+                      String programCacheDir) {
+        this.stressCircles = stressCircles;
+        this.circleMode = circleMode;
+        this.trail = trail;
+        this.programCacheDir = programCacheDir;
+    }
+
     // Native method declarations
     // These are implemented in gl_renderer.cpp
 
     /**
      * Called when the OpenGL context is created.
      * This is where we initialize OpenGL resources (shaders, buffers, etc.)
+     *
+     * @param stressCircles Circles in the stress scene (0 = normal scene)
+     * @param circleMode    How the single circle is drawn (null = fan)
+     * @param trail         Whether the single circle leaves a trail
+     * @param programCacheDir Directory for saved shader programs (null = off)
      */
-    private native void nativeOnSurfaceCreated();
+    private native void nativeOnSurfaceCreated(int stressCircles, String circleMode,
+                                               boolean trail, String programCacheDir);
 
     /**
      * Called when the surface size changes (rotation, resize, etc.)
@@ -70,7 +105,7 @@ public class GLRenderer implements GLSurfaceView.Renderer {
     public void onSurfaceCreated(GL10 gl, EGLConfig config) {
         // Note: We ignore the GL10 parameter - it's legacy OpenGL ES 1.0
         // We use OpenGL ES 2.0 via native code instead
-        nativeOnSurfaceCreated();
+        nativeOnSurfaceCreated(stressCircles, circleMode, trail, programCacheDir);
     }
 
     /**
@@ -108,8 +143,9 @@ public class GLRenderer implements GLSurfaceView.Renderer {
     }
 
     /**
-     * Called when the surface is destroyed.
-     * This is our custom cleanup hook.
+     * Called when the surface is about to go away.
+     * This is our custom cleanup hook: MyGLSurfaceView.onPause() queues it
+     * on the rendering thread while the context is still current.
      */
     public void onSurfaceDestroyed() {
         nativeOnSurfaceDestroyed();
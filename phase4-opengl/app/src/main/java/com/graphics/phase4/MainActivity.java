@@ -19,8 +19,25 @@ public class MainActivity extends Activity {
 
         Log.i(TAG, "Activity created");
 
+        // Stress scene: "circles" instanced circles instead of the single one
+        //   adb shell am start -n com.graphics.phase4/.MainActivity --ei circles 100000
+        int circles = getIntent().getIntExtra("circles", 0);
+
+        // How the single circle is drawn: fan, sdf, stroke, rings or auto
+        //   adb shell am start -n com.graphics.phase4/.MainActivity --es circle sdf
+        String circleMode = getIntent().getStringExtra("circle");
+
+        // A fading trail behind the single circle, streamed every frame
+        //   adb shell am start -n com.graphics.phase4/.MainActivity --ez trail true
+        boolean trail = getIntent().getBooleanExtra("trail", false);
+
+        // Save linked shader programs for the next launch (on by default;
+        // false measures the start without them)
+        //   adb shell am start -n com.graphics.phase4/.MainActivity --ez programCache false
+        boolean programCache = getIntent().getBooleanExtra("programCache", true);
+
         // Create and set the OpenGL surface view
-        glSurfaceView = new MyGLSurfaceView(this);
+        glSurfaceView = new MyGLSurfaceView(this, circles, circleMode, trail, programCache);
         setContentView(glSurfaceView);
 
         Log.i(TAG, "Phase 4: OpenGL ES 2.0 rendering active");
@@ -11,6 +11,7 @@
 
 package com.graphics.phase4;
 
+import android.app.ActivityManager;
 import android.content.Context;
 import android.opengl.GLSurfaceView;
 import android.util.Log;
@@ -24,16 +25,33 @@ public class MyGLSurfaceView extends GLSurfaceView {
      * Constructor
      *
      * @param context The activity context
+     * @param circles Circles in the stress scene (0 = the normal scene)
+     * @param circleMode How the normal scene's circle is drawn (null = fan)
+     * @param trail Whether the normal scene's circle leaves a trail
+     * @param programCache Whether to save and reuse linked shader programs
      */
-    public MyGLSurfaceView(Context context) {
+    public MyGLSurfaceView(Context context, int circles, String circleMode, boolean trail,
+                           boolean programCache) {
         super(context);
 
-        // Tell GLSurfaceView we want to use OpenGL ES 2.0
-        // (as opposed to OpenGL ES 1.0 or 3.0)
-        setEGLContextClientVersion(2);
+        // Ask for OpenGL ES 3.0 where the device has it: it includes
+        // instanced drawing (glDrawArraysInstanced), which the stress scene
+        // uses, and buffer mapping with fences, which the trail streams its
+        // vertices through. Our shaders are GLSL ES 1.00, so they run on either version;
+        // on 2.0 the native code looks for the GL_EXT_instanced_arrays
+        // extension instead, and the trail falls back to buffer orphaning.
+        int version = 2;
+        ActivityManager activityManager =
+                (ActivityManager) context.getSystemService(Context.ACTIVITY_SERVICE);
+        if (activityManager != null
+                && activityManager.getDeviceConfigurationInfo().reqGlEsVersion >= 0x30000) {
+            version = 3;
+        }
+        setEGLContextClientVersion(version);
 
         // Create our renderer
-        glRenderer = new GLRenderer();
+        glRenderer = new GLRenderer(circles, circleMode, trail,
+                programCache ? context.getCacheDir().getAbsolutePath() : null);
 
         // Set the renderer
         // GLSurfaceView will now:
@@ -47,20 +65,34 @@ public class MyGLSurfaceView extends GLSurfaceView {
         // RENDERMODE_WHEN_DIRTY: Only render when requestRender() is called
         setRenderMode(GLSurfaceView.RENDERMODE_CONTINUOUSLY);
 
-        Log.i(TAG, "GLSurfaceView created with OpenGL ES 2.0");
+        Log.i(TAG, "GLSurfaceView created with OpenGL ES " + version + ".0");
     }
 
     /**
      * Called when the view is being destroyed
-     * This is a good place to clean up resources
+     *
+     * Native cleanup doesn't happen here: super.onDetachedFromWindow() has
+     * already stopped the rendering thread, so an event queued now would
+     * never run. The activity pauses us first, and onPause() cleans up.
      */
     @Override
     protected void onDetachedFromWindow() {
         super.onDetachedFromWindow();
+        Log.i(TAG, "GLSurfaceView detached from window");
+    }
 
-        // Clean up native resources
-        // Note: This must be done carefully to avoid race conditions
-        // with the rendering thread
+    /**
+     * Pause rendering
+     * Called when activity is paused
+     *
+     * super.onPause() destroys the EGL context, so the native cleanup is
+     * queued first: the rendering thread runs queued events before it
+     * pauses, with the context still current. That frees the GL objects
+     * and logs the trace; onSurfaceCreated() builds everything again on
+     * resume.
+     */
+    @Override
+    public void onPause() {
         if (glRenderer != null) {
             queueEvent(new Runnable() {
                 @Override
@@ -70,16 +102,6 @@ public class MyGLSurfaceView extends GLSurfaceView {
                 }
             });
         }
-
-        Log.i(TAG, "GLSurfaceView detached from window");
-    }
-
-    /**
-     * Pause rendering
-     * Called when activity is paused
-     */
-    @Override
-    public void onPause() {
         super.onPause();
         Log.i(TAG, "GLSurfaceView paused");
     }